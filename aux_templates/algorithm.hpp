@@ -1,22 +1,19 @@
 #ifndef ALGORITHM_HPP
 # define ALGORITHM_HPP
 
+#include <algorithm>
+#include <cstring>
+#include "type_traits.hpp"
+#include "simd.hpp"
+#include "../iterators/random_access_iterator.hpp"
+
 namespace merkol
 {
-	/// equal
-	///
-	/// Returns: true if for every iterator i in the range [first1, last1) the
-	/// following corresponding conditions hold: predicate(*i, *(first2 + (i - first1))) != false.
-	/// Otherwise, returns false.
-	///
-	/// Complexity: At most last1 first1 applications of the corresponding predicate.
-	///
-	/// To consider: Make specializations of this for scalar types and random access
-	/// iterators that uses memcmp or some trick memory comparison function.
-	/// We should verify that such a thing results in an improvement.
+	// The generic loops behind equal() and lexicographical_compare(). The public versions, further down,
+	// unwrap contiguous iterators first so that pointer ranges of scalars reach the compare_kind fast paths.
 	template<typename InputIterator1, typename InputIterator2>
 	inline bool
-	equal(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2)
+	equal_unwrapped(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2)
 	{
 		for (; first1 != last1; ++first1, (void) ++first2)
 		{
@@ -48,7 +45,7 @@ namespace merkol
 
 	template<typename InputIterator1, typename InputIterator2>
 	inline bool
-	lexicographical_compare(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, InputIterator2 last2)
+	lexicographical_compare_unwrapped(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, InputIterator2 last2)
 	{
 		for(; (first1 != last1) && (first2 != last2); ++first1, (void) ++first2)
 		{
@@ -77,6 +74,209 @@ namespace merkol
 		return (first1 == last1) && (first2 != last2);
 	}
 
+	/*
+		compare_kind
+		How equal() and lexicographical_compare() can compare contiguous ranges of T:
+
+			kCompareGeneric		element by element with operator== / operator<
+			kCompareBytes		memcmp. Its unsigned byte order is also the value order, so it answers
+								lexicographical_compare directly (unsigned char, bool, unsigned plain char).
+			kCompareBitwise		two values are equal iff their bytes are (integers, enums, pointers): find the
+								first differing byte with simd::mismatch_bytes, then compare that element
+								as a value, which takes care of signedness and byte order.
+			kCompareFloat		float and double, with the SIMD kernels that treat NaN and -0.0 like
+								operator== and operator< do.
+	*/
+	enum { kCompareGeneric, kCompareBytes, kCompareBitwise, kCompareFloat };
+
+	template<typename T>
+	struct compare_kind : integral_constant<int, (is_integral<T>::value || is_enum<T>::value || is_pointer<T>::value)
+												 ? kCompareBitwise : kCompareGeneric> {};
+
+	template<>
+	struct compare_kind<unsigned char> : integral_constant<int, kCompareBytes> {};
+
+	template<>
+	struct compare_kind<bool> : integral_constant<int, kCompareBytes> {};
+
+	template<>
+	struct compare_kind<char> : integral_constant<int, ((char)-1 < 0) ? kCompareBitwise : kCompareBytes> {};
+
+	template<>
+	struct compare_kind<float> : integral_constant<int, kCompareFloat> {};
+
+	template<>
+	struct compare_kind<double> : integral_constant<int, kCompareFloat> {};
+
+	template<typename T>
+	inline bool equal_impl(const T* first1, const T* last1, const T* first2, integral_constant<int, kCompareGeneric>)
+	{
+		return merkol::equal_unwrapped<const T*, const T*>(first1, last1, first2); // the generic loop
+	}
+
+	template<typename T, int Kind>
+	inline bool equal_impl(const T* first1, const T* last1, const T* first2, integral_constant<int, Kind>) // bytes and bitwise
+	{
+		const std::size_t n = (std::size_t)(last1 - first1);
+
+		return !n || (std::memcmp(first1, first2, n * sizeof(T)) == 0);
+	}
+
+	template<typename T>
+	inline bool equal_impl(const T* first1, const T* last1, const T* first2, integral_constant<int, kCompareFloat>)
+	{
+		const std::size_t n = (std::size_t)(last1 - first1);
+
+		return merkol::simd::mismatch_equal(first1, first2, n) == n;
+	}
+
+	template<typename T>
+	inline bool
+	equal_unwrapped(const T* first1, const T* last1, const T* first2)
+	{
+		return merkol::equal_impl(first1, last1, first2, compare_kind<T>());
+	}
+
+	template<typename T>
+	inline bool
+	equal_unwrapped(T* first1, T* last1, T* first2)
+	{
+		typedef typename remove_cv<T>::type value_type;
+
+		return merkol::equal_impl<value_type>(first1, last1, first2, compare_kind<value_type>());
+	}
+
+	/// equal
+	///
+	/// Returns: true if for every iterator i in the range [first1, last1) the
+	/// following corresponding conditions hold: predicate(*i, *(first2 + (i - first1))) != false.
+	/// Otherwise, returns false.
+	///
+	/// Complexity: At most last1 first1 applications of the corresponding predicate.
+	///
+	/// Pointers and contiguous iterators over scalars take a fast path, see compare_kind above.
+	template<typename InputIterator1, typename InputIterator2>
+	inline bool
+	equal(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2)
+	{
+		return merkol::equal_unwrapped(merkol::unwrap_iterator(first1), merkol::unwrap_iterator(last1), merkol::unwrap_iterator(first2));
+	}
+
+	template<typename T>
+	inline bool lexicographical_compare_impl(const T* first1, const T* last1, const T* first2, const T* last2,
+											 integral_constant<int, kCompareGeneric>)
+	{
+		return merkol::lexicographical_compare_unwrapped<const T*, const T*>(first1, last1, first2, last2); // the generic loop
+	}
+
+	template<typename T>
+	inline bool lexicographical_compare_impl(const T* first1, const T* last1, const T* first2, const T* last2,
+											 integral_constant<int, kCompareBytes>)
+	{
+		const std::size_t n1 = (std::size_t)(last1 - first1);
+		const std::size_t n2 = (std::size_t)(last2 - first2);
+		const std::size_t n  = (n1 < n2) ? n1 : n2;
+
+		if (n)
+		{
+			const int result = std::memcmp(first1, first2, n * sizeof(T));
+			if (result)
+				return result < 0;
+		}
+		return n1 < n2;
+	}
+
+	template<typename T>
+	inline bool lexicographical_compare_impl(const T* first1, const T* last1, const T* first2, const T* last2,
+											 integral_constant<int, kCompareBitwise>)
+	{
+		const std::size_t n1 = (std::size_t)(last1 - first1);
+		const std::size_t n2 = (std::size_t)(last2 - first2);
+		const std::size_t n  = (n1 < n2) ? n1 : n2;
+		const std::size_t i  = merkol::simd::mismatch_bytes(first1, first2, n * sizeof(T)) / sizeof(T);
+
+		if (i < n)
+			return first1[i] < first2[i];
+		return n1 < n2;
+	}
+
+	template<typename T>
+	inline bool lexicographical_compare_impl(const T* first1, const T* last1, const T* first2, const T* last2,
+											 integral_constant<int, kCompareFloat>)
+	{
+		const std::size_t n1 = (std::size_t)(last1 - first1);
+		const std::size_t n2 = (std::size_t)(last2 - first2);
+		const std::size_t n  = (n1 < n2) ? n1 : n2;
+		const std::size_t i  = merkol::simd::mismatch_ordered(first1, first2, n);
+
+		if (i < n)
+			return first1[i] < first2[i];
+		return n1 < n2;
+	}
+
+	template<typename T>
+	inline bool
+	lexicographical_compare_unwrapped(const T* first1, const T* last1, const T* first2, const T* last2)
+	{
+		return merkol::lexicographical_compare_impl(first1, last1, first2, last2, compare_kind<T>());
+	}
+
+	template<typename T>
+	inline bool
+	lexicographical_compare_unwrapped(T* first1, T* last1, T* first2, T* last2)
+	{
+		typedef typename remove_cv<T>::type value_type;
+
+		return merkol::lexicographical_compare_impl<value_type>(first1, last1, first2, last2, compare_kind<value_type>());
+	}
+
+	template<typename InputIterator1, typename InputIterator2>
+	inline bool
+	lexicographical_compare(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, InputIterator2 last2)
+	{
+		return merkol::lexicographical_compare_unwrapped(merkol::unwrap_iterator(first1), merkol::unwrap_iterator(last1),
+														 merkol::unwrap_iterator(first2), merkol::unwrap_iterator(last2));
+	}
+
+	template<typename InputIterator, typename Function>
+	inline Function for_each_unwrapped(InputIterator first, InputIterator last, Function f)
+	{
+		for (; first != last; ++first)
+			f(*first);
+		return f;
+	}
+
+	/// for_each
+	///
+	/// Applies f to every element of [first, last) and returns f. Segmented iterators (deque) have an
+	/// overload that runs one loop per block.
+	template<typename InputIterator, typename Function>
+	inline Function for_each(InputIterator first, InputIterator last, Function f)
+	{
+		return merkol::for_each_unwrapped(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), f);
+	}
+
+	/// copy
+	///
+	/// Copies [first, last) to the range starting at dest, front to back, and returns the end of the
+	/// destination. Contiguous iterators are unwrapped, so that std::copy gets the pointers it turns into
+	/// memmove for trivially copyable types.
+	template<typename InputIterator, typename OutputIterator>
+	inline OutputIterator copy(InputIterator first, InputIterator last, OutputIterator dest)
+	{
+		return merkol::rewrap_iterator(dest, std::copy(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last),
+													   merkol::unwrap_iterator(dest)));
+	}
+
+	/// fill
+	///
+	/// Assigns value to every element of [first, last).
+	template<typename ForwardIterator, typename T>
+	inline void fill(ForwardIterator first, ForwardIterator last, const T& value)
+	{
+		std::fill(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), value);
+	}
+
 	template<typename T>
 	const T& min(const T &x, const T &y)
 	{
@@ -86,9 +286,149 @@ namespace merkol
 	template<typename T>
 	void swap(T &x, T &y)
 	{
-		T tmp(x);
-		x = y;
-		y = tmp;
+		T tmp(MERKOL_MOVE(x));
+		x = MERKOL_MOVE(y);
+		y = MERKOL_MOVE(tmp);
+	}
+
+	// Pointer ranges of trivially copyable types are moved with memmove: the ranges may overlap
+	// (erase and insert shift elements inside the same buffer), and assignment is a byte copy anyway.
+	template<typename T>
+	inline T* move_impl(const T* first, const T* last, T* dest, merkol::true_type) // true means T is trivially copyable.
+	{
+		const std::size_t n = (std::size_t)(last - first);
+
+		if (n)
+			std::memmove(static_cast<void*>(dest), static_cast<const void*>(first), n * sizeof(T));
+		return dest + n;
+	}
+
+	template<typename InputIterator, typename OutputIterator>
+	inline OutputIterator move_impl(InputIterator first, InputIterator last, OutputIterator dest, merkol::false_type)
+	{
+	#if __cplusplus >= 201103L
+		return std::move(first, last, dest);
+	#else
+		return std::copy(first, last, dest);
+	#endif
+	}
+
+	template<typename T>
+	inline T* move_backward_impl(const T* first, const T* last, T* destLast, merkol::true_type) // true means T is trivially copyable.
+	{
+		const std::size_t n = (std::size_t)(last - first);
+
+		if (n)
+			std::memmove(static_cast<void*>(destLast - n), static_cast<const void*>(first), n * sizeof(T));
+		return destLast - n;
+	}
+
+	template<typename BidirectionalIterator1, typename BidirectionalIterator2>
+	inline BidirectionalIterator2 move_backward_impl(BidirectionalIterator1 first, BidirectionalIterator1 last, BidirectionalIterator2 destLast, merkol::false_type)
+	{
+	#if __cplusplus >= 201103L
+		return std::move_backward(first, last, destLast);
+	#else
+		return std::copy_backward(first, last, destLast);
+	#endif
+	}
+
+	template<typename InputIterator, typename OutputIterator>
+	inline OutputIterator
+	move_unwrapped(InputIterator first, InputIterator last, OutputIterator dest)
+	{
+		return merkol::move_impl(first, last, dest, merkol::false_type());
+	}
+
+	template<typename T>
+	inline T*
+	move_unwrapped(T* first, T* last, T* dest)
+	{
+		return merkol::move_impl(first, last, dest, merkol::is_trivially_copyable<T>());
+	}
+
+	template<typename BidirectionalIterator1, typename BidirectionalIterator2>
+	inline BidirectionalIterator2
+	move_backward_unwrapped(BidirectionalIterator1 first, BidirectionalIterator1 last, BidirectionalIterator2 destLast)
+	{
+		return merkol::move_backward_impl(first, last, destLast, merkol::false_type());
+	}
+
+	template<typename T>
+	inline T*
+	move_backward_unwrapped(T* first, T* last, T* destLast)
+	{
+		return merkol::move_backward_impl(first, last, destLast, merkol::is_trivially_copyable<T>());
+	}
+
+	/// move
+	///
+	/// Moves the range [first, last) to the range starting at dest, front to back.
+	/// Copies in C++98 mode.
+	template<typename InputIterator, typename OutputIterator>
+	inline OutputIterator
+	move(InputIterator first, InputIterator last, OutputIterator dest)
+	{
+		return merkol::rewrap_iterator(dest, merkol::move_unwrapped(merkol::unwrap_iterator(first),
+			merkol::unwrap_iterator(last), merkol::unwrap_iterator(dest)));
+	}
+
+	/// move_backward
+	///
+	/// Moves the range [first, last) to the range ending at destLast, back to front, so that
+	/// overlapping ranges that shift to the right are handled. Copies in C++98 mode.
+	template<typename BidirectionalIterator1, typename BidirectionalIterator2>
+	inline BidirectionalIterator2
+	move_backward(BidirectionalIterator1 first, BidirectionalIterator1 last, BidirectionalIterator2 destLast)
+	{
+		return merkol::rewrap_iterator(destLast, merkol::move_backward_unwrapped(merkol::unwrap_iterator(first),
+			merkol::unwrap_iterator(last), merkol::unwrap_iterator(destLast)));
+	}
+
+	/// lower_bound
+	///
+	/// First position in the sorted range [first, last) whose element is not ordered before value
+	/// (comp(element, value) is false). Random access iterators only.
+	///
+	/// Branchless: every step halves the range by moving the base or not, which compiles to a conditional
+	/// move instead of a jump. The loop runs exactly log2(n) times whatever the data, so there is no
+	/// branch to mispredict. That is about one mispredict per lookup saved for tables that fit in cache.
+	template<typename RandomAccessIterator, typename T, typename Compare>
+	inline RandomAccessIterator lower_bound(RandomAccessIterator first, RandomAccessIterator last, const T& value, Compare comp)
+	{
+		typename merkol::iterator_traits<RandomAccessIterator>::difference_type n = last - first;
+
+		if (n == 0)
+			return first;
+		while (n > 1)
+		{
+			const typename merkol::iterator_traits<RandomAccessIterator>::difference_type half = n / 2;
+
+			first = comp(first[half], value) ? first + half : first;
+			n -= half;
+		}
+		return first + (comp(*first, value) ? 1 : 0);
+	}
+
+	/// upper_bound
+	///
+	/// First position in the sorted range [first, last) whose element is ordered after value
+	/// (comp(value, element) is true). Branchless, like lower_bound.
+	template<typename RandomAccessIterator, typename T, typename Compare>
+	inline RandomAccessIterator upper_bound(RandomAccessIterator first, RandomAccessIterator last, const T& value, Compare comp)
+	{
+		typename merkol::iterator_traits<RandomAccessIterator>::difference_type n = last - first;
+
+		if (n == 0)
+			return first;
+		while (n > 1)
+		{
+			const typename merkol::iterator_traits<RandomAccessIterator>::difference_type half = n / 2;
+
+			first = comp(value, first[half]) ? first : first + half;
+			n -= half;
+		}
+		return first + (comp(value, *first) ? 0 : 1);
 	}
 
 } // namespace merkol
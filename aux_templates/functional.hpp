@@ -0,0 +1,178 @@
+#ifndef FUNCTIONAL_HPP
+# define FUNCTIONAL_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+/*
+	Function objects for the associative containers.
+
+	merkol::hash is cheap rather than well mixed: integers and pointers hash to themselves, like
+	std::hash in libstdc++. Tables that need every bit of the hash to be random (flat_hash_map keeps
+	the low 7 bits in the control bytes and probes from the rest, hash >> 7) run it through hash_mix()
+	first, so user supplied hashers of the same quality work too. Strings are hashed 8 bytes at a time
+	by hash_bytes().
+*/
+
+namespace merkol
+{
+	/// hash_mix
+	///
+	/// Spreads the entropy of h over every bit: a 64 x 64 -> 128 bit multiply by a large odd constant,
+	/// folded back to 64 bits. Consecutive integers end up with unrelated high and low bits.
+	inline std::size_t hash_mix(std::size_t h)
+	{
+	#if defined(__SIZEOF_INT128__) && (__SIZEOF_SIZE_T__ == 8)
+		const unsigned __int128 m = (unsigned __int128)h * 0x9E3779B97F4A7C15ull;
+
+		return (std::size_t)(m >> 64) ^ (std::size_t)m;
+	#else
+		h ^= h >> 16;
+		h *= 0x85EBCA6Bu;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35u;
+		return h ^ (h >> 16);
+	#endif
+	}
+
+	/// hash_bytes
+	///
+	/// Hash of n bytes, 8 at a time. Not a cryptographic hash: it is not seeded per process, so keys
+	/// chosen by an attacker can collide.
+	inline std::size_t hash_bytes(const void* data, std::size_t n, std::size_t seed = 0)
+	{
+		const unsigned char*	p = static_cast<const unsigned char*>(data);
+		std::size_t				h = seed ^ (n * 0xA0761D6478BD642Full);
+
+		for (; n >= sizeof(std::size_t); n -= sizeof(std::size_t), p += sizeof(std::size_t))
+		{
+			std::size_t word;
+
+			std::memcpy(&word, p, sizeof(word));
+			h = merkol::hash_mix(h ^ word);
+		}
+		if (n)
+		{
+			std::size_t word = 0;
+
+			std::memcpy(&word, p, n);
+			h = merkol::hash_mix(h ^ word);
+		}
+		return h;
+	}
+
+	/// hash
+	///
+	/// Default hasher of the unordered containers. Specialize it for your own key types.
+	template <typename T>
+	struct hash;
+
+	template <typename T>
+	struct hash<T*>
+	{
+		std::size_t operator()(T* p) const { return (std::size_t)p; }
+	};
+
+# define MERKOL_HASH_IDENTITY(T) \
+	template <> \
+	struct hash<T> \
+	{ \
+		std::size_t operator()(T value) const { return (std::size_t)value; } \
+	};
+
+	MERKOL_HASH_IDENTITY(bool)
+	MERKOL_HASH_IDENTITY(char)
+	MERKOL_HASH_IDENTITY(signed char)
+	MERKOL_HASH_IDENTITY(unsigned char)
+	MERKOL_HASH_IDENTITY(wchar_t)
+	MERKOL_HASH_IDENTITY(short)
+	MERKOL_HASH_IDENTITY(unsigned short)
+	MERKOL_HASH_IDENTITY(int)
+	MERKOL_HASH_IDENTITY(unsigned int)
+	MERKOL_HASH_IDENTITY(long)
+	MERKOL_HASH_IDENTITY(unsigned long)
+	MERKOL_HASH_IDENTITY(long long)
+	MERKOL_HASH_IDENTITY(unsigned long long)
+
+# undef MERKOL_HASH_IDENTITY
+
+	// +0.0 and -0.0 compare equal, so they must hash the same.
+	template <>
+	struct hash<float>
+	{
+		std::size_t operator()(float value) const { return (value == 0.0f) ? 0 : merkol::hash_bytes(&value, sizeof(value)); }
+	};
+
+	template <>
+	struct hash<double>
+	{
+		std::size_t operator()(double value) const { return (value == 0.0) ? 0 : merkol::hash_bytes(&value, sizeof(value)); }
+	};
+
+	template <typename CharT, typename Traits, typename Allocator>
+	struct hash<std::basic_string<CharT, Traits, Allocator> >
+	{
+		std::size_t operator()(const std::basic_string<CharT, Traits, Allocator>& s) const
+		{
+			return merkol::hash_bytes(s.data(), s.size() * sizeof(CharT));
+		}
+	};
+
+	/// equal_to
+	template <typename T>
+	struct equal_to
+	{
+		bool operator()(const T& a, const T& b) const { return a == b; }
+	};
+
+	/// less
+	template <typename T>
+	struct less
+	{
+		bool operator()(const T& a, const T& b) const { return a < b; }
+	};
+
+	/// greater
+	template <typename T>
+	struct greater
+	{
+		bool operator()(const T& a, const T& b) const { return b < a; }
+	};
+
+	/// not_ordered
+	///
+	/// Equivalence of two neighbours a, b of a range sorted by Compare: b is not ordered after a.
+	/// The predicate std::unique needs to drop duplicate keys from a sorted range.
+	template <typename T, typename Compare>
+	struct not_ordered
+	{
+		Compare comp;
+
+		explicit not_ordered(const Compare& c) : comp(c) { }
+		bool operator()(const T& a, const T& b) const { return !comp(a, b); }
+	};
+
+	/// use_self / use_first
+	///
+	/// Key extractors of the associative containers: a set stores the key itself, a map a pair whose
+	/// first member is the key.
+	template <typename T>
+	struct use_self
+	{
+		typedef T result_type;
+
+		const T& operator()(const T& x) const { return x; }
+	};
+
+	template <typename Pair>
+	struct use_first
+	{
+		typedef typename Pair::first_type result_type;
+
+		const result_type& operator()(const Pair& x) const { return x.first; }
+	};
+
+} // namespace merkol
+
+#endif // FUNCTIONAL_HPP
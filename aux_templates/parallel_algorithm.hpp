@@ -0,0 +1,681 @@
+#ifndef MERKOL_PARALLEL_ALGORITHM_HPP
+# define MERKOL_PARALLEL_ALGORITHM_HPP
+
+#if __cplusplus < 201103L
+# error "parallel_algorithm.hpp requires C++11"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <stdint.h>
+#include <vector>
+#include "algorithm.hpp"
+#include "functional.hpp"
+#include "sort.hpp"
+#include "type_traits.hpp"
+#include "../auxiliary/thread_pool.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	merkol::parallel algorithms
+
+	for_each, transform, reduce, fill, copy, sort, stable_sort, equal, find and find_if over random access ranges
+	(merkol::vector, deque, pointers...), run on a thread_pool (auxiliary/thread_pool.hpp). The range is
+	cut in two halves with thread_pool::invoke, recursively, until the pieces are at most a grain of
+	elements; each piece runs the sequential algorithm (merkol::fill, merkol::copy and merkol::equal with
+	their memset, memmove and memcmp fast paths, merkol::sort...). Ranges of at most one grain do not touch
+	the pool at all.
+
+	Every algorithm takes an optional policy first:
+
+		merkol::parallel::reduce(merkol::parallel::policy().grain(1 << 16).deterministic(), v.begin(), v.end(), 0.0);
+
+		pool(p)				the thread_pool to run on, default_pool() otherwise
+		grain(n)			the largest piece a task runs sequentially. Default: enough pieces for 8 per
+							worker, and no piece under kMinGrain elements (the whole range for a pool
+							of one worker).
+		deterministic()		reduce() combines the pieces along the tree of halves, in range order, so its
+							result only depends on where the range is cut. By default the grain depends on
+							the number of workers: a floating point sum may differ in the last bits between
+							two machines. In deterministic mode the default grain only depends on the size
+							of the range, and the result is bitwise the same for any pool and any schedule.
+
+	Functions are called concurrently from several threads and must not have data races with each other.
+	copy and transform require the destination not to overlap the source (except transform with
+	dest == first). The first exception thrown by an element function is rethrown once every piece is
+	done; the range is left partially processed, like after a sequential algorithm that threw.
+
+	sort is a sample sort and stable_sort a merge sort (see below); both need a buffer of n elements.
+*/
+
+namespace merkol
+{
+namespace parallel
+{
+	static const std::size_t kMinGrain		= 4096;		// elements below which a piece is not worth a task
+	static const std::size_t kSortGrain		= 16384;	// smallest piece sort sorts with std::sort
+	static const std::size_t kPiecesPerWorker	= 8;
+	static const std::size_t kDeterministicPieces	= 1024;	// default piece count of deterministic mode
+	static const std::size_t kMaxSortBuckets		= 1024;	// most buckets between splitters of sort
+	static const std::size_t kOversampling		= 16;	// sample elements per bucket of sort
+
+	/**
+	 * @brief policy
+	 * How a parallel algorithm runs: pool, grain size and deterministic mode (see above).
+	 */
+	class policy
+	{
+	public:
+		typedef std::size_t	size_type;
+
+		policy() : mpPool(NULL), mnGrain(0), mbDeterministic(false) { }
+
+		policy&			pool(thread_pool& p) { mpPool = &p; return *this; }
+		policy&			grain(size_type n) { mnGrain = n; return *this; }
+		policy&			deterministic(bool on = true) { mbDeterministic = on; return *this; }
+
+		thread_pool&	get_pool() const { return mpPool ? *mpPool : default_pool(); }
+		bool			is_deterministic() const { return mbDeterministic; }
+
+		// The grain for a range of n elements, at least minimum unless set explicitly.
+		size_type		get_grain(size_type n, size_type minimum) const
+		{
+			size_type grain;
+
+			if (mnGrain)
+				return mnGrain;
+			if (mbDeterministic)
+				grain = n / kDeterministicPieces;
+			else if (get_pool().size() == 1)
+				return n;		// one worker: the calling thread does it all, without a merge pass
+			else
+				grain = n / (get_pool().size() * kPiecesPerWorker);
+			return (grain < minimum) ? minimum : grain;
+		}
+
+	protected:
+		thread_pool*	mpPool;
+		size_type		mnGrain;
+		bool			mbDeterministic;
+	};
+
+
+	// Runs body(begin, end) on pieces of at most grain indexes of [first, last), cut in halves. The cuts
+	// only depend on last - first and grain.
+	template <typename Body>
+	void for_range_impl(thread_pool& pool, std::size_t first, std::size_t last, std::size_t grain, Body& body)
+	{
+		if (last - first <= grain)
+		{
+			body(first, last);
+			return;
+		}
+
+		const std::size_t middle = first + (last - first) / 2;
+
+		pool.invoke([&] { for_range_impl(pool, first, middle, grain, body); },
+					[&] { for_range_impl(pool, middle, last, grain, body); });
+	}
+
+	template <typename Body>
+	void for_range(const policy& p, std::size_t n, std::size_t minimum, Body body)
+	{
+		const std::size_t grain = p.get_grain(n, minimum);
+
+		if (n <= grain)
+		{
+			if (n)
+				body(0, n);
+			return;
+		}
+
+		thread_pool& pool = p.get_pool();
+
+		pool.run([&] { for_range_impl(pool, 0, n, grain, body); });
+	}
+
+	/// for_each
+	///
+	/// Calls f(*it) for every it in [first, last), in parallel.
+	template <typename RandomAccessIterator, typename Function>
+	void for_each(const policy& p, RandomAccessIterator first, RandomAccessIterator last, Function f)
+	{
+		parallel::for_range(p, (std::size_t)(last - first), kMinGrain, [&](std::size_t begin, std::size_t end) {
+			for (RandomAccessIterator it = first + begin, stop = first + end; it != stop; ++it)
+				f(*it);
+		});
+	}
+
+	template <typename RandomAccessIterator, typename Function>
+	inline void for_each(RandomAccessIterator first, RandomAccessIterator last, Function f)
+	{
+		parallel::for_each(policy(), first, last, f);
+	}
+
+	/// transform
+	///
+	/// dest[i] = op(first[i]), or op(first1[i], first2[i]), in parallel. Returns the end of the destination.
+	template <typename RandomAccessIterator, typename OutputIterator, typename UnaryOperation>
+	OutputIterator transform(const policy& p, RandomAccessIterator first, RandomAccessIterator last, OutputIterator dest, UnaryOperation op)
+	{
+		const std::size_t n = (std::size_t)(last - first);
+
+		parallel::for_range(p, n, kMinGrain, [&](std::size_t begin, std::size_t end) {
+			std::transform(first + begin, first + end, dest + begin, op);
+		});
+		return dest + n;
+	}
+
+	template <typename RandomAccessIterator, typename OutputIterator, typename UnaryOperation>
+	inline OutputIterator transform(RandomAccessIterator first, RandomAccessIterator last, OutputIterator dest, UnaryOperation op)
+	{
+		return parallel::transform(policy(), first, last, dest, op);
+	}
+
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIterator, typename BinaryOperation>
+	OutputIterator transform(const policy& p, RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2,
+							 OutputIterator dest, BinaryOperation op)
+	{
+		const std::size_t n = (std::size_t)(last1 - first1);
+
+		parallel::for_range(p, n, kMinGrain, [&](std::size_t begin, std::size_t end) {
+			std::transform(first1 + begin, first1 + end, first2 + begin, dest + begin, op);
+		});
+		return dest + n;
+	}
+
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIterator, typename BinaryOperation>
+	inline OutputIterator transform(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2,
+									OutputIterator dest, BinaryOperation op)
+	{
+		return parallel::transform(policy(), first1, last1, first2, dest, op);
+	}
+
+	/// fill
+	template <typename RandomAccessIterator, typename T>
+	void fill(const policy& p, RandomAccessIterator first, RandomAccessIterator last, const T& value)
+	{
+		parallel::for_range(p, (std::size_t)(last - first), kMinGrain, [&](std::size_t begin, std::size_t end) {
+			merkol::fill(first + begin, first + end, value);
+		});
+	}
+
+	template <typename RandomAccessIterator, typename T>
+	inline void fill(RandomAccessIterator first, RandomAccessIterator last, const T& value)
+	{
+		parallel::fill(policy(), first, last, value);
+	}
+
+	/// copy
+	///
+	/// Copies [first, last) to the range starting at dest, which must not overlap it.
+	template <typename RandomAccessIterator, typename OutputIterator>
+	OutputIterator copy(const policy& p, RandomAccessIterator first, RandomAccessIterator last, OutputIterator dest)
+	{
+		const std::size_t n = (std::size_t)(last - first);
+
+		parallel::for_range(p, n, kMinGrain, [&](std::size_t begin, std::size_t end) {
+			merkol::copy(first + begin, first + end, dest + begin);
+		});
+		return dest + n;
+	}
+
+	template <typename RandomAccessIterator, typename OutputIterator>
+	inline OutputIterator copy(RandomAccessIterator first, RandomAccessIterator last, OutputIterator dest)
+	{
+		return parallel::copy(policy(), first, last, dest);
+	}
+
+
+	// The partial result of a piece, built in place once the piece is done: T needs no default constructor.
+	template <typename T>
+	class reduce_result
+	{
+	public:
+		reduce_result() : mbBuilt(false) { }
+		~reduce_result() { if (mbBuilt) get().~T(); }
+
+		template <typename U>
+		void	set(U&& value) { ::new(static_cast<void*>(mStorage.mBuffer)) T(std::forward<U>(value)); mbBuilt = true; }
+		T&		get() { return *reinterpret_cast<T*>(mStorage.mBuffer); }
+
+	private:
+		merkol::aligned_buffer<T>	mStorage;
+		bool						mbBuilt;
+	};
+
+	// Folds the n > 0 elements from first: sequentially from the left within a grain, along the tree of
+	// halves above it.
+	template <typename T, typename RandomAccessIterator, typename BinaryOperation>
+	T reduce_impl(thread_pool& pool, RandomAccessIterator first, std::size_t n, std::size_t grain, BinaryOperation& op)
+	{
+		if (n <= grain)
+		{
+			T sum(*first);
+
+			for (std::size_t i = 1; i < n; ++i)
+				sum = op(MERKOL_MOVE(sum), first[i]);
+			return sum;
+		}
+
+		const std::size_t	half = n / 2;
+		reduce_result<T>	left;
+		reduce_result<T>	right;
+
+		pool.invoke([&] { left.set(reduce_impl<T>(pool, first, half, grain, op)); },
+					[&] { right.set(reduce_impl<T>(pool, first + half, n - half, grain, op)); });
+		return op(MERKOL_MOVE(left.get()), MERKOL_MOVE(right.get()));
+	}
+
+	/// reduce
+	///
+	/// op(init, op(...)) over [first, last) in some grouping: op must be associative (and commutative
+	/// is not required: the operands keep the range order). The sum of the elements by default.
+	template <typename RandomAccessIterator, typename T, typename BinaryOperation>
+	T reduce(const policy& p, RandomAccessIterator first, RandomAccessIterator last, T init, BinaryOperation op)
+	{
+		const std::size_t n = (std::size_t)(last - first);
+
+		if (n == 0)
+			return init;
+
+		thread_pool&		pool	= p.get_pool();
+		const std::size_t	grain	= p.get_grain(n, kMinGrain);
+		reduce_result<T>	sum;
+
+		if (n <= grain)
+			sum.set(reduce_impl<T>(pool, first, n, grain, op));
+		else
+			pool.run([&] { sum.set(reduce_impl<T>(pool, first, n, grain, op)); });
+		return op(MERKOL_MOVE(init), MERKOL_MOVE(sum.get()));
+	}
+
+	template <typename RandomAccessIterator, typename T>
+	inline T reduce(const policy& p, RandomAccessIterator first, RandomAccessIterator last, T init)
+	{
+		return parallel::reduce(p, first, last, init, std::plus<T>());
+	}
+
+	template <typename RandomAccessIterator, typename T, typename BinaryOperation>
+	inline T reduce(RandomAccessIterator first, RandomAccessIterator last, T init, BinaryOperation op)
+	{
+		return parallel::reduce(policy(), first, last, init, op);
+	}
+
+	template <typename RandomAccessIterator, typename T>
+	inline T reduce(RandomAccessIterator first, RandomAccessIterator last, T init)
+	{
+		return parallel::reduce(policy(), first, last, init, std::plus<T>());
+	}
+
+	template <typename RandomAccessIterator>
+	inline typename merkol::iterator_traits<RandomAccessIterator>::value_type
+	reduce(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		return parallel::reduce(policy(), first, last, value_type(), std::plus<value_type>());
+	}
+
+	/// equal
+	///
+	/// True if predicate(first1[i], first2[i]) (or ==) holds for every i. Pieces that start after a
+	/// mismatch was found are skipped.
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename BinaryPredicate>
+	bool equal(const policy& p, RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, BinaryPredicate predicate)
+	{
+		std::atomic<bool> mismatch(false);
+
+		parallel::for_range(p, (std::size_t)(last1 - first1), kMinGrain, [&](std::size_t begin, std::size_t end) {
+			if (!mismatch.load(std::memory_order_relaxed) && !merkol::equal(first1 + begin, first1 + end, first2 + begin, predicate))
+				mismatch.store(true, std::memory_order_relaxed);
+		});
+		return !mismatch.load(std::memory_order_relaxed);
+	}
+
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2>
+	bool equal(const policy& p, RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2)
+	{
+		std::atomic<bool> mismatch(false);
+
+		parallel::for_range(p, (std::size_t)(last1 - first1), kMinGrain, [&](std::size_t begin, std::size_t end) {
+			if (!mismatch.load(std::memory_order_relaxed) && !merkol::equal(first1 + begin, first1 + end, first2 + begin))
+				mismatch.store(true, std::memory_order_relaxed);
+		});
+		return !mismatch.load(std::memory_order_relaxed);
+	}
+
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename BinaryPredicate>
+	inline bool equal(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, BinaryPredicate predicate)
+	{
+		return parallel::equal(policy(), first1, last1, first2, predicate);
+	}
+
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2>
+	inline bool equal(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2)
+	{
+		return parallel::equal(policy(), first1, last1, first2);
+	}
+
+	/// find_if
+	///
+	/// The first it in [first, last) for which predicate(*it) is true, or last. Pieces are skipped once
+	/// a match before them is known; every piece before the result is searched in full, so the result
+	/// is the first match, as with std::find_if.
+	template <typename RandomAccessIterator, typename Predicate>
+	RandomAccessIterator find_if(const policy& p, RandomAccessIterator first, RandomAccessIterator last, Predicate predicate)
+	{
+		const std::size_t			n = (std::size_t)(last - first);
+		std::atomic<std::size_t>	found(n);
+
+		parallel::for_range(p, n, kMinGrain, [&](std::size_t begin, std::size_t end) {
+			if (begin >= found.load(std::memory_order_relaxed))
+				return;
+
+			const std::size_t	i		= (std::size_t)(std::find_if(first + begin, first + end, predicate) - first);
+			std::size_t			best	= found.load(std::memory_order_relaxed);
+
+			while ((i < end) && (i < best) && !found.compare_exchange_weak(best, i, std::memory_order_relaxed))
+				;
+		});
+		return first + found.load(std::memory_order_relaxed);
+	}
+
+	template <typename RandomAccessIterator, typename Predicate>
+	inline RandomAccessIterator find_if(RandomAccessIterator first, RandomAccessIterator last, Predicate predicate)
+	{
+		return parallel::find_if(policy(), first, last, predicate);
+	}
+
+	/// find
+	template <typename RandomAccessIterator, typename T>
+	inline RandomAccessIterator find(const policy& p, RandomAccessIterator first, RandomAccessIterator last, const T& value)
+	{
+		return parallel::find_if(p, first, last, [&value](const typename merkol::iterator_traits<RandomAccessIterator>::value_type& x) {
+			return x == value;
+		});
+	}
+
+	template <typename RandomAccessIterator, typename T>
+	inline RandomAccessIterator find(RandomAccessIterator first, RandomAccessIterator last, const T& value)
+	{
+		return parallel::find(policy(), first, last, value);
+	}
+
+
+	// Bucket of value among the m sorted, distinct splitters of sort: 2i for the values between splitters
+	// i - 1 and i, 2i + 1 for the values equivalent to splitter i.
+	template <typename T, typename Compare>
+	inline std::size_t sample_bucket(const T* splitters, std::size_t m, const T& value, Compare& comp)
+	{
+		const std::size_t i = (std::size_t)(merkol::upper_bound(splitters, splitters + m, value, comp) - splitters);
+
+		return ((i > 0) && !comp(splitters[i - 1], value)) ? 2 * i - 1 : 2 * i;
+	}
+
+	// Sample sort of the n elements at from into to (n constructed elements), moved back to from if
+	// toBack. See sort.
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename Compare>
+	void sample_sort_impl(thread_pool& pool, RandomAccessIterator1 from, RandomAccessIterator2 to, std::size_t n, std::size_t grain,
+						  Compare& comp, bool toBack)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator1>::value_type value_type;
+
+		// Splitters: every kOversampling-th element of a sorted random sample, without repeats.
+		const std::size_t		wanted	= std::min(std::max(n / grain, (std::size_t)2), kMaxSortBuckets);
+		std::vector<value_type>	sample;
+		std::vector<value_type>	splitters;
+		uint64_t				seed	= (uint64_t)n * 0x9E3779B97F4A7C15ull + 1;
+
+		sample.reserve(wanted * kOversampling);
+		for (std::size_t i = 0; i < wanted * kOversampling; ++i)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			sample.push_back(from[(std::size_t)(seed % n)]);
+		}
+		merkol::sort(sample.begin(), sample.end(), comp);
+		for (std::size_t i = 1; i < wanted; ++i)
+		{
+			const value_type& splitter = sample[i * kOversampling];
+
+			if (splitters.empty() || comp(splitters.back(), splitter))
+				splitters.push_back(splitter);
+		}
+
+		const value_type* const	bounds	= splitters.empty() ? NULL : &splitters[0];
+		const std::size_t		m		= splitters.size();
+		const std::size_t		buckets	= 2 * m + 1;
+		const std::size_t		pieces	= std::min(pool.size() * kPiecesPerWorker, (n + kMinGrain - 1) / kMinGrain);
+		const std::size_t		piece	= (n + pieces - 1) / pieces;
+		const std::size_t		blocks	= (n + piece - 1) / piece;
+		std::vector<std::size_t>	counts(blocks * buckets, 0);
+		std::vector<std::size_t>	starts(buckets + 1);
+
+		// Count the buckets of every block, then turn the counts into the positions each block writes
+		// its elements of each bucket to, block after block within a bucket.
+		auto countBuckets = [&](std::size_t begin, std::size_t end) {
+			for (std::size_t b = begin; b < end; ++b)
+			{
+				std::size_t* const count = &counts[b * buckets];
+
+				for (std::size_t i = b * piece, stop = std::min(i + piece, n); i < stop; ++i)
+					++count[sample_bucket(bounds, m, from[i], comp)];
+			}
+		};
+
+		for_range_impl(pool, 0, blocks, 1, countBuckets);
+		for (std::size_t j = 0, sum = 0; j < buckets; ++j)
+		{
+			starts[j] = sum;
+			for (std::size_t b = 0; b < blocks; ++b)
+			{
+				const std::size_t c = counts[b * buckets + j];
+
+				counts[b * buckets + j] = sum;
+				sum += c;
+			}
+		}
+		starts[buckets] = n;
+
+		auto scatter = [&](std::size_t begin, std::size_t end) {
+			for (std::size_t b = begin; b < end; ++b)
+			{
+				std::size_t* const offset = &counts[b * buckets];
+
+				for (std::size_t i = b * piece, stop = std::min(i + piece, n); i < stop; ++i)
+					to[offset[sample_bucket(bounds, m, from[i], comp)]++] = MERKOL_MOVE(from[i]);
+			}
+		};
+
+		// The buckets of elements equivalent to a splitter are done.
+		auto sortBuckets = [&](std::size_t begin, std::size_t end) {
+			for (std::size_t j = begin; j < end; ++j)
+			{
+				if ((j % 2 == 0) && (starts[j + 1] - starts[j] > 1))
+					merkol::sort(to + starts[j], to + starts[j + 1], comp);
+			}
+		};
+		auto moveBack = [&](std::size_t begin, std::size_t end) { merkol::move(to + begin, to + end, from + begin); };
+
+		for_range_impl(pool, 0, blocks, 1, scatter);
+		for_range_impl(pool, 0, buckets, 1, sortBuckets);
+		if (toBack)
+			for_range_impl(pool, 0, n, grain, moveBack);
+	}
+
+	/// sort
+	///
+	/// Sorts [first, last) by comp (operator< by default), with a parallel sample sort. Not stable.
+	///
+	/// A random sample of the range gives up to kMaxSortBuckets - 1 splitters. Each block of the range
+	/// counts how many of its elements fall in every bucket between two splitters (a binary search), so
+	/// that every block knows where to move its elements; then all the blocks move their elements to
+	/// a buffer of n elements at the same time, every bucket is sorted with merkol::sort, in parallel,
+	/// and the buffer is moved back. Every element is moved twice and compared log2(buckets) times more
+	/// than by a sequential sort. Elements equivalent to a splitter get a bucket of their own, which
+	/// needs no sorting: a range of few distinct values is sorted by the move alone. The splitters and
+	/// the sample are copies, so value_type must be copy constructible.
+	template <typename RandomAccessIterator, typename Compare>
+	void sort(const policy& p, RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		const std::size_t n		= (std::size_t)(last - first);
+		const std::size_t grain	= p.get_grain(n, kSortGrain);
+
+		if (n <= grain)
+		{
+			merkol::sort(first, last, comp);
+			return;
+		}
+
+		thread_pool&					pool = p.get_pool();
+		merkol::sort_buffer<value_type>	buffer(first, n);
+
+		pool.run([&] {
+			if (buffer.holds_range())
+				sample_sort_impl(pool, buffer.data(), first, n, grain, comp, false);
+			else
+				sample_sort_impl(pool, first, buffer.data(), n, grain, comp, true);
+		});
+	}
+
+	template <typename RandomAccessIterator>
+	inline void sort(const policy& p, RandomAccessIterator first, RandomAccessIterator last)
+	{
+		parallel::sort(p, first, last, merkol::less<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+	template <typename RandomAccessIterator, typename Compare>
+	inline void sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		parallel::sort(policy(), first, last, comp);
+	}
+
+	template <typename RandomAccessIterator>
+	inline void sort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		parallel::sort(policy(), first, last, merkol::less<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+
+	// Moves the merge of the sorted ranges [first1, last1) and [first2, last2) to dest, which holds
+	// constructed elements. Stable. Big merges are cut at the middle of the longer range and the
+	// matching bound in the other one. Below 3 elements the longer range may have a single one, which
+	// the cut would leave whole on one side: such merges are never cut, whatever the grain.
+	template <typename InputIterator, typename OutputIterator, typename Compare>
+	void merge_impl(thread_pool& pool, InputIterator first1, InputIterator last1, InputIterator first2, InputIterator last2,
+					OutputIterator dest, std::size_t grain, Compare& comp)
+	{
+		const std::size_t n1 = (std::size_t)(last1 - first1);
+		const std::size_t n2 = (std::size_t)(last2 - first2);
+
+		if ((n1 + n2 <= grain) || (n1 + n2 <= 2))
+		{
+			merkol::move_merge(first1, last1, first2, last2, dest, comp);
+			return;
+		}
+
+		InputIterator middle1;
+		InputIterator middle2;
+
+		if (n1 >= n2)
+		{
+			middle1	= first1 + n1 / 2;
+			middle2	= merkol::lower_bound(first2, last2, *middle1, comp);
+		}
+		else
+		{
+			middle2	= first2 + n2 / 2;
+			middle1	= merkol::upper_bound(first1, last1, *middle2, comp);
+		}
+
+		OutputIterator middle = dest + (middle1 - first1) + (middle2 - first2);
+
+		pool.invoke([&] { merge_impl(pool, first1, middle1, first2, middle2, dest, grain, comp); },
+					[&] { merge_impl(pool, middle1, last1, middle2, last2, middle, grain, comp); });
+	}
+
+	// Sorts the n elements at first, leaving them at first, or at other if toOther. other holds n
+	// constructed elements. The two halves are sorted into the other array, then merged back.
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename Compare>
+	void stable_sort_impl(thread_pool& pool, RandomAccessIterator1 first, RandomAccessIterator2 other, std::size_t n, std::size_t grain,
+						  Compare& comp, bool toOther)
+	{
+		if (n <= grain)
+		{
+			merkol::stable_sort(first, first + n, comp);
+			if (toOther)
+				merkol::move(first, first + n, other);
+			return;
+		}
+
+		const std::size_t half = n / 2;
+
+		pool.invoke([&] { stable_sort_impl(pool, first, other, half, grain, comp, !toOther); },
+					[&] { stable_sort_impl(pool, first + half, other + half, n - half, grain, comp, !toOther); });
+		if (toOther)
+			merge_impl(pool, first, first + half, first + half, first + n, other, grain, comp);
+		else
+			merge_impl(pool, other, other + half, other + half, other + n, first, grain, comp);
+	}
+
+	/// stable_sort
+	///
+	/// Sorts [first, last) by comp (operator< by default), keeping the order of equivalent elements, with
+	/// a parallel merge sort: the pieces are sorted with merkol::stable_sort, then merged pairwise into a
+	/// buffer of n elements and back, each merge split in parallel at a binary search. Every element is
+	/// moved log2(n / grain) times.
+	template <typename RandomAccessIterator, typename Compare>
+	void stable_sort(const policy& p, RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		const std::size_t n		= (std::size_t)(last - first);
+		const std::size_t grain	= p.get_grain(n, kSortGrain);
+
+		if (n <= grain)
+		{
+			merkol::stable_sort(first, last, comp);
+			return;
+		}
+
+		thread_pool&					pool = p.get_pool();
+		merkol::sort_buffer<value_type>	buffer(first, n);
+
+		pool.run([&] {
+			if (buffer.holds_range())
+				stable_sort_impl(pool, buffer.data(), first, n, grain, comp, true);
+			else
+				stable_sort_impl(pool, first, buffer.data(), n, grain, comp, false);
+		});
+	}
+
+	template <typename RandomAccessIterator>
+	inline void stable_sort(const policy& p, RandomAccessIterator first, RandomAccessIterator last)
+	{
+		parallel::stable_sort(p, first, last, merkol::less<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+	template <typename RandomAccessIterator, typename Compare>
+	inline void stable_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		parallel::stable_sort(policy(), first, last, comp);
+	}
+
+	template <typename RandomAccessIterator>
+	inline void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		parallel::stable_sort(policy(), first, last, merkol::less<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+} // namespace parallel
+} // namespace merkol
+
+#endif // MERKOL_PARALLEL_ALGORITHM_HPP
@@ -0,0 +1,428 @@
+#ifndef SIMD_HPP
+# define SIMD_HPP
+
+#include <cstddef>
+#include <cstring>
+
+/*
+	Mismatch kernels
+
+	Each kernel returns the index of the first position at which two arrays of n elements differ, or n.
+	merkol::equal and merkol::lexicographical_compare (algorithm.hpp) use them for contiguous ranges of
+	scalars, so they run at memory bandwidth instead of one iterator step per element.
+
+		mismatch_bytes(a, b, n)		first byte that differs. Enough for every type whose == is a bitwise
+									comparison (integers, enums, pointers): divide by sizeof(T).
+		mismatch_equal(a, b, n)		float/double: first i with !(a[i] == b[i]). NaN never compares equal,
+									-0.0 equals +0.0, so this can not be done on bytes.
+		mismatch_ordered(a, b, n)	float/double: first i with a[i] < b[i] || b[i] < a[i]. This is what
+									lexicographical_compare needs: it skips pairs involving a NaN.
+
+	Group kernels
+
+	Compare 16 consecutive signed bytes against one value and return a 16 bit mask, bit i set for byte i.
+	flat_hash_map uses them to probe 16 control bytes at once.
+
+		group_match_eq(g, b)		g[i] == b
+		group_match_lt(g, b)		g[i] < b
+
+	Count kernel
+
+		count_less(keys, n, key)	number of keys[i] < key, for 32 and 64 bit integers. On a sorted
+									array that is the lower bound of key: btree nodes are searched this
+									way, every key compared, no branch depending on the data.
+
+	On x86 the SSE2 version is the baseline (SSE2 is part of x86-64) and the AVX2 version is selected at
+	run time with __builtin_cpu_supports, so the binary does not have to be built with -mavx2. Other
+	targets get a scalar version, which compares 8 bytes at a time in mismatch_bytes.
+*/
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+# define MERKOL_SIMD_X86 1
+# include <immintrin.h>
+#else
+# define MERKOL_SIMD_X86 0
+#endif
+
+namespace merkol
+{
+namespace simd
+{
+	///////////////////////////////////////////////////////////////////////
+	// scalar															///
+	///////////////////////////////////////////////////////////////////////
+
+	inline std::size_t mismatch_bytes_scalar(const unsigned char* a, const unsigned char* b, std::size_t n)
+	{
+		std::size_t i = 0;
+
+		for (; i + sizeof(unsigned long long) <= n; i += sizeof(unsigned long long))
+		{
+			unsigned long long x, y;
+
+			std::memcpy(&x, a + i, sizeof(x));
+			std::memcpy(&y, b + i, sizeof(y));
+			if (x != y)
+				break;
+		}
+		for (; i < n; ++i)
+		{
+			if (a[i] != b[i])
+				break;
+		}
+		return i;
+	}
+
+	template <bool Ordered, typename T>
+	inline std::size_t mismatch_float_scalar(const T* a, const T* b, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			if (Ordered ? (a[i] < b[i] || b[i] < a[i]) : !(a[i] == b[i]))
+				return i;
+		}
+		return n;
+	}
+
+	inline unsigned group_match_eq_scalar(const signed char* g, signed char b)
+	{
+		unsigned mask = 0;
+
+		for (unsigned i = 0; i < 16; ++i)
+			mask |= (unsigned)(g[i] == b) << i;
+		return mask;
+	}
+
+	inline unsigned group_match_lt_scalar(const signed char* g, signed char b)
+	{
+		unsigned mask = 0;
+
+		for (unsigned i = 0; i < 16; ++i)
+			mask |= (unsigned)(g[i] < b) << i;
+		return mask;
+	}
+
+	template <typename T>
+	inline std::size_t count_less_scalar(const T* keys, std::size_t n, T key)
+	{
+		std::size_t count = 0;
+
+		for (std::size_t i = 0; i < n; ++i)
+			count += (keys[i] < key) ? 1 : 0;
+		return count;
+	}
+
+#if MERKOL_SIMD_X86
+	///////////////////////////////////////////////////////////////////////
+	// SSE2																///
+	///////////////////////////////////////////////////////////////////////
+
+	inline std::size_t mismatch_bytes_sse2(const unsigned char* a, const unsigned char* b, std::size_t n)
+	{
+		std::size_t i = 0;
+
+		for (; i + 16 <= n; i += 16)
+		{
+			const __m128i	x		= _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+			const __m128i	y		= _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+			const unsigned	diff	= (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xFFFFu;
+
+			if (diff)
+				return i + (std::size_t)__builtin_ctz(diff);
+		}
+		return i + mismatch_bytes_scalar(a + i, b + i, n - i);
+	}
+
+	template <bool Ordered>
+	inline std::size_t mismatch_float_sse2(const float* a, const float* b, std::size_t n)
+	{
+		std::size_t i = 0;
+
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128	x	= _mm_loadu_ps(a + i);
+			const __m128	y	= _mm_loadu_ps(b + i);
+			__m128			ne	= _mm_cmpneq_ps(x, y); // true for NaN
+			if (Ordered)
+				ne = _mm_and_ps(ne, _mm_cmpord_ps(x, y));
+
+			const int		diff = _mm_movemask_ps(ne);
+			if (diff)
+				return i + (std::size_t)__builtin_ctz((unsigned)diff);
+		}
+		return i + mismatch_float_scalar<Ordered>(a + i, b + i, n - i);
+	}
+
+	template <bool Ordered>
+	inline std::size_t mismatch_float_sse2(const double* a, const double* b, std::size_t n)
+	{
+		std::size_t i = 0;
+
+		for (; i + 2 <= n; i += 2)
+		{
+			const __m128d	x	= _mm_loadu_pd(a + i);
+			const __m128d	y	= _mm_loadu_pd(b + i);
+			__m128d			ne	= _mm_cmpneq_pd(x, y);
+			if (Ordered)
+				ne = _mm_and_pd(ne, _mm_cmpord_pd(x, y));
+
+			const int		diff = _mm_movemask_pd(ne);
+			if (diff)
+				return i + (std::size_t)__builtin_ctz((unsigned)diff);
+		}
+		return i + mismatch_float_scalar<Ordered>(a + i, b + i, n - i);
+	}
+
+	// A group is 16 bytes, one SSE2 register: there is nothing to gain from AVX2.
+	inline unsigned group_match_eq_sse2(const signed char* g, signed char b)
+	{
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g));
+
+		return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(b)));
+	}
+
+	inline unsigned group_match_lt_sse2(const signed char* g, signed char b)
+	{
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(g));
+
+		return (unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(bytes, _mm_set1_epi8(b)));
+	}
+
+	// The vector compares are signed: unsigned keys are biased by the sign bit first, which maps their
+	// order onto the signed one.
+	template <typename T>
+	inline std::size_t count_less32_sse2(const T* keys, std::size_t n, T key)
+	{
+		const int		bias	= (T(-1) < T(0)) ? 0 : static_cast<int>(0x80000000u);
+		const __m128i	vbias	= _mm_set1_epi32(bias);
+		const __m128i	vkey	= _mm_set1_epi32(static_cast<int>(key) ^ bias);
+		std::size_t		count	= 0;
+		std::size_t		i		= 0;
+
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), vbias);
+
+			count += (std::size_t)__builtin_popcount((unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(vkey, v))));
+		}
+		return count + count_less_scalar(keys + i, n - i, key);
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// AVX2																///
+	///////////////////////////////////////////////////////////////////////
+
+	// Two vectors per iteration: the loads of the second one are in flight while the first is compared.
+	__attribute__((target("avx2")))
+	inline std::size_t mismatch_bytes_avx2(const unsigned char* a, const unsigned char* b, std::size_t n)
+	{
+		std::size_t i = 0;
+
+		for (; i + 64 <= n; i += 64)
+		{
+			const __m256i eq0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+												  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+			const __m256i eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 32)),
+												  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 32)));
+
+			if ((unsigned)_mm256_movemask_epi8(_mm256_and_si256(eq0, eq1)) != 0xFFFFFFFFu)
+			{
+				const unsigned diff0 = ~(unsigned)_mm256_movemask_epi8(eq0);
+
+				if (diff0)
+					return i + (std::size_t)__builtin_ctz(diff0);
+				return i + 32 + (std::size_t)__builtin_ctz(~(unsigned)_mm256_movemask_epi8(eq1));
+			}
+		}
+		for (; i + 32 <= n; i += 32)
+		{
+			const __m256i	eq		= _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+														_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+			const unsigned	diff	= ~(unsigned)_mm256_movemask_epi8(eq);
+
+			if (diff)
+				return i + (std::size_t)__builtin_ctz(diff);
+		}
+		return i + mismatch_bytes_sse2(a + i, b + i, n - i);
+	}
+
+	template <bool Ordered>
+	__attribute__((target("avx2")))
+	inline std::size_t mismatch_float_avx2(const float* a, const float* b, std::size_t n)
+	{
+		std::size_t i = 0;
+
+		for (; i + 8 <= n; i += 8)
+		{
+			const __m256	ne		= _mm256_cmp_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), Ordered ? _CMP_NEQ_OQ : _CMP_NEQ_UQ);
+			const int		diff	= _mm256_movemask_ps(ne);
+
+			if (diff)
+				return i + (std::size_t)__builtin_ctz((unsigned)diff);
+		}
+		return i + mismatch_float_sse2<Ordered>(a + i, b + i, n - i);
+	}
+
+	template <bool Ordered>
+	__attribute__((target("avx2")))
+	inline std::size_t mismatch_float_avx2(const double* a, const double* b, std::size_t n)
+	{
+		std::size_t i = 0;
+
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m256d	ne		= _mm256_cmp_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), Ordered ? _CMP_NEQ_OQ : _CMP_NEQ_UQ);
+			const int		diff	= _mm256_movemask_pd(ne);
+
+			if (diff)
+				return i + (std::size_t)__builtin_ctz((unsigned)diff);
+		}
+		return i + mismatch_float_sse2<Ordered>(a + i, b + i, n - i);
+	}
+
+	template <typename T>
+	__attribute__((target("avx2")))
+	inline std::size_t count_less32_avx2(const T* keys, std::size_t n, T key)
+	{
+		const int		bias	= (T(-1) < T(0)) ? 0 : static_cast<int>(0x80000000u);
+		const __m256i	vbias	= _mm256_set1_epi32(bias);
+		const __m256i	vkey	= _mm256_set1_epi32(static_cast<int>(key) ^ bias);
+		std::size_t		count	= 0;
+		std::size_t		i		= 0;
+
+		for (; i + 8 <= n; i += 8)
+		{
+			const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), vbias);
+
+			count += (std::size_t)__builtin_popcount((unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vkey, v))));
+		}
+		return count + count_less_scalar(keys + i, n - i, key);
+	}
+
+	// SSE2 has no 64 bit compare (it came with SSE4.2): 64 bit keys are AVX2 or scalar.
+	template <typename T>
+	__attribute__((target("avx2")))
+	inline std::size_t count_less64_avx2(const T* keys, std::size_t n, T key)
+	{
+		const long long	bias	= (T(-1) < T(0)) ? 0 : static_cast<long long>(0x8000000000000000ull);
+		const __m256i	vbias	= _mm256_set1_epi64x(bias);
+		const __m256i	vkey	= _mm256_set1_epi64x(static_cast<long long>(key) ^ bias);
+		std::size_t		count	= 0;
+		std::size_t		i		= 0;
+
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), vbias);
+
+			count += (std::size_t)__builtin_popcount((unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(vkey, v))));
+		}
+		return count + count_less_scalar(keys + i, n - i, key);
+	}
+
+	// Checked once per process.
+	inline bool has_avx2()
+	{
+		static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+
+		return hasAvx2;
+	}
+#endif // MERKOL_SIMD_X86
+
+	///////////////////////////////////////////////////////////////////////
+	// dispatch															///
+	///////////////////////////////////////////////////////////////////////
+
+	inline std::size_t mismatch_bytes(const void* a, const void* b, std::size_t n)
+	{
+		const unsigned char* const pa = static_cast<const unsigned char*>(a);
+		const unsigned char* const pb = static_cast<const unsigned char*>(b);
+
+	#if MERKOL_SIMD_X86
+		if (has_avx2())
+			return mismatch_bytes_avx2(pa, pb, n);
+		return mismatch_bytes_sse2(pa, pb, n);
+	#else
+		return mismatch_bytes_scalar(pa, pb, n);
+	#endif
+	}
+
+	template <bool Ordered, typename T>
+	inline std::size_t mismatch_float(const T* a, const T* b, std::size_t n)
+	{
+	#if MERKOL_SIMD_X86
+		if (has_avx2())
+			return mismatch_float_avx2<Ordered>(a, b, n);
+		return mismatch_float_sse2<Ordered>(a, b, n);
+	#else
+		return mismatch_float_scalar<Ordered>(a, b, n);
+	#endif
+	}
+
+	inline unsigned group_match_eq(const signed char* g, signed char b)
+	{
+	#if MERKOL_SIMD_X86
+		return group_match_eq_sse2(g, b);
+	#else
+		return group_match_eq_scalar(g, b);
+	#endif
+	}
+
+	inline unsigned group_match_lt(const signed char* g, signed char b)
+	{
+	#if MERKOL_SIMD_X86
+		return group_match_lt_sse2(g, b);
+	#else
+		return group_match_lt_scalar(g, b);
+	#endif
+	}
+
+	// By key size: the kernels only know 32 and 64 bit integers.
+	template <std::size_t KeySize>
+	struct count_less_dispatch
+	{
+		template <typename T>
+		static std::size_t run(const T* keys, std::size_t n, T key) { return count_less_scalar(keys, n, key); }
+	};
+
+#if MERKOL_SIMD_X86
+	template <>
+	struct count_less_dispatch<4>
+	{
+		template <typename T>
+		static std::size_t run(const T* keys, std::size_t n, T key)
+		{
+			if (has_avx2())
+				return count_less32_avx2(keys, n, key);
+			return count_less32_sse2(keys, n, key);
+		}
+	};
+
+	template <>
+	struct count_less_dispatch<8>
+	{
+		template <typename T>
+		static std::size_t run(const T* keys, std::size_t n, T key)
+		{
+			if (has_avx2())
+				return count_less64_avx2(keys, n, key);
+			return count_less_scalar(keys, n, key);
+		}
+	};
+#endif
+
+	// T is an integer type.
+	template <typename T>
+	inline std::size_t count_less(const T* keys, std::size_t n, T key)
+	{
+		return count_less_dispatch<sizeof(T)>::run(keys, n, key);
+	}
+
+	inline std::size_t mismatch_equal(const float* a, const float* b, std::size_t n)		{ return mismatch_float<false>(a, b, n); }
+	inline std::size_t mismatch_equal(const double* a, const double* b, std::size_t n)		{ return mismatch_float<false>(a, b, n); }
+	inline std::size_t mismatch_ordered(const float* a, const float* b, std::size_t n)		{ return mismatch_float<true>(a, b, n); }
+	inline std::size_t mismatch_ordered(const double* a, const double* b, std::size_t n)	{ return mismatch_float<true>(a, b, n); }
+
+} // namespace simd
+} // namespace merkol
+
+#endif // SIMD_HPP
@@ -0,0 +1,959 @@
+#ifndef MERKOL_SORT_HPP
+# define MERKOL_SORT_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "algorithm.hpp"
+#include "functional.hpp"
+#include "type_traits.hpp"
+#include "../iterators/iterator.hpp"
+#include "../iterators/iterator_traits.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	sort, sort_branchless, stable_sort, radix_sort
+
+	sort is pattern-defeating quicksort (O. Peters, "Pattern-defeating Quicksort"): introsort with
+		- a median of 3 pivot, or the median of 3 medians of 3 (a pseudo ninther) above 128 elements;
+		- insertion sort below 24 elements, unguarded (no bounds check) right of the first partition, as
+		  the previous pivot stops it;
+		- partition_left when the pivot equals the previous one: all the elements equal to it go left and
+		  are done, so ranges of few distinct values take linear time;
+		- a partial insertion sort, given up after 8 moves, when a partition swapped nothing: sorted,
+		  reversed and almost sorted inputs take linear time;
+		- a few swaps that break the pattern when a partition is very unbalanced, and heapsort after
+		  log2(n) of them, so the worst case is O(n log n).
+	For arithmetic types with the default comparison (and always with sort_branchless) the partition is
+	the branchless block partition of BlockQuicksort (S. Edelkamp and A. Weiss): 64 elements at a time,
+	the comparisons write offsets into a small buffer (offsets[num] = i; num += !comp(x, pivot)) and
+	the misplaced elements are swapped afterwards. The comparison result is never branched on, so there
+	is no misprediction on random data; it is about twice as fast as a branching partition for integers
+	and doubles. For elements with an expensive comparison the branching partition is used.
+
+	stable_sort is a bottom-up merge sort: insertion sort on runs of 32 elements, then merge passes
+	between the range and a buffer of n elements. A merge of two runs that are already in order is a
+	plain move.
+
+	radix_sort is a stable least significant digit radix sort of integers, floats and doubles, or of any
+	elements by an integral or floating point key (radix_sort(first, last, key) with key(element)). Keys
+	are mapped to unsigned integers that compare in the same order (sign bit flipped for signed integers,
+	all bits flipped for negative floats: -0.0 sorts before 0.0 and NaNs sort at the ends by sign). One
+	read of the range builds the histograms of all digits; a digit that has the same value in every key
+	has nothing to sort and its pass is skipped (e.g. the high digits of small 64 bit values, or every
+	digit of a sorted run of equal keys). The digit width is 8, 11 or 16 bits, chosen from the key size
+	and n, or given as radix_sort<Bits>(...): 16 bit digits make half as many passes as 8 bit digits but
+	need 64K counters per digit and scatter to 64K places, which only pays off for large arrays.
+
+	stable_sort and radix_sort need a buffer of n elements, taken from std::allocator. Elements are
+	moved, and must be move assignable; the order of equivalent elements is kept.
+
+	Parallel versions are in parallel_algorithm.hpp.
+*/
+
+namespace merkol
+{
+	static const std::ptrdiff_t kInsertionSortThreshold	= 24;	// below this many elements, insertion sort
+	static const std::ptrdiff_t kNintherThreshold		= 128;	// above this many, the pivot is a pseudo ninther
+	static const std::size_t	kPartialInsertionLimit	= 8;	// moves before a partial insertion sort gives up
+	static const std::size_t	kPartitionBlock			= 64;	// elements per block of the branchless partition
+	static const std::ptrdiff_t kStableSortRun			= 32;	// runs insertion sorted by stable_sort
+	static const std::size_t	kRadixSortMin			= 256;	// below this many elements radix_sort merge sorts
+
+	/// sort_buffer
+	///
+	/// Scratch array of n constructed elements for the merge and radix sorts. Trivially copyable types
+	/// use the raw memory as is. Other types are moved in from the range, whose elements are then moved
+	/// from but alive: the sort starts from the buffer (holds_range()) and ends in the range.
+	template <typename T>
+	class sort_buffer
+	{
+	public:
+		template <typename RandomAccessIterator>
+		sort_buffer(RandomAccessIterator first, std::size_t n) : mpData(mAllocator.allocate(n)), mnSize(n)
+		{
+			if (holds_range())
+			{
+				try
+				{
+					merkol::uninitialized_move(first, first + n, mpData);
+				}
+				catch (...)
+				{
+					mAllocator.deallocate(mpData, n);
+					throw;
+				}
+			}
+		}
+
+		~sort_buffer()
+		{
+			merkol::destruct(mpData, mpData + mnSize);
+			mAllocator.deallocate(mpData, mnSize);
+		}
+
+		static bool	holds_range() { return !merkol::is_trivially_copyable<T>::value; }
+		T*			data() const { return mpData; }
+
+	private:
+		sort_buffer(const sort_buffer&);
+		sort_buffer& operator=(const sort_buffer&);
+
+		std::allocator<T>	mAllocator;
+		T*					mpData;
+		std::size_t			mnSize;
+	};
+
+	/// move_merge
+	///
+	/// Moves the merge of the sorted ranges [first1, last1) and [first2, last2) to dest, whose elements
+	/// are assigned to. Stable: of equivalent elements, those of the first range come first.
+	template <typename InputIterator1, typename InputIterator2, typename OutputIterator, typename Compare>
+	inline OutputIterator move_merge(InputIterator1 first1, InputIterator1 last1, InputIterator2 first2, InputIterator2 last2,
+									 OutputIterator dest, Compare& comp)
+	{
+		while ((first1 != last1) && (first2 != last2))
+		{
+			if (comp(*first2, *first1))
+			{
+				*dest = MERKOL_MOVE(*first2);
+				++first2;
+			}
+			else
+			{
+				*dest = MERKOL_MOVE(*first1);
+				++first1;
+			}
+			++dest;
+		}
+		dest = merkol::move(first1, last1, dest);
+		return merkol::move(first2, last2, dest);
+	}
+
+	// Comparisons for which sort uses the branchless partition on arithmetic types.
+	template <typename Compare, typename T>
+	struct is_default_compare : merkol::false_type {};
+
+	template <typename T>
+	struct is_default_compare<merkol::less<T>, T> : merkol::true_type {};
+
+	template <typename T>
+	struct is_default_compare<std::less<T>, T> : merkol::true_type {};
+
+	template <typename T>
+	struct is_default_compare<std::greater<T>, T> : merkol::true_type {};
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Pdqsort.imp.begin();												///
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename RandomAccessIterator, typename Compare>
+	inline void insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		if (first == last)
+			return;
+		for (RandomAccessIterator i = first + 1; i != last; ++i)
+		{
+			RandomAccessIterator hole = i;
+			RandomAccessIterator prev = i - 1;
+
+			if (comp(*hole, *prev))
+			{
+				value_type value(MERKOL_MOVE(*hole));
+
+				do
+				{
+					*hole = MERKOL_MOVE(*prev);
+					--hole;
+				} while ((hole != first) && comp(value, *--prev));
+				*hole = MERKOL_MOVE(value);
+			}
+		}
+	}
+
+	// Insertion sort for a range that has an element not greater than all of its own right before it.
+	template <typename RandomAccessIterator, typename Compare>
+	inline void unguarded_insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		if (first == last)
+			return;
+		for (RandomAccessIterator i = first + 1; i != last; ++i)
+		{
+			RandomAccessIterator hole = i;
+			RandomAccessIterator prev = i - 1;
+
+			if (comp(*hole, *prev))
+			{
+				value_type value(MERKOL_MOVE(*hole));
+
+				do
+				{
+					*hole = MERKOL_MOVE(*prev);
+					--hole;
+				} while (comp(value, *--prev));
+				*hole = MERKOL_MOVE(value);
+			}
+		}
+	}
+
+	// Insertion sort that gives up (returns false) after kPartialInsertionLimit element moves.
+	template <typename RandomAccessIterator, typename Compare>
+	inline bool partial_insertion_sort(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		std::size_t moves = 0;
+
+		if (first == last)
+			return true;
+		for (RandomAccessIterator i = first + 1; i != last; ++i)
+		{
+			RandomAccessIterator hole = i;
+			RandomAccessIterator prev = i - 1;
+
+			if (comp(*hole, *prev))
+			{
+				value_type value(MERKOL_MOVE(*hole));
+
+				do
+				{
+					*hole = MERKOL_MOVE(*prev);
+					--hole;
+				} while ((hole != first) && comp(value, *--prev));
+				*hole = MERKOL_MOVE(value);
+				moves += (std::size_t)(i - hole);
+			}
+			if (moves > kPartialInsertionLimit)
+				return false;
+		}
+		return true;
+	}
+
+	template <typename RandomAccessIterator, typename Compare>
+	inline void sort2(RandomAccessIterator a, RandomAccessIterator b, Compare& comp)
+	{
+		if (comp(*b, *a))
+			std::iter_swap(a, b);
+	}
+
+	template <typename RandomAccessIterator, typename Compare>
+	inline void sort3(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator c, Compare& comp)
+	{
+		merkol::sort2(a, b, comp);
+		merkol::sort2(b, c, comp);
+		merkol::sort2(a, b, comp);
+	}
+
+	// Swaps first[left[i]] with last[-right[i]] for i < n. When the two lists have the same length the
+	// elements are swapped in pairs; otherwise they are rotated along a cycle, with fewer moves.
+	template <typename RandomAccessIterator>
+	inline void swap_offsets(RandomAccessIterator first, RandomAccessIterator last, const unsigned char* left,
+							 const unsigned char* right, std::size_t n, bool pairs)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		if (pairs)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				std::iter_swap(first + left[i], last - right[i]);
+		}
+		else if (n > 0)
+		{
+			RandomAccessIterator	l = first + left[0];
+			RandomAccessIterator	r = last - right[0];
+			value_type				value(MERKOL_MOVE(*l));
+
+			*l = MERKOL_MOVE(*r);
+			for (std::size_t i = 1; i < n; ++i)
+			{
+				l = first + left[i];
+				*r = MERKOL_MOVE(*l);
+				r = last - right[i];
+				*l = MERKOL_MOVE(*r);
+			}
+			*r = MERKOL_MOVE(value);
+		}
+	}
+
+	// Partitions [first, last) around *first: the elements less than it to its left, the others to its
+	// right. Returns the position of the pivot, and whether nothing had to be swapped. Needs an element
+	// not less than the pivot after the range, or the median of 3 in place (which guarantees one inside).
+	template <typename RandomAccessIterator, typename Compare>
+	std::pair<RandomAccessIterator, bool> partition_right(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		value_type				pivot(MERKOL_MOVE(*first));
+		RandomAccessIterator	l = first;
+		RandomAccessIterator	r = last;
+
+		while (comp(*++l, pivot))
+			;
+		if (l - 1 == first)
+		{
+			while ((l < r) && !comp(*--r, pivot))
+				;
+		}
+		else
+		{
+			while (!comp(*--r, pivot))
+				;
+		}
+
+		const bool partitioned = (l >= r);
+
+		while (l < r)
+		{
+			std::iter_swap(l, r);
+			while (comp(*++l, pivot))
+				;
+			while (!comp(*--r, pivot))
+				;
+		}
+
+		RandomAccessIterator pivotPos = l - 1;
+
+		*first = MERKOL_MOVE(*pivotPos);
+		*pivotPos = MERKOL_MOVE(pivot);
+		return std::make_pair(pivotPos, partitioned);
+	}
+
+	// partition_right without a branch on the comparisons (see above).
+	template <typename RandomAccessIterator, typename Compare>
+	std::pair<RandomAccessIterator, bool> partition_right_branchless(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		value_type				pivot(MERKOL_MOVE(*first));
+		RandomAccessIterator	l = first;
+		RandomAccessIterator	r = last;
+
+		while (comp(*++l, pivot))
+			;
+		if (l - 1 == first)
+		{
+			while ((l < r) && !comp(*--r, pivot))
+				;
+		}
+		else
+		{
+			while (!comp(*--r, pivot))
+				;
+		}
+
+		const bool partitioned = (l >= r);
+
+		if (!partitioned)
+		{
+			std::iter_swap(l, r);
+			++l;
+
+			// Offsets of the misplaced elements of the current left and right blocks, counted from
+			// leftBase forwards and from rightBase backwards.
+			unsigned char			leftOffsets[kPartitionBlock];
+			unsigned char			rightOffsets[kPartitionBlock];
+			RandomAccessIterator	leftBase	= l;
+			RandomAccessIterator	rightBase	= r;
+			std::size_t				numLeft		= 0;
+			std::size_t				numRight	= 0;
+			std::size_t				startLeft	= 0;
+			std::size_t				startRight	= 0;
+
+			while (l < r)
+			{
+				// Fill the blocks that are empty, splitting what is left when both are.
+				const std::size_t unknown		= (std::size_t)(r - l);
+				const std::size_t leftSplit		= (numLeft == 0) ? ((numRight == 0) ? unknown / 2 : unknown) : 0;
+				const std::size_t rightSplit	= (numRight == 0) ? (unknown - leftSplit) : 0;
+				const std::size_t leftCount		= (leftSplit < kPartitionBlock) ? leftSplit : kPartitionBlock;
+				const std::size_t rightCount	= (rightSplit < kPartitionBlock) ? rightSplit : kPartitionBlock;
+
+				for (std::size_t i = 0; i < leftCount; ++i)
+				{
+					leftOffsets[numLeft] = (unsigned char)i;
+					numLeft += !comp(*l, pivot);
+					++l;
+				}
+				for (std::size_t i = 0; i < rightCount; )
+				{
+					rightOffsets[numRight] = (unsigned char)++i;
+					numRight += comp(*--r, pivot);
+				}
+
+				const std::size_t n = (numLeft < numRight) ? numLeft : numRight;
+
+				merkol::swap_offsets(leftBase, rightBase, leftOffsets + startLeft, rightOffsets + startRight, n, numLeft == numRight);
+				numLeft		-= n;
+				numRight	-= n;
+				startLeft	+= n;
+				startRight	+= n;
+				if (numLeft == 0)
+				{
+					startLeft	= 0;
+					leftBase	= l;
+				}
+				if (numRight == 0)
+				{
+					startRight	= 0;
+					rightBase	= r;
+				}
+			}
+
+			// One block may still hold misplaced elements: move them to the boundary.
+			if (numLeft)
+			{
+				while (numLeft--)
+					std::iter_swap(leftBase + leftOffsets[startLeft + numLeft], --r);
+				l = r;
+			}
+			if (numRight)
+			{
+				while (numRight--)
+				{
+					std::iter_swap(rightBase - rightOffsets[startRight + numRight], l);
+					++l;
+				}
+			}
+		}
+
+		RandomAccessIterator pivotPos = l - 1;
+
+		*first = MERKOL_MOVE(*pivotPos);
+		*pivotPos = MERKOL_MOVE(pivot);
+		return std::make_pair(pivotPos, partitioned);
+	}
+
+	// Partitions [first, last) around *first with the elements equal to it on the left. Used when the
+	// pivot equals the element before the range (the previous pivot): the left part is then all equal
+	// to it, sorted. Returns the position of the pivot.
+	template <typename RandomAccessIterator, typename Compare>
+	RandomAccessIterator partition_left(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		value_type				pivot(MERKOL_MOVE(*first));
+		RandomAccessIterator	l = first;
+		RandomAccessIterator	r = last;
+
+		while (comp(pivot, *--r))
+			;
+		if (r + 1 == last)
+		{
+			while ((l < r) && !comp(pivot, *++l))
+				;
+		}
+		else
+		{
+			while (!comp(pivot, *++l))
+				;
+		}
+		while (l < r)
+		{
+			std::iter_swap(l, r);
+			while (comp(pivot, *--r))
+				;
+			while (!comp(pivot, *++l))
+				;
+		}
+		*first = MERKOL_MOVE(*r);
+		*r = MERKOL_MOVE(pivot);
+		return r;
+	}
+
+	// Swaps a few elements of a badly partitioned side with others a quarter of the way in, so that the
+	// next pivots are not chosen from the same pattern again.
+	template <typename RandomAccessIterator>
+	inline void break_patterns(RandomAccessIterator first, RandomAccessIterator pivotPos, RandomAccessIterator last)
+	{
+		const std::ptrdiff_t left	= pivotPos - first;
+		const std::ptrdiff_t right	= last - (pivotPos + 1);
+
+		if (left >= kInsertionSortThreshold)
+		{
+			std::iter_swap(first, first + left / 4);
+			std::iter_swap(pivotPos - 1, pivotPos - left / 4);
+			if (left > kNintherThreshold)
+			{
+				std::iter_swap(first + 1, first + (left / 4 + 1));
+				std::iter_swap(first + 2, first + (left / 4 + 2));
+				std::iter_swap(pivotPos - 2, pivotPos - (left / 4 + 1));
+				std::iter_swap(pivotPos - 3, pivotPos - (left / 4 + 2));
+			}
+		}
+		if (right >= kInsertionSortThreshold)
+		{
+			std::iter_swap(pivotPos + 1, pivotPos + (1 + right / 4));
+			std::iter_swap(last - 1, last - right / 4);
+			if (right > kNintherThreshold)
+			{
+				std::iter_swap(pivotPos + 2, pivotPos + (2 + right / 4));
+				std::iter_swap(pivotPos + 3, pivotPos + (3 + right / 4));
+				std::iter_swap(last - 2, last - (1 + right / 4));
+				std::iter_swap(last - 3, last - (2 + right / 4));
+			}
+		}
+	}
+
+	template <typename RandomAccessIterator, typename Compare, bool Branchless>
+	void pdqsort_loop(RandomAccessIterator first, RandomAccessIterator last, Compare& comp, int badAllowed, bool leftmost,
+					  merkol::integral_constant<bool, Branchless> branchless)
+	{
+		for (;;)
+		{
+			const std::ptrdiff_t size = last - first;
+
+			if (size < kInsertionSortThreshold)
+			{
+				if (leftmost)
+					merkol::insertion_sort(first, last, comp);
+				else
+					merkol::unguarded_insertion_sort(first, last, comp);
+				return;
+			}
+
+			// The pivot goes to *first.
+			const std::ptrdiff_t half = size / 2;
+
+			if (size > kNintherThreshold)
+			{
+				merkol::sort3(first, first + half, last - 1, comp);
+				merkol::sort3(first + 1, first + (half - 1), last - 2, comp);
+				merkol::sort3(first + 2, first + (half + 1), last - 3, comp);
+				merkol::sort3(first + (half - 1), first + half, first + (half + 1), comp);
+				std::iter_swap(first, first + half);
+			}
+			else
+				merkol::sort3(first + half, first, last - 1, comp);
+
+			// Equal to the previous pivot: everything equal to it is in place.
+			if (!leftmost && !comp(*(first - 1), *first))
+			{
+				first = merkol::partition_left(first, last, comp) + 1;
+				continue;
+			}
+
+			const std::pair<RandomAccessIterator, bool> result = Branchless
+				? merkol::partition_right_branchless(first, last, comp) : merkol::partition_right(first, last, comp);
+			const RandomAccessIterator	pivotPos	= result.first;
+			const std::ptrdiff_t		leftSize	= pivotPos - first;
+			const std::ptrdiff_t		rightSize	= last - (pivotPos + 1);
+
+			if ((leftSize < size / 8) || (rightSize < size / 8))
+			{
+				if (--badAllowed == 0)
+				{
+					std::make_heap(first, last, comp);
+					std::sort_heap(first, last, comp);
+					return;
+				}
+				merkol::break_patterns(first, pivotPos, last);
+			}
+			else if (result.second && merkol::partial_insertion_sort(first, pivotPos, comp)
+					 && merkol::partial_insertion_sort(pivotPos + 1, last, comp))
+				return;
+
+			// Recurse into the left part, loop on the right one.
+			merkol::pdqsort_loop(first, pivotPos, comp, badAllowed, leftmost, branchless);
+			first		= pivotPos + 1;
+			leftmost	= false;
+		}
+	}
+
+	template <typename RandomAccessIterator, typename Compare, bool Branchless>
+	inline void pdqsort(RandomAccessIterator first, RandomAccessIterator last, Compare& comp, merkol::integral_constant<bool, Branchless> branchless)
+	{
+		int log2 = 0;
+
+		if (last - first < 2)
+			return;
+		for (std::size_t n = (std::size_t)(last - first); n >>= 1; )
+			++log2;
+		merkol::pdqsort_loop(first, last, comp, log2, true, branchless);
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// Pdqsort.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/// sort
+	///
+	/// Sorts [first, last) by comp (operator< by default) with pattern-defeating quicksort (see above).
+	/// Not stable. O(n log n) in the worst case, O(n) for sorted, reversed and few-valued inputs.
+	template <typename RandomAccessIterator, typename Compare>
+	inline void sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+		typedef merkol::integral_constant<bool, merkol::is_arithmetic<value_type>::value
+												&& merkol::is_default_compare<Compare, value_type>::value>	branchless;
+
+		merkol::pdqsort(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), comp, branchless());
+	}
+
+	template <typename RandomAccessIterator>
+	inline void sort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		merkol::sort(first, last, merkol::less<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+	/// sort_branchless
+	///
+	/// sort with the branchless partition whatever the types: for user types whose comparison is cheap
+	/// (a struct compared by an integer key...). Slower than sort when the comparison is expensive.
+	template <typename RandomAccessIterator, typename Compare>
+	inline void sort_branchless(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		merkol::pdqsort(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), comp, merkol::true_type());
+	}
+
+	template <typename RandomAccessIterator>
+	inline void sort_branchless(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		merkol::sort_branchless(first, last, merkol::less<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// StableSort.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	// Merges the runs of width elements of [from, from + n) pairwise into to.
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename Compare>
+	void merge_pass(RandomAccessIterator1 from, RandomAccessIterator2 to, std::ptrdiff_t n, std::ptrdiff_t width, Compare& comp)
+	{
+		for (std::ptrdiff_t i = 0; i < n; i += 2 * width)
+		{
+			const std::ptrdiff_t middle	= (i + width < n) ? i + width : n;
+			const std::ptrdiff_t end	= (middle + width < n) ? middle + width : n;
+
+			if ((middle == end) || !comp(from[middle], from[middle - 1]))	// already in order
+				merkol::move(from + i, from + end, to + i);
+			else
+				merkol::move_merge(from + i, from + middle, from + middle, from + end, to + i, comp);
+		}
+	}
+
+	// Sorts the n elements at first, using other (n constructed elements) as scratch. Returns true if
+	// the result was left in other.
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename Compare>
+	bool stable_sort_passes(RandomAccessIterator1 first, RandomAccessIterator2 other, std::ptrdiff_t n, Compare& comp)
+	{
+		for (std::ptrdiff_t i = 0; i < n; i += kStableSortRun)
+			merkol::insertion_sort(first + i, first + ((i + kStableSortRun < n) ? i + kStableSortRun : n), comp);
+		for (std::ptrdiff_t width = kStableSortRun; ; )
+		{
+			if (width >= n)
+				return false;
+			merkol::merge_pass(first, other, n, width, comp);
+			width *= 2;
+			if (width >= n)
+				return true;
+			merkol::merge_pass(other, first, n, width, comp);
+			width *= 2;
+		}
+	}
+
+	template <typename RandomAccessIterator, typename Compare>
+	void stable_sort_impl(RandomAccessIterator first, RandomAccessIterator last, Compare& comp)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+		const std::ptrdiff_t n = last - first;
+
+		if (n <= kStableSortRun)
+		{
+			merkol::insertion_sort(first, last, comp);
+			return;
+		}
+
+		sort_buffer<value_type> buffer(first, (std::size_t)n);
+
+		if (buffer.holds_range())
+		{
+			if (!merkol::stable_sort_passes(buffer.data(), first, n, comp))
+				merkol::move(buffer.data(), buffer.data() + n, first);
+		}
+		else if (merkol::stable_sort_passes(first, buffer.data(), n, comp))
+			merkol::move(buffer.data(), buffer.data() + n, first);
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// StableSort.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/// stable_sort
+	///
+	/// Sorts [first, last) by comp (operator< by default), keeping the order of equivalent elements.
+	/// Bottom-up merge sort with a buffer of n elements (see above).
+	template <typename RandomAccessIterator, typename Compare>
+	inline void stable_sort(RandomAccessIterator first, RandomAccessIterator last, Compare comp)
+	{
+		merkol::stable_sort_impl(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), comp);
+	}
+
+	template <typename RandomAccessIterator>
+	inline void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		merkol::stable_sort(first, last, merkol::less<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// RadixSort.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	template <std::size_t Size>
+	struct radix_unsigned {};
+
+	template <>
+	struct radix_unsigned<1> { typedef uint8_t type; };
+
+	template <>
+	struct radix_unsigned<2> { typedef uint16_t type; };
+
+	template <>
+	struct radix_unsigned<4> { typedef uint32_t type; };
+
+	template <>
+	struct radix_unsigned<8> { typedef uint64_t type; };
+
+	/// radix_key
+	///
+	/// Maps a key to an unsigned integer of the same size with the same order.
+	template <typename Key, bool Floating = merkol::is_floating_point<Key>::value>
+	struct radix_key
+	{
+		typedef typename radix_unsigned<sizeof(Key)>::type type;
+
+		static type get(Key key)
+		{
+			const type signBit = (Key)-1 < (Key)0 ? (type)((type)1 << (sizeof(Key) * 8 - 1)) : (type)0;
+
+			return (type)((type)key ^ signBit);
+		}
+	};
+
+	template <typename Key>
+	struct radix_key<Key, true>
+	{
+		typedef typename radix_unsigned<sizeof(Key)>::type type;
+
+		static type get(Key key)
+		{
+			const type	signBit = (type)((type)1 << (sizeof(Key) * 8 - 1));
+			type		bits;
+
+			std::memcpy(&bits, &key, sizeof(bits));
+			return (bits & signBit) ? (type)~bits : (type)(bits | signBit);
+		}
+	};
+
+	// The key extractor of radix_sort(first, last): the element itself.
+	template <typename T>
+	struct radix_identity
+	{
+		const T& operator()(const T& value) const { return value; }
+	};
+
+	// The key type of an element through Key, and its mapping. In C++98 mode key extractors other
+	// than the identity declare their result_type.
+	template <typename T, typename Key>
+	struct radix_key_of
+	{
+	#if __cplusplus >= 201103L
+		typedef typename std::decay<decltype(std::declval<Key&>()(std::declval<const T&>()))>::type	key_type;
+	#else
+		typedef typename merkol::remove_cv<typename Key::result_type>::type							key_type;
+	#endif
+		typedef radix_key<key_type>		mapping;
+		typedef typename mapping::type	type;
+	};
+
+	template <typename T>
+	struct radix_key_of<T, radix_identity<T> >
+	{
+		typedef T						key_type;
+		typedef radix_key<key_type>		mapping;
+		typedef typename mapping::type	type;
+	};
+
+	// Orders elements by mapped key, for the small ranges radix_sort merge sorts.
+	template <typename T, typename Key>
+	struct radix_compare
+	{
+		Key	mKey;
+
+		explicit radix_compare(const Key& key) : mKey(key) { }
+
+		bool operator()(const T& a, const T& b) const
+		{
+			typedef typename radix_key_of<T, Key>::mapping mapping;
+
+			return mapping::get(mKey(a)) < mapping::get(mKey(b));
+		}
+	};
+
+	// Moves the n elements of from into to by the digit at shift, offsets holding the next position of
+	// every digit value.
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename Key, typename Unsigned>
+	void radix_scatter(RandomAccessIterator1 from, RandomAccessIterator2 to, std::size_t n, Key& key, unsigned shift, Unsigned mask,
+					   std::size_t* offsets)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator1>::value_type		value_type;
+		typedef typename radix_key_of<value_type, Key>::mapping							mapping;
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const std::size_t digit = (std::size_t)((mapping::get(key(from[i])) >> shift) & mask);
+
+			to[offsets[digit]++] = MERKOL_MOVE(from[i]);
+		}
+	}
+
+	// Runs the passes of the given shifts, alternating between first and other. Returns true if the
+	// result was left in other.
+	template <typename RandomAccessIterator1, typename RandomAccessIterator2, typename Key, typename Unsigned>
+	bool radix_passes(RandomAccessIterator1 first, RandomAccessIterator2 other, std::size_t n, Key& key, unsigned bits,
+					  const std::vector<unsigned>& passes, std::vector<std::size_t>& counts, Unsigned mask)
+	{
+		const std::size_t buckets = (std::size_t)mask + 1;
+
+		for (std::size_t p = 0; ; )
+		{
+			if (p == passes.size())
+				return false;
+			merkol::radix_scatter(first, other, n, key, passes[p] * bits, mask, &counts[passes[p] * buckets]);
+			if (++p == passes.size())
+				return true;
+			merkol::radix_scatter(other, first, n, key, passes[p] * bits, mask, &counts[passes[p] * buckets]);
+			++p;
+		}
+	}
+
+	template <unsigned Bits, typename RandomAccessIterator, typename Key>
+	void radix_sort_impl(RandomAccessIterator first, RandomAccessIterator last, Key& key)
+	{
+		typedef typename merkol::iterator_traits<RandomAccessIterator>::value_type		value_type;
+		typedef radix_key_of<value_type, Key>											key_of;
+		typedef typename key_of::type													unsigned_key;
+
+		const std::size_t n = (std::size_t)(last - first);
+
+		if (n < kRadixSortMin)
+		{
+			radix_compare<value_type, Key> comp(key);
+
+			merkol::stable_sort_impl(first, last, comp);
+			return;
+		}
+
+		const unsigned keyBits	= (unsigned)sizeof(unsigned_key) * 8;
+		unsigned bits			= Bits;
+
+		if (bits == 0)		// automatic
+		{
+			if (keyBits <= 8)
+				bits = 8;
+			else if (keyBits == 16)
+				bits = (n >= ((std::size_t)1 << 20)) ? 16 : 8;
+			else
+				bits = 11;
+		}
+		if (bits > keyBits)
+			bits = keyBits;
+
+		const unsigned			digits	= (keyBits + bits - 1) / bits;
+		const std::size_t		buckets	= (std::size_t)1 << bits;
+		const unsigned_key		mask	= (unsigned_key)(buckets - 1);
+		std::vector<std::size_t>	counts(digits * buckets, 0);
+		std::vector<unsigned>		passes;
+
+		// All the histograms in one read.
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const unsigned_key k = key_of::mapping::get(key(first[i]));
+
+			for (unsigned d = 0; d < digits; ++d)
+				++counts[d * buckets + (std::size_t)((k >> (d * bits)) & mask)];
+		}
+
+		// Skip the digits every key shares; the others get their counts turned into offsets.
+		const unsigned_key firstKey = key_of::mapping::get(key(first[0]));
+
+		for (unsigned d = 0; d < digits; ++d)
+		{
+			std::size_t* const count = &counts[d * buckets];
+
+			if (count[(std::size_t)((firstKey >> (d * bits)) & mask)] == n)
+				continue;
+			passes.push_back(d);
+			for (std::size_t b = 0, sum = 0; b < buckets; ++b)
+			{
+				const std::size_t c = count[b];
+
+				count[b] = sum;
+				sum += c;
+			}
+		}
+		if (passes.empty())
+			return;
+
+		sort_buffer<value_type> buffer(first, n);
+
+		if (buffer.holds_range())
+		{
+			if (!merkol::radix_passes(buffer.data(), first, n, key, bits, passes, counts, mask))
+				merkol::move(buffer.data(), buffer.data() + n, first);
+		}
+		else if (merkol::radix_passes(first, buffer.data(), n, key, bits, passes, counts, mask))
+			merkol::move(buffer.data(), buffer.data() + n, first);
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// RadixSort.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/// radix_sort
+	///
+	/// Stable sort of [first, last) by key(element), an integer or floating point value (the elements
+	/// themselves without key), in ascending order (see above). radix_sort<Bits>(...) sets the digit
+	/// width, 8, 11 or 16 bits; by default it is chosen from the key size and the number of elements.
+	template <typename RandomAccessIterator, typename Key>
+	inline void radix_sort(RandomAccessIterator first, RandomAccessIterator last, Key key)
+	{
+		merkol::radix_sort_impl<0>(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), key);
+	}
+
+	template <typename RandomAccessIterator>
+	inline void radix_sort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		merkol::radix_sort(first, last, radix_identity<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+	template <unsigned Bits, typename RandomAccessIterator, typename Key>
+	inline void radix_sort(RandomAccessIterator first, RandomAccessIterator last, Key key)
+	{
+		merkol::radix_sort_impl<Bits>(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), key);
+	}
+
+	template <unsigned Bits, typename RandomAccessIterator>
+	inline void radix_sort(RandomAccessIterator first, RandomAccessIterator last)
+	{
+		merkol::radix_sort<Bits>(first, last, radix_identity<typename merkol::iterator_traits<RandomAccessIterator>::value_type>());
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_SORT_HPP
@@ -1,6 +1,13 @@
 #ifndef TYPE_TRAITS_TPP
 # define TYPE_TRAITS_TPP
 
+#include <cstddef>
+
+#if __cplusplus >= 201103L
+# include <type_traits>
+# include <utility>
+#endif
+
 namespace merkol
 {
 	//integral_constant to make false/true_type typedef below
@@ -55,6 +62,51 @@ namespace merkol
 	template<>
 	struct is_integral<unsigned long long> : true_type {};
 
+	template<>
+	struct is_integral<signed char> : true_type {};
+
+	template<>
+	struct is_integral<short> : true_type {};
+
+	template<>
+	struct is_integral<unsigned short> : true_type {};
+
+	template<>
+	struct is_integral<wchar_t> : true_type {};
+
+	// is_floating_point
+	template<typename T>
+	struct is_floating_point : false_type {};
+
+	template<>
+	struct is_floating_point<float> : true_type {};
+
+	template<>
+	struct is_floating_point<double> : true_type {};
+
+	template<>
+	struct is_floating_point<long double> : true_type {};
+
+	// is_arithmetic
+	template<typename T>
+	struct is_arithmetic : integral_constant<bool, is_integral<T>::value || is_floating_point<T>::value> {};
+
+	// is_pointer
+	template<typename T>
+	struct is_pointer : false_type {};
+
+	template<typename T>
+	struct is_pointer<T*> : true_type {};
+
+	template<typename T>
+	struct is_pointer<T* const> : true_type {};
+
+	template<typename T>
+	struct is_pointer<T* volatile> : true_type {};
+
+	template<typename T>
+	struct is_pointer<T* const volatile> : true_type {};
+
 	// enable if
 	template <bool Cond, class T = void>
 	struct enable_if {};
@@ -98,14 +150,145 @@ namespace merkol
 	template<class T>
 	struct remove_volatile<volatile T> { typedef T type; };
 
+	/// conditional
+	///
+	/// type is T if B is true, F otherwise.
+	template<bool B, class T, class F>
+	struct conditional { typedef T type; };
+
+	template<class T, class F>
+	struct conditional<false, T, F> { typedef F type; };
+
+	// The traits below can not be written in the language itself (C++98 has no way to ask whether a
+	// user struct has a trivial copy constructor), so they use the compiler intrinsics that the standard
+	// library uses to implement <type_traits>. GCC and Clang provide them in every language mode.
+	// Without them the answer falls back to scalars only, which is always correct, just slower.
+#if defined(__GNUC__) || defined(__clang__)
+# define MERKOL_IS_ENUM(T)								__is_enum(T)
+# define MERKOL_IS_TRIVIALLY_COPYABLE(T)				__is_trivially_copyable(T)
+# define MERKOL_IS_TRIVIALLY_DEFAULT_CONSTRUCTIBLE(T)	__is_trivially_constructible(T)
+# if defined(__clang__)
+#  define MERKOL_IS_TRIVIALLY_DESTRUCTIBLE(T)			__is_trivially_destructible(T)
+# else
+#  define MERKOL_IS_TRIVIALLY_DESTRUCTIBLE(T)			__has_trivial_destructor(T)
+# endif
+# define MERKOL_ALIGNOF(T)								__alignof__(T)
+#else
+# define MERKOL_IS_ENUM(T)								false
+# define MERKOL_IS_TRIVIALLY_COPYABLE(T)				merkol::is_scalar<T>::value
+# define MERKOL_IS_TRIVIALLY_DEFAULT_CONSTRUCTIBLE(T)	merkol::is_scalar<T>::value
+# define MERKOL_IS_TRIVIALLY_DESTRUCTIBLE(T)			merkol::is_scalar<T>::value
+# define MERKOL_ALIGNOF(T)								(sizeof(T) & (~sizeof(T) + 1)) // largest power of two dividing sizeof(T)
+#endif
+
+	// is_enum
+	template<typename T>
+	struct is_enum : integral_constant<bool, MERKOL_IS_ENUM(T)> {};
+
+	// is_scalar
+	// Member pointers are scalars too, but nothing in the library needs them.
+	template<typename T>
+	struct is_scalar : integral_constant<bool, is_arithmetic<typename remove_cv<T>::type>::value
+												|| is_pointer<T>::value || is_enum<T>::value> {};
+
+	/// is_trivially_copyable
+	///
+	/// True if T can be copied with memcpy: scalars, and classes whose copy/move constructors,
+	/// assignments and destructor are all trivial (PODs, plain structs of scalars...).
+	template<typename T>
+	struct is_trivially_copyable : integral_constant<bool, MERKOL_IS_TRIVIALLY_COPYABLE(T)> {};
+
+	/// is_trivially_default_constructible
+	///
+	/// True if 'T t;' runs no code. For such types value-initialization 'T()' is zero-initialization,
+	/// which is what lets uninitialized_value_construct_n use memset.
+	template<typename T>
+	struct is_trivially_default_constructible : integral_constant<bool, MERKOL_IS_TRIVIALLY_DEFAULT_CONSTRUCTIBLE(T)> {};
+
+	/// is_trivially_destructible
+	template<typename T>
+	struct is_trivially_destructible : integral_constant<bool, MERKOL_IS_TRIVIALLY_DESTRUCTIBLE(T)> {};
+
+	/// alignment_of
+	template<typename T>
+	struct alignment_of : integral_constant<std::size_t, MERKOL_ALIGNOF(T)> {};
+
+	/// is_trivially_relocatable
+	///
+	/// True if moving a T to a new address and destroying the original is equivalent to a memcpy of its
+	/// bytes, with no constructor or destructor call. Containers use it to relocate their whole buffer
+	/// with one memcpy (or a realloc) when they grow.
+	///
+	/// It is true for every trivially copyable type. It is also true for many types that are not
+	/// trivially copyable, e.g. a class owning a heap pointer (std::unique_ptr, a handle wrapper), but
+	/// false for types that store pointers into themselves (libstdc++'s std::string with its small
+	/// buffer). Those can not be detected, so this is a customization point: specialize it, or use
+	/// MERKOL_DECLARE_TRIVIALLY_RELOCATABLE(T) at global scope.
+	template<typename T>
+	struct is_trivially_relocatable : integral_constant<bool, is_trivially_copyable<T>::value> {};
+
 	// void_t implementation. !! not tested !!
 	template<typename>
 	struct void_t
 	{
 		typedef void type;
 	};
+
+#if __cplusplus >= 201103L
+	// noexcept queries need the compiler (std::declval, noexcept operator and the intrinsics behind
+	// <type_traits>), so they are only available in C++11 mode.
+	template<typename T>
+	struct is_nothrow_move_constructible : integral_constant<bool, std::is_nothrow_move_constructible<T>::value> {};
+
+	template<typename T>
+	struct is_copy_constructible : integral_constant<bool, std::is_copy_constructible<T>::value> {};
+
+	/// move_if_noexcept_cond
+	///
+	/// True when relocating a T by move could throw half way while a copy is available, i.e. when
+	/// the strong exception guarantee of a reallocation requires copying instead of moving.
+	template<typename T>
+	struct move_if_noexcept_cond
+		: integral_constant<bool, !is_nothrow_move_constructible<T>::value && is_copy_constructible<T>::value> {};
+
+	/// index_sequence / make_index_sequence
+	///
+	/// C++14's compile time list of indexes 0, 1 ... N - 1, to expand a parameter pack of fields or
+	/// tuple elements along with their positions.
+	template<std::size_t... I>
+	struct index_sequence {};
+
+	template<std::size_t N, std::size_t... I>
+	struct make_index_sequence_impl : make_index_sequence_impl<N - 1, N - 1, I...> {};
+
+	template<std::size_t... I>
+	struct make_index_sequence_impl<0, I...> { typedef index_sequence<I...> type; };
+
+	template<std::size_t N>
+	using make_index_sequence = typename make_index_sequence_impl<N>::type;
+#endif
 	
 }
 
+// MERKOL_DECLARE_TRIVIALLY_RELOCATABLE
+// Opts a (non-template) user type into merkol::is_trivially_relocatable. Use at global scope:
+//     MERKOL_DECLARE_TRIVIALLY_RELOCATABLE(my::handle)
+#define MERKOL_DECLARE_TRIVIALLY_RELOCATABLE(T) \
+	namespace merkol { template<> struct is_trivially_relocatable< T > : merkol::true_type {}; }
+
+// MERKOL_MOVE / MERKOL_FORWARD / MERKOL_FORWARD_REF
+// Casts to an rvalue (or forwards) in C++11 mode and are plain copies in C++98 mode, so the
+// same container code can be written once for both. MERKOL_FORWARD_REF(T) declares the parameter
+// that MERKOL_FORWARD forwards: a forwarding reference, or a const reference in C++98 mode.
+#if __cplusplus >= 201103L
+# define MERKOL_MOVE(x)				std::move(x)
+# define MERKOL_FORWARD(T, x)		std::forward<T>(x)
+# define MERKOL_FORWARD_REF(T)		T&&
+#else
+# define MERKOL_MOVE(x)				(x)
+# define MERKOL_FORWARD(T, x)		(x)
+# define MERKOL_FORWARD_REF(T)		const T&
+#endif
+
 
 #endif
\ No newline at end of file
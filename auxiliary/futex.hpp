@@ -0,0 +1,67 @@
+#ifndef MERKOL_FUTEX_HPP
+# define MERKOL_FUTEX_HPP
+
+#if __cplusplus < 201103L
+# error "futex.hpp requires C++11"
+#endif
+
+#include <atomic>
+#include <climits>
+#include <stdint.h>
+#include <thread>
+
+#ifdef __linux__
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+/*
+	futex_wait / futex_wake
+
+	Sleeping on a 32 bit atomic word until another thread changes it, for the blocking operations of the
+	concurrent containers. futex_wait(word, expected) returns at once if word is no longer expected,
+	otherwise it sleeps until a futex_wake on the same word (or a spurious wakeup): callers always check
+	their condition again in a loop. On Linux these are the futex system calls (private to the process);
+	elsewhere futex_wait yields the CPU and returns, which turns the caller's loop into a polling loop.
+
+	futex_wake is a system call even when nobody sleeps, so callers keep a count of sleepers and only
+	wake when it is not zero.
+*/
+
+namespace merkol
+{
+	inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected)
+	{
+	#ifdef __linux__
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+	#else
+		if (word.load(std::memory_order_relaxed) == expected)
+			std::this_thread::yield();
+	#endif
+	}
+
+	// Wakes up to count threads sleeping on word; INT_MAX wakes them all.
+	inline void futex_wake(std::atomic<uint32_t>& word, int count)
+	{
+	#ifdef __linux__
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+	#else
+		(void)word;
+		(void)count;
+	#endif
+	}
+
+	// A short pause in a spin loop, letting the sibling hyperthread run.
+	inline void cpu_relax()
+	{
+	#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+	#elif defined(__aarch64__)
+		__asm__ __volatile__("yield");
+	#endif
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_FUTEX_HPP
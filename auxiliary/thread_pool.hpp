@@ -0,0 +1,623 @@
+#ifndef MERKOL_THREAD_POOL_HPP
+# define MERKOL_THREAD_POOL_HPP
+
+#if __cplusplus < 201103L
+# error "thread_pool.hpp requires C++11"
+#endif
+
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "futex.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	work_stealing_deque / thread_pool
+
+	The fork-join pool behind the parallel algorithms (aux_templates/parallel_algorithm.hpp). Work is
+	expressed as invoke(a, b): run a and b, possibly at the same time, and return when both are done.
+	The algorithms split their range in two halves with invoke, recursively, down to a grain size.
+
+	Every worker owns a work_stealing_deque of tasks (D. Chase and Y. Lev, "Dynamic Circular Work-Stealing
+	Deque", with the memory orders of N. M. Le et al., "Correct and Efficient Work-Stealing for Weak
+	Memory Models"). invoke pushes b at the bottom of the calling worker's deque, runs a, then pops b
+	back and runs it itself, unless an idle worker stole it in the meantime from the top of the deque.
+	The owner pushes and pops without any read-modify-write unless the deque holds a single task; thieves
+	take the oldest task, which is the largest half of the range, so a steal moves a lot of work at once
+	and the number of steals stays small (about workers * log2(n / grain)).
+
+	A worker that waits for a stolen task does not sleep: it runs tasks from its own deque or steals
+	others' until the task is done. Idle workers spin for a while, then sleep on a futex (see
+	auxiliary/futex.hpp). They count themselves in mSleepers first and take themselves off again once
+	awake, and every push checks the count after a full fence: while it is not zero, the push bumps the
+	epoch and wakes one sleeper, which steals the task and wakes the next one by pushing its own. When
+	everybody is busy, a push costs the fence and a load.
+
+	Threads that are not workers of the pool (the main thread) hand their work over as a root task, through
+	a queue under a mutex, and wait for it on a condition variable. Calls from inside a task run inline:
+	nested parallel algorithms are fine.
+
+	An exception thrown by a or b is rethrown by invoke, once both are done: a task that threw does not
+	stop the others, it only makes the whole call throw. If both threw, the exception of a wins.
+*/
+
+namespace merkol
+{
+namespace parallel
+{
+	/**
+	 * @brief work_stealing_deque
+	 * Chase-Lev deque of trivially copyable values (task pointers): push and pop at the bottom by the
+	 * owner thread only, steal at the top by any thread. Grows when full; the old arrays are kept until
+	 * the deque is destroyed, as a thief may still be reading them.
+	 */
+	template <typename T>
+	class work_stealing_deque
+	{
+	public:
+		typedef T				value_type;
+		typedef std::size_t		size_type;
+
+	public:
+		explicit work_stealing_deque(size_type capacity = 64);
+		~work_stealing_deque();
+
+		work_stealing_deque(const work_stealing_deque&) = delete;
+		work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+		void		push(T value);			// owner
+		bool		pop(T& value);			// owner, newest first
+		bool		steal(T& value);		// any thread, oldest first; false when empty or when it lost a race
+
+		size_type	size() const M_NOEXCEPT;	// a snapshot
+		bool		empty() const M_NOEXCEPT { return size() == 0; }
+
+	protected:
+		struct ring
+		{
+			int64_t				mMask;
+			std::atomic<T>*		mpSlots;
+
+			explicit ring(int64_t capacity) : mMask(capacity - 1), mpSlots(new std::atomic<T>[capacity]) { }
+			~ring() { delete[] mpSlots; }
+
+			T		get(int64_t i) const { return mpSlots[i & mMask].load(std::memory_order_relaxed); }
+			void	put(int64_t i, T value) { mpSlots[i & mMask].store(value, std::memory_order_relaxed); }
+		};
+
+		std::atomic<int64_t>	mTop;		// thieves
+		unsigned char			mPadTop[MERKOL_CACHE_LINE_SIZE];
+		std::atomic<int64_t>	mBottom;	// owner
+		std::atomic<ring*>		mpRing;
+		std::vector<ring*>		mRetired;	// owner
+		unsigned char			mPadBottom[MERKOL_CACHE_LINE_SIZE];
+
+		ring*		doGrow(ring* old, int64_t top, int64_t bottom);
+	}; // work_stealing_deque
+
+
+	///////////////////////////////////////////////////////////////////////
+	// WorkStealingDeque.imp.begin();									///
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename T>
+	work_stealing_deque<T>::work_stealing_deque(size_type capacity)
+		: mTop(0), mBottom(0), mpRing(NULL)
+	{
+		size_type rounded = 2;
+
+		while (rounded < capacity)
+			rounded *= 2;
+		mpRing.store(new ring((int64_t)rounded), std::memory_order_relaxed);
+	}
+
+	template <typename T>
+	work_stealing_deque<T>::~work_stealing_deque()
+	{
+		delete mpRing.load(std::memory_order_relaxed);
+		for (std::size_t i = 0; i < mRetired.size(); ++i)
+			delete mRetired[i];
+	}
+
+	template <typename T>
+	typename work_stealing_deque<T>::ring* work_stealing_deque<T>::doGrow(ring* old, int64_t top, int64_t bottom)
+	{
+		ring* const bigger = new ring((old->mMask + 1) * 2);
+
+		for (int64_t i = top; i < bottom; ++i)
+			bigger->put(i, old->get(i));
+		mRetired.push_back(old);
+		mpRing.store(bigger, std::memory_order_release);
+		return bigger;
+	}
+
+	template <typename T>
+	void work_stealing_deque<T>::push(T value)
+	{
+		const int64_t	bottom	= mBottom.load(std::memory_order_relaxed);
+		const int64_t	top		= mTop.load(std::memory_order_acquire);
+		ring*			slots	= mpRing.load(std::memory_order_relaxed);
+
+		if (bottom - top > slots->mMask)
+			slots = doGrow(slots, top, bottom);
+		slots->put(bottom, value);
+		mBottom.store(bottom + 1, std::memory_order_release);	// publishes the slot, and what it points to
+	}
+
+	template <typename T>
+	bool work_stealing_deque<T>::pop(T& value)
+	{
+		const int64_t	bottom	= mBottom.load(std::memory_order_relaxed) - 1;
+		ring* const		slots	= mpRing.load(std::memory_order_relaxed);
+
+		mBottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);	// the bottom store before the top load
+
+		int64_t top = mTop.load(std::memory_order_relaxed);
+
+		if (top > bottom)		// empty
+		{
+			mBottom.store(bottom + 1, std::memory_order_relaxed);
+			return false;
+		}
+		value = slots->get(bottom);
+		if (top < bottom)		// more than one task: thieves can not reach this one
+			return true;
+
+		// The last task: race the thieves for it.
+		const bool won = mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+		mBottom.store(bottom + 1, std::memory_order_relaxed);
+		return won;
+	}
+
+	template <typename T>
+	bool work_stealing_deque<T>::steal(T& value)
+	{
+		int64_t top = mTop.load(std::memory_order_acquire);
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		const int64_t bottom = mBottom.load(std::memory_order_acquire);
+
+		if (top >= bottom)
+			return false;
+		value = mpRing.load(std::memory_order_acquire)->get(top);
+		return mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+
+	template <typename T>
+	typename work_stealing_deque<T>::size_type work_stealing_deque<T>::size() const M_NOEXCEPT
+	{
+		const int64_t bottom	= mBottom.load(std::memory_order_relaxed);
+		const int64_t top		= mTop.load(std::memory_order_relaxed);
+
+		return (bottom > top) ? (size_type)(bottom - top) : 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// WorkStealingDeque.imp.end();										///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/**
+	 * @brief thread_pool
+	 * Fork-join pool of worker threads with one work_stealing_deque each (see above). run() and invoke()
+	 * may be called from any thread, including from inside the functions they run.
+	 */
+	class thread_pool
+	{
+	public:
+		typedef std::size_t		size_type;
+
+	public:
+		// threads == 0 starts one worker per hardware thread.
+		explicit thread_pool(size_type threads = 0);
+		~thread_pool();
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		size_type	size() const M_NOEXCEPT { return mWorkers.size(); }
+
+		// Runs f() on a worker of this pool (on the calling thread if it is one) and waits for it.
+		template <typename Function>
+		void		run(Function&& f);
+
+		// Runs a() and b(), in parallel if a worker is idle, and returns when both are done.
+		template <typename Function1, typename Function2>
+		void		invoke(Function1&& a, Function2&& b);
+
+	protected:
+		static const unsigned kSpins	= 256;	// idle rounds before a worker sleeps
+
+		struct task
+		{
+			void				(*mpExecute)(task*);
+			std::atomic<bool>	mDone;
+			std::exception_ptr	mException;
+
+			explicit task(void (*execute)(task*)) : mpExecute(execute), mDone(false) { }
+		};
+
+		// b of an invoke(a, b).
+		template <typename Function>
+		struct child_task : task
+		{
+			Function&	mFunction;
+
+			explicit child_task(Function& f) : task(&execute), mFunction(f) { }
+
+			static void execute(task* t)
+			{
+				child_task* const self = static_cast<child_task*>(t);
+
+				try
+				{
+					self->mFunction();
+				}
+				catch (...)
+				{
+					self->mException = std::current_exception();
+				}
+				self->mDone.store(true, std::memory_order_release);
+			}
+		};
+
+		// The work of a thread that is not a worker. It owns the task, so the worker signals under the
+		// mutex: the task is not destroyed before the worker is done with it.
+		template <typename Function>
+		struct root_task : task
+		{
+			Function&				mFunction;
+			std::mutex				mMutex;
+			std::condition_variable	mFinished;
+
+			explicit root_task(Function& f) : task(&execute), mFunction(f) { }
+
+			static void execute(task* t)
+			{
+				root_task* const self = static_cast<root_task*>(t);
+
+				try
+				{
+					self->mFunction();
+				}
+				catch (...)
+				{
+					self->mException = std::current_exception();
+				}
+
+				std::lock_guard<std::mutex> lock(self->mMutex);
+
+				self->mDone.store(true, std::memory_order_release);
+				self->mFinished.notify_one();
+			}
+		};
+
+		struct worker
+		{
+			thread_pool*					mpPool;
+			size_type						mIndex;
+			uint32_t						mSeed;		// victim selection
+			work_stealing_deque<task*>		mTasks;
+			std::thread						mThread;
+
+			worker(thread_pool* pool, size_type index) : mpPool(pool), mIndex(index), mSeed((uint32_t)index * 2654435761u + 1) { }
+		};
+
+		std::vector<std::unique_ptr<worker> >	mWorkers;
+
+		std::mutex				mRootMutex;
+		std::deque<task*>		mRoots;
+		std::atomic<size_type>	mnRoots;
+		std::atomic<bool>		mStop;
+
+		unsigned char			mPadSleep[MERKOL_CACHE_LINE_SIZE];
+		std::atomic<uint32_t>	mEpoch;			// idle workers sleep on it
+		std::atomic<uint32_t>	mSleepers;
+		unsigned char			mPadBack[MERKOL_CACHE_LINE_SIZE];
+
+		static worker*&	doCurrent();
+		worker*			doCurrentWorker() const;
+
+		void			doMain(worker& self);
+		task*			doFind(worker& self);
+		task*			doSteal(worker& self);
+		task*			doTakeRoot();
+		bool			doHasWork() const;
+		void			doSleep();
+		void			doNotify();
+		void			doJoin(worker& self, task& t);
+		void			doStop();
+	}; // thread_pool
+
+
+	///////////////////////////////////////////////////////////////////////
+	// ThreadPool.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	inline thread_pool::thread_pool(size_type threads)
+		: mnRoots(0), mStop(false), mEpoch(0), mSleepers(0)
+	{
+		if (threads == 0)
+			threads = std::thread::hardware_concurrency();
+		if (threads == 0)
+			threads = 1;
+
+		mWorkers.reserve(threads);
+		for (size_type i = 0; i < threads; ++i)
+			mWorkers.push_back(std::unique_ptr<worker>(new worker(this, i)));
+		try
+		{
+			for (size_type i = 0; i < threads; ++i)
+				mWorkers[i]->mThread = std::thread(&thread_pool::doMain, this, std::ref(*mWorkers[i]));
+		}
+		catch (...)
+		{
+			doStop();
+			throw;
+		}
+	}
+
+	inline thread_pool::~thread_pool()
+	{
+		doStop();
+	}
+
+	inline void thread_pool::doStop()
+	{
+		mStop.store(true, std::memory_order_seq_cst);
+		mEpoch.fetch_add(1, std::memory_order_seq_cst);
+		merkol::futex_wake(mEpoch, INT_MAX);
+		for (size_type i = 0; i < mWorkers.size(); ++i)
+		{
+			if (mWorkers[i]->mThread.joinable())
+				mWorkers[i]->mThread.join();
+		}
+	}
+
+	// The worker running on this thread, of whichever pool.
+	inline thread_pool::worker*& thread_pool::doCurrent()
+	{
+		static thread_local worker* current = NULL;
+
+		return current;
+	}
+
+	inline thread_pool::worker* thread_pool::doCurrentWorker() const
+	{
+		worker* const current = doCurrent();
+
+		return (current && current->mpPool == this) ? current : NULL;
+	}
+
+	// Leaves mSleepers alone: each sleeper takes itself off the count, so it is never lower than the number
+	// of workers that may be asleep.
+	inline void thread_pool::doNotify()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (mSleepers.load(std::memory_order_relaxed) != 0)
+		{
+			mEpoch.fetch_add(1, std::memory_order_relaxed);
+			merkol::futex_wake(mEpoch, 1);
+		}
+	}
+
+	inline bool thread_pool::doHasWork() const
+	{
+		if (mnRoots.load(std::memory_order_relaxed) != 0)
+			return true;
+		for (size_type i = 0; i < mWorkers.size(); ++i)
+		{
+			if (!mWorkers[i]->mTasks.empty())
+				return true;
+		}
+		return false;
+	}
+
+	// Registers as a sleeper, looks for work once more (a push that did not see the registration happened
+	// before it, so its task is visible), then sleeps until a push or the destructor moves the epoch.
+	// Either way the worker takes itself off the count before it returns. The epoch is read before the
+	// registration: read after it, it could already include the bump of a push whose task the check
+	// below misses, and futex_wait would then sleep through that push's wakeup.
+	inline void thread_pool::doSleep()
+	{
+		const uint32_t epoch = mEpoch.load(std::memory_order_relaxed);
+
+		mSleepers.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (!doHasWork() && !mStop.load(std::memory_order_relaxed))
+			merkol::futex_wait(mEpoch, epoch);
+		mSleepers.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	inline thread_pool::task* thread_pool::doTakeRoot()
+	{
+		if (mnRoots.load(std::memory_order_relaxed) == 0)
+			return NULL;
+
+		std::lock_guard<std::mutex> lock(mRootMutex);
+
+		if (mRoots.empty())
+			return NULL;
+
+		task* const t = mRoots.front();
+
+		mRoots.pop_front();
+		mnRoots.store(mRoots.size(), std::memory_order_relaxed);
+		return t;
+	}
+
+	// One pass over the other workers, from a random one.
+	inline thread_pool::task* thread_pool::doSteal(worker& self)
+	{
+		const size_type n = mWorkers.size();
+
+		self.mSeed ^= self.mSeed << 13;
+		self.mSeed ^= self.mSeed >> 17;
+		self.mSeed ^= self.mSeed << 5;
+
+		const size_type	start	= self.mSeed % n;
+		task*			t;
+
+		for (size_type i = 0; i < n; ++i)
+		{
+			worker& victim = *mWorkers[(start + i) % n];
+
+			if ((&victim != &self) && victim.mTasks.steal(t))
+				return t;
+		}
+		return NULL;
+	}
+
+	inline thread_pool::task* thread_pool::doFind(worker& self)
+	{
+		task* t;
+
+		if (self.mTasks.pop(t))
+			return t;
+		if ((t = doTakeRoot()))
+			return t;
+		return doSteal(self);
+	}
+
+	inline void thread_pool::doMain(worker& self)
+	{
+		unsigned spins = 0;
+
+		doCurrent() = &self;
+		for (;;)
+		{
+			task* const t = doFind(self);
+
+			if (t)
+			{
+				t->mpExecute(t);
+				spins = 0;
+			}
+			else if (mStop.load(std::memory_order_relaxed))
+				return;
+			else if (++spins >= kSpins)
+			{
+				doSleep();
+				spins = 0;
+			}
+			else if ((spins % 16) != 0)
+				merkol::cpu_relax();
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	// Waits for t, running other tasks meanwhile. If t was not stolen it is the newest task of the deque
+	// (the ones pushed after it were joined already), so the first pop takes it back. If it was stolen,
+	// every older task was stolen first and the deque is empty. New root tasks are left to idle workers.
+	inline void thread_pool::doJoin(worker& self, task& t)
+	{
+		unsigned spins = 0;
+
+		while (!t.mDone.load(std::memory_order_acquire))
+		{
+			task* next;
+
+			if (self.mTasks.pop(next) || (next = doSteal(self)))
+			{
+				next->mpExecute(next);
+				spins = 0;
+			}
+			else if ((++spins % 16) != 0)
+				merkol::cpu_relax();
+			else
+				std::this_thread::yield();
+		}
+	}
+
+	template <typename Function>
+	void thread_pool::run(Function&& f)
+	{
+		if (doCurrentWorker())
+		{
+			f();
+			return;
+		}
+
+		typedef typename std::remove_reference<Function>::type	function_type;
+		root_task<function_type>								root(f);
+
+		{
+			std::lock_guard<std::mutex> lock(mRootMutex);
+
+			mRoots.push_back(&root);
+			mnRoots.store(mRoots.size(), std::memory_order_relaxed);
+		}
+		doNotify();
+		{
+			std::unique_lock<std::mutex> lock(root.mMutex);
+
+			while (!root.mDone.load(std::memory_order_acquire))
+				root.mFinished.wait(lock);
+		}
+		if (root.mException)
+			std::rethrow_exception(root.mException);
+	}
+
+	template <typename Function1, typename Function2>
+	void thread_pool::invoke(Function1&& a, Function2&& b)
+	{
+		worker* const self = doCurrentWorker();
+
+		if (!self)
+		{
+			run([&] { invoke(a, b); });
+			return;
+		}
+
+		typedef typename std::remove_reference<Function2>::type	function_type;
+		child_task<function_type>								child(b);
+
+		self->mTasks.push(&child);
+		doNotify();
+		try
+		{
+			a();
+		}
+		catch (...)
+		{
+			doJoin(*self, child);
+			throw;
+		}
+		doJoin(*self, child);
+		if (child.mException)
+			std::rethrow_exception(child.mException);
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// ThreadPool.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/// default_pool
+	///
+	/// The pool the parallel algorithms use unless told otherwise: one worker per hardware thread, started
+	/// by the first call and stopped at exit.
+	inline thread_pool& default_pool()
+	{
+		static thread_pool pool;
+
+		return pool;
+	}
+
+} // namespace parallel
+} // namespace merkol
+
+#endif // MERKOL_THREAD_POOL_HPP
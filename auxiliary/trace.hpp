@@ -0,0 +1,281 @@
+#ifndef TRACE_HPP
+# define TRACE_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <stdio.h>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <stdint.h>
+#include <time.h>
+
+/*
+	MERKOL_TRACE(container, op, size, capacity)
+
+	Hot paths used to call print_info(), which meant a synchronous, flushed std::cout write for
+	every begin()/end(). They now go through this macro instead.
+
+	- Release builds (NDEBUG, or MERKOL_TRACE_ENABLED=0): the macro expands to nothing, the arguments
+	  are not evaluated.
+	- Debug builds: the event is appended to a ring buffer owned by the calling thread. No locks,
+	  no formatting and no I/O happen on the hot path; when the ring is full the oldest events are
+	  overwritten. Events are rendered later by merkol::trace::dump() or written in binary form by
+	  merkol::trace::flush() and rendered by auxiliary/trace_dump.cpp.
+
+	If the MERKOL_TRACE_FILE environment variable is set, every buffer is flushed to that file at exit.
+	The buffers are freed at exit, after that flush; events recorded later (by the destructors of
+	objects that outlive the exit handler) are dropped.
+
+	'op' must be a string literal (only the pointer is stored).
+*/
+#ifndef MERKOL_TRACE_ENABLED
+# ifdef NDEBUG
+#  define MERKOL_TRACE_ENABLED 0
+# else
+#  define MERKOL_TRACE_ENABLED 1
+# endif
+#endif
+
+#if MERKOL_TRACE_ENABLED
+# define MERKOL_TRACE(container, op, size, capacity) \
+	merkol::trace::record((const void*)(container), (op), (std::size_t)(size), (std::size_t)(capacity))
+#else
+# define MERKOL_TRACE(container, op, size, capacity) ((void)0)
+#endif
+
+#if __cplusplus >= 201103L
+# define MERKOL_THREAD_LOCAL thread_local
+#else
+# define MERKOL_THREAD_LOCAL __thread
+#endif
+
+namespace merkol
+{
+namespace trace
+{
+	struct event
+	{
+		uint64_t		timestamp;	// nanoseconds, CLOCK_MONOTONIC
+		const void*		container;
+		const char*		op;
+		std::size_t		size;
+		std::size_t		capacity;
+	};
+
+	/// file_record
+	///
+	/// On-disk form of an event, as written by flush() and read back by trace_dump.
+	/// The op name is copied (and truncated) because the string literal address means nothing
+	/// outside of the process.
+	struct file_record
+	{
+		uint64_t	timestamp;
+		uint64_t	container;
+		uint64_t	size;
+		uint64_t	capacity;
+		uint32_t	thread;
+		char		op[44];
+	};
+
+	static const std::size_t	kRingSize	= 4096; // events kept per thread, must be a power of two.
+	static const char			kFileMagic[8] = { 'M', 'K', 'T', 'R', 'A', 'C', 'E', '1' };
+
+	struct ring_buffer
+	{
+		event			events[kRingSize];
+		uint64_t		head;	// number of events ever written. Only the owning thread stores to it.
+		uint32_t		thread;
+		ring_buffer*	next;	// registry link. Buffers are only unlinked and freed at exit.
+	};
+
+	inline uint64_t now()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+	}
+
+	inline ring_buffer*& registry_head()
+	{
+		static ring_buffer* head = NULL;
+		return head;
+	}
+
+	inline uint32_t& thread_counter()
+	{
+		static uint32_t counter = 0;
+		return counter;
+	}
+
+	// Set by release_at_exit(); nothing is recorded any more.
+	inline bool& released()
+	{
+		static bool flag = false;
+		return flag;
+	}
+
+	inline void release_at_exit();
+
+	// Called once per thread, the first time it records an event. This is the only place a
+	// thread touches shared state; the registry is a lock-free push-only list.
+	inline ring_buffer* register_buffer()
+	{
+		ring_buffer* rb = static_cast<ring_buffer*>(std::calloc(1, sizeof(ring_buffer)));
+		if (!rb)
+			return NULL;
+		rb->thread = __atomic_fetch_add(&thread_counter(), 1, __ATOMIC_RELAXED);
+		rb->next = __atomic_load_n(&registry_head(), __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&registry_head(), &rb->next, rb, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+		if (rb->thread == 0)
+			std::atexit(release_at_exit);
+		return rb;
+	}
+
+	inline ring_buffer* local_buffer()
+	{
+		static MERKOL_THREAD_LOCAL ring_buffer* buffer = NULL;
+		if (!buffer)
+			buffer = register_buffer();
+		return buffer;
+	}
+
+	inline void record(const void* container, const char* op, std::size_t size, std::size_t capacity)
+	{
+		if (__atomic_load_n(&released(), __ATOMIC_RELAXED))
+			return;
+		ring_buffer* rb = local_buffer();
+		if (!rb)
+			return;
+		uint64_t	head = rb->head;
+		event&		e = rb->events[head & (kRingSize - 1)];
+
+		e.timestamp	= now();
+		e.container	= container;
+		e.op		= op;
+		e.size		= size;
+		e.capacity	= capacity;
+		__atomic_store_n(&rb->head, head + 1, __ATOMIC_RELEASE);
+	}
+
+	/// for_each_event
+	///
+	/// Visits the retained events of every registered thread, oldest first per thread.
+	/// Reading a buffer while its owner keeps recording is allowed; the events being overwritten
+	/// at that moment may come out torn, which is acceptable for a debugging aid.
+	template <typename Function>
+	inline void for_each_event(Function f)
+	{
+		for (ring_buffer* rb = __atomic_load_n(&registry_head(), __ATOMIC_ACQUIRE); rb; rb = rb->next)
+		{
+			uint64_t head	= __atomic_load_n(&rb->head, __ATOMIC_ACQUIRE);
+			uint64_t first	= (head > kRingSize) ? head - kRingSize : 0;
+
+			for (; first < head; ++first)
+				f(rb->thread, rb->events[first & (kRingSize - 1)]);
+		}
+	}
+
+	inline void to_record(uint32_t thread, const event& e, file_record& r)
+	{
+		std::memset(&r, 0, sizeof(r));
+		r.timestamp	= e.timestamp;
+		r.container	= (uint64_t)(uintptr_t)e.container;
+		r.size		= e.size;
+		r.capacity	= e.capacity;
+		r.thread	= thread;
+		if (e.op)
+			std::strncpy(r.op, e.op, sizeof(r.op) - 1);
+	}
+
+	inline void render(std::ostream& os, const file_record& r)
+	{
+		char line[160];
+
+		snprintf(line, sizeof(line), "[%12llu ns] thread %-3u \033[0;33m%-43s\033[0m container=0x%llx size=%llu capacity=%llu",
+					  (unsigned long long)r.timestamp, r.thread, r.op, (unsigned long long)r.container,
+					  (unsigned long long)r.size, (unsigned long long)r.capacity);
+		os << line << '\n';
+	}
+
+	struct render_visitor
+	{
+		std::ostream* os;
+
+		void operator()(uint32_t thread, const event& e) const
+		{
+			file_record r;
+			to_record(thread, e, r);
+			render(*os, r);
+		}
+	};
+
+	struct write_visitor
+	{
+		std::FILE* file;
+
+		void operator()(uint32_t thread, const event& e) const
+		{
+			file_record r;
+			to_record(thread, e, r);
+			std::fwrite(&r, sizeof(r), 1, file);
+		}
+	};
+
+	/// dump
+	///
+	/// Renders the retained events of every thread as text. Never call this from a hot path.
+	inline void dump(std::ostream& os)
+	{
+		render_visitor v;
+		v.os = &os;
+		for_each_event(v);
+		os.flush();
+	}
+
+	/// flush
+	///
+	/// Writes the retained events of every thread in binary form, to be rendered by trace_dump.
+	inline bool flush(std::FILE* file)
+	{
+		if (!file || std::fwrite(kFileMagic, sizeof(kFileMagic), 1, file) != 1)
+			return false;
+		write_visitor v;
+		v.file = file;
+		for_each_event(v);
+		return std::fflush(file) == 0;
+	}
+
+	inline bool flush(const char* path)
+	{
+		std::FILE*	file = std::fopen(path, "wb");
+		bool		ok = flush(file);
+
+		if (file)
+			std::fclose(file);
+		return ok;
+	}
+
+	// Registered by the first thread that records. Threads still recording at that point must not
+	// outlive it, as for any other static.
+	inline void release_at_exit()
+	{
+		const char* path = std::getenv("MERKOL_TRACE_FILE");
+		if (path)
+			flush(path);
+		__atomic_store_n(&released(), true, __ATOMIC_RELAXED);
+
+		ring_buffer* rb = __atomic_exchange_n(&registry_head(), (ring_buffer*)NULL, __ATOMIC_ACQUIRE);
+		while (rb)
+		{
+			ring_buffer* next = rb->next;
+			std::free(rb);
+			rb = next;
+		}
+	}
+
+} // namespace trace
+} // namespace merkol
+
+#endif // TRACE_HPP
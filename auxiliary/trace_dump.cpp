@@ -0,0 +1,61 @@
+// Renders a trace file written by merkol::trace::flush() (or by MERKOL_TRACE_FILE at exit).
+//
+//	c++ -O2 trace_dump.cpp -o trace_dump
+//	./trace_dump trace.bin [op-filter]
+//
+// Events of all threads are merged and printed in timestamp order, relative to the first event.
+
+#include "trace.hpp"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+static bool by_timestamp(const merkol::trace::file_record& a, const merkol::trace::file_record& b)
+{
+	return a.timestamp < b.timestamp;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " <trace file> [op filter]" << std::endl;
+		return 1;
+	}
+
+	std::FILE* file = std::fopen(argv[1], "rb");
+	if (!file)
+	{
+		std::perror(argv[1]);
+		return 1;
+	}
+
+	char magic[sizeof(merkol::trace::kFileMagic)];
+	if (std::fread(magic, sizeof(magic), 1, file) != 1 || std::memcmp(magic, merkol::trace::kFileMagic, sizeof(magic)) != 0)
+	{
+		std::cerr << argv[1] << ": not a merkol trace file" << std::endl;
+		std::fclose(file);
+		return 1;
+	}
+
+	std::vector<merkol::trace::file_record>	records;
+	merkol::trace::file_record				r;
+
+	while (std::fread(&r, sizeof(r), 1, file) == 1)
+	{
+		if (argc < 3 || std::strstr(r.op, argv[2]))
+			records.push_back(r);
+	}
+	std::fclose(file);
+
+	std::stable_sort(records.begin(), records.end(), by_timestamp);
+
+	uint64_t origin = records.empty() ? 0 : records.front().timestamp;
+	for (std::size_t i = 0; i < records.size(); ++i)
+	{
+		records[i].timestamp -= origin;
+		merkol::trace::render(std::cout, records[i]);
+	}
+	std::cout << records.size() << " events" << std::endl;
+	return 0;
+}
@@ -0,0 +1,170 @@
+// merkol::btree_map against merkol::map and std::map, 64 bit keys and values, from 10^3 to 10^7 entries
+// (10^8 with enough memory): ns per element to insert keys in random order and in ascending order
+// (end() as the hint, the time series case), to find every key in random order, to scan the whole map
+// with iterators and to scan 1000 element ranges from lower_bound; and the resident memory of the map
+// after random insertion, in MiB per million entries. For btree_map the scan column uses
+// merkol::for_each, which streams the leaves (for_each_segment).
+//
+//	c++ -O2 -DNDEBUG -std=c++11 btree_bench.cpp -o btree_bench
+//	./btree_bench [max entries = 10000000]
+//
+// Every measurement runs in its own child process, so that the resident size is not inflated or hidden
+// by what the previous runs left in the heap.
+
+#if __cplusplus < 201103L
+# error "btree_bench requires C++11"
+#endif
+
+#include "../containers/btree_map.hpp"
+#include "../containers/map.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+	typedef unsigned long long	key_type;
+
+	const std::size_t kRangeLength = 1000;
+
+	volatile std::size_t gSink;
+
+	double elapsed_ns(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Resident set size of the process, from /proc/self/statm.
+	std::size_t resident_bytes()
+	{
+		unsigned long	pages		= 0;
+		unsigned long	resident	= 0;
+		FILE* const		statm		= std::fopen("/proc/self/statm", "r");
+
+		if (!statm)
+			return 0;
+		if (std::fscanf(statm, "%lu %lu", &pages, &resident) != 2)
+			resident = 0;
+		std::fclose(statm);
+		return resident * (std::size_t)sysconf(_SC_PAGESIZE);
+	}
+
+	template <typename Map>
+	std::size_t scan(const Map& map)
+	{
+		std::size_t sum = 0;
+
+		for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it)
+			sum += it->second;
+		return sum;
+	}
+
+	struct sum_values
+	{
+		std::size_t* sum;
+
+		template <typename Reference>
+		void operator()(const Reference& r) const { *sum += r.second; }
+	};
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	std::size_t scan(const merkol::btree_map<Key, T, Compare, Allocator, NodeSize>& map)
+	{
+		std::size_t sum = 0;
+
+		merkol::for_each(map.begin(), map.end(), sum_values{ &sum });
+		return sum;
+	}
+
+	template <typename Map>
+	void run(const char* name, std::size_t n)
+	{
+		std::fflush(stdout);
+		pid_t pid = fork();
+		if (pid != 0)
+		{
+			waitpid(pid, NULL, 0);
+			return;
+		}
+
+		std::vector<key_type> shuffled(n);
+		for (std::size_t i = 0; i < n; ++i)
+			shuffled[i] = i * 2;
+		std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64(42));
+
+		std::size_t sum = 0;
+
+		// random insertion, and the memory it takes
+		const std::size_t	residentBefore	= resident_bytes();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		Map* const			map				= new Map;
+		for (std::size_t i = 0; i < n; ++i)
+			(*map)[shuffled[i]] = i;
+		const double		insertRandom	= elapsed_ns(start) / n;
+		const double		mibPerMillion	= (double)(resident_bytes() - residentBefore) / 1048576.0 / n * 1e6;
+
+		start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < n; ++i)
+			sum += map->find(shuffled[i])->second;
+		const double find = elapsed_ns(start) / n;
+
+		start = std::chrono::steady_clock::now();
+		sum += scan(*map);
+		const double fullScan = elapsed_ns(start) / n;
+
+		// ranges of kRangeLength elements from random starting keys, about n elements in all
+		const std::size_t ranges = (n > kRangeLength) ? n / kRangeLength : 1;
+		start = std::chrono::steady_clock::now();
+		for (std::size_t r = 0; r < ranges; ++r)
+		{
+			typename Map::const_iterator it = static_cast<const Map*>(map)->lower_bound(shuffled[r]);
+
+			for (std::size_t i = 0; (i < kRangeLength) && (it != map->end()); ++i, ++it)
+				sum += it->second;
+		}
+		const double rangeScan = elapsed_ns(start) / (ranges * kRangeLength);
+		delete map;
+
+		double insertAscending;
+		{
+			Map ascending;
+
+			start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < n; ++i)
+				ascending.insert(ascending.end(), typename Map::value_type(i * 2, i));
+			insertAscending = elapsed_ns(start) / n;
+			sum += ascending.size();
+		}
+		gSink = sum;
+
+		std::printf("%-16s %10zu %9.1f %9.1f %9.1f %9.2f %9.2f %9.1f\n", name, n, insertRandom, insertAscending,
+					find, fullScan, rangeScan, mibPerMillion);
+		std::fflush(stdout);
+		_exit(0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t maxEntries = (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 10000000;
+
+	std::printf("ns per element, 64 bit keys and values; memory in MiB per million entries\n");
+	std::printf("%-16s %10s %9s %9s %9s %9s %9s %9s\n", "container", "entries", "insert", "ascending", "find",
+				"scan", "ranges", "MiB/M");
+	for (std::size_t n = 1000; n <= maxEntries; n *= 10)
+	{
+		run<std::map<key_type, key_type> >("std::map", n);
+		run<merkol::map<key_type, key_type> >("merkol::map", n);
+		run<merkol::btree_map<key_type, key_type> >("btree_map", n);
+		run<merkol::btree_map<key_type, key_type, merkol::less<key_type>,
+							  std::allocator<std::pair<const key_type, key_type> >, 512> >("btree_map/512", n);
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+// merkol::concurrent_vector against a std::vector behind a std::mutex, 1 to 64 threads appending 32 byte
+// records (a log ingestion pattern): million appends per second with push_back, with grow_by in batches
+// of 64 for concurrent_vector, and with push_back under the lock for std::vector.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 -pthread concurrent_vector_bench.cpp -o concurrent_vector_bench
+//	./concurrent_vector_bench [appends = 16000000] [max threads = 64]
+
+#if __cplusplus < 201103L
+# error "concurrent_vector_bench requires C++11"
+#endif
+
+#include "../containers/concurrent_vector.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	struct record
+	{
+		unsigned long long	timestamp;
+		unsigned			thread;
+		unsigned			level;
+		unsigned long long	offset;
+		unsigned long long	length;
+	};
+
+	const std::size_t kBatch = 64;
+
+	volatile std::size_t gSink;
+
+	template <typename Append>
+	double run(std::size_t threads, std::size_t appends, Append append)
+	{
+		const std::size_t			perThread = appends / threads;
+		std::vector<std::thread>	pool;
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t t = 0; t < threads; ++t)
+			pool.push_back(std::thread(append, (unsigned)t, perThread));
+		for (std::size_t t = 0; t < threads; ++t)
+			pool[t].join();
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return (double)(perThread * threads) / seconds / 1e6;
+	}
+
+	record make_record(unsigned thread, std::size_t i)
+	{
+		record r = { i, thread, (unsigned)(i & 7), i * 64, 64 };
+		return r;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t appends		= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 16000000;
+	const std::size_t maxThreads	= (argc > 2) ? std::strtoull(argv[2], NULL, 10) : 64;
+
+	std::printf("%zu appends of %zu byte records, %u hardware threads (Mappends/s, higher is better)\n", appends,
+				sizeof(record), std::thread::hardware_concurrency());
+	std::printf("%8s %12s %12s %12s\n", "threads", "push_back", "grow_by/64", "mutex");
+	for (std::size_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		double pushed;
+		double grown;
+		double locked;
+
+		{
+			merkol::concurrent_vector<record> v;
+
+			pushed = run(threads, appends, [&v](unsigned t, std::size_t n) {
+				for (std::size_t i = 0; i < n; ++i)
+					v.push_back(make_record(t, i));
+			});
+			gSink = v.size();
+		}
+		{
+			merkol::concurrent_vector<record> v;
+
+			grown = run(threads, appends, [&v](unsigned t, std::size_t n) {
+				for (std::size_t i = 0; i < n; i += kBatch)
+				{
+					const std::size_t count = (n - i < kBatch) ? n - i : kBatch;
+					merkol::concurrent_vector<record>::iterator it = v.grow_by(count);
+
+					for (std::size_t j = 0; j < count; ++j, ++it)
+						*it = make_record(t, i + j);
+				}
+			});
+			gSink = v.size();
+		}
+		{
+			std::mutex			mutex;
+			std::vector<record>	v;
+
+			locked = run(threads, appends, [&](unsigned t, std::size_t n) {
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					const record r = make_record(t, i);
+					std::lock_guard<std::mutex> lock(mutex);
+
+					v.push_back(r);
+				}
+			});
+			gSink = v.size();
+		}
+		std::printf("%8zu %12.1f %12.1f %12.1f\n", threads, pushed, grown, locked);
+		std::fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,446 @@
+// merkol::vector against std::vector: push_back, reserve + fill, random access, iteration, insert and
+// erase in the middle, copy, swap and comparison, for int, double, a 64 byte POD and std::string, at
+// sizes from 16 to 10^8 elements. Every result is reported per operation: nanoseconds, heap allocations
+// and, when the kernel lets us open the counter (perf_event_open), last level cache misses.
+//
+// The results are printed on stdout as JSON so that two runs can be diffed; progress goes to stderr.
+// Configurations that would need more memory than the budget are skipped.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 container_bench.cpp -o container_bench
+//	./container_bench [max size = 100000000] [memory budget in MiB = 2048] > container_bench.json
+//
+// or "make container_bench.json" in this directory, which also records the git revision.
+
+#if __cplusplus < 201103L
+# error "container_bench requires C++11"
+#endif
+
+#include "../containers/vector.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+#ifndef BENCH_REVISION
+# define BENCH_REVISION "unknown"
+#endif
+
+// Every replaceable allocation function is replaced, so that no pointer from the library's operator new
+// reaches our operator delete or the reverse. They are kept out of line: once GCC inlines one side it
+// sees malloc paired with ::operator delete (or new with free) and warns (-Wmismatched-new-delete).
+static std::size_t gAllocations = 0;
+
+static void* counted_malloc(std::size_t size) noexcept
+{
+	++gAllocations;
+	return std::malloc(size ? size : 1);
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size)
+{
+	if (void* p = counted_malloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size)
+{
+	if (void* p = counted_malloc(size))
+		return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+__attribute__((noinline)) void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return counted_malloc(size); }
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+#ifdef __cpp_aligned_new
+static void* counted_aligned_malloc(std::size_t size, std::align_val_t alignment) noexcept
+{
+	const std::size_t align = static_cast<std::size_t>(alignment);
+
+	++gAllocations;
+	return std::aligned_alloc(align, size ? (size + align - 1) / align * align : align);
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void* p = counted_aligned_malloc(size, alignment))
+		return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+	if (void* p = counted_aligned_malloc(size, alignment))
+		return p;
+	throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return counted_aligned_malloc(size, alignment);
+}
+
+__attribute__((noinline)) void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return counted_aligned_malloc(size, alignment);
+}
+
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+__attribute__((noinline)) void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+namespace
+{
+	volatile std::size_t gSink;
+
+	/// cache_miss_counter
+	///
+	/// Hardware cache misses of this thread, user space only. available() is false when
+	/// perf_event_open is missing or refused (containers, perf_event_paranoid > 2, no PMU in the VM).
+	class cache_miss_counter
+	{
+	public:
+		cache_miss_counter() : mFd(-1)
+		{
+		#ifdef __linux__
+			perf_event_attr attr;
+
+			std::memset(&attr, 0, sizeof(attr));
+			attr.type			= PERF_TYPE_HARDWARE;
+			attr.size			= sizeof(attr);
+			attr.config			= PERF_COUNT_HW_CACHE_MISSES;
+			attr.disabled		= 1;
+			attr.exclude_kernel	= 1;
+			attr.exclude_hv		= 1;
+			mFd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		#endif
+		}
+
+		~cache_miss_counter()
+		{
+		#ifdef __linux__
+			if (mFd >= 0)
+				close(mFd);
+		#endif
+		}
+
+		bool available() const { return mFd >= 0; }
+
+		void start()
+		{
+		#ifdef __linux__
+			if (mFd >= 0)
+			{
+				ioctl(mFd, PERF_EVENT_IOC_RESET, 0);
+				ioctl(mFd, PERF_EVENT_IOC_ENABLE, 0);
+			}
+		#endif
+		}
+
+		unsigned long long stop()
+		{
+			unsigned long long count = 0;
+		#ifdef __linux__
+			if (mFd >= 0)
+			{
+				ioctl(mFd, PERF_EVENT_IOC_DISABLE, 0);
+				if (read(mFd, &count, sizeof(count)) != (ssize_t)sizeof(count))
+					count = 0;
+			}
+		#endif
+			return count;
+		}
+
+	private:
+		cache_miss_counter(const cache_miss_counter&);
+		cache_miss_counter& operator=(const cache_miss_counter&);
+
+		int mFd;
+	};
+
+	cache_miss_counter* gCacheMisses;
+
+
+	// Element types
+
+	struct pod64
+	{
+		unsigned long long a[8];
+	};
+
+	inline bool operator==(const pod64& x, const pod64& y) { return std::memcmp(x.a, y.a, sizeof(x.a)) == 0; }
+	inline bool operator<(const pod64& x, const pod64& y) { return std::memcmp(x.a, y.a, sizeof(x.a)) < 0; }
+
+	template <typename T> T make_value(std::size_t i);
+
+	template <> int make_value<int>(std::size_t i) { return (int)(unsigned)(i * 2654435761u); }
+	template <> double make_value<double>(std::size_t i) { return (double)i * 0.5; }
+
+	template <> pod64 make_value<pod64>(std::size_t i)
+	{
+		pod64 value;
+
+		for (int k = 0; k < 8; ++k)
+			value.a[k] = i + k;
+		return value;
+	}
+
+	// Longer than the small string buffer, so every string owns a heap block like most real ones.
+	template <> std::string make_value<std::string>(std::size_t i)
+	{
+		char buffer[64];
+
+		std::snprintf(buffer, sizeof(buffer), "merkol-container-bench-%zu", i);
+		return buffer;
+	}
+
+	// What the read-only benchmarks accumulate, so that the loads can not be optimized away.
+	inline std::size_t touch(int value)					{ return (std::size_t)value; }
+	inline std::size_t touch(double value)				{ return (std::size_t)value; }
+	inline std::size_t touch(const pod64& value)		{ return (std::size_t)value.a[0]; }
+	inline std::size_t touch(const std::string& value)	{ return value.size(); }
+
+	template <typename T> const char* type_name();
+	template <> const char* type_name<int>()			{ return "int"; }
+	template <> const char* type_name<double>()			{ return "double"; }
+	template <> const char* type_name<pod64>()			{ return "pod64"; }
+	template <> const char* type_name<std::string>()	{ return "std::string"; }
+
+	// Bytes a filled container of n elements occupies, heap blocks of the elements included.
+	template <typename T> std::size_t footprint(std::size_t n) { return n * sizeof(T); }
+	template <> std::size_t footprint<std::string>(std::size_t n) { return n * (sizeof(std::string) + 48); }
+
+
+	// Measurement
+
+	const std::size_t kTargetOps	= 1 << 18;			// operations timed per sample, at least
+	const std::size_t kStateBudget	= 64 * 1024 * 1024;	// bytes of prepared containers per sample, at most
+
+	struct result
+	{
+		double	ns_per_op;
+		double	allocations_per_op;
+		double	cache_misses_per_op;
+	};
+
+	template <typename Vector>
+	struct state
+	{
+		Vector	v;
+		Vector	other;
+	};
+
+	template <typename Vector>
+	void fill(Vector& v, std::size_t n)
+	{
+		typedef typename Vector::value_type value_type;
+
+		for (std::size_t i = 0; i < n; ++i)
+			v.push_back(make_value<value_type>(i));
+	}
+
+	// Runs body on freshly prepared states and keeps the fastest sample. Preparing the states (setup)
+	// and destroying them is not timed. opsPerRun is how many operations one call to body performs.
+	template <typename Vector, typename Setup, typename Body>
+	result measure(std::size_t n, std::size_t opsPerRun, Setup setup, Body body)
+	{
+		typedef typename Vector::value_type value_type;
+
+		const std::size_t	stateBytes	= 2 * footprint<value_type>(n) + sizeof(state<Vector>);
+		std::size_t			batch		= (kTargetOps + opsPerRun - 1) / opsPerRun;
+		if (batch * stateBytes > kStateBudget)
+			batch = (kStateBudget / stateBytes) ? kStateBudget / stateBytes : 1;
+		const int			samples		= (n >= 10000000) ? 1 : (n >= 1000000) ? 3 : 5;
+		result				best		= { 1e300, 0, 0 };
+
+		for (int sample = 0; sample < samples; ++sample)
+		{
+			std::vector<state<Vector> > states(batch);
+
+			for (std::size_t b = 0; b < batch; ++b)
+				setup(states[b]);
+
+			const std::size_t allocationsBefore = gAllocations;
+			gCacheMisses->start();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			for (std::size_t b = 0; b < batch; ++b)
+				body(states[b]);
+
+			const double				ns		= std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			const unsigned long long	misses	= gCacheMisses->stop();
+			const double				ops		= (double)(batch * opsPerRun);
+
+			if (ns / ops < best.ns_per_op)
+			{
+				best.ns_per_op				= ns / ops;
+				best.allocations_per_op		= (double)(gAllocations - allocationsBefore) / ops;
+				best.cache_misses_per_op	= (double)misses / ops;
+			}
+		}
+		return best;
+	}
+
+	bool gFirstResult = true;
+
+	void report(const char* container, const char* type, std::size_t n, const char* op, const result& r)
+	{
+		std::printf("%s\n    {\"container\": \"%s\", \"type\": \"%s\", \"size\": %zu, \"op\": \"%s\", "
+					"\"ns_per_op\": %.4f, \"allocations_per_op\": %.4f, \"cache_misses_per_op\": ",
+					gFirstResult ? "" : ",", container, type, n, op, r.ns_per_op, r.allocations_per_op);
+		if (gCacheMisses->available())
+			std::printf("%.4f}", r.cache_misses_per_op);
+		else
+			std::printf("null}");
+		gFirstResult = false;
+		std::fflush(stdout);
+	}
+
+	template <typename Vector>
+	void run_all(const char* container, std::size_t n)
+	{
+		typedef typename Vector::value_type value_type;
+		typedef state<Vector>				state_type;
+
+		const char* const	type		= type_name<value_type>();
+		const value_type	value		= make_value<value_type>(n);
+		// Inserting or erasing in the middle moves half the elements, so fewer are done on big containers.
+		const std::size_t	middleOps	= (kTargetOps / n < 1) ? 1 : (kTargetOps / n > 64) ? 64 : kTargetOps / n;
+		const std::size_t	swaps		= 1024;
+
+		std::fprintf(stderr, "%s<%s> %zu\n", container, type, n);
+
+		report(container, type, n, "push_back", measure<Vector>(n, n,
+			[](state_type&) { },
+			[&](state_type& s) { fill(s.v, n); }));
+
+		report(container, type, n, "reserve_fill", measure<Vector>(n, n,
+			[](state_type&) { },
+			[&](state_type& s) { s.v.reserve(n); fill(s.v, n); }));
+
+		report(container, type, n, "random_access", measure<Vector>(n, n,
+			[&](state_type& s) { fill(s.v, n); },
+			[&](state_type& s)
+			{
+				std::size_t		sum	= 0;
+				unsigned		x	= 12345;
+
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					x = x * 1664525u + 1013904223u;
+					sum += touch(s.v[(std::size_t)(((unsigned long long)x * n) >> 32)]);
+				}
+				gSink = sum;
+			}));
+
+		report(container, type, n, "iterate", measure<Vector>(n, n,
+			[&](state_type& s) { fill(s.v, n); },
+			[&](state_type& s)
+			{
+				std::size_t sum = 0;
+
+				for (typename Vector::const_iterator it = s.v.begin(), end = s.v.end(); it != end; ++it)
+					sum += touch(*it);
+				gSink = sum;
+			}));
+
+		report(container, type, n, "insert_middle", measure<Vector>(n, middleOps,
+			[&](state_type& s) { fill(s.v, n); },
+			[&](state_type& s)
+			{
+				for (std::size_t i = 0; i < middleOps; ++i)
+					s.v.insert(s.v.begin() + s.v.size() / 2, value);
+			}));
+
+		report(container, type, n, "erase_middle", measure<Vector>(n, (middleOps < n) ? middleOps : n,
+			[&](state_type& s) { fill(s.v, n); },
+			[&](state_type& s)
+			{
+				for (std::size_t i = 0; i < middleOps && !s.v.empty(); ++i)
+					s.v.erase(s.v.begin() + s.v.size() / 2);
+			}));
+
+		report(container, type, n, "copy", measure<Vector>(n, n,
+			[&](state_type& s) { fill(s.v, n); },
+			[&](state_type& s)
+			{
+				Vector copy(s.v);
+				gSink = copy.size();
+			}));
+
+		report(container, type, n, "swap", measure<Vector>(n, swaps,
+			[&](state_type& s) { fill(s.v, n); },
+			[&](state_type& s)
+			{
+				for (std::size_t i = 0; i < swaps; ++i)
+					s.v.swap(s.other);
+				gSink = s.v.size();
+			}));
+
+		report(container, type, n, "compare", measure<Vector>(n, n,
+			[&](state_type& s) { fill(s.v, n); fill(s.other, n); },
+			[&](state_type& s) { gSink = (std::size_t)(s.v == s.other) + (std::size_t)(s.v < s.other); }));
+	}
+
+	template <typename T>
+	void run_type(std::size_t n, std::size_t budget)
+	{
+		// The biggest state is a container plus its copy; pessimistically count a spare one for growth.
+		if (3 * footprint<T>(n) > budget)
+		{
+			std::fprintf(stderr, "skipping %s at %zu elements: over the memory budget\n", type_name<T>(), n);
+			return;
+		}
+		run_all<merkol::vector<T> >("merkol::vector", n);
+		run_all<std::vector<T> >("std::vector", n);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t maxSize	= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 100000000;
+	const std::size_t budget	= ((argc > 2) ? std::strtoull(argv[2], NULL, 10) : 2048) * 1024 * 1024;
+	const std::size_t sizes[]	= { 16, 256, 4096, 65536, 1000000, 10000000, 100000000 };
+
+	cache_miss_counter counter;
+	gCacheMisses = &counter;
+	if (!counter.available())
+		std::fprintf(stderr, "perf_event_open unavailable: cache_misses_per_op will be null\n");
+
+	std::printf("{\n  \"benchmark\": \"container_bench\",\n  \"revision\": \"%s\",\n  \"compiler\": \"%s\",\n"
+				"  \"cache_miss_counter\": %s,\n  \"results\": [",
+				BENCH_REVISION, __VERSION__, counter.available() ? "true" : "false");
+
+	for (std::size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]) && sizes[i] <= maxSize; ++i)
+	{
+		run_type<int>(sizes[i], budget);
+		run_type<double>(sizes[i], budget);
+		run_type<pod64>(sizes[i], budget);
+		run_type<std::string>(sizes[i], budget);
+	}
+
+	std::printf("\n  ]\n}\n");
+	return 0;
+}
@@ -0,0 +1,172 @@
+// merkol::deque with different block sizes versus std::deque (512 byte blocks in libstdc++).
+// Workloads: a FIFO work queue (push_back / pop_front at a steady size), push_front, iteration with ++,
+// random access with operator[], and the block-wise merkol::for_each / merkol::fill over the same elements.
+// Reports ns per element and heap allocations per element.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 deque_bench.cpp -o deque_bench
+//	./deque_bench [elements = 1000000] [repetitions = 5]
+
+#if __cplusplus < 201103L
+# error "deque_bench requires C++11"
+#endif
+
+#include "../containers/deque.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <new>
+
+static std::size_t gAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+	++gAllocations;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+	volatile long gSink;
+
+	struct result
+	{
+		double	ns_per_element;
+		double	allocations_per_element;
+	};
+
+	struct adder
+	{
+		long sum;
+
+		adder() : sum(0) { }
+		void operator()(int x) { sum += x; }
+	};
+
+	// Best of repetitions. Prepare builds the container outside of the timed region, Work returns a checksum.
+	template <typename Deque, typename Prepare, typename Work>
+	result measure(std::size_t n, int repetitions, Prepare prepare, Work work)
+	{
+		result best = { 1e300, 0 };
+
+		for (int r = 0; r < repetitions; ++r)
+		{
+			Deque d;
+			prepare(d);
+
+			std::size_t allocationsBefore = gAllocations;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			gSink = work(d);
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			if (ns / n < best.ns_per_element)
+			{
+				best.ns_per_element = ns / n;
+				best.allocations_per_element = (double)(gAllocations - allocationsBefore) / n;
+			}
+		}
+		return best;
+	}
+
+	template <typename Deque>
+	void fill_back(Deque& d, std::size_t n)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+			d.push_back((int)i);
+	}
+
+	void report(const char* container, const char* workload, const result& r)
+	{
+		std::printf("%-28s %-14s %8.3f ns/element %8.4f allocations/element\n",
+					container, workload, r.ns_per_element, r.allocations_per_element);
+	}
+
+	// Workloads every deque supports.
+	template <typename Deque>
+	void run_common(const char* name, std::size_t n, int repetitions)
+	{
+		// 1000 queued items, n pushed through
+		report(name, "fifo", measure<Deque>(n, repetitions,
+			[](Deque& d) { fill_back(d, 1000); },
+			[n](Deque& d) {
+				long sum = 0;
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					d.push_back((int)i);
+					sum += d.front();
+					d.pop_front();
+				}
+				return sum;
+			}));
+
+		report(name, "push_back", measure<Deque>(n, repetitions,
+			[](Deque&) { },
+			[n](Deque& d) { fill_back(d, n); return (long)d.size(); }));
+
+		report(name, "push_front", measure<Deque>(n, repetitions,
+			[](Deque&) { },
+			[n](Deque& d) {
+				for (std::size_t i = 0; i < n; ++i)
+					d.push_front((int)i);
+				return (long)d.size();
+			}));
+
+		report(name, "iterate", measure<Deque>(n, repetitions,
+			[n](Deque& d) { fill_back(d, n); },
+			[](Deque& d) {
+				long sum = 0;
+				for (typename Deque::iterator it = d.begin(); it != d.end(); ++it)
+					sum += *it;
+				return sum;
+			}));
+
+		report(name, "random_access", measure<Deque>(n, repetitions,
+			[n](Deque& d) { fill_back(d, n); },
+			[n](Deque& d) {
+				long sum = 0;
+				std::size_t index = 0;
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					index = (index + 7919) % n;
+					sum += d[index];
+				}
+				return sum;
+			}));
+	}
+
+	// The block-wise algorithms, on merkol::deque only.
+	template <typename Deque>
+	void run_segmented(const char* name, std::size_t n, int repetitions)
+	{
+		run_common<Deque>(name, n, repetitions);
+
+		report(name, "for_each", measure<Deque>(n, repetitions,
+			[n](Deque& d) { fill_back(d, n); },
+			[](Deque& d) { return merkol::for_each(d.begin(), d.end(), adder()).sum; }));
+
+		report(name, "fill", measure<Deque>(n, repetitions,
+			[n](Deque& d) { fill_back(d, n); },
+			[](Deque& d) { merkol::fill(d.begin(), d.end(), 3); return (long)d.back(); }));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t	n			= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 1000000;
+	int			repetitions	= (argc > 2) ? std::atoi(argv[2]) : 5;
+
+	if (n == 0)
+		n = 1;
+	std::printf("deque<int>: %zu elements, best of %d\n", n, repetitions);
+	run_common<std::deque<int> >("std::deque", n, repetitions);
+	run_segmented<merkol::deque<int, std::allocator<int>, 64> >("merkol::deque (64)", n, repetitions);
+	run_segmented<merkol::deque<int, std::allocator<int>, 256> >("merkol::deque (256)", n, repetitions);
+	run_segmented<merkol::deque<int> >("merkol::deque (default 1024)", n, repetitions);
+	run_segmented<merkol::deque<int, std::allocator<int>, 16384> >("merkol::deque (16384)", n, repetitions);
+	return 0;
+}
@@ -0,0 +1,152 @@
+// merkol::flat_hash_map against std::unordered_map, 64 bit keys and values, from 10^3 to 10^8 keys:
+// insert into an empty map, lookups that hit (in random order), lookups that miss, iteration, and
+// erasing every key. Small maps are run many times over, so that every measurement covers at least
+// 10^7 operations. Sizes whose maps would not fit in the memory budget are skipped.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 flat_hash_bench.cpp -o flat_hash_bench
+//	./flat_hash_bench [max keys = 100000000] [memory budget in MiB = 2048]
+
+#if __cplusplus < 201103L
+# error "flat_hash_bench requires C++11"
+#endif
+
+#include "../containers/flat_hash_map.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	typedef unsigned long long	key_type;
+
+	volatile std::size_t gSink;
+
+	// splitmix64: distinct keys with every bit random.
+	key_type next_key(key_type& state)
+	{
+		key_type z = (state += 0x9E3779B97F4A7C15ull);
+
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	struct key_set
+	{
+		std::vector<key_type>	keys;		// inserted, in insertion order
+		std::vector<key_type>	shuffled;	// the same keys, lookup order
+		std::vector<key_type>	missing;	// keys that are not in the map
+	};
+
+	key_set make_keys(std::size_t n)
+	{
+		key_set		set;
+		key_type	state = 42;
+
+		set.keys.resize(n);
+		set.missing.resize(n);
+		for (std::size_t i = 0; i < n; ++i)
+			set.keys[i] = next_key(state);
+		for (std::size_t i = 0; i < n; ++i)
+			set.missing[i] = next_key(state);
+		set.shuffled = set.keys;
+		std::shuffle(set.shuffled.begin(), set.shuffled.end(), std::mt19937_64(7));
+		return set;
+	}
+
+	double elapsed_ns(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	struct result
+	{
+		double insert;
+		double hit;
+		double miss;
+		double iterate;
+		double erase;
+	};
+
+	// ns per operation of each workload, averaged over rounds fresh maps.
+	template <typename Map>
+	result run(const key_set& set, std::size_t rounds)
+	{
+		const std::size_t	n = set.keys.size();
+		result				r = { 0, 0, 0, 0, 0 };
+		std::size_t			sum = 0;
+
+		for (std::size_t round = 0; round < rounds; ++round)
+		{
+			Map map;
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < n; ++i)
+				map[set.keys[i]] = i;
+			r.insert += elapsed_ns(start);
+
+			start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < n; ++i)
+				sum += map.find(set.shuffled[i])->second;
+			r.hit += elapsed_ns(start);
+
+			start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < n; ++i)
+				sum += (map.find(set.missing[i]) == map.end());
+			r.miss += elapsed_ns(start);
+
+			start = std::chrono::steady_clock::now();
+			for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it)
+				sum += it->second;
+			r.iterate += elapsed_ns(start);
+
+			start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < n; ++i)
+				sum += map.erase(set.shuffled[i]);
+			r.erase += elapsed_ns(start);
+		}
+		gSink = sum;
+
+		const double ops = (double)n * rounds;
+		r.insert /= ops;
+		r.hit /= ops;
+		r.miss /= ops;
+		r.iterate /= ops;
+		r.erase /= ops;
+		return r;
+	}
+
+	void report(const char* name, std::size_t n, const result& r)
+	{
+		std::printf("%-22s %10zu %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, n, r.insert, r.hit, r.miss, r.iterate, r.erase);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t maxKeys	= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 100000000;
+	const std::size_t budget	= ((argc > 2) ? std::strtoull(argv[2], NULL, 10) : 2048) * 1024 * 1024;
+
+	std::printf("ns per operation, 64 bit keys and values\n");
+	std::printf("%-22s %10s %9s %9s %9s %9s %9s\n", "container", "keys", "insert", "hit", "miss", "iterate", "erase");
+	for (std::size_t n = 1000; n <= maxKeys; n *= 10)
+	{
+		// key arrays, plus about 64 bytes per node and bucket of std::unordered_map
+		if (n * (3 * sizeof(key_type) + 64) > budget)
+		{
+			std::fprintf(stderr, "skipping %zu keys: over the memory budget\n", n);
+			break;
+		}
+
+		const key_set		set		= make_keys(n);
+		const std::size_t	rounds	= (n < 10000000) ? 10000000 / n : 1;
+
+		report("std::unordered_map", n, run<std::unordered_map<key_type, key_type> >(set, rounds));
+		report("merkol::flat_hash_map", n, run<merkol::flat_hash_map<key_type, key_type> >(set, rounds));
+	}
+	return 0;
+}
@@ -0,0 +1,168 @@
+// merkol::flat_map against std::map, 64 bit keys and values, from 10^2 to 10^7 keys: ns per lookup that
+// hits, in random order, and per lookup that misses; plus the time to build the map from an unsorted
+// batch, with insert(first, last) for flat_map. A third column searches the same sorted key array
+// with std::lower_bound, to separate what the branchless search gains from what the layout gains.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 flat_map_bench.cpp -o flat_map_bench
+//	./flat_map_bench [max keys = 10000000]
+
+#if __cplusplus < 201103L
+# error "flat_map_bench requires C++11"
+#endif
+
+#include "../containers/flat_map.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	typedef unsigned long long	key_type;
+
+	volatile std::size_t gSink;
+
+	struct key_set
+	{
+		std::vector<std::pair<key_type, key_type> >	entries;	// unsorted
+		std::vector<key_type>						hits;		// the keys, lookup order
+		std::vector<key_type>						misses;		// keys that are not in the map
+	};
+
+	// Even keys are in the map, odd keys are not, so that misses land between the entries.
+	key_set make_keys(std::size_t n)
+	{
+		key_set				set;
+		std::mt19937_64		random(42);
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const key_type key = random() & ~1ull;
+
+			set.entries.push_back(std::make_pair(key, (key_type)i));
+			set.hits.push_back(key);
+			set.misses.push_back(key | 1);
+		}
+		std::shuffle(set.hits.begin(), set.hits.end(), std::mt19937_64(7));
+		std::shuffle(set.misses.begin(), set.misses.end(), std::mt19937_64(11));
+		return set;
+	}
+
+	double elapsed_ns(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	struct result
+	{
+		double build;
+		double hit;
+		double miss;
+	};
+
+	// Lookups are repeated until every measurement covers at least 10^7 of them.
+	template <typename Find>
+	double time_lookups(const std::vector<key_type>& keys, Find find)
+	{
+		const std::size_t	rounds	= (keys.size() < 10000000) ? 10000000 / keys.size() : 1;
+		std::size_t			sum		= 0;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t round = 0; round < rounds; ++round)
+		{
+			for (std::size_t i = 0; i < keys.size(); ++i)
+				sum += find(keys[i]);
+		}
+		const double ns = elapsed_ns(start);
+
+		gSink = sum;
+		return ns / ((double)keys.size() * rounds);
+	}
+
+	result run_std_map(const key_set& set)
+	{
+		typedef std::map<key_type, key_type> map_type;
+
+		result r;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		map_type map(set.entries.begin(), set.entries.end());
+		r.build = elapsed_ns(start) / set.entries.size();
+
+		r.hit = time_lookups(set.hits, [&map](key_type key) { return map.find(key)->second; });
+		r.miss = time_lookups(set.misses, [&map](key_type key) { return (std::size_t)(map.find(key) == map.end()); });
+		return r;
+	}
+
+	result run_flat_map(const key_set& set)
+	{
+		typedef merkol::flat_map<key_type, key_type> map_type;
+
+		result r;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		map_type map;
+		map.insert(set.entries.begin(), set.entries.end());
+		r.build = elapsed_ns(start) / set.entries.size();
+
+		r.hit = time_lookups(set.hits, [&map](key_type key) { return map.find(key)->second; });
+		r.miss = time_lookups(set.misses, [&map](key_type key) { return (std::size_t)(map.find(key) == map.end()); });
+		return r;
+	}
+
+	// The same sorted arrays as the flat_map, searched with the branchy std::lower_bound.
+	result run_std_lower_bound(const key_set& set)
+	{
+		std::vector<std::pair<key_type, key_type> >	sorted(set.entries);
+		std::vector<key_type>						keys;
+		std::vector<key_type>						values;
+		result										r;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::sort(sorted.begin(), sorted.end());
+		for (std::size_t i = 0; i < sorted.size(); ++i)
+		{
+			keys.push_back(sorted[i].first);
+			values.push_back(sorted[i].second);
+		}
+		r.build = elapsed_ns(start) / set.entries.size();
+
+		r.hit = time_lookups(set.hits, [&keys, &values](key_type key)
+		{
+			return values[std::lower_bound(keys.begin(), keys.end(), key) - keys.begin()];
+		});
+		r.miss = time_lookups(set.misses, [&keys](key_type key)
+		{
+			const std::vector<key_type>::const_iterator it = std::lower_bound(keys.begin(), keys.end(), key);
+
+			return (std::size_t)((it == keys.end()) || (*it != key));
+		});
+		return r;
+	}
+
+	void report(const char* name, std::size_t n, const result& r)
+	{
+		std::printf("%-22s %10zu %9.2f %9.2f %9.2f\n", name, n, r.build, r.hit, r.miss);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t maxKeys = (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 10000000;
+
+	std::printf("ns per entry (build) and per lookup, 64 bit keys and values\n");
+	std::printf("%-22s %10s %9s %9s %9s\n", "container", "keys", "build", "hit", "miss");
+	for (std::size_t n = 100; n <= maxKeys; n *= 10)
+	{
+		const key_set set = make_keys(n);
+
+		report("std::map", n, run_std_map(set));
+		report("std::lower_bound", n, run_std_lower_bound(set));
+		report("merkol::flat_map", n, run_flat_map(set));
+	}
+	return 0;
+}
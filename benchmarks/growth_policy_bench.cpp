@@ -0,0 +1,100 @@
+// Pushes N ints into merkol::vector under each growth policy and reports reallocations,
+// bytes copied during growth, and the peak RSS of the process.
+//
+//	c++ -O2 -DNDEBUG growth_policy_bench.cpp -o growth_policy_bench
+//	./growth_policy_bench [N = 100000000]
+//
+// Every policy runs in its own child process so that ru_maxrss is not polluted by the previous run.
+
+#include "../containers/vector.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+	struct growth_counters
+	{
+		std::size_t	allocations;
+		std::size_t	bytesAllocated;
+		std::size_t	liveElements;	// elements in the most recent block
+		std::size_t	bytesCopied;	// every block freed before the last one was copied out of in full
+	};
+
+	growth_counters gCounters;
+
+	// std::allocator that reports to gCounters. A vector only frees a block (before its destructor)
+	// once its content has been copied to the next one, and push_back only grows a full block.
+	template <typename T>
+	struct counting_allocator : public std::allocator<T>
+	{
+		counting_allocator() { }
+		counting_allocator(const counting_allocator& other) : std::allocator<T>(other) { }
+
+		T* allocate(std::size_t n)
+		{
+			++gCounters.allocations;
+			gCounters.bytesAllocated += n * sizeof(T);
+			return std::allocator<T>().allocate(n);
+		}
+
+		void deallocate(T* p, std::size_t n)
+		{
+			gCounters.bytesCopied += n * sizeof(T);
+			std::allocator<T>().deallocate(p, n);
+		}
+
+		std::size_t max_size() const { return (std::size_t)-1 / sizeof(T); }
+	};
+
+	double seconds()
+	{
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		return tv.tv_sec + tv.tv_usec * 1e-6;
+	}
+
+	template <typename GrowthPolicy>
+	void run(const char* name, std::size_t n)
+	{
+		std::fflush(stdout);
+		pid_t pid = fork();
+		if (pid != 0)
+		{
+			waitpid(pid, NULL, 0);
+			return;
+		}
+
+		merkol::vector<int, counting_allocator<int>, GrowthPolicy> v;
+		double start = seconds();
+
+		for (std::size_t i = 0; i < n; ++i)
+			v.push_back((int)i);
+
+		double elapsed = seconds() - start;
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+
+		std::printf("%-12s %14zu %14.1f %14.1f %14.1f %12.2f %10.3f\n", name, gCounters.allocations,
+					gCounters.bytesAllocated / 1048576.0, gCounters.bytesCopied / 1048576.0,
+					usage.ru_maxrss / 1024.0, (double)v.capacity() / v.size(), elapsed);
+		std::fflush(stdout);
+		_exit(0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t n = (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 100000000ull;
+
+	std::printf("push_back of %zu ints\n", n);
+	std::printf("%-12s %14s %14s %14s %14s %12s %10s\n", "policy", "reallocations", "allocated MiB",
+				"copied MiB", "peak RSS MiB", "cap/size", "seconds");
+	run<merkol::growth_policy_double>("2x", n);
+	run<merkol::growth_policy_one_and_half>("1.5x", n);
+	run<merkol::growth_policy_size_class>("size-class", n);
+	return 0;
+}
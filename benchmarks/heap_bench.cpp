@@ -0,0 +1,230 @@
+// Priority queues of uint64_t keys: std::priority_queue against merkol::priority_queue (binary heap) and
+// merkol::d_ary_heap with 4 and 8 children, on n pushes then n pops, and on the "hold" model of event
+// queues (pop the top, push it back a random amount later, 10 n times at size n). Then Dijkstra's
+// algorithm on a random directed graph: lazy deletion with std::priority_queue and d_ary_heap<4>,
+// against decrease_key on merkol::indexed_heap<4>. Reports ms; the Dijkstra distances are checked.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 heap_bench.cpp -o heap_bench
+//	./heap_bench [heap size = 1000000] [vertices = 1000000] [edges = 10000000]
+
+#if __cplusplus < 201103L
+# error "heap_bench requires C++11"
+#endif
+
+#include "../containers/priority_queue.hpp"
+#include "../containers/vector.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <random>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	typedef std::pair<uint64_t, uint32_t> item;	// distance, vertex
+
+	const uint64_t kInfinity = ~(uint64_t)0;
+
+	volatile uint64_t gSink;
+
+	template <typename Kernel>
+	double time_ms(Kernel kernel)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		kernel();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// One step of the hold model for heaps without replace_top.
+	template <typename Heap>
+	void pop_push(Heap& heap, uint64_t key)
+	{
+		heap.pop();
+		heap.push(key);
+	}
+
+	template <typename Heap>
+	double push_pop(const std::vector<uint64_t>& keys)
+	{
+		Heap heap;
+
+		return time_ms([&] {
+			for (std::size_t i = 0; i < keys.size(); ++i)
+				heap.push(keys[i]);
+			for (std::size_t i = 0; i < keys.size(); ++i)
+			{
+				gSink = heap.top();
+				heap.pop();
+			}
+		});
+	}
+
+	template <typename Heap, typename Step>
+	double hold(const std::vector<uint64_t>& keys, Step step)
+	{
+		Heap			heap;
+		std::mt19937_64	rng(7);
+
+		for (std::size_t i = 0; i < keys.size(); ++i)
+			heap.push(keys[i]);
+		return time_ms([&] {
+			for (std::size_t i = 0; i < 10 * keys.size(); ++i)
+				step(heap, heap.top() + (rng() & 0xFFFFF));
+		});
+	}
+
+	// Compressed adjacency lists: the edges of v are [first[v], first[v + 1]).
+	struct graph
+	{
+		std::vector<uint32_t>	first;
+		std::vector<uint32_t>	target;
+		std::vector<uint32_t>	weight;
+	};
+
+	graph make_graph(uint32_t vertices, std::size_t edges)
+	{
+		std::mt19937_64	rng(42);
+		graph			g;
+
+		g.first.resize(vertices + 1);
+		g.target.resize(edges);
+		g.weight.resize(edges);
+		for (uint32_t v = 0; v <= vertices; ++v)
+			g.first[v] = (uint32_t)((uint64_t)edges * v / vertices);
+		for (uint32_t v = 0; v < vertices; ++v)
+		{
+			for (uint32_t e = g.first[v]; e < g.first[v + 1]; ++e)
+			{
+				// The first edge of every vertex goes to the next one, so that all are reachable.
+				g.target[e] = (e == g.first[v]) ? (v + 1) % vertices : (uint32_t)(rng() % vertices);
+				g.weight[e] = 1 + (uint32_t)(rng() % 1000);
+			}
+		}
+		return g;
+	}
+
+	// Dijkstra with lazy deletion: a shorter path pushes the vertex again, stale entries are skipped.
+	template <typename Heap>
+	double dijkstra_lazy(const graph& g, std::vector<uint64_t>& dist, std::size_t& peak)
+	{
+		Heap heap;
+
+		dist.assign(g.first.size() - 1, kInfinity);
+		peak = 0;
+		return time_ms([&] {
+			dist[0] = 0;
+			heap.push(item(0, 0));
+			while (!heap.empty())
+			{
+				const item top = heap.top();
+
+				heap.pop();
+				if (top.first != dist[top.second])
+					continue;
+				for (uint32_t e = g.first[top.second]; e < g.first[top.second + 1]; ++e)
+				{
+					const uint64_t d = top.first + g.weight[e];
+
+					if (d < dist[g.target[e]])
+					{
+						dist[g.target[e]] = d;
+						heap.push(item(d, g.target[e]));
+					}
+				}
+				peak = std::max(peak, (std::size_t)heap.size());
+			}
+		});
+	}
+
+	// Dijkstra with decrease_key: every vertex is in the heap at most once.
+	double dijkstra_indexed(const graph& g, std::vector<uint64_t>& dist, std::size_t& peak)
+	{
+		typedef merkol::indexed_heap<item, 4, merkol::greater<item> > heap_type;
+
+		const uint32_t						vertices = (uint32_t)(g.first.size() - 1);
+		heap_type							heap;
+		std::vector<heap_type::handle_type>	handle(vertices, heap_type::kInvalidHandle);
+
+		dist.assign(vertices, kInfinity);
+		peak = 0;
+		return time_ms([&] {
+			dist[0] = 0;
+			handle[0] = heap.push(item(0, 0));
+			while (!heap.empty())
+			{
+				const item top = heap.top();
+
+				heap.pop();
+				handle[top.second] = heap_type::kInvalidHandle;
+				for (uint32_t e = g.first[top.second]; e < g.first[top.second + 1]; ++e)
+				{
+					const uint32_t	v = g.target[e];
+					const uint64_t	d = top.first + g.weight[e];
+
+					if (d < dist[v])
+					{
+						dist[v] = d;
+						if (handle[v] == heap_type::kInvalidHandle)
+							handle[v] = heap.push(item(d, v));
+						else
+							heap.decrease_key(handle[v], item(d, v));
+					}
+				}
+				peak = std::max(peak, (std::size_t)heap.size());
+			}
+		});
+	}
+
+	void report_dijkstra(const char* name, double ms, std::size_t peak, const std::vector<uint64_t>& dist, const std::vector<uint64_t>& expected)
+	{
+		std::printf("%-34s %10.1f %12zu%s\n", name, ms, peak, (dist == expected) ? "" : "  WRONG DISTANCES");
+		std::fflush(stdout);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	typedef std::priority_queue<uint64_t>			std_heap;
+	typedef merkol::priority_queue<uint64_t>		binary_heap;
+	typedef merkol::d_ary_heap<uint64_t, 4>			heap4;
+	typedef merkol::d_ary_heap<uint64_t, 8>			heap8;
+
+	const std::size_t	n			= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 1000000;
+	const uint32_t		vertices	= (argc > 2) ? (uint32_t)std::strtoul(argv[2], NULL, 10) : 1000000;
+	const std::size_t	edges		= (argc > 3) ? std::strtoull(argv[3], NULL, 10) : 10000000;
+
+	std::vector<uint64_t>	keys(n);
+	std::mt19937_64			rng(1);
+
+	for (std::size_t i = 0; i < n; ++i)
+		keys[i] = rng() >> 16;
+
+	std::printf("%zu keys (ms, lower is better)\n", n);
+	std::printf("%-24s %10s %10s\n", "heap", "push/pop", "hold");
+	std::printf("%-24s %10.1f %10.1f\n", "std::priority_queue", push_pop<std_heap>(keys), hold<std_heap>(keys, pop_push<std_heap>));
+	std::printf("%-24s %10.1f %10.1f\n", "priority_queue", push_pop<binary_heap>(keys), hold<binary_heap>(keys, pop_push<binary_heap>));
+	std::printf("%-24s %10.1f %10.1f\n", "d_ary_heap<4>", push_pop<heap4>(keys), hold<heap4>(keys, pop_push<heap4>));
+	std::printf("%-24s %10.1f %10.1f\n", "d_ary_heap<8>", push_pop<heap8>(keys), hold<heap8>(keys, pop_push<heap8>));
+	std::printf("%-24s %10s %10.1f\n", "d_ary_heap<4> replace_top", "",
+				hold<heap4>(keys, [](heap4& heap, uint64_t key) { heap.replace_top(key); }));
+
+	const graph				g = make_graph(vertices, edges);
+	std::vector<uint64_t>	expected;
+	std::vector<uint64_t>	dist;
+	std::size_t				peak;
+	double					ms;
+
+	std::printf("\ndijkstra, %u vertices, %zu edges (ms, peak heap size)\n", vertices, edges);
+	ms = dijkstra_lazy<std::priority_queue<item, std::vector<item>, std::greater<item> > >(g, expected, peak);
+	report_dijkstra("std::priority_queue, lazy", ms, peak, expected, expected);
+	ms = dijkstra_lazy<merkol::d_ary_heap<item, 4, merkol::greater<item> > >(g, dist, peak);
+	report_dijkstra("d_ary_heap<4>, lazy", ms, peak, dist, expected);
+	ms = dijkstra_indexed(g, dist, peak);
+	report_dijkstra("indexed_heap<4>, decrease_key", ms, peak, dist, expected);
+	return 0;
+}
@@ -0,0 +1,103 @@
+// Codegen regression check: summing a merkol::vector<float> through its iterators must run as fast as
+// summing a raw float array. If the iterator stops being a trivially copyable wrapper around a pointer
+// the loop is no longer vectorized and this program fails (exit status 1).
+// -ffast-math lets the compiler reorder the float additions, which it needs to vectorize the reduction.
+//
+//	c++ -O3 -ffast-math -DNDEBUG -std=c++11 iterator_codegen_bench.cpp -o iterator_codegen_bench
+//	./iterator_codegen_bench [elements = 4096] [repetitions = 20000] [tolerance = 1.10]
+
+#if __cplusplus < 201103L
+# error "iterator_codegen_bench requires C++11"
+#endif
+
+#include "../containers/vector.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	volatile float gSink;
+
+	// noinline so that each loop is compiled on its own and can not be folded into the timing loop.
+	__attribute__((noinline)) float sum_pointer(const float* first, const float* last)
+	{
+		float sum = 0;
+
+		for (; first != last; ++first)
+			sum += *first;
+		return sum;
+	}
+
+	__attribute__((noinline)) float sum_iterator(merkol::vector<float>::const_iterator first, merkol::vector<float>::const_iterator last)
+	{
+		float sum = 0;
+
+		for (; first != last; ++first)
+			sum += *first;
+		return sum;
+	}
+
+	__attribute__((noinline)) float sum_index(const merkol::vector<float>& v)
+	{
+		float sum = 0;
+
+		for (merkol::vector<float>::size_type i = 0, n = v.size(); i < n; ++i)
+			sum += v.data()[i];
+		return sum;
+	}
+
+	template <typename Function>
+	double best_ns(Function f, int repetitions)
+	{
+		double best = 1e300;
+
+		for (int round = 0; round < 5; ++round)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			for (int r = 0; r < repetitions; ++r)
+				gSink = f();
+
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / repetitions;
+			if (ns < best)
+				best = ns;
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t	n			= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 4096;
+	int			repetitions	= (argc > 2) ? std::atoi(argv[2]) : 20000;
+	double		tolerance	= (argc > 3) ? std::atof(argv[3]) : 1.10;
+
+	float* const			raw = new float[n];
+	merkol::vector<float>	v;
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		raw[i] = (float)(i % 17) * 0.25f;
+		v.push_back(raw[i]);
+	}
+
+	const merkol::vector<float>& cv = v;
+	double pointer	= best_ns([&] { return sum_pointer(raw, raw + n); }, repetitions);
+	double iterator	= best_ns([&] { return sum_iterator(cv.begin(), cv.end()); }, repetitions);
+	double index	= best_ns([&] { return sum_index(cv); }, repetitions);
+
+	std::printf("sum of %zu floats, best of 5 x %d (ns per sum)\n", n, repetitions);
+	std::printf("%-32s %10.1f\n", "float*", pointer);
+	std::printf("%-32s %10.1f %6.2fx\n", "vector<float>::const_iterator", iterator, iterator / pointer);
+	std::printf("%-32s %10.1f %6.2fx\n", "vector<float>::data()[i]", index, index / pointer);
+	delete[] raw;
+
+	if (iterator > pointer * tolerance)
+	{
+		std::printf("FAIL: the iterator loop is more than %.0f%% slower than the pointer loop\n", (tolerance - 1) * 100);
+		return 1;
+	}
+	std::printf("ok\n");
+	return 0;
+}
@@ -0,0 +1,136 @@
+// merkol::map against std::map, 64 bit keys and values, from 10^3 to 10^7 entries: ns per element to
+// insert keys in random order, to insert ascending keys with end() as the hint, to build the map from
+// a sorted range, to find every key (random order) and to iterate; and the resident memory the map
+// takes, in MiB per million entries.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 map_bench.cpp -o map_bench
+//	./map_bench [max entries = 10000000]
+//
+// Every measurement runs in its own child process, so that the resident size is not inflated or hidden
+// by what the previous runs left in the heap.
+
+#if __cplusplus < 201103L
+# error "map_bench requires C++11"
+#endif
+
+#include "../containers/map.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace
+{
+	typedef unsigned long long	key_type;
+
+	volatile std::size_t gSink;
+
+	double elapsed_ns(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// Resident set size of the process, from /proc/self/statm.
+	std::size_t resident_bytes()
+	{
+		unsigned long	pages		= 0;
+		unsigned long	resident	= 0;
+		FILE* const		statm		= std::fopen("/proc/self/statm", "r");
+
+		if (!statm)
+			return 0;
+		if (std::fscanf(statm, "%lu %lu", &pages, &resident) != 2)
+			resident = 0;
+		std::fclose(statm);
+		return resident * (std::size_t)sysconf(_SC_PAGESIZE);
+	}
+
+	template <typename Map>
+	void run(const char* name, std::size_t n)
+	{
+		std::fflush(stdout);
+		pid_t pid = fork();
+		if (pid != 0)
+		{
+			waitpid(pid, NULL, 0);
+			return;
+		}
+
+		std::vector<key_type> keys(n);
+		for (std::size_t i = 0; i < n; ++i)
+			keys[i] = i * 2;
+		std::vector<key_type> shuffled(keys);
+		std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64(42));
+		std::vector<std::pair<key_type, key_type> > sorted(n);
+		for (std::size_t i = 0; i < n; ++i)
+			sorted[i] = std::make_pair(keys[i], keys[i]);
+
+		std::size_t sum = 0;
+
+		// random insertion, and the memory it takes
+		const std::size_t	residentBefore	= resident_bytes();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		Map* const			map				= new Map;
+		for (std::size_t i = 0; i < n; ++i)
+			(*map)[shuffled[i]] = i;
+		const double		insertRandom	= elapsed_ns(start) / n;
+		const double		mibPerMillion	= (double)(resident_bytes() - residentBefore) / 1048576.0 / n * 1e6;
+
+		start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < n; ++i)
+			sum += map->find(shuffled[i])->second;
+		const double find = elapsed_ns(start) / n;
+
+		start = std::chrono::steady_clock::now();
+		for (typename Map::const_iterator it = map->begin(); it != map->end(); ++it)
+			sum += it->second;
+		const double iterate = elapsed_ns(start) / n;
+		delete map;
+
+		double insertHinted;
+		{
+			Map hinted;
+
+			start = std::chrono::steady_clock::now();
+			for (std::size_t i = 0; i < n; ++i)
+				hinted.insert(hinted.end(), typename Map::value_type(keys[i], i));
+			insertHinted = elapsed_ns(start) / n;
+			sum += hinted.size();
+		}
+
+		double build;
+		{
+			start = std::chrono::steady_clock::now();
+			Map built(sorted.begin(), sorted.end());
+			build = elapsed_ns(start) / n;
+			sum += built.size();
+		}
+		gSink = sum;
+
+		std::printf("%-12s %10zu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", name, n, insertRandom, insertHinted, build,
+					find, iterate, mibPerMillion);
+		std::fflush(stdout);
+		_exit(0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t maxEntries = (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 10000000;
+
+	std::printf("ns per element, 64 bit keys and values; memory in MiB per million entries\n");
+	std::printf("%-12s %10s %9s %9s %9s %9s %9s %9s\n", "container", "entries", "insert", "hinted", "sorted", "find",
+				"iterate", "MiB/M");
+	for (std::size_t n = 1000; n <= maxEntries; n *= 10)
+	{
+		run<std::map<key_type, key_type> >("std::map", n);
+		run<merkol::map<key_type, key_type> >("merkol::map", n);
+	}
+	return 0;
+}
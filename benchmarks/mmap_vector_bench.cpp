@@ -0,0 +1,124 @@
+// Loading a lookup table of uint64_t saved by the previous run: deserializing it into a merkol::vector
+// (fread of the whole file) against opening it as a read-only merkol::mmap_vector, then a sequential
+// scan and random lookups over each. Also times building the table with push_back in both.
+// Reports ms; the file is in the page cache for every load, so the times are those of a warm start.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 mmap_vector_bench.cpp -o mmap_vector_bench
+//	./mmap_vector_bench [elements = 100000000] [file = mmap_vector_bench.bin]
+
+#if __cplusplus < 201103L
+# error "mmap_vector_bench requires C++11"
+#endif
+
+#include "../containers/mmap_vector.hpp"
+#include "../containers/vector.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+	const std::size_t kLookups = 10000000;
+
+	volatile uint64_t gSink;
+
+	template <typename Kernel>
+	double time_ms(Kernel kernel)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		kernel();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	template <typename Table>
+	double scan(const Table& table)
+	{
+		return time_ms([&] {
+			uint64_t sum = 0;
+
+			for (std::size_t i = 0; i < table.size(); ++i)
+				sum += table.data()[i];
+			gSink = sum;
+		});
+	}
+
+	template <typename Table>
+	double lookups(const Table& table)
+	{
+		std::mt19937_64 rng(3);
+
+		return time_ms([&] {
+			uint64_t sum = 0;
+
+			for (std::size_t i = 0; i < kLookups; ++i)
+				sum += table.data()[rng() % table.size()];
+			gSink = sum;
+		});
+	}
+
+	void report(const char* name, double vectorMs, double mappedMs)
+	{
+		std::printf("%-22s %12.1f %12.1f\n", name, vectorMs, mappedMs);
+		std::fflush(stdout);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t	n		= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 100000000;
+	const char* const	path	= (argc > 2) ? argv[2] : "mmap_vector_bench.bin";
+	const std::string	dump	= std::string(path) + ".raw";
+
+	std::printf("%zu uint64_t (ms, lower is better)\n", n);
+	std::printf("%-22s %12s %12s\n", "", "vector", "mmap_vector");
+
+	// Build: the vector is then saved the usual way, with one fwrite.
+	{
+		merkol::vector<uint64_t>		table;
+		merkol::mmap_vector<uint64_t>	mapped(path, merkol::kMapCreate);
+		const double					vectorMs = time_ms([&] { for (std::size_t i = 0; i < n; ++i) table.push_back(i * 7); });
+		const double					mappedMs = time_ms([&] { for (std::size_t i = 0; i < n; ++i) mapped.push_back(i * 7); });
+
+		report("build (push_back)", vectorMs, mappedMs);
+		report("save (fwrite, msync)",
+			time_ms([&] {
+				FILE* file = std::fopen(dump.c_str(), "wb");
+
+				if ((file == NULL) || (std::fwrite(table.data(), sizeof(uint64_t), n, file) != n) || (std::fclose(file) != 0))
+					std::perror("fwrite");
+			}),
+			time_ms([&] { mapped.sync(); }));
+	}
+
+	// Load, as at the start of the next run.
+	merkol::vector<uint64_t> table;
+
+	report("load (fread, mmap)",
+		time_ms([&] {
+			FILE* file = std::fopen(dump.c_str(), "rb");
+
+			table.resize(n);
+			if ((file == NULL) || (std::fread(table.data(), sizeof(uint64_t), n, file) != n))
+				std::perror("fread");
+			if (file != NULL)
+				std::fclose(file);
+		}),
+		time_ms([&] { merkol::mmap_vector<uint64_t> reopened(path, merkol::kMapReadOnly); gSink = reopened.size(); }));
+
+	merkol::mmap_vector<uint64_t> mapped(path, merkol::kMapReadOnly);
+
+	mapped.advise(merkol::kAdviseSequential);
+	report("first scan", scan(table), scan(mapped));
+	report("second scan", scan(table), scan(mapped));
+	mapped.advise(merkol::kAdviseRandom);
+	report("random lookups", lookups(table), lookups(mapped));
+
+	::unlink(path);
+	::unlink(dump.c_str());
+	return 0;
+}
@@ -0,0 +1,87 @@
+// Growth cost of merkol::vector versus std::vector for payloads that are expensive to copy
+// (std::string longer than the SSO buffer) or impossible to copy (std::unique_ptr).
+// Also counts heap allocations, which shows whether reallocation moved or deep-copied the strings.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 move_bench.cpp -o move_bench
+//	./move_bench [elements = 1000000] [repetitions = 5]
+
+#if __cplusplus < 201103L
+# error "move_bench requires C++11"
+#endif
+
+#include "../containers/vector.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::size_t gAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+	++gAllocations;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+	struct result
+	{
+		double		ns_per_element;
+		std::size_t	allocations;
+	};
+
+	template <typename Vector, typename Make>
+	result push_back_run(std::size_t n, int repetitions, Make make)
+	{
+		result best = { 1e300, 0 };
+
+		for (int r = 0; r < repetitions; ++r)
+		{
+			Vector v;
+			std::size_t allocationsBefore = gAllocations;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			for (std::size_t i = 0; i < n; ++i)
+				v.push_back(make(i));
+
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			if (ns / n < best.ns_per_element)
+			{
+				best.ns_per_element = ns / n;
+				best.allocations = gAllocations - allocationsBefore;
+			}
+		}
+		return best;
+	}
+
+	void report(const char* payload, const char* container, const result& r, std::size_t n)
+	{
+		std::printf("%-22s %-20s %10.2f ns/elem %12zu allocations (%.2f per element)\n",
+					payload, container, r.ns_per_element, r.allocations, (double)r.allocations / n);
+	}
+
+	std::string make_string(std::size_t i) { return std::string(48, (char)('a' + i % 26)); }
+	std::unique_ptr<int> make_unique(std::size_t i) { return std::unique_ptr<int>(new int((int)i)); }
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t	n			= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 1000000;
+	int			repetitions	= (argc > 2) ? std::atoi(argv[2]) : 5;
+
+	std::printf("push_back of %zu elements, best of %d\n", n, repetitions);
+	report("std::string (48 chars)", "merkol::vector", push_back_run<merkol::vector<std::string> >(n, repetitions, make_string), n);
+	report("std::string (48 chars)", "std::vector", push_back_run<std::vector<std::string> >(n, repetitions, make_string), n);
+	report("std::unique_ptr<int>", "merkol::vector", push_back_run<merkol::vector<std::unique_ptr<int> > >(n, repetitions, make_unique), n);
+	report("std::unique_ptr<int>", "std::vector", push_back_run<std::vector<std::unique_ptr<int> > >(n, repetitions, make_unique), n);
+	return 0;
+}
@@ -0,0 +1,207 @@
+// merkol::mpmc_queue against a std::deque behind a std::mutex and two condition variables (the queue it
+// replaces), both bounded to 1024 elements, with 1 to N producers and as many consumers using the
+// blocking push and pop. Reports million messages per second through the queue and the 99th percentile
+// of the time from push to pop, in ns (one message in 16 is timed).
+//
+// Before that, a stress run pushes and pops through a queue of capacity 2 with more threads than
+// hardware threads, so that both sides keep going to sleep; a watchdog aborts if no message moves
+// for 10 seconds (a lost wakeup), and the sum of the messages popped is checked.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 -pthread mpmc_queue_bench.cpp -o mpmc_queue_bench
+//	./mpmc_queue_bench [messages = 4000000] [max producers = 2 * hardware threads]
+
+#if __cplusplus < 201103L
+# error "mpmc_queue_bench requires C++11"
+#endif
+
+#include "../containers/mpmc_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef unsigned long long	message;	// push time in ns
+
+	const std::size_t kCapacity		= 1024;
+	const std::size_t kSampleEvery	= 16;
+	const int kStallSeconds			= 10;
+
+	message now_ns()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	class locked_queue
+	{
+	public:
+		void push(message value)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			mNotFull.wait(lock, [this] { return mQueue.size() < kCapacity; });
+			mQueue.push_back(value);
+			lock.unlock();
+			mNotEmpty.notify_one();
+		}
+
+		void pop(message& value)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			mNotEmpty.wait(lock, [this] { return !mQueue.empty(); });
+			value = mQueue.front();
+			mQueue.pop_front();
+			lock.unlock();
+			mNotFull.notify_one();
+		}
+
+	private:
+		std::mutex				mMutex;
+		std::condition_variable	mNotEmpty;
+		std::condition_variable	mNotFull;
+		std::deque<message>		mQueue;
+	};
+
+	// Blocking push and pop only, through a queue that is almost always full or empty.
+	void stress(std::size_t threads, std::size_t messages)
+	{
+		merkol::mpmc_queue<message>	queue(2);
+		const std::size_t			perThread = messages / threads;
+		std::atomic<std::size_t>	popped(0);
+		std::atomic<message>		sum(0);
+		std::atomic<bool>			done(false);
+		std::vector<std::thread>	pool;
+
+		std::thread watchdog([&popped, &done] {
+			std::size_t	last	= popped.load();
+			int			idle	= 0;
+
+			while (!done.load())
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+				const std::size_t current = popped.load();
+
+				idle = (current == last) ? idle + 1 : 0;
+				last = current;
+				if (idle == kStallSeconds * 10)
+				{
+					std::fprintf(stderr, "stress: no progress for %d s after %zu messages, lost wakeup\n", kStallSeconds, current);
+					std::abort();
+				}
+			}
+		});
+		for (std::size_t t = 0; t < threads; ++t)
+		{
+			pool.push_back(std::thread([&queue, perThread] {
+				for (std::size_t i = 1; i <= perThread; ++i)
+					queue.push(i);
+			}));
+			pool.push_back(std::thread([&queue, &popped, &sum, perThread] {
+				message value;
+
+				for (std::size_t i = 0; i < perThread; ++i)
+				{
+					queue.pop(value);
+					sum.fetch_add(value, std::memory_order_relaxed);
+					popped.fetch_add(1, std::memory_order_relaxed);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < pool.size(); ++t)
+			pool[t].join();
+		done.store(true);
+		watchdog.join();
+
+		const message expected = (message)threads * perThread * (perThread + 1) / 2;
+
+		if (sum.load() != expected || !queue.empty())
+		{
+			std::fprintf(stderr, "stress: popped sum %llu, expected %llu\n", sum.load(), expected);
+			std::abort();
+		}
+		std::printf("stress, capacity 2, %zu producers and %zu consumers, %zu messages: ok\n",
+					threads, threads, perThread * threads);
+	}
+
+	struct result
+	{
+		double	mops;
+		double	p99;
+	};
+
+	template <typename Queue>
+	result run(Queue& queue, std::size_t threads, std::size_t messages)
+	{
+		const std::size_t					perThread = messages / threads;
+		std::vector<std::vector<double> >	latencies(threads);
+		std::vector<std::thread>			pool;
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (std::size_t t = 0; t < threads; ++t)
+		{
+			pool.push_back(std::thread([&queue, perThread] {
+				for (std::size_t i = 0; i < perThread; ++i)
+					queue.push((i % kSampleEvery == 0) ? now_ns() : 0);
+			}));
+			pool.push_back(std::thread([&queue, &latencies, perThread, t] {
+				std::vector<double>&	samples = latencies[t];
+				message					value;
+
+				samples.reserve(perThread / kSampleEvery + 1);
+				for (std::size_t i = 0; i < perThread; ++i)
+				{
+					queue.pop(value);
+					if (value != 0)
+						samples.push_back((double)(now_ns() - value));
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < pool.size(); ++t)
+			pool[t].join();
+
+		const double		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::vector<double>	all;
+
+		for (std::size_t t = 0; t < threads; ++t)
+			all.insert(all.end(), latencies[t].begin(), latencies[t].end());
+		std::sort(all.begin(), all.end());
+
+		result r;
+		r.mops	= (double)(perThread * threads) / seconds / 1e6;
+		r.p99	= all.empty() ? 0 : all[all.size() - all.size() / 100 - 1];
+		return r;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t hardware		= std::max(1u, std::thread::hardware_concurrency());
+	const std::size_t messages		= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 4000000;
+	const std::size_t maxThreads	= (argc > 2) ? std::strtoull(argv[2], NULL, 10) : 2 * hardware;
+
+	stress(std::max<std::size_t>(16, 2 * hardware), std::min<std::size_t>(messages, 400000));
+	std::printf("%zu messages, capacity %zu, %zu hardware threads; Mmsg/s (higher is better), p99 push to pop in ns\n",
+				messages, kCapacity, hardware);
+	std::printf("%10s %10s %10s %10s %10s\n", "producers", "mpmc", "p99", "mutex", "p99");
+	for (std::size_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		merkol::mpmc_queue<message>	lockFree(kCapacity);
+		locked_queue				locked;
+
+		const result a = run(lockFree, threads, messages);
+		const result b = run(locked, threads, messages);
+
+		std::printf("%10zu %10.2f %10.0f %10.2f %10.0f\n", threads, a.mops, a.p99, b.mops, b.p99);
+		std::fflush(stdout);
+	}
+	return 0;
+}
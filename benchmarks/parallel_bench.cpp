@@ -0,0 +1,109 @@
+// merkol::parallel algorithms against their sequential std:: counterparts over a merkol::vector<double>:
+// for_each, transform, reduce (default and deterministic), fill, copy, equal, find (of the last element),
+// sort and stable_sort. Reports the best time of a few runs in ms, and the speedup.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 -pthread parallel_bench.cpp -o parallel_bench
+//	./parallel_bench [elements = 100000000] [threads = hardware threads]
+
+#if __cplusplus < 201103L
+# error "parallel_bench requires C++11"
+#endif
+
+#include "../aux_templates/parallel_algorithm.hpp"
+#include "../containers/vector.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace
+{
+	namespace par = merkol::parallel;
+
+	const int kRepeats = 3;
+
+	volatile double gSink;
+
+	template <typename Prepare, typename Kernel>
+	double best_ms(Prepare prepare, Kernel kernel)
+	{
+		double best = 1e30;
+
+		for (int r = 0; r < kRepeats; ++r)
+		{
+			prepare();
+
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			kernel();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	template <typename Kernel>
+	double best_ms(Kernel kernel)
+	{
+		return best_ms([] { }, kernel);
+	}
+
+	void report(const char* name, double sequential, double parallel)
+	{
+		std::printf("%-16s %12.1f %12.1f %8.2fx\n", name, sequential, parallel, sequential / parallel);
+		std::fflush(stdout);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t	n		= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 100000000;
+	const std::size_t	threads	= (argc > 2) ? std::strtoull(argv[2], NULL, 10) : 0;
+	par::thread_pool	pool(threads);
+	const par::policy	policy	= par::policy().pool(pool);
+
+	merkol::vector<double>	a(n);
+	merkol::vector<double>	b(n);
+	merkol::vector<double>	keys;
+	std::mt19937_64			rng(42);
+
+	for (std::size_t i = 0; i < n; ++i)
+		a[i] = (double)(rng() >> 11) * (1.0 / 9007199254740992.0);
+	keys = a;
+
+	std::printf("%zu doubles, %zu workers, best of %d (ms, lower is better)\n", n, pool.size(), kRepeats);
+	std::printf("%-16s %12s %12s %9s\n", "algorithm", "std", "parallel", "speedup");
+
+	report("for_each",
+		best_ms([&] { std::for_each(b.begin(), b.end(), [](double& x) { x = x * 1.5 + 1.0; }); }),
+		best_ms([&] { par::for_each(policy, b.begin(), b.end(), [](double& x) { x = x * 1.5 + 1.0; }); }));
+	report("transform",
+		best_ms([&] { std::transform(a.begin(), a.end(), b.begin(), [](double x) { return x * x; }); }),
+		best_ms([&] { par::transform(policy, a.begin(), a.end(), b.begin(), [](double x) { return x * x; }); }));
+	report("reduce",
+		best_ms([&] { gSink = std::accumulate(a.begin(), a.end(), 0.0); }),
+		best_ms([&] { gSink = par::reduce(policy, a.begin(), a.end(), 0.0); }));
+	report("reduce (det.)",
+		best_ms([&] { gSink = std::accumulate(a.begin(), a.end(), 0.0); }),
+		best_ms([&] { gSink = par::reduce(par::policy(policy).deterministic(), a.begin(), a.end(), 0.0); }));
+	report("fill",
+		best_ms([&] { std::fill(b.begin(), b.end(), 2.0); }),
+		best_ms([&] { par::fill(policy, b.begin(), b.end(), 2.0); }));
+	report("copy",
+		best_ms([&] { std::copy(a.begin(), a.end(), b.begin()); }),
+		best_ms([&] { par::copy(policy, a.begin(), a.end(), b.begin()); }));
+	report("equal",
+		best_ms([&] { gSink = std::equal(a.begin(), a.end(), b.begin()); }),
+		best_ms([&] { gSink = par::equal(policy, a.begin(), a.end(), b.begin()); }));
+	report("find (last)",
+		best_ms([&] { gSink = (double)(std::find(a.begin(), a.end(), a[n - 1]) - a.begin()); }),
+		best_ms([&] { gSink = (double)(par::find(policy, a.begin(), a.end(), a[n - 1]) - a.begin()); }));
+	report("sort",
+		best_ms([&] { b = keys; }, [&] { std::sort(b.begin(), b.end()); }),
+		best_ms([&] { b = keys; }, [&] { par::sort(policy, b.begin(), b.end()); }));
+	report("stable_sort",
+		best_ms([&] { b = keys; }, [&] { std::stable_sort(b.begin(), b.end()); }),
+		best_ms([&] { b = keys; }, [&] { par::stable_sort(policy, b.begin(), b.end()); }));
+	return 0;
+}
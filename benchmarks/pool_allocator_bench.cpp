@@ -0,0 +1,98 @@
+// Threads building and destroying merkol::vector buffers, with merkol::pool_allocator and with glibc malloc.
+// Every thread keeps a ring of live vectors and replaces a random one at each step, so allocations and
+// frees of many sizes interleave. Reports million vectors built per second for 1 to 64 threads.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 -pthread pool_allocator_bench.cpp -o pool_allocator_bench
+//	./pool_allocator_bench [vectors per thread = 200000] [max threads = 64]
+
+#if __cplusplus < 201103L
+# error "pool_allocator_bench requires C++11"
+#endif
+
+#include "../containers/vector.hpp"
+#include "../memory/pool_allocator.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Plain malloc/free; merkol::malloc_allocator would let vector realloc in place and skew the comparison.
+	template <typename T>
+	struct libc_allocator
+	{
+		typedef T			value_type;
+		typedef std::size_t	size_type;
+
+		template <typename U>
+		struct rebind { typedef libc_allocator<U> other; };
+
+		T* allocate(std::size_t n)
+		{
+			if (void* p = std::malloc(n * sizeof(T)))
+				return static_cast<T*>(p);
+			throw std::bad_alloc();
+		}
+
+		void		deallocate(T* p, std::size_t) { std::free(p); }
+		std::size_t	max_size() const { return (std::size_t)-1 / sizeof(T) / 2; }
+	};
+
+	const std::size_t kRing = 64;
+
+	template <typename Vector>
+	void worker(std::size_t iterations, unsigned seed)
+	{
+		std::vector<Vector> ring(kRing);
+
+		for (std::size_t i = 0; i < iterations; ++i)
+		{
+			seed = seed * 1103515245u + 12345u;
+			Vector& slot = ring[(seed >> 8) % kRing];
+			Vector fresh;
+			const int n = (int)((seed >> 16) % 256) + 1;
+
+			for (int k = 0; k < n; ++k)
+				fresh.push_back(k);
+			slot.swap(fresh); // the previous occupant is freed here
+		}
+	}
+
+	template <typename Vector>
+	double run(std::size_t threads, std::size_t iterations)
+	{
+		std::vector<std::thread> pool;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		for (std::size_t t = 0; t < threads; ++t)
+			pool.push_back(std::thread(worker<Vector>, iterations, (unsigned)(t * 7919 + 1)));
+		for (std::size_t t = 0; t < threads; ++t)
+			pool[t].join();
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return (double)(threads * iterations) / seconds / 1e6;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t iterations	= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 200000;
+	std::size_t maxThreads	= (argc > 2) ? std::strtoull(argv[2], NULL, 10) : 64;
+
+	std::printf("%zu vectors of 1-256 ints per thread (Mvectors/s, higher is better)\n", iterations);
+	std::printf("%8s %14s %14s %8s\n", "threads", "pool", "malloc", "ratio");
+	for (std::size_t threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		double pooled	= run<merkol::vector<int, merkol::pool_allocator<int> > >(threads, iterations);
+		double libc		= run<merkol::vector<int, libc_allocator<int> > >(threads, iterations);
+
+		std::printf("%8zu %14.2f %14.2f %8.2f\n", threads, pooled, libc, pooled / libc);
+	}
+
+	std::printf("\npool statistics\n");
+	merkol::pool::print_stats(std::cout);
+	return 0;
+}
@@ -0,0 +1,94 @@
+// Create / push_back 4 elements / destroy, the life of most of our short vectors.
+// Reports heap allocations per operation and ns per operation for merkol::vector and merkol::small_vector.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 small_vector_bench.cpp -o small_vector_bench
+//	./small_vector_bench [operations = 10000000] [repetitions = 5]
+
+#if __cplusplus < 201103L
+# error "small_vector_bench requires C++11"
+#endif
+
+#include "../containers/vector.hpp"
+#include "../containers/small_vector.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::size_t gAllocations = 0;
+
+void* operator new(std::size_t size)
+{
+	++gAllocations;
+	if (void* p = std::malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace
+{
+	volatile long gSink;
+
+	struct result
+	{
+		double	ns_per_op;
+		double	allocations_per_op;
+	};
+
+	template <typename Vector>
+	result run(std::size_t n, int repetitions, std::size_t elements, bool reserve)
+	{
+		result best = { 1e300, 0 };
+
+		for (int r = 0; r < repetitions; ++r)
+		{
+			std::size_t allocationsBefore = gAllocations;
+			long sum = 0;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				Vector v;
+				if (reserve)
+					v.reserve(elements);
+				for (std::size_t k = 0; k < elements; ++k)
+					v.push_back((int)(i + k));
+				sum += v[elements - 1];
+			}
+
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			gSink = sum;
+			if (ns / n < best.ns_per_op)
+			{
+				best.ns_per_op = ns / n;
+				best.allocations_per_op = (double)(gAllocations - allocationsBefore) / n;
+			}
+		}
+		return best;
+	}
+
+	void report(const char* name, const result& r)
+	{
+		std::printf("%-34s %10.2f ns/op %8.2f allocations/op\n", name, r.ns_per_op, r.allocations_per_op);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t	n			= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 10000000;
+	int			repetitions	= (argc > 2) ? std::atoi(argv[2]) : 5;
+
+	std::printf("create, push_back 4 ints, destroy: %zu operations, best of %d\n", n, repetitions);
+	report("merkol::vector<int>", run<merkol::vector<int> >(n, repetitions, 4, false));
+	report("merkol::vector<int> + reserve(4)", run<merkol::vector<int> >(n, repetitions, 4, true));
+	report("merkol::small_vector<int, 4>", run<merkol::small_vector<int, 4> >(n, repetitions, 4, false));
+	report("merkol::small_vector<int, 8>", run<merkol::small_vector<int, 8> >(n, repetitions, 4, false));
+
+	std::printf("\nsame with 12 ints (spills to the heap)\n");
+	report("merkol::vector<int>", run<merkol::vector<int> >(n / 4, repetitions, 12, false));
+	report("merkol::small_vector<int, 8>", run<merkol::small_vector<int, 8> >(n / 4, repetitions, 12, false));
+	return 0;
+}
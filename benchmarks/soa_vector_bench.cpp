@@ -0,0 +1,115 @@
+// merkol::soa_vector<...> against a merkol::vector of structs (array of structures) holding the same
+// 32 byte rows of a trade table: the sum of one column, and a filter (the sum of the quantities of the
+// rows whose price is above a threshold). Reports million rows per second and GB/s of row data.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 soa_vector_bench.cpp -o soa_vector_bench
+//	./soa_vector_bench [rows = 100000000] [repeats = 5]
+
+#if __cplusplus < 201103L
+# error "soa_vector_bench requires C++11"
+#endif
+
+#include "../containers/soa_vector.hpp"
+#include "../containers/vector.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	struct trade
+	{
+		long long	timestamp;
+		double		price;
+		int			quantity;
+		int			venue;
+		long long	id;
+	};
+
+	typedef merkol::soa_vector<long long, double, int, int, long long>	trade_columns;
+
+	enum { kTimestamp, kPrice, kQuantity, kVenue, kId };
+
+	const double kThreshold = 900.0;
+
+	volatile double gSink;
+
+	template <typename Kernel>
+	double best_seconds(std::size_t repeats, Kernel kernel)
+	{
+		double best = 1e30;
+
+		for (std::size_t r = 0; r < repeats; ++r)
+		{
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			gSink = kernel();
+			best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	void report(const char* name, std::size_t rows, double aos, double soa)
+	{
+		const double gb = (double)rows * sizeof(trade) / 1e9;
+
+		std::printf("%-12s %12.0f %12.0f %10.2f %10.2f %8.2fx\n", name, rows / aos / 1e6, rows / soa / 1e6,
+					gb / aos, gb / soa, aos / soa);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t rows		= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 100000000;
+	const std::size_t repeats	= (argc > 2) ? std::strtoull(argv[2], NULL, 10) : 5;
+
+	merkol::vector<trade>	aos;
+	trade_columns			soa;
+
+	aos.reserve(rows);
+	soa.reserve(rows);
+	for (std::size_t i = 0; i < rows; ++i)
+	{
+		const trade t = { (long long)i, (double)(i * 7919 % 1000), (int)(i % 100), (int)(i % 16), (long long)(i * 31) };
+
+		aos.push_back(t);
+		soa.push_back(t.timestamp, t.price, t.quantity, t.venue, t.id);
+	}
+
+	std::printf("%zu rows of %zu bytes, best of %zu (Mrows/s and GB/s of rows, higher is better)\n", rows, sizeof(trade), repeats);
+	std::printf("%-12s %12s %12s %10s %10s %9s\n", "kernel", "aos", "soa", "aos GB/s", "soa GB/s", "soa/aos");
+
+	const double sumAos = best_seconds(repeats, [&aos] {
+		double sum = 0;
+		for (std::size_t i = 0, n = aos.size(); i < n; ++i)
+			sum += aos[i].price;
+		return sum;
+	});
+	const double sumSoa = best_seconds(repeats, [&soa] {
+		merkol::column_span<const double>	price	= static_cast<const trade_columns&>(soa).column<kPrice>();
+		double								sum		= 0;
+
+		for (std::size_t i = 0, n = price.size(); i < n; ++i)
+			sum += price[i];
+		return sum;
+	});
+	report("column sum", rows, sumAos, sumSoa);
+
+	const double filterAos = best_seconds(repeats, [&aos] {
+		long long sum = 0;
+		for (std::size_t i = 0, n = aos.size(); i < n; ++i)
+			sum += (aos[i].price > kThreshold) ? aos[i].quantity : 0;
+		return (double)sum;
+	});
+	const double filterSoa = best_seconds(repeats, [&soa] {
+		const double*	price		= soa.data<kPrice>();
+		const int*		quantity	= soa.data<kQuantity>();
+		long long		sum			= 0;
+
+		for (std::size_t i = 0, n = soa.size(); i < n; ++i)
+			sum += (price[i] > kThreshold) ? quantity[i] : 0;
+		return (double)sum;
+	});
+	report("filter", rows, filterAos, filterSoa);
+	return 0;
+}
@@ -0,0 +1,271 @@
+// merkol::spsc_ring between two threads pinned to a pair of CPUs, the producer on the first CPU the process
+// may run on and the consumer on each CPU in turn (the first pair shares one CPU). For every pair:
+// million 8 byte messages per second pushed and popped one at a time, in batches of 64 with push_n/pop_n,
+// and through a std::deque behind a std::mutex; and the one way latency (half of a ping-pong round trip
+// through two rings), median and 99th percentile.
+//
+//	c++ -O2 -DNDEBUG -std=c++11 -pthread spsc_ring_bench.cpp -o spsc_ring_bench
+//	./spsc_ring_bench [messages = 20000000] [round trips = 200000]
+//
+// A waiting side spins, and yields its CPU after 64 failed attempts, so that the shared CPU pair (and
+// machines with fewer CPUs than threads) make progress.
+
+#if __cplusplus < 201103L
+# error "spsc_ring_bench requires C++11"
+#endif
+
+#include "../containers/spsc_ring.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <pthread.h>
+#include <sched.h>
+
+namespace
+{
+	typedef unsigned long long	message;
+
+	const std::size_t kCapacity	= 4096;
+	const std::size_t kBatch	= 64;
+
+	typedef merkol::spsc_ring<message, kCapacity>	ring_type;
+
+	volatile message gSink;
+
+	struct backoff
+	{
+		unsigned misses = 0;
+
+		void operator()()
+		{
+			if (++misses == 64)
+			{
+				misses = 0;
+				std::this_thread::yield();
+			}
+		}
+	};
+
+	void pin(std::thread& thread, int cpu)
+	{
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+	}
+
+	// Runs producer and consumer on their CPUs, returns the seconds until both are done.
+	template <typename Producer, typename Consumer>
+	double measure(int producerCpu, int consumerCpu, Producer producer, Consumer consumer)
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::thread consuming(consumer);
+		std::thread producing(producer);
+
+		pin(consuming, consumerCpu);
+		pin(producing, producerCpu);
+		producing.join();
+		consuming.join();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	double single(int producerCpu, int consumerCpu, std::size_t n)
+	{
+		ring_type ring;
+
+		const double seconds = measure(producerCpu, consumerCpu,
+			[&] {
+				backoff wait;
+
+				for (message i = 0; i < n; ++i)
+					while (!ring.try_push(i))
+						wait();
+			},
+			[&] {
+				backoff	wait;
+				message	sum = 0;
+				message	value;
+
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					while (!ring.try_pop(value))
+						wait();
+					sum += value;
+				}
+				gSink = sum;
+			});
+		return n / seconds / 1e6;
+	}
+
+	double batched(int producerCpu, int consumerCpu, std::size_t n)
+	{
+		ring_type ring;
+
+		const double seconds = measure(producerCpu, consumerCpu,
+			[&] {
+				backoff	wait;
+				message	batch[kBatch];
+
+				for (std::size_t sent = 0; sent < n; )
+				{
+					const std::size_t count = std::min(kBatch, n - sent);
+
+					for (std::size_t j = 0; j < count; ++j)
+						batch[j] = sent + j;
+
+					const std::size_t pushed = ring.push_n(batch, count);
+
+					if (pushed == 0)
+						wait();
+					sent += pushed;
+				}
+			},
+			[&] {
+				backoff	wait;
+				message	sum = 0;
+				message	batch[kBatch];
+
+				for (std::size_t received = 0; received < n; )
+				{
+					const std::size_t popped = ring.pop_n(batch, std::min(kBatch, n - received));
+
+					if (popped == 0)
+						wait();
+					for (std::size_t j = 0; j < popped; ++j)
+						sum += batch[j];
+					received += popped;
+				}
+				gSink = sum;
+			});
+		return n / seconds / 1e6;
+	}
+
+	// The same bounded queue with a lock: what spsc_ring replaces.
+	double locked(int producerCpu, int consumerCpu, std::size_t n)
+	{
+		std::mutex			mutex;
+		std::deque<message>	queue;
+
+		const double seconds = measure(producerCpu, consumerCpu,
+			[&] {
+				backoff wait;
+
+				for (message i = 0; i < n; )
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+
+						if (queue.size() < kCapacity)
+						{
+							queue.push_back(i);
+							++i;
+							continue;
+						}
+					}
+					wait();
+				}
+			},
+			[&] {
+				backoff	wait;
+				message	sum = 0;
+
+				for (std::size_t i = 0; i < n; )
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+
+						if (!queue.empty())
+						{
+							sum += queue.front();
+							queue.pop_front();
+							++i;
+							continue;
+						}
+					}
+					wait();
+				}
+				gSink = sum;
+			});
+		return n / seconds / 1e6;
+	}
+
+	// One way latency in ns, half of each round trip: the median and the 99th percentile.
+	void latency(int producerCpu, int consumerCpu, std::size_t rounds, double& median, double& p99)
+	{
+		ring_type			ping;
+		ring_type			pong;
+		std::vector<double>	samples(rounds);
+
+		measure(producerCpu, consumerCpu,
+			[&] {
+				backoff wait;
+				message value;
+
+				for (std::size_t r = 0; r < rounds; ++r)
+				{
+					const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+					ping.try_push(r);
+					while (!pong.try_pop(value))
+						wait();
+					samples[r] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / 2;
+				}
+			},
+			[&] {
+				backoff wait;
+				message value;
+
+				for (std::size_t r = 0; r < rounds; ++r)
+				{
+					while (!ping.try_pop(value))
+						wait();
+					pong.try_push(value);
+				}
+			});
+		std::sort(samples.begin(), samples.end());
+		median	= samples[rounds / 2];
+		p99		= samples[rounds - rounds / 100 - 1];
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::size_t	messages	= (argc > 1) ? std::strtoull(argv[1], NULL, 10) : 20000000;
+	const std::size_t	rounds		= (argc > 2) ? std::strtoull(argv[2], NULL, 10) : 200000;
+	std::vector<int>	cpus;
+	cpu_set_t			allowed;
+
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+	{
+		for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+			if (CPU_ISSET(cpu, &allowed))
+				cpus.push_back(cpu);
+	}
+	if (cpus.empty())
+		cpus.push_back(0);
+
+	std::printf("%zu messages of 8 bytes, ring of %zu; Mmsg/s (higher is better), one way latency in ns\n", messages, kCapacity);
+	std::printf("%5s %5s %10s %10s %10s %10s %10s\n", "prod", "cons", "single", "batch/64", "mutex", "lat p50", "lat p99");
+	for (std::size_t c = 0; c < cpus.size(); ++c)
+	{
+		const int	producerCpu	= cpus[0];
+		const int	consumerCpu	= cpus[c];
+		double		median;
+		double		p99;
+
+		const double one	= single(producerCpu, consumerCpu, messages);
+		const double batch	= batched(producerCpu, consumerCpu, messages);
+		const double mutex	= locked(producerCpu, consumerCpu, messages);
+
+		latency(producerCpu, consumerCpu, rounds, median, p99);
+		std::printf("%5d %5d %10.1f %10.1f %10.1f %10.0f %10.0f\n", producerCpu, consumerCpu, one, batch, mutex, median, p99);
+		std::fflush(stdout);
+	}
+	return 0;
+}
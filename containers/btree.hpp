@@ -0,0 +1,1691 @@
+#ifndef MERKOL_BTREE_HPP
+# define MERKOL_BTREE_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include "vector.hpp"
+#include "flat_map.hpp"
+#include "rb_tree.hpp"
+#include "../iterators/iterator.hpp"
+#include "../iterators/reverse_iterator.hpp"
+#include "../auxiliary/trace.hpp"
+#include "../aux_templates/algorithm.hpp"
+#include "../aux_templates/functional.hpp"
+#include "../aux_templates/simd.hpp"
+#include "../aux_templates/type_traits.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	btree
+
+	B+ tree behind btree_map and btree_set, for large ordered sets. A red-black tree pays a node, three
+	pointers and a likely cache miss per element and per level of the search; a B+ tree packs a few
+	dozen keys into a node of a few cache lines, so a search touches a handful of nodes and the tree
+	costs little more than the elements themselves.
+
+		leaf:		parent | count, position | prev | next | values[kLeafSlots] | keys[kLeafSlots]
+		internal:	parent | count, position | keys[kInternalSlots] | children[kInternalSlots + 1]
+
+	The elements are in the leaves, which are chained in order. Internal nodes route the searches with
+	copies of keys: every key under child i is <= separator i < every key under child i + 1. NodeSize
+	(bytes, 256 by default: four cache lines) sets the fanout, kLeafSlots and kInternalSlots. Keys and
+	values are separate arrays, so that searching a node only reads keys. Nodes come from two
+	rbtree_node_pool (one per node type): no malloc header per node, and memory given back by clear().
+
+	Search in a node: for 32 and 64 bit integral keys ordered by merkol::less or std::less, the position
+	of a key is the number of keys below it, counted with vector compares over the whole node
+	(simd::count_less), with no branch on the data. Other keys use the branchless merkol::lower_bound.
+
+	Range scans: iterators step through a leaf and then along the leaf chain, never back up the tree.
+	for_each_segment(first, last, f) hands f the key and value arrays of one leaf at a time while the
+	next leaf is prefetched; merkol::for_each on btree iterators is built on it.
+
+	Nodes other than the root stay at least half full. A full leaf splits in two halves, except when the
+	key goes past the end of the tree: the new rightmost leaf then starts with the new key alone and the
+	old one stays full, so that ascending keys (time series) leave full leaves behind. Erasing merges a
+	node that falls below half with a neighbour, or moves elements over from it. insert(first, last)
+	into an empty tree and the copy constructor fill the leaves and build the levels above in O(n).
+
+	With 64 bit keys and values and 256 byte nodes a leaf holds 14 elements: about 19 bytes per element
+	after bulk insertion, 21 after ascending insertion and 29 or so after random insertion, against 40
+	for merkol::map and 64 for std::map.
+
+	Iterator invalidation: insertion and erasure move elements within and between nodes and invalidate
+	all iterators, references and pointers to elements, as for flat_map. erase returns an iterator to the
+	element after the erased one. Keys and values are moved with their move constructor, which must not
+	throw. Keys are unique (there is no multimap or multiset variant).
+*/
+
+namespace merkol
+{
+	/// btree_no_value
+	///
+	/// Mapped type of btree_set: the leaves then have no value array.
+	struct btree_no_value { };
+
+	/// btree_node_base
+	///
+	/// Header of leaves and internal nodes.
+	struct btree_node_base
+	{
+		btree_node_base*	mpParent;	// NULL for the root
+		unsigned short		mnCount;	// keys in the node
+		unsigned short		mnPosition;	// index in the parent's children
+		bool				mbLeaf;
+	};
+
+	/// btree_node_traits
+	///
+	/// Slots of a leaf and of an internal node of NodeSize bytes. Never fewer than 3, so that a split
+	/// leaves something on both sides.
+	template <typename Key, typename Mapped, std::size_t NodeSize>
+	struct btree_node_traits
+	{
+		static const std::size_t kValueSize			= merkol::is_same<Mapped, btree_no_value>::value ? 0 : sizeof(Mapped);
+		static const std::size_t kLeafHeader		= sizeof(btree_node_base) + 2 * sizeof(void*);
+		static const std::size_t kInternalHeader	= sizeof(btree_node_base) + sizeof(void*); // with the extra child
+		static const std::size_t kLeafFit			= (NodeSize > kLeafHeader) ? (NodeSize - kLeafHeader) / (sizeof(Key) + kValueSize) : 0;
+		static const std::size_t kInternalFit		= (NodeSize > kInternalHeader) ? (NodeSize - kInternalHeader) / (sizeof(Key) + sizeof(void*)) : 0;
+		static const std::size_t kLeafSlots			= (kLeafFit < 3) ? 3 : kLeafFit;
+		static const std::size_t kInternalSlots		= (kInternalFit < 3) ? 3 : kInternalFit;
+	};
+
+	/// btree_leaf_values
+	///
+	/// Value array of a leaf; empty for sets. value(i) is the address of slot i (NULL for sets).
+	template <typename Mapped, std::size_t Slots>
+	struct btree_leaf_values
+	{
+		aligned_buffer<Mapped[Slots]>	mValues;
+
+		Mapped*	value(std::size_t i) { return reinterpret_cast<Mapped*>(mValues.mBuffer) + i; }
+	};
+
+	template <std::size_t Slots>
+	struct btree_leaf_values<btree_no_value, Slots>
+	{
+		btree_no_value*	value(std::size_t) { return NULL; }
+	};
+
+	template <typename Key, typename Mapped, std::size_t NodeSize>
+	struct btree_leaf
+		: public btree_node_base,
+		  public btree_leaf_values<Mapped, btree_node_traits<Key, Mapped, NodeSize>::kLeafSlots>
+	{
+		typedef Key		key_type;
+		typedef Mapped	mapped_type;
+
+		static const std::size_t kSlots = btree_node_traits<Key, Mapped, NodeSize>::kLeafSlots;
+
+		btree_leaf*						mpPrev;
+		btree_leaf*						mpNext;
+		aligned_buffer<Key[kSlots]>		mKeys;
+
+		Key*	keys() { return reinterpret_cast<Key*>(mKeys.mBuffer); }
+	};
+
+	template <typename Key, std::size_t Slots>
+	struct btree_internal : public btree_node_base
+	{
+		static const std::size_t kSlots = Slots;
+
+		aligned_buffer<Key[Slots]>	mKeys;
+		btree_node_base*			mpChildren[Slots + 1];
+
+		Key*	keys() { return reinterpret_cast<Key*>(mKeys.mBuffer); }
+	};
+
+
+	///////////////////////////////////////////////////////////////////////
+	// BTreeSlots.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	/// btree_relocate
+	///
+	/// Moves n objects from first to dest and ends the lifetime of the sources; the ranges may overlap.
+	/// One memmove for trivially relocatable types.
+	template <typename T>
+	inline void btree_relocate(T* first, std::size_t n, T* dest, true_type)
+	{
+		if (n)
+			std::memmove(static_cast<void*>(dest), static_cast<const void*>(first), n * sizeof(T));
+	}
+
+	template <typename T>
+	inline void btree_relocate(T* first, std::size_t n, T* dest, false_type)
+	{
+		if (dest < first)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				::new(static_cast<void*>(dest + i)) T(MERKOL_MOVE(first[i]));
+				first[i].~T();
+			}
+		}
+		else
+		{
+			for (std::size_t i = n; i-- > 0; )
+			{
+				::new(static_cast<void*>(dest + i)) T(MERKOL_MOVE(first[i]));
+				first[i].~T();
+			}
+		}
+	}
+
+	template <typename T>
+	inline void btree_relocate(T* first, std::size_t n, T* dest)
+	{
+		merkol::btree_relocate(first, n, dest, integral_constant<bool, merkol::is_trivially_relocatable<T>::value>());
+	}
+
+	inline void btree_relocate(btree_no_value*, std::size_t, btree_no_value*) { }
+
+	template <typename T>
+	inline void btree_destroy(T* first, std::size_t n)
+	{
+		if (!merkol::is_trivially_destructible<T>::value)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				first[i].~T();
+		}
+	}
+
+	inline void btree_destroy(btree_no_value*, std::size_t) { }
+
+	///////////////////////////////////////////////////////////////////////
+	// BTreeSlots.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/// btree_value_traits
+	///
+	/// What the iterators of a tree with mapped type T (const qualified for const iterators) point to:
+	/// a flat_map_reference to a key and its value for maps, the key for sets. key() and
+	/// construct_mapped() take apart the values given to insert.
+	template <typename Key, typename T>
+	struct btree_value_traits
+	{
+		typedef typename merkol::remove_const<T>::type				mapped_type;
+		typedef std::pair<Key, mapped_type>							value_type;
+		typedef flat_map_reference<Key, T>							reference;
+		typedef typename flat_map_iterator<Key, T>::pointer			pointer;
+
+		static reference	make_reference(const Key* keys, T* values, std::size_t i) { return reference(keys[i], values[i]); }
+		static pointer		make_pointer(const Key* keys, T* values, std::size_t i) { return pointer(make_reference(keys, values, i)); }
+
+		template <typename V>
+		static const Key&	key(const V& value) { return value.first; }
+
+		template <typename V>
+		static void			construct_mapped(mapped_type* p, const V& value) { ::new(static_cast<void*>(p)) mapped_type(value.second); }
+	};
+
+	template <typename Key>
+	struct btree_set_value_traits
+	{
+		typedef btree_no_value	mapped_type;
+		typedef Key				value_type;
+		typedef const Key&		reference;
+		typedef const Key*		pointer;
+
+		static reference	make_reference(const Key* keys, const btree_no_value*, std::size_t i) { return keys[i]; }
+		static pointer		make_pointer(const Key* keys, const btree_no_value*, std::size_t i) { return keys + i; }
+
+		static const Key&	key(const Key& value) { return value; }
+		static void			construct_mapped(mapped_type*, const Key&) { }
+	};
+
+	template <typename Key>
+	struct btree_value_traits<Key, btree_no_value> : public btree_set_value_traits<Key> { };
+
+	template <typename Key>
+	struct btree_value_traits<Key, const btree_no_value> : public btree_set_value_traits<Key> { };
+
+
+	/// btree_iterator
+	///
+	/// Bidirectional iterator: a leaf and an index in it. It moves along the leaf chain, so a scan never
+	/// climbs the tree. T is the mapped type, const qualified for const iterators. Only the last leaf
+	/// has a past-the-end position: one past the last element of any other leaf is the first of the next.
+	template <typename Leaf, typename T>
+	class btree_iterator
+	{
+		template <typename, typename> friend class btree_iterator;
+
+		typedef btree_value_traits<typename Leaf::key_type, T>		traits_type;
+
+	public:
+		typedef btree_iterator<Leaf, T>								this_type;
+		typedef typename traits_type::value_type					value_type;
+		typedef typename traits_type::reference						reference;
+		typedef typename traits_type::pointer						pointer;
+		typedef std::ptrdiff_t										difference_type;
+		typedef merkol::bidirectional_iterator_tag					iterator_category;
+		typedef btree_iterator<Leaf, const T>						const_iterator;
+		typedef Leaf												leaf_type;
+
+		btree_iterator() : mpLeaf(NULL), mnIndex(0) { }
+		btree_iterator(Leaf* leaf, std::size_t index) : mpLeaf(leaf), mnIndex(index) { }
+
+		// convertion to const
+		operator const_iterator() const
+		{
+			return (const_iterator(mpLeaf, mnIndex));
+		}
+
+		Leaf*		leaf() const { return mpLeaf; }
+		std::size_t	index() const { return mnIndex; }
+
+		reference	operator*() const { return traits_type::make_reference(mpLeaf->keys(), mpLeaf->value(0), mnIndex); }
+		pointer		operator->() const { return traits_type::make_pointer(mpLeaf->keys(), mpLeaf->value(0), mnIndex); }
+
+		btree_iterator& operator++()
+		{
+			if ((++mnIndex == mpLeaf->mnCount) && mpLeaf->mpNext)
+			{
+				mpLeaf	= mpLeaf->mpNext;
+				mnIndex	= 0;
+			}
+			return *this;
+		}
+
+		btree_iterator& operator--()
+		{
+			if (mnIndex == 0)
+			{
+				mpLeaf	= mpLeaf->mpPrev;
+				mnIndex	= mpLeaf->mnCount;
+			}
+			--mnIndex;
+			return *this;
+		}
+
+		btree_iterator	operator++(int) { btree_iterator temp(*this); ++(*this); return temp; }
+		btree_iterator	operator--(int) { btree_iterator temp(*this); --(*this); return temp; }
+
+	private:
+		Leaf*		mpLeaf;
+		std::size_t	mnIndex;
+	};
+
+	template <typename Leaf, typename T1, typename T2>
+	inline bool operator==(const btree_iterator<Leaf, T1>& lhs, const btree_iterator<Leaf, T2>& rhs)
+	{
+		return (lhs.leaf() == rhs.leaf()) && (lhs.index() == rhs.index());
+	}
+
+	template <typename Leaf, typename T1, typename T2>
+	inline bool operator!=(const btree_iterator<Leaf, T1>& lhs, const btree_iterator<Leaf, T2>& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+
+	// Reads the lines of the node at p ahead of use.
+	template <typename Node>
+	inline void btree_prefetch(const Node* p)
+	{
+	#if defined(__GNUC__) || defined(__clang__)
+		for (std::size_t offset = 0; offset < sizeof(Node); offset += 64)
+			__builtin_prefetch(reinterpret_cast<const char*>(p) + offset);
+	#else
+		(void)p;
+	#endif
+	}
+
+	/// for_each_segment
+	///
+	/// Calls f(keys, values, n) for every leaf [first, last) covers, in order: keys and values point to
+	/// the n elements of the range in that leaf (values is NULL for sets). The next leaf is prefetched
+	/// before f runs on the current one.
+	template <typename Leaf, typename T, typename SegmentFunction>
+	inline SegmentFunction for_each_segment(btree_iterator<Leaf, T> first, btree_iterator<Leaf, T> last, SegmentFunction f)
+	{
+		if (first == last)
+			return f;
+
+		Leaf*		leaf	= first.leaf();
+		std::size_t	index	= first.index();
+
+		for (; leaf != last.leaf(); leaf = leaf->mpNext, index = 0)
+		{
+			if (leaf->mpNext)
+				merkol::btree_prefetch(leaf->mpNext);
+			f(static_cast<const typename Leaf::key_type*>(leaf->keys() + index), static_cast<T*>(leaf->value(index)),
+			  leaf->mnCount - index);
+		}
+		if (last.index() > index)
+			f(static_cast<const typename Leaf::key_type*>(leaf->keys() + index), static_cast<T*>(leaf->value(index)),
+			  last.index() - index);
+		return f;
+	}
+
+	template <typename Function, typename Key, typename T>
+	struct btree_for_each_adaptor
+	{
+		Function f;
+
+		explicit btree_for_each_adaptor(Function function) : f(function) { }
+
+		void operator()(const Key* keys, T* values, std::size_t n)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				f(btree_value_traits<Key, T>::make_reference(keys, values, i));
+		}
+	};
+
+	template <typename Leaf, typename T, typename Function>
+	inline Function for_each(btree_iterator<Leaf, T> first, btree_iterator<Leaf, T> last, Function f)
+	{
+		return merkol::for_each_segment(first, last, btree_for_each_adaptor<Function, typename Leaf::key_type, T>(f)).f;
+	}
+
+
+	/// btree_use_simd_search
+	///
+	/// Whether nodes are searched with simd::count_less: 32 and 64 bit integral keys in ascending order.
+	template <typename Key, typename Compare>
+	struct btree_use_simd_search
+		: integral_constant<bool, merkol::is_integral<Key>::value && ((sizeof(Key) == 4) || (sizeof(Key) == 8))
+								  && (merkol::is_same<Compare, merkol::less<Key> >::value
+									  || merkol::is_same<Compare, std::less<Key> >::value)> { };
+
+	/// btree_mapped_from, btree_mapped_default
+	///
+	/// Build the mapped value of a new element in its slot, once the key is known to be new.
+	template <typename Traits, typename Value>
+	struct btree_mapped_from
+	{
+		const Value& value;
+
+		explicit btree_mapped_from(const Value& v) : value(v) { }
+		void operator()(typename Traits::mapped_type* p) const { Traits::construct_mapped(p, value); }
+	};
+
+	template <typename T>
+	struct btree_mapped_default
+	{
+		void operator()(T* p) const { ::new(static_cast<void*>(p)) T(); }
+	};
+
+
+	/**
+	 * @brief btree
+	 * Storage and lookup of btree_map and btree_set, see the comment at the top of the file.
+	 *
+	 * @tparam Key key type
+	 * @tparam Mapped mapped type, btree_no_value for sets
+	 * @tparam Compare strict weak ordering of the keys
+	 * @tparam Allocator allocator, rebound to the node types
+	 * @tparam NodeSize bytes per node, which sets the fanout
+	 */
+	template <typename Key, typename Mapped, typename Compare, typename Allocator, std::size_t NodeSize>
+	class btree
+	{
+		typedef btree<Key, Mapped, Compare, Allocator, NodeSize>						this_type;
+
+	public:
+		typedef Key																		key_type;
+		typedef Compare																	key_compare;
+		typedef Allocator																allocator_type;
+		typedef std::size_t																size_type;
+		typedef std::ptrdiff_t															difference_type;
+		typedef btree_leaf<Key, Mapped, NodeSize>										leaf_type;
+		typedef btree_internal<Key, btree_node_traits<Key, Mapped, NodeSize>::kInternalSlots>	internal_type;
+		typedef btree_iterator<leaf_type, typename merkol::conditional<merkol::is_same<Mapped, btree_no_value>::value,
+																	   const Mapped, Mapped>::type>	iterator;
+		typedef btree_iterator<leaf_type, const Mapped>									const_iterator;
+		typedef merkol::reverse_iterator<iterator>										reverse_iterator;
+		typedef merkol::reverse_iterator<const_iterator>								const_reverse_iterator;
+		typedef typename iterator::value_type											value_type;
+		typedef typename iterator::reference											reference;
+		typedef typename const_iterator::reference										const_reference;
+		typedef std::pair<iterator, bool>												insert_return_type;
+
+		static const size_type kLeafSlots		= leaf_type::kSlots;
+		static const size_type kInternalSlots	= internal_type::kSlots;
+
+	protected:
+		typedef btree_value_traits<Key, Mapped>											value_traits;
+		typedef rbtree_node_pool<leaf_type, Allocator>									leaf_pool_type;
+		typedef rbtree_node_pool<internal_type, Allocator>								internal_pool_type;
+		typedef btree_use_simd_search<Key, Compare>										simd_search;
+
+		static const size_type kMinLeafSlots		= kLeafSlots / 2;
+		static const size_type kMinInternalSlots	= kInternalSlots / 2;
+		static const size_type kMaxHeight			= 64;
+
+		// A slot of a leaf: where a key is, or goes.
+		struct position
+		{
+			leaf_type*	leaf;
+			size_type	index;
+		};
+
+		// Walks an array of pointers to value_type, for doBuild.
+		struct indirect_iterator
+		{
+			void* const* p;
+
+			explicit indirect_iterator(void* const* pointer) : p(pointer) { }
+			const value_type&	operator*() const { return *static_cast<const value_type*>(*p); }
+			indirect_iterator&	operator++() { ++p; return *this; }
+		};
+
+		// Orders pointers to value_type by key, to sort a bulk insertion.
+		struct indirect_compare
+		{
+			key_compare compare;
+
+			explicit indirect_compare(const key_compare& c) : compare(c) { }
+			bool operator()(const void* a, const void* b) const
+			{
+				return compare(value_traits::key(*static_cast<const value_type*>(a)), value_traits::key(*static_cast<const value_type*>(b)));
+			}
+		};
+
+		btree_node_base*	mpRoot;
+		leaf_type*			mpLeftmost;
+		leaf_type*			mpRightmost;
+		size_type			mnSize;
+		key_compare			mCompare;
+		leaf_pool_type		mLeafPool;
+		internal_pool_type	mInternalPool;
+
+	public:
+		explicit btree(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type());
+		btree(const this_type& other);
+	#if __cplusplus >= 201103L
+		btree(this_type&& other);
+	#endif
+		~btree();
+
+		this_type&	operator=(const this_type& other);
+	#if __cplusplus >= 201103L
+		this_type&	operator=(this_type&& other);
+	#endif
+
+		// Iterators
+		iterator				begin() M_NOEXCEPT { return iterator(mpLeftmost, 0); }
+		const_iterator			begin() const M_NOEXCEPT { return const_iterator(mpLeftmost, 0); }
+		const_iterator			cbegin() const M_NOEXCEPT { return begin(); }
+		iterator				end() M_NOEXCEPT { return iterator(mpRightmost, mpRightmost ? mpRightmost->mnCount : 0); }
+		const_iterator			end() const M_NOEXCEPT { return const_iterator(mpRightmost, mpRightmost ? mpRightmost->mnCount : 0); }
+		const_iterator			cend() const M_NOEXCEPT { return end(); }
+		reverse_iterator		rbegin() M_NOEXCEPT { return reverse_iterator(end()); }
+		const_reverse_iterator	rbegin() const M_NOEXCEPT { return const_reverse_iterator(end()); }
+		reverse_iterator		rend() M_NOEXCEPT { return reverse_iterator(begin()); }
+		const_reverse_iterator	rend() const M_NOEXCEPT { return const_reverse_iterator(begin()); }
+
+		// Capacity
+		bool		empty() const M_NOEXCEPT { return mnSize == 0; }
+		size_type	size() const M_NOEXCEPT { return mnSize; }
+		size_type	max_size() const M_NOEXCEPT { return mLeafPool.max_size() * kLeafSlots; }
+		size_type	node_bytes() const M_NOEXCEPT { return mLeafPool.bytes() + mInternalPool.bytes(); }
+
+		// Lookup
+		iterator		find(const key_type& key);
+		const_iterator	find(const key_type& key) const;
+		size_type		count(const key_type& key) const { return contains(key) ? 1 : 0; }
+		bool			contains(const key_type& key) const { return find(key) != end(); }
+		iterator		lower_bound(const key_type& key) { return doIterator(doLowerBound(key)); }
+		const_iterator	lower_bound(const key_type& key) const { return doIterator(doLowerBound(key)); }
+		iterator		upper_bound(const key_type& key) { return doIterator(doUpperBound(key)); }
+		const_iterator	upper_bound(const key_type& key) const { return doIterator(doUpperBound(key)); }
+
+		std::pair<iterator, iterator>				equal_range(const key_type& key);
+		std::pair<const_iterator, const_iterator>	equal_range(const key_type& key) const;
+
+		// Modifiers
+		insert_return_type	insert(const value_type& value);
+		iterator			insert(const_iterator hint, const value_type& value);
+
+		template <typename InputIterator>
+		void		insert(InputIterator first, InputIterator last);
+
+		iterator	erase(const_iterator pos);
+		iterator	erase(const_iterator first, const_iterator last);
+		size_type	erase(const key_type& key);
+		void		clear() M_NOEXCEPT;
+		void		swap(this_type& other);
+
+		// Observers
+		key_compare		key_comp() const { return mCompare; }
+		allocator_type	get_allocator() const { return allocator_type(mLeafPool.get_allocator()); }
+
+		// Checks the ordering, the separators, the fill of the nodes and every link; for tests.
+		bool		validate() const;
+
+	protected:
+		size_type	doSearch(const key_type* keys, size_type n, const key_type& key) const { return doSearch(keys, n, key, simd_search()); }
+		size_type	doSearch(const key_type* keys, size_type n, const key_type& key, true_type) const;
+		size_type	doSearch(const key_type* keys, size_type n, const key_type& key, false_type) const;
+
+		position	doLowerBound(const key_type& key) const;
+		position	doUpperBound(const key_type& key) const;
+		bool		doFound(const position& pos, const key_type& key) const;
+		iterator	doIterator(position pos) const;
+		bool		doFindHintPosition(const_iterator hint, const key_type& key, position& pos) const;
+
+		template <typename MappedMaker>
+		insert_return_type	doInsertUnique(const key_type& key, MappedMaker maker);
+		template <typename MappedMaker>
+		iterator			doInsertAt(position pos, const key_type& key, MappedMaker maker);
+
+		void		doMakeRoom(position& pos);
+		void		doCloseRoom(const position& pos);
+		void		doSplitLeaf(position& pos);
+		void		doInsertSeparator(btree_node_base* left, key_type* separator, btree_node_base* right,
+									  internal_type** spare, size_type& spareCount);
+
+		void		doRebalanceLeaf(leaf_type* leaf, position& tracked);
+		void		doMergeLeaves(leaf_type* left, leaf_type* right, position& tracked);
+		void		doMoveFromLeft(leaf_type* left, leaf_type* leaf, position& tracked);
+		void		doMoveFromRight(leaf_type* leaf, leaf_type* right);
+		void		doRebalanceInternal(internal_type* node);
+		void		doMergeInternal(internal_type* left, internal_type* right);
+		void		doRemoveChild(internal_type* node, size_type child);
+
+		static void	doSetChild(internal_type* node, size_type i, btree_node_base* child)
+		{
+			node->mpChildren[i]	= child;
+			child->mpParent		= node;
+			child->mnPosition	= (unsigned short)i;
+		}
+
+		leaf_type*		doNewLeaf();
+		internal_type*	doNewInternal();
+		void			doFreeLeaf(leaf_type* leaf);
+		void			doFreeInternal(internal_type* node);
+		void			doDestroySubtree(btree_node_base* node);
+		void			doReset();
+
+		template <typename Value>
+		void			doConstructElement(leaf_type* leaf, size_type i, const Value& value);
+		template <typename Iterator>
+		void			doBuild(Iterator first, size_type n);
+		const key_type&	doMaxKey(const btree_node_base* node) const;
+
+		bool			doValidate(const btree_node_base* node, const key_type* lower, const key_type* upper, size_type depth,
+								   size_type& leafDepth, const leaf_type*& previous, size_type& count) const;
+	}; // btree
+
+
+	///////////////////////////////////////////////////////////////////////
+	// BTree.imp.begin();												///
+	///////////////////////////////////////////////////////////////////////
+
+# define MERKOL_BTREE_TEMPLATE \
+	template <typename Key, typename Mapped, typename Compare, typename Allocator, std::size_t NodeSize>
+# define MERKOL_BTREE btree<Key, Mapped, Compare, Allocator, NodeSize>
+
+	MERKOL_BTREE_TEMPLATE
+	MERKOL_BTREE::btree(const key_compare& compare, const allocator_type& allocator)
+		: mpRoot(NULL),
+		  mpLeftmost(NULL),
+		  mpRightmost(NULL),
+		  mnSize(0),
+		  mCompare(compare),
+		  mLeafPool(allocator),
+		  mInternalPool(allocator)
+	{
+		MERKOL_TRACE(this, "btree::constructor", 0, 0);
+	}
+
+	// The other tree is in order and has unique keys: its elements go straight into doBuild, O(n).
+	MERKOL_BTREE_TEMPLATE
+	MERKOL_BTREE::btree(const this_type& other)
+		: mpRoot(NULL),
+		  mpLeftmost(NULL),
+		  mpRightmost(NULL),
+		  mnSize(0),
+		  mCompare(other.mCompare),
+		  mLeafPool(other.get_allocator()),
+		  mInternalPool(other.get_allocator())
+	{
+		doBuild(other.begin(), other.mnSize);
+		MERKOL_TRACE(this, "btree::copy_constructor", mnSize, 0);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_BTREE_TEMPLATE
+	MERKOL_BTREE::btree(this_type&& other)
+		: mpRoot(NULL),
+		  mpLeftmost(NULL),
+		  mpRightmost(NULL),
+		  mnSize(0),
+		  mCompare(other.mCompare),
+		  mLeafPool(other.get_allocator()),
+		  mInternalPool(other.get_allocator())
+	{
+		swap(other);
+	}
+#endif
+
+	MERKOL_BTREE_TEMPLATE
+	MERKOL_BTREE::~btree()
+	{
+		MERKOL_TRACE(this, "btree::destructor", mnSize, 0);
+		clear();
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::this_type&
+	MERKOL_BTREE::operator=(const this_type& other)
+	{
+		if (this != &other)
+		{
+			this_type temp(other);
+			swap(temp);
+		}
+		return *this;
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::this_type&
+	MERKOL_BTREE::operator=(this_type&& other)
+	{
+		if (this != &other)
+		{
+			this_type temp(std::move(other));
+			swap(temp);
+		}
+		return *this;
+	}
+#endif
+
+	// Every key of the node is compared: the count of keys below key is its position.
+	MERKOL_BTREE_TEMPLATE
+	inline typename MERKOL_BTREE::size_type
+	MERKOL_BTREE::doSearch(const key_type* keys, size_type n, const key_type& key, true_type) const
+	{
+		return simd::count_less(keys, n, key);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	inline typename MERKOL_BTREE::size_type
+	MERKOL_BTREE::doSearch(const key_type* keys, size_type n, const key_type& key, false_type) const
+	{
+		return (size_type)(merkol::lower_bound(keys, keys + n, key, mCompare) - keys);
+	}
+
+	// The slot of the first key not ordered before key, which may be one past the last key of its leaf
+	// (see doIterator).
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::position
+	MERKOL_BTREE::doLowerBound(const key_type& key) const
+	{
+		position			pos		= { NULL, 0 };
+		btree_node_base*	node	= mpRoot;
+
+		if (!node)
+			return pos;
+		while (!node->mbLeaf)
+		{
+			internal_type* const internal = static_cast<internal_type*>(node);
+
+			node = internal->mpChildren[doSearch(internal->keys(), internal->mnCount, key)];
+		}
+		pos.leaf	= static_cast<leaf_type*>(node);
+		pos.index	= doSearch(pos.leaf->keys(), pos.leaf->mnCount, key);
+		return pos;
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::position
+	MERKOL_BTREE::doUpperBound(const key_type& key) const
+	{
+		position pos = doLowerBound(key);
+
+		if (doFound(pos, key))
+			++pos.index;
+		return pos;
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	inline bool MERKOL_BTREE::doFound(const position& pos, const key_type& key) const
+	{
+		return pos.leaf && (pos.index < pos.leaf->mnCount) && !mCompare(key, pos.leaf->keys()[pos.index]);
+	}
+
+	// Past the last key of a leaf is the first key of the next leaf.
+	MERKOL_BTREE_TEMPLATE
+	inline typename MERKOL_BTREE::iterator
+	MERKOL_BTREE::doIterator(position pos) const
+	{
+		if (pos.leaf && (pos.index == pos.leaf->mnCount) && pos.leaf->mpNext)
+		{
+			pos.leaf	= pos.leaf->mpNext;
+			pos.index	= 0;
+		}
+		return iterator(pos.leaf, pos.index);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::iterator
+	MERKOL_BTREE::find(const key_type& key)
+	{
+		const position pos = doLowerBound(key);
+
+		return doFound(pos, key) ? iterator(pos.leaf, pos.index) : end();
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::const_iterator
+	MERKOL_BTREE::find(const key_type& key) const
+	{
+		const position pos = doLowerBound(key);
+
+		return doFound(pos, key) ? const_iterator(pos.leaf, pos.index) : end();
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	std::pair<typename MERKOL_BTREE::iterator, typename MERKOL_BTREE::iterator>
+	MERKOL_BTREE::equal_range(const key_type& key)
+	{
+		const position lower = doLowerBound(key);
+
+		if (doFound(lower, key))
+			return std::pair<iterator, iterator>(iterator(lower.leaf, lower.index), ++iterator(lower.leaf, lower.index));
+		return std::pair<iterator, iterator>(doIterator(lower), doIterator(lower));
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	std::pair<typename MERKOL_BTREE::const_iterator, typename MERKOL_BTREE::const_iterator>
+	MERKOL_BTREE::equal_range(const key_type& key) const
+	{
+		const std::pair<iterator, iterator> range = const_cast<this_type*>(this)->equal_range(key);
+
+		return std::pair<const_iterator, const_iterator>(range.first, range.second);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::insert_return_type
+	MERKOL_BTREE::insert(const value_type& value)
+	{
+		return doInsertUnique(value_traits::key(value), btree_mapped_from<value_traits, value_type>(value));
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::iterator
+	MERKOL_BTREE::insert(const_iterator hint, const value_type& value)
+	{
+		position pos;
+
+		if (doFindHintPosition(hint, value_traits::key(value), pos))
+			return doInsertAt(pos, value_traits::key(value), btree_mapped_from<value_traits, value_type>(value));
+		return insert(value).first;
+	}
+
+	// A hint helps when key goes right before it in the same leaf, or at end() past the last key, which
+	// makes ascending insertion O(1) amortized: no search from the root. False sends the caller to
+	// the full search, which also finds out whether key is already there.
+	MERKOL_BTREE_TEMPLATE
+	bool MERKOL_BTREE::doFindHintPosition(const_iterator hint, const key_type& key, position& pos) const
+	{
+		leaf_type* const	leaf	= hint.leaf();
+		const size_type		i		= hint.index();
+
+		if (!leaf)
+			return false;
+		if (i == leaf->mnCount)
+		{
+			if ((leaf != mpRightmost) || !mCompare(leaf->keys()[i - 1], key))
+				return false;
+		}
+		else if ((i == 0) || !mCompare(key, leaf->keys()[i]) || !mCompare(leaf->keys()[i - 1], key))
+			return false;
+		pos.leaf	= leaf;
+		pos.index	= i;
+		return true;
+	}
+
+	// The value is only built once the key is known to be new.
+	MERKOL_BTREE_TEMPLATE
+	template <typename MappedMaker>
+	typename MERKOL_BTREE::insert_return_type
+	MERKOL_BTREE::doInsertUnique(const key_type& key, MappedMaker maker)
+	{
+		const position pos = doLowerBound(key);
+
+		if (doFound(pos, key))
+			return insert_return_type(iterator(pos.leaf, pos.index), false);
+		return insert_return_type(doInsertAt(pos, key, maker), true);
+	}
+
+	// Opens slot pos (splitting the leaf if full), then builds the key and the mapped value in it. If
+	// either throws, the slot is closed again; a split that was made stays, the tree is valid either way.
+	MERKOL_BTREE_TEMPLATE
+	template <typename MappedMaker>
+	typename MERKOL_BTREE::iterator
+	MERKOL_BTREE::doInsertAt(position pos, const key_type& key, MappedMaker maker)
+	{
+		if (!pos.leaf)
+		{
+			pos.leaf	= doNewLeaf();
+			pos.index	= 0;
+			mpRoot		= pos.leaf;
+			mpLeftmost	= pos.leaf;
+			mpRightmost	= pos.leaf;
+		}
+		doMakeRoom(pos);
+
+		key_type* const slot = pos.leaf->keys() + pos.index;
+		try
+		{
+			::new(static_cast<void*>(slot)) key_type(key);
+			try
+			{
+				maker(pos.leaf->value(pos.index));
+			}
+			catch (...)
+			{
+				slot->~key_type();
+				throw;
+			}
+		}
+		catch (...)
+		{
+			doCloseRoom(pos);
+			if (mnSize == 0)
+			{
+				doFreeLeaf(pos.leaf);
+				doReset();
+			}
+			throw;
+		}
+		++pos.leaf->mnCount;
+		++mnSize;
+		return iterator(pos.leaf, pos.index);
+	}
+
+	// Shifts the slots from pos on one place right; the count is only raised once the slot is filled.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doMakeRoom(position& pos)
+	{
+		if (pos.leaf->mnCount == kLeafSlots)
+			doSplitLeaf(pos);
+
+		leaf_type* const	leaf	= pos.leaf;
+		const size_type		n		= leaf->mnCount - pos.index;
+
+		merkol::btree_relocate(leaf->keys() + pos.index, n, leaf->keys() + pos.index + 1);
+		merkol::btree_relocate(leaf->value(pos.index), n, leaf->value(pos.index + 1));
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doCloseRoom(const position& pos)
+	{
+		leaf_type* const	leaf	= pos.leaf;
+		const size_type		n		= leaf->mnCount - pos.index;
+
+		merkol::btree_relocate(leaf->keys() + pos.index + 1, n, leaf->keys() + pos.index);
+		merkol::btree_relocate(leaf->value(pos.index + 1), n, leaf->value(pos.index));
+	}
+
+	// Splits the full leaf of pos and moves pos to the half the new key belongs to. Whatever can throw
+	// is done before the tree is touched: the new nodes (the leaf, one per full ancestor, and a new root
+	// if they are all full) and the copy of the separator.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doSplitLeaf(position& pos)
+	{
+		leaf_type* const	leaf	= pos.leaf;
+		const size_type		n		= leaf->mnCount;
+		// Past the end of the tree: the new leaf gets the new key alone and this one stays full.
+		const size_type		m		= ((leaf == mpRightmost) && (pos.index == n)) ? n : n / 2;
+
+		size_type			needed	= 0;
+		btree_node_base*	node	= leaf->mpParent;
+		for (; node && (node->mnCount == kInternalSlots); node = node->mpParent)
+			++needed;
+		if (!node)
+			++needed;
+
+		internal_type*				spare[kMaxHeight];
+		size_type					spareCount	= 0;
+		aligned_buffer<key_type>	separator;
+		key_type* const				sep			= reinterpret_cast<key_type*>(separator.mBuffer);
+		leaf_type* const			right		= doNewLeaf();
+
+		try
+		{
+			for (; spareCount < needed; ++spareCount)
+				spare[spareCount] = doNewInternal();
+			::new(static_cast<void*>(sep)) key_type(leaf->keys()[m - 1]);
+		}
+		catch (...)
+		{
+			while (spareCount)
+				doFreeInternal(spare[--spareCount]);
+			doFreeLeaf(right);
+			throw;
+		}
+
+		merkol::btree_relocate(leaf->keys() + m, n - m, right->keys());
+		merkol::btree_relocate(leaf->value(m), n - m, right->value(0));
+		right->mnCount	= (unsigned short)(n - m);
+		leaf->mnCount	= (unsigned short)m;
+
+		right->mpPrev	= leaf;
+		right->mpNext	= leaf->mpNext;
+		if (leaf->mpNext)
+			leaf->mpNext->mpPrev = right;
+		else
+			mpRightmost = right;
+		leaf->mpNext	= right;
+
+		doInsertSeparator(leaf, sep, right, spare, spareCount);
+		if (pos.index >= m)
+		{
+			pos.leaf	= right;
+			pos.index	-= m;
+		}
+	}
+
+	// Puts separator (moved out of its buffer) and the new node right after left in left's parent,
+	// splitting the parent first if it is full. The nodes needed come from spare.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doInsertSeparator(btree_node_base* left, key_type* separator, btree_node_base* right,
+										 internal_type** spare, size_type& spareCount)
+	{
+		internal_type*	parent	= static_cast<internal_type*>(left->mpParent);
+		size_type		i		= left->mnPosition;
+
+		if (!parent)
+		{
+			internal_type* const root = spare[--spareCount];
+
+			merkol::btree_relocate(separator, 1, root->keys());
+			root->mnCount = 1;
+			doSetChild(root, 0, left);
+			doSetChild(root, 1, right);
+			mpRoot = root;
+			return;
+		}
+
+		if (parent->mnCount == kInternalSlots)
+		{
+			// Both halves end up with at least n / 2 keys: the key moving up is taken next to where the
+			// separator goes, or is the separator itself.
+			internal_type* const	sibling	= spare[--spareCount];
+			const size_type			n		= kInternalSlots;
+			const size_type			half	= n / 2;
+
+			if (i == half)
+			{
+				merkol::btree_relocate(parent->keys() + half, n - half, sibling->keys());
+				doSetChild(sibling, 0, right);
+				for (size_type j = half + 1; j <= n; ++j)
+					doSetChild(sibling, j - half, parent->mpChildren[j]);
+				sibling->mnCount	= (unsigned short)(n - half);
+				parent->mnCount		= (unsigned short)half;
+				doInsertSeparator(parent, separator, sibling, spare, spareCount);
+				return;
+			}
+
+			const size_type				mid	= (i < half) ? half - 1 : half;
+			aligned_buffer<key_type>	buffer;
+			key_type* const				up	= reinterpret_cast<key_type*>(buffer.mBuffer);
+
+			merkol::btree_relocate(parent->keys() + mid, 1, up);
+			merkol::btree_relocate(parent->keys() + mid + 1, n - mid - 1, sibling->keys());
+			for (size_type j = mid + 1; j <= n; ++j)
+				doSetChild(sibling, j - mid - 1, parent->mpChildren[j]);
+			sibling->mnCount	= (unsigned short)(n - mid - 1);
+			parent->mnCount		= (unsigned short)mid;
+			doInsertSeparator(parent, up, sibling, spare, spareCount);
+			if (i > mid)
+			{
+				parent	= sibling;
+				i		-= mid + 1;
+			}
+		}
+
+		const size_type n = parent->mnCount;
+
+		merkol::btree_relocate(parent->keys() + i, n - i, parent->keys() + i + 1);
+		merkol::btree_relocate(separator, 1, parent->keys() + i);
+		for (size_type j = n + 1; j > i + 1; --j)
+			doSetChild(parent, j, parent->mpChildren[j - 1]);
+		doSetChild(parent, i + 1, right);
+		parent->mnCount = (unsigned short)(n + 1);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	template <typename InputIterator>
+	void MERKOL_BTREE::insert(InputIterator first, InputIterator last)
+	{
+		if (mnSize != 0)
+		{
+			for (; first != last; ++first)
+				insert(end(), value_type(*first));
+			return;
+		}
+
+		// Into an empty tree: the values are gathered, sorted by key if they are not in order already
+		// (stably, so that the first of equal keys is kept) and built into the tree in one go.
+		merkol::vector<value_type> values;
+		for (; first != last; ++first)
+			values.push_back(value_type(*first));
+
+		const size_type n = values.size();
+		size_type		i = 1;
+
+		while ((i < n) && mCompare(value_traits::key(values[i - 1]), value_traits::key(values[i])))
+			++i;
+		if (i >= n)
+		{
+			doBuild(values.begin(), n);
+			return;
+		}
+
+		// void*: std::stable_sort swaps with an unqualified swap(), which for pointers to merkol types
+		// would also find the unconstrained merkol::swap and be ambiguous.
+		merkol::vector<void*> sorted(n);
+		for (i = 0; i < n; ++i)
+			sorted[i] = &values[i];
+		std::stable_sort(sorted.begin(), sorted.end(), indirect_compare(mCompare));
+
+		size_type kept = 1;
+		for (i = 1; i < n; ++i)
+		{
+			if (mCompare(value_traits::key(*static_cast<const value_type*>(sorted[kept - 1])),
+						 value_traits::key(*static_cast<const value_type*>(sorted[i]))))
+				sorted[kept++] = sorted[i];
+		}
+		doBuild(indirect_iterator(sorted.data()), kept);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	template <typename Value>
+	inline void MERKOL_BTREE::doConstructElement(leaf_type* leaf, size_type i, const Value& value)
+	{
+		key_type* const slot = leaf->keys() + i;
+
+		::new(static_cast<void*>(slot)) key_type(value_traits::key(value));
+		try
+		{
+			value_traits::construct_mapped(leaf->value(i), value);
+		}
+		catch (...)
+		{
+			slot->~key_type();
+			throw;
+		}
+	}
+
+	// Builds the tree from n elements in strictly ascending key order, the tree being empty. The leaves
+	// are filled as evenly as their count allows (so completely but for the rounding), then each level
+	// of internal nodes is built over the one below, each node taking as many children as fit, again
+	// evenly. If something throws, everything built so far is destroyed and the tree is left empty.
+	MERKOL_BTREE_TEMPLATE
+	template <typename Iterator>
+	void MERKOL_BTREE::doBuild(Iterator first, size_type n)
+	{
+		if (n == 0)
+			return;
+
+		const size_type leaves		= (n + kLeafSlots - 1) / kLeafSlots;
+		size_type		internals	= 0;
+		for (size_type nodes = leaves; nodes > 1; )
+		{
+			nodes = (nodes + kInternalSlots) / (kInternalSlots + 1);
+			internals += nodes;
+		}
+
+		merkol::vector<void*> level;
+		merkol::vector<void*> upper;
+		merkol::vector<void*> built; // every internal node, for the cleanup
+		level.reserve(leaves);
+		built.reserve(internals);
+
+		try
+		{
+			leaf_type* previous = NULL;
+
+			for (size_type j = 0; j < leaves; ++j)
+			{
+				leaf_type* const	leaf	= doNewLeaf();
+				const size_type		count	= n / leaves + ((j < n % leaves) ? 1 : 0);
+
+				level.push_back(static_cast<btree_node_base*>(leaf));
+				leaf->mpPrev = previous;
+				if (previous)
+					previous->mpNext = leaf;
+				else
+					mpLeftmost = leaf;
+				mpRightmost = leaf;
+				for (size_type s = 0; s < count; ++s, ++first)
+				{
+					doConstructElement(leaf, s, *first);
+					leaf->mnCount = (unsigned short)(s + 1);
+				}
+				previous = leaf;
+			}
+
+			while (level.size() > 1)
+			{
+				const size_type children	= level.size();
+				const size_type nodes		= (children + kInternalSlots) / (kInternalSlots + 1);
+				size_type		c			= 0;
+
+				upper.clear();
+				upper.reserve(nodes);
+				for (size_type j = 0; j < nodes; ++j)
+				{
+					internal_type* const	node	= doNewInternal();
+					const size_type			count	= children / nodes + ((j < children % nodes) ? 1 : 0);
+
+					built.push_back(node);
+					upper.push_back(static_cast<btree_node_base*>(node));
+					for (size_type s = 0; s < count; ++s, ++c)
+					{
+						if (s > 0)
+						{
+							::new(static_cast<void*>(node->keys() + s - 1))
+								key_type(doMaxKey(static_cast<btree_node_base*>(level[c - 1])));
+							node->mnCount = (unsigned short)s;
+						}
+						doSetChild(node, s, static_cast<btree_node_base*>(level[c]));
+					}
+				}
+				level.swap(upper);
+			}
+		}
+		catch (...)
+		{
+			for (leaf_type* leaf = mpLeftmost; leaf; leaf = leaf->mpNext)
+			{
+				merkol::btree_destroy(leaf->keys(), leaf->mnCount);
+				merkol::btree_destroy(leaf->value(0), leaf->mnCount);
+			}
+			for (size_type j = 0; j < built.size(); ++j)
+				merkol::btree_destroy(static_cast<internal_type*>(built[j])->keys(), static_cast<internal_type*>(built[j])->mnCount);
+			mLeafPool.release();
+			mInternalPool.release();
+			doReset();
+			throw;
+		}
+
+		mpRoot						= static_cast<btree_node_base*>(level[0]);
+		mpRoot->mpParent			= NULL;
+		mnSize						= n;
+		MERKOL_TRACE(this, "btree::build", n, 0);
+	}
+
+	// Greatest key under node: the last key of its rightmost leaf.
+	MERKOL_BTREE_TEMPLATE
+	const typename MERKOL_BTREE::key_type&
+	MERKOL_BTREE::doMaxKey(const btree_node_base* node) const
+	{
+		while (!node->mbLeaf)
+			node = static_cast<const internal_type*>(node)->mpChildren[node->mnCount];
+
+		leaf_type* const leaf = static_cast<leaf_type*>(const_cast<btree_node_base*>(node));
+
+		return leaf->keys()[leaf->mnCount - 1];
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::iterator
+	MERKOL_BTREE::erase(const_iterator it)
+	{
+		position			pos		= { it.leaf(), it.index() };
+		leaf_type* const	leaf	= pos.leaf;
+		const size_type		n		= leaf->mnCount - pos.index - 1;
+
+		merkol::btree_destroy(leaf->keys() + pos.index, 1);
+		merkol::btree_destroy(leaf->value(pos.index), 1);
+		merkol::btree_relocate(leaf->keys() + pos.index + 1, n, leaf->keys() + pos.index);
+		merkol::btree_relocate(leaf->value(pos.index + 1), n, leaf->value(pos.index));
+		--leaf->mnCount;
+		--mnSize;
+
+		if (leaf == mpRoot)
+		{
+			if (mnSize == 0)
+			{
+				doFreeLeaf(leaf);
+				doReset();
+				return end();
+			}
+		}
+		else if (leaf->mnCount < kMinLeafSlots)
+			doRebalanceLeaf(leaf, pos);
+		return doIterator(pos);
+	}
+
+	// Every erasure may move elements between leaves, so last can not be kept: the number of elements
+	// in the range is.
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::iterator
+	MERKOL_BTREE::erase(const_iterator first, const_iterator last)
+	{
+		if ((first == begin()) && (last == end()))
+		{
+			clear();
+			return end();
+		}
+
+		iterator	it(first.leaf(), first.index());
+		size_type	n = 0;
+
+		for (; first != last; ++first)
+			++n;
+		while (n--)
+			it = erase(it);
+		return it;
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::size_type
+	MERKOL_BTREE::erase(const key_type& key)
+	{
+		const position pos = doLowerBound(key);
+
+		if (!doFound(pos, key))
+			return 0;
+		erase(const_iterator(pos.leaf, pos.index));
+		return 1;
+	}
+
+	// leaf, not the root, fell below half full: merge it with a neighbour if the two fit in one leaf,
+	// otherwise even them out. tracked (a slot of leaf) follows the element it designates.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doRebalanceLeaf(leaf_type* leaf, position& tracked)
+	{
+		internal_type* const	parent	= static_cast<internal_type*>(leaf->mpParent);
+		const size_type			i		= leaf->mnPosition;
+		leaf_type* const		left	= (i > 0) ? static_cast<leaf_type*>(parent->mpChildren[i - 1]) : NULL;
+		leaf_type* const		right	= (i < parent->mnCount) ? static_cast<leaf_type*>(parent->mpChildren[i + 1]) : NULL;
+
+		if (left && ((size_type)left->mnCount + leaf->mnCount <= kLeafSlots))
+			doMergeLeaves(left, leaf, tracked);
+		else if (right && ((size_type)leaf->mnCount + right->mnCount <= kLeafSlots))
+			doMergeLeaves(leaf, right, tracked);
+		else if (left)
+			doMoveFromLeft(left, leaf, tracked);
+		else
+			doMoveFromRight(leaf, right);
+	}
+
+	// right goes into left and is freed, with the separator between them.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doMergeLeaves(leaf_type* left, leaf_type* right, position& tracked)
+	{
+		internal_type* const	parent	= static_cast<internal_type*>(right->mpParent);
+		const size_type			r		= right->mnPosition;
+		const size_type			n		= left->mnCount;
+		const size_type			m		= right->mnCount;
+
+		merkol::btree_relocate(right->keys(), m, left->keys() + n);
+		merkol::btree_relocate(right->value(0), m, left->value(n));
+		left->mnCount = (unsigned short)(n + m);
+		if (tracked.leaf == right)
+		{
+			tracked.leaf	= left;
+			tracked.index	+= n;
+		}
+
+		left->mpNext = right->mpNext;
+		if (right->mpNext)
+			right->mpNext->mpPrev = left;
+		else
+			mpRightmost = left;
+
+		merkol::btree_destroy(parent->keys() + r - 1, 1);
+		doRemoveChild(parent, r);
+		doFreeLeaf(right);
+		doRebalanceInternal(parent);
+	}
+
+	// The separators change: the new one is copied first, and if that throws the leaf just stays below
+	// half full, which costs space but breaks nothing.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doMoveFromLeft(leaf_type* left, leaf_type* leaf, position& tracked)
+	{
+		internal_type* const		parent	= static_cast<internal_type*>(leaf->mpParent);
+		const size_type				i		= leaf->mnPosition;
+		const size_type				n		= leaf->mnCount;
+		const size_type				l		= left->mnCount;
+		const size_type				k		= (l - n) / 2;
+		aligned_buffer<key_type>	buffer;
+		key_type* const				sep		= reinterpret_cast<key_type*>(buffer.mBuffer);
+
+		try
+		{
+			::new(static_cast<void*>(sep)) key_type(left->keys()[l - k - 1]);
+		}
+		catch (...)
+		{
+			return;
+		}
+
+		merkol::btree_relocate(leaf->keys(), n, leaf->keys() + k);
+		merkol::btree_relocate(leaf->value(0), n, leaf->value(k));
+		merkol::btree_relocate(left->keys() + l - k, k, leaf->keys());
+		merkol::btree_relocate(left->value(l - k), k, leaf->value(0));
+		left->mnCount	= (unsigned short)(l - k);
+		leaf->mnCount	= (unsigned short)(n + k);
+		tracked.index	+= k;
+
+		merkol::btree_destroy(parent->keys() + i - 1, 1);
+		merkol::btree_relocate(sep, 1, parent->keys() + i - 1);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doMoveFromRight(leaf_type* leaf, leaf_type* right)
+	{
+		internal_type* const		parent	= static_cast<internal_type*>(leaf->mpParent);
+		const size_type				i		= leaf->mnPosition;
+		const size_type				n		= leaf->mnCount;
+		const size_type				r		= right->mnCount;
+		const size_type				k		= (r - n) / 2;
+		aligned_buffer<key_type>	buffer;
+		key_type* const				sep		= reinterpret_cast<key_type*>(buffer.mBuffer);
+
+		try
+		{
+			::new(static_cast<void*>(sep)) key_type(right->keys()[k - 1]);
+		}
+		catch (...)
+		{
+			return;
+		}
+
+		merkol::btree_relocate(right->keys(), k, leaf->keys() + n);
+		merkol::btree_relocate(right->value(0), k, leaf->value(n));
+		merkol::btree_relocate(right->keys() + k, r - k, right->keys());
+		merkol::btree_relocate(right->value(k), r - k, right->value(0));
+		right->mnCount	= (unsigned short)(r - k);
+		leaf->mnCount	= (unsigned short)(n + k);
+
+		merkol::btree_destroy(parent->keys() + i, 1);
+		merkol::btree_relocate(sep, 1, parent->keys() + i);
+	}
+
+	// node lost a key. A root left with a single child is replaced by it; any other node below half
+	// full is merged with a neighbour (the separator between them coming down) or takes one child from
+	// it, rotating a key through the parent.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doRebalanceInternal(internal_type* node)
+	{
+		if (node == mpRoot)
+		{
+			if (node->mnCount == 0)
+			{
+				mpRoot				= node->mpChildren[0];
+				mpRoot->mpParent	= NULL;
+				mpRoot->mnPosition	= 0;
+				doFreeInternal(node);
+			}
+			return;
+		}
+		if (node->mnCount >= kMinInternalSlots)
+			return;
+
+		internal_type* const	parent	= static_cast<internal_type*>(node->mpParent);
+		const size_type			i		= node->mnPosition;
+		internal_type* const	left	= (i > 0) ? static_cast<internal_type*>(parent->mpChildren[i - 1]) : NULL;
+		internal_type* const	right	= (i < parent->mnCount) ? static_cast<internal_type*>(parent->mpChildren[i + 1]) : NULL;
+		const size_type			n		= node->mnCount;
+
+		if (left && ((size_type)left->mnCount + n + 1 <= kInternalSlots))
+			doMergeInternal(left, node);
+		else if (right && (n + right->mnCount + 1 <= kInternalSlots))
+			doMergeInternal(node, right);
+		else if (left)
+		{
+			const size_type l = left->mnCount;
+
+			merkol::btree_relocate(node->keys(), n, node->keys() + 1);
+			for (size_type j = n + 1; j > 0; --j)
+				doSetChild(node, j, node->mpChildren[j - 1]);
+			merkol::btree_relocate(parent->keys() + i - 1, 1, node->keys());
+			doSetChild(node, 0, left->mpChildren[l]);
+			merkol::btree_relocate(left->keys() + l - 1, 1, parent->keys() + i - 1);
+			left->mnCount	= (unsigned short)(l - 1);
+			node->mnCount	= (unsigned short)(n + 1);
+		}
+		else
+		{
+			const size_type r = right->mnCount;
+
+			merkol::btree_relocate(parent->keys() + i, 1, node->keys() + n);
+			doSetChild(node, n + 1, right->mpChildren[0]);
+			merkol::btree_relocate(right->keys(), 1, parent->keys() + i);
+			merkol::btree_relocate(right->keys() + 1, r - 1, right->keys());
+			for (size_type j = 0; j < r; ++j)
+				doSetChild(right, j, right->mpChildren[j + 1]);
+			right->mnCount	= (unsigned short)(r - 1);
+			node->mnCount	= (unsigned short)(n + 1);
+		}
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doMergeInternal(internal_type* left, internal_type* right)
+	{
+		internal_type* const	parent	= static_cast<internal_type*>(right->mpParent);
+		const size_type			r		= right->mnPosition;
+		const size_type			n		= left->mnCount;
+		const size_type			m		= right->mnCount;
+
+		merkol::btree_relocate(parent->keys() + r - 1, 1, left->keys() + n);
+		merkol::btree_relocate(right->keys(), m, left->keys() + n + 1);
+		for (size_type j = 0; j <= m; ++j)
+			doSetChild(left, n + 1 + j, right->mpChildren[j]);
+		left->mnCount = (unsigned short)(n + 1 + m);
+
+		doRemoveChild(parent, r);
+		doFreeInternal(right);
+		doRebalanceInternal(parent);
+	}
+
+	// Closes the gap of child and of the key before it, which the caller already destroyed or moved out.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doRemoveChild(internal_type* node, size_type child)
+	{
+		const size_type n = node->mnCount;
+
+		merkol::btree_relocate(node->keys() + child, n - child, node->keys() + child - 1);
+		for (size_type j = child; j < n; ++j)
+			doSetChild(node, j, node->mpChildren[j + 1]);
+		node->mnCount = (unsigned short)(n - 1);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::leaf_type*
+	MERKOL_BTREE::doNewLeaf()
+	{
+		leaf_type* const leaf = ::new(static_cast<void*>(mLeafPool.allocate())) leaf_type;
+
+		leaf->mpParent		= NULL;
+		leaf->mnCount		= 0;
+		leaf->mnPosition	= 0;
+		leaf->mbLeaf		= true;
+		leaf->mpPrev		= NULL;
+		leaf->mpNext		= NULL;
+		return leaf;
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	typename MERKOL_BTREE::internal_type*
+	MERKOL_BTREE::doNewInternal()
+	{
+		internal_type* const node = ::new(static_cast<void*>(mInternalPool.allocate())) internal_type;
+
+		node->mpParent		= NULL;
+		node->mnCount		= 0;
+		node->mnPosition	= 0;
+		node->mbLeaf		= false;
+		return node;
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	inline void MERKOL_BTREE::doFreeLeaf(leaf_type* leaf)
+	{
+		mLeafPool.deallocate(leaf);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	inline void MERKOL_BTREE::doFreeInternal(internal_type* node)
+	{
+		mInternalPool.deallocate(node);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	inline void MERKOL_BTREE::doReset()
+	{
+		mpRoot		= NULL;
+		mpLeftmost	= NULL;
+		mpRightmost	= NULL;
+		mnSize		= 0;
+	}
+
+	// Destroys the keys and values of a subtree; the nodes themselves go back with the pools.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::doDestroySubtree(btree_node_base* node)
+	{
+		if (node->mbLeaf)
+		{
+			leaf_type* const leaf = static_cast<leaf_type*>(node);
+
+			merkol::btree_destroy(leaf->keys(), leaf->mnCount);
+			merkol::btree_destroy(leaf->value(0), leaf->mnCount);
+			return;
+		}
+
+		internal_type* const internal = static_cast<internal_type*>(node);
+
+		for (size_type j = 0; j <= internal->mnCount; ++j)
+			doDestroySubtree(internal->mpChildren[j]);
+		merkol::btree_destroy(internal->keys(), internal->mnCount);
+	}
+
+	// Trivially destructible keys and values: no node is visited.
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::clear() M_NOEXCEPT
+	{
+		if (mpRoot && (!merkol::is_trivially_destructible<Key>::value || !merkol::is_trivially_destructible<Mapped>::value))
+			doDestroySubtree(mpRoot);
+		mLeafPool.release();
+		mInternalPool.release();
+		doReset();
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	void MERKOL_BTREE::swap(this_type& other)
+	{
+		merkol::swap(mpRoot, other.mpRoot);
+		merkol::swap(mpLeftmost, other.mpLeftmost);
+		merkol::swap(mpRightmost, other.mpRightmost);
+		merkol::swap(mnSize, other.mnSize);
+		merkol::swap(mCompare, other.mCompare);
+		mLeafPool.swap(other.mLeafPool);
+		mInternalPool.swap(other.mInternalPool);
+	}
+
+	MERKOL_BTREE_TEMPLATE
+	bool MERKOL_BTREE::validate() const
+	{
+		if (!mpRoot)
+			return (mnSize == 0) && !mpLeftmost && !mpRightmost;
+		if (mpRoot->mpParent)
+			return false;
+
+		size_type			leafDepth	= (size_type)-1;
+		const leaf_type*	previous	= NULL;
+		size_type			count		= 0;
+
+		if (!doValidate(mpRoot, NULL, NULL, 0, leafDepth, previous, count))
+			return false;
+		return (previous == mpRightmost) && !mpRightmost->mpNext && (count == mnSize);
+	}
+
+	// Keys under node are in (lower, upper]; NULL bounds are open.
+	MERKOL_BTREE_TEMPLATE
+	bool MERKOL_BTREE::doValidate(const btree_node_base* node, const key_type* lower, const key_type* upper, size_type depth,
+								  size_type& leafDepth, const leaf_type*& previous, size_type& count) const
+	{
+		const size_type n = node->mnCount;
+
+		if (node->mbLeaf)
+		{
+			leaf_type* const leaf = static_cast<leaf_type*>(const_cast<btree_node_base*>(node));
+
+			// The rightmost leaf may hold a single element after a split past the end.
+			if ((n == 0) || (n > kLeafSlots) || ((node != mpRoot) && (node != mpRightmost) && (n < kMinLeafSlots)))
+				return false;
+			if (leafDepth == (size_type)-1)
+				leafDepth = depth;
+			if ((depth != leafDepth) || (leaf->mpPrev != previous) || (previous ? (previous->mpNext != leaf) : (mpLeftmost != leaf)))
+				return false;
+			for (size_type j = 0; j < n; ++j)
+			{
+				const key_type& key = leaf->keys()[j];
+
+				if ((j > 0) && !mCompare(leaf->keys()[j - 1], key))
+					return false;
+				if ((lower && !mCompare(*lower, key)) || (upper && mCompare(*upper, key)))
+					return false;
+			}
+			previous	= leaf;
+			count		+= n;
+			return true;
+		}
+
+		internal_type* const internal = static_cast<internal_type*>(const_cast<btree_node_base*>(node));
+
+		if ((n == 0) || (n > kInternalSlots) || ((node != mpRoot) && (n < kMinInternalSlots)))
+			return false;
+		for (size_type j = 0; j < n; ++j)
+		{
+			const key_type& key = internal->keys()[j];
+
+			if ((j > 0) && !mCompare(internal->keys()[j - 1], key))
+				return false;
+			if ((lower && !mCompare(*lower, key)) || (upper && mCompare(*upper, key)))
+				return false;
+		}
+		for (size_type j = 0; j <= n; ++j)
+		{
+			const btree_node_base* const child = internal->mpChildren[j];
+
+			if ((child->mpParent != node) || (child->mnPosition != j))
+				return false;
+			if (!doValidate(child, (j > 0) ? internal->keys() + j - 1 : lower, (j < n) ? internal->keys() + j : upper,
+							depth + 1, leafDepth, previous, count))
+				return false;
+		}
+		return true;
+	}
+
+# undef MERKOL_BTREE_TEMPLATE
+# undef MERKOL_BTREE
+
+	///////////////////////////////////////////////////////////////////////
+	// BTree.imp.end();													///
+	///////////////////////////////////////////////////////////////////////
+
+} // namespace merkol
+
+
+namespace std
+{
+	template <typename Leaf, typename T>
+	struct iterator_traits<merkol::btree_iterator<Leaf, T> >
+	{
+		typedef std::bidirectional_iterator_tag								iterator_category;
+		typedef typename merkol::btree_iterator<Leaf, T>::value_type		value_type;
+		typedef std::ptrdiff_t												difference_type;
+		typedef typename merkol::btree_iterator<Leaf, T>::pointer			pointer;
+		typedef typename merkol::btree_iterator<Leaf, T>::reference			reference;
+	};
+} // namespace std
+
+#endif // MERKOL_BTREE_HPP
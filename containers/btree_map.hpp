@@ -0,0 +1,163 @@
+#ifndef MERKOL_BTREE_MAP_HPP
+# define MERKOL_BTREE_MAP_HPP
+
+#include <stdexcept>
+#include <utility>
+#include "btree.hpp"
+
+namespace merkol
+{
+	/**
+	 * @brief btree_map
+	 * Ordered map on a B+ tree (see btree.hpp): std::map's interface, with flat_map's iterators (they
+	 * dereference to a flat_map_reference and are invalidated by every insertion and erasure).
+	 *
+	 * @tparam NodeSize bytes per node, 256 by default; larger nodes mean fewer levels and longer scans
+	 * within a node
+	 */
+	template <typename Key, typename T, typename Compare = merkol::less<Key>,
+			  typename Allocator = std::allocator<std::pair<const Key, T> >, std::size_t NodeSize = 256>
+	class btree_map
+		: public btree<Key, T, Compare, Allocator, NodeSize>
+	{
+		typedef btree<Key, T, Compare, Allocator, NodeSize>								base_type;
+
+	public:
+		typedef T																		mapped_type;
+		typedef typename base_type::key_type											key_type;
+		typedef typename base_type::value_type											value_type;
+		typedef typename base_type::key_compare											key_compare;
+		typedef typename base_type::allocator_type										allocator_type;
+		typedef typename base_type::iterator											iterator;
+		typedef typename base_type::const_iterator										const_iterator;
+		typedef typename base_type::insert_return_type									insert_return_type;
+
+		// Orders value_type by key.
+		struct value_compare
+		{
+			key_compare comp;
+
+			explicit value_compare(const key_compare& c) : comp(c) { }
+			bool operator()(const value_type& a, const value_type& b) const { return comp(a.first, b.first); }
+		};
+
+	public:
+		explicit btree_map(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator) { }
+
+		// O(n) when [first, last) is sorted, see btree::insert(first, last).
+		template <typename InputIterator>
+		btree_map(InputIterator first, InputIterator last, const key_compare& compare = key_compare(),
+				  const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator)
+		{
+			base_type::insert(first, last);
+		}
+
+		mapped_type&		operator[](const key_type& key);
+		mapped_type&		at(const key_type& key);
+		const mapped_type&	at(const key_type& key) const;
+
+		value_compare		value_comp() const { return value_compare(this->mCompare); }
+
+	#if __cplusplus >= 201103L
+		template <typename... Args>
+		insert_return_type	try_emplace(const key_type& key, Args&&... args);
+
+		template <typename M>
+		insert_return_type	insert_or_assign(const key_type& key, M&& value);
+	#endif
+	}; // btree_map
+
+
+	///////////////////////////////////////////////////////////////////////
+	// BTreeMap.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename btree_map<Key, T, Compare, Allocator, NodeSize>::mapped_type&
+	btree_map<Key, T, Compare, Allocator, NodeSize>::operator[](const key_type& key)
+	{
+		return this->doInsertUnique(key, btree_mapped_default<mapped_type>()).first->second;
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	typename btree_map<Key, T, Compare, Allocator, NodeSize>::mapped_type&
+	btree_map<Key, T, Compare, Allocator, NodeSize>::at(const key_type& key)
+	{
+		const iterator it = this->find(key);
+
+		if (it == this->end())
+			throw std::out_of_range("merkol::btree_map::at -- key not found");
+		return it->second;
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	const typename btree_map<Key, T, Compare, Allocator, NodeSize>::mapped_type&
+	btree_map<Key, T, Compare, Allocator, NodeSize>::at(const key_type& key) const
+	{
+		const const_iterator it = this->find(key);
+
+		if (it == this->end())
+			throw std::out_of_range("merkol::btree_map::at -- key not found");
+		return it->second;
+	}
+
+#if __cplusplus >= 201103L
+	// args are only used when key is new.
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	template <typename... Args>
+	typename btree_map<Key, T, Compare, Allocator, NodeSize>::insert_return_type
+	btree_map<Key, T, Compare, Allocator, NodeSize>::try_emplace(const key_type& key, Args&&... args)
+	{
+		return this->doInsertUnique(key, [&](mapped_type* p) { ::new(static_cast<void*>(p)) mapped_type(std::forward<Args>(args)...); });
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	template <typename M>
+	typename btree_map<Key, T, Compare, Allocator, NodeSize>::insert_return_type
+	btree_map<Key, T, Compare, Allocator, NodeSize>::insert_or_assign(const key_type& key, M&& value)
+	{
+		insert_return_type result = try_emplace(key, std::forward<M>(value));
+
+		if (!result.second)
+			result.first->second = std::forward<M>(value);
+		return result;
+	}
+#endif
+
+	///////////////////////////////////////////////////////////////////////
+	// BTreeMap.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	inline bool operator==(const btree_map<Key, T, Compare, Allocator, NodeSize>& a, const btree_map<Key, T, Compare, Allocator, NodeSize>& b)
+	{
+		typedef typename btree_map<Key, T, Compare, Allocator, NodeSize>::const_iterator const_iterator;
+
+		if (a.size() != b.size())
+			return false;
+		for (const_iterator i = a.begin(), j = b.begin(); i != a.end(); ++i, ++j)
+		{
+			if (!(i->first == j->first) || !(i->second == j->second))
+				return false;
+		}
+		return true;
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	inline bool operator!=(const btree_map<Key, T, Compare, Allocator, NodeSize>& a, const btree_map<Key, T, Compare, Allocator, NodeSize>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator, std::size_t NodeSize>
+	inline void swap(btree_map<Key, T, Compare, Allocator, NodeSize>& a, btree_map<Key, T, Compare, Allocator, NodeSize>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_BTREE_MAP_HPP
@@ -0,0 +1,70 @@
+#ifndef MERKOL_BTREE_SET_HPP
+# define MERKOL_BTREE_SET_HPP
+
+#include "btree.hpp"
+
+namespace merkol
+{
+	/**
+	 * @brief btree_set
+	 * Ordered set on a B+ tree (see btree.hpp). The leaves only hold keys. Both iterator types are
+	 * constant, and every insertion or erasure invalidates them.
+	 *
+	 * @tparam NodeSize bytes per node, 256 by default
+	 */
+	template <typename Key, typename Compare = merkol::less<Key>, typename Allocator = std::allocator<Key>,
+			  std::size_t NodeSize = 256>
+	class btree_set
+		: public btree<Key, btree_no_value, Compare, Allocator, NodeSize>
+	{
+		typedef btree<Key, btree_no_value, Compare, Allocator, NodeSize>				base_type;
+
+	public:
+		typedef typename base_type::key_compare											key_compare;
+		typedef typename base_type::key_compare											value_compare;
+		typedef typename base_type::allocator_type										allocator_type;
+
+	public:
+		explicit btree_set(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator) { }
+
+		// O(n) when [first, last) is sorted, see btree::insert(first, last).
+		template <typename InputIterator>
+		btree_set(InputIterator first, InputIterator last, const key_compare& compare = key_compare(),
+				  const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator)
+		{
+			base_type::insert(first, last);
+		}
+
+		value_compare	value_comp() const { return this->mCompare; }
+	}; // btree_set
+
+
+	template <typename Key, typename Compare, typename Allocator, std::size_t NodeSize>
+	inline bool operator==(const btree_set<Key, Compare, Allocator, NodeSize>& a, const btree_set<Key, Compare, Allocator, NodeSize>& b)
+	{
+		return (a.size() == b.size()) && merkol::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template <typename Key, typename Compare, typename Allocator, std::size_t NodeSize>
+	inline bool operator!=(const btree_set<Key, Compare, Allocator, NodeSize>& a, const btree_set<Key, Compare, Allocator, NodeSize>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename Compare, typename Allocator, std::size_t NodeSize>
+	inline bool operator<(const btree_set<Key, Compare, Allocator, NodeSize>& a, const btree_set<Key, Compare, Allocator, NodeSize>& b)
+	{
+		return merkol::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template <typename Key, typename Compare, typename Allocator, std::size_t NodeSize>
+	inline void swap(btree_set<Key, Compare, Allocator, NodeSize>& a, btree_set<Key, Compare, Allocator, NodeSize>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_BTREE_SET_HPP
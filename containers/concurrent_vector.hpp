@@ -0,0 +1,493 @@
+#ifndef MERKOL_CONCURRENT_VECTOR_HPP
+# define MERKOL_CONCURRENT_VECTOR_HPP
+
+#if __cplusplus < 201103L
+# error "concurrent_vector.hpp requires C++11"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <stdint.h>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "../auxiliary/futex.hpp"
+#include "../iterators/iterator_traits.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	concurrent_vector
+
+	An append-only vector that any number of threads can push_back to and grow_by at once, while others
+	read the elements already there. Elements live in segments that never move once allocated; segment k
+	holds kFirstSegment << k elements, so that the segments double like a vector's buffer would, and
+	element i is in segment log2(i / kFirstSegment + 1):
+
+		segment		0		1			2					3
+		indexes		[0, B)	[B, 3B)		[3B, 7B)			[7B, 15B)		B = kFirstSegment
+
+	The segment table has a slot for every segment a size_type can index, so it never grows either: an
+	index is turned into an address with a shift, a count of leading zeros and one load, and a reference
+	or iterator to an element stays valid until clear() or the destructor.
+
+	An append claims its indexes with one fetch_add on the size, then constructs the elements. Appenders
+	never wait for each other, with one exception: the thread whose claim contains the first index of a
+	segment allocates that segment, and a thread that lands in the same segment before the allocation is
+	published spins (then yields) until it is. Segments double, so that happens about log2(n) times over
+	the life of the vector.
+
+	size() counts the claimed indexes, including elements still being constructed by other threads. An
+	element may be read by a thread that knows its construction is finished: the thread that appended it,
+	or one that got its index from that thread through some synchronization (a queue, a flag with
+	release/acquire, joining the thread). Reading [0, size()) is only safe once the appenders are done.
+
+	Construction must not throw once indexes are claimed, since the other threads' elements may already
+	follow: push_back and emplace_back build a temporary first when the constructor could throw, then
+	move it in, and the move constructor must be noexcept. grow_by default constructs or copies in
+	place, and requires those to be noexcept. If allocating a segment throws, that segment is marked
+	failed, every thread that needs it gets std::bad_alloc, and its indexes stay unusable.
+
+	clear() and the destructor are not concurrent: no other thread may use the vector meanwhile.
+*/
+
+namespace merkol
+{
+	template <typename T, typename Allocator>
+	class concurrent_vector;
+
+
+	/// concurrent_vector_iterator
+	///
+	/// Random access iterator holding the vector and an index. T is const qualified for const iterators.
+	template <typename Vector, typename T>
+	class concurrent_vector_iterator
+	{
+		template <typename, typename> friend class concurrent_vector_iterator;
+
+	public:
+		typedef typename merkol::remove_cv<T>::type			value_type;
+		typedef T*											pointer;
+		typedef T&											reference;
+		typedef std::ptrdiff_t								difference_type;
+		typedef merkol::random_access_iterator_tag			iterator_category;
+
+		concurrent_vector_iterator() : mpVector(NULL), mnIndex(0) { }
+		concurrent_vector_iterator(Vector* vector, std::size_t index) : mpVector(vector), mnIndex(index) { }
+
+		// convertion to const
+		template <typename V, typename U>
+		concurrent_vector_iterator(const concurrent_vector_iterator<V, U>& other) : mpVector(other.mpVector), mnIndex(other.mnIndex) { }
+
+		std::size_t	index() const { return mnIndex; }
+
+		reference	operator*() const { return (*mpVector)[mnIndex]; }
+		pointer		operator->() const { return &(*mpVector)[mnIndex]; }
+		reference	operator[](difference_type n) const { return (*mpVector)[mnIndex + n]; }
+
+		concurrent_vector_iterator&	operator++() { ++mnIndex; return *this; }
+		concurrent_vector_iterator	operator++(int) { concurrent_vector_iterator temp(*this); ++mnIndex; return temp; }
+		concurrent_vector_iterator&	operator--() { --mnIndex; return *this; }
+		concurrent_vector_iterator	operator--(int) { concurrent_vector_iterator temp(*this); --mnIndex; return temp; }
+
+		concurrent_vector_iterator&	operator+=(difference_type n) { mnIndex += n; return *this; }
+		concurrent_vector_iterator&	operator-=(difference_type n) { mnIndex -= n; return *this; }
+		concurrent_vector_iterator	operator+(difference_type n) const { return concurrent_vector_iterator(mpVector, mnIndex + n); }
+		concurrent_vector_iterator	operator-(difference_type n) const { return concurrent_vector_iterator(mpVector, mnIndex - n); }
+
+	private:
+		Vector*		mpVector;
+		std::size_t	mnIndex;
+	};
+
+	template <typename V1, typename T1, typename V2, typename T2>
+	inline bool operator==(const concurrent_vector_iterator<V1, T1>& lhs, const concurrent_vector_iterator<V2, T2>& rhs)
+	{
+		return (lhs.index() == rhs.index());
+	}
+
+	template <typename V1, typename T1, typename V2, typename T2>
+	inline bool operator!=(const concurrent_vector_iterator<V1, T1>& lhs, const concurrent_vector_iterator<V2, T2>& rhs)
+	{
+		return (lhs.index() != rhs.index());
+	}
+
+	template <typename V1, typename T1, typename V2, typename T2>
+	inline bool operator<(const concurrent_vector_iterator<V1, T1>& lhs, const concurrent_vector_iterator<V2, T2>& rhs)
+	{
+		return (lhs.index() < rhs.index());
+	}
+
+	template <typename V1, typename T1, typename V2, typename T2>
+	inline bool operator>(const concurrent_vector_iterator<V1, T1>& lhs, const concurrent_vector_iterator<V2, T2>& rhs)
+	{
+		return (rhs < lhs);
+	}
+
+	template <typename V1, typename T1, typename V2, typename T2>
+	inline bool operator<=(const concurrent_vector_iterator<V1, T1>& lhs, const concurrent_vector_iterator<V2, T2>& rhs)
+	{
+		return !(rhs < lhs);
+	}
+
+	template <typename V1, typename T1, typename V2, typename T2>
+	inline bool operator>=(const concurrent_vector_iterator<V1, T1>& lhs, const concurrent_vector_iterator<V2, T2>& rhs)
+	{
+		return !(lhs < rhs);
+	}
+
+	template <typename V1, typename T1, typename V2, typename T2>
+	inline std::ptrdiff_t operator-(const concurrent_vector_iterator<V1, T1>& lhs, const concurrent_vector_iterator<V2, T2>& rhs)
+	{
+		return (std::ptrdiff_t)(lhs.index() - rhs.index());
+	}
+
+	template <typename V, typename T>
+	inline concurrent_vector_iterator<V, T> operator+(std::ptrdiff_t n, const concurrent_vector_iterator<V, T>& it)
+	{
+		return it + n;
+	}
+
+
+	/**
+	 * @brief concurrent_vector
+	 * Vector that many threads append to concurrently, with elements that never move (see above).
+	 * push_back, emplace_back, grow_by, operator[], at, size and capacity may be called from any thread.
+	 */
+	template <typename T, typename Allocator = std::allocator<T> >
+	class concurrent_vector
+	{
+		static_assert(std::is_nothrow_move_constructible<T>::value, "concurrent_vector needs a noexcept move constructor");
+
+	public:
+		typedef T																		value_type;
+		typedef T*																		pointer;
+		typedef const T*																const_pointer;
+		typedef T&																		reference;
+		typedef const T&																const_reference;
+		typedef std::size_t																size_type;
+		typedef std::ptrdiff_t															difference_type;
+		typedef Allocator																allocator_type;
+		typedef concurrent_vector_iterator<concurrent_vector, T>						iterator;
+		typedef concurrent_vector_iterator<const concurrent_vector, const T>			const_iterator;
+
+	protected:
+		static constexpr size_type floor_pow2(size_type n, size_type p = 1) { return (p * 2 <= n) ? floor_pow2(n, p * 2) : p; }
+		static constexpr size_type log2(size_type p) { return (p > 1) ? 1 + log2(p / 2) : 0; }
+
+	public:
+		// Elements of segment 0: about 512 bytes worth, a power of two.
+		static const size_type kFirstSegment	= floor_pow2((sizeof(T) < 512) ? 512 / sizeof(T) : 1);
+		static const size_type kFirstShift		= log2(kFirstSegment);
+		static const size_type kMaxSegments		= sizeof(size_type) * 8 - kFirstShift;
+
+	public:
+		explicit concurrent_vector(const allocator_type& allocator = allocator_type());
+		~concurrent_vector();
+
+		concurrent_vector(const concurrent_vector&) = delete;
+		concurrent_vector& operator=(const concurrent_vector&) = delete;
+
+		// Append, from any thread. They return an iterator to the (first) new element.
+		iterator		push_back(const value_type& value);
+		iterator		push_back(value_type&& value);
+		template <typename... Args>
+		iterator		emplace_back(Args&&... args);
+		iterator		grow_by(size_type n);
+		iterator		grow_by(size_type n, const value_type& value);
+
+		reference		operator[](size_type i);
+		const_reference	operator[](size_type i) const;
+		reference		at(size_type i);
+		const_reference	at(size_type i) const;
+
+		iterator		begin() { return iterator(this, 0); }
+		const_iterator	begin() const { return const_iterator(this, 0); }
+		iterator		end() { return iterator(this, size()); }
+		const_iterator	end() const { return const_iterator(this, size()); }
+
+		size_type		size() const M_NOEXCEPT { return mSize.load(std::memory_order_acquire); }
+		bool			empty() const M_NOEXCEPT { return size() == 0; }
+		size_type		capacity() const M_NOEXCEPT;
+		size_type		max_size() const M_NOEXCEPT { return mAllocator.max_size(); }
+
+		// Not concurrent: destroys the elements and frees the segments.
+		void			clear();
+
+		allocator_type	get_allocator() const { return mAllocator; }
+
+	protected:
+		// Segment of index i, and the index its first element has.
+		static size_type	doSegmentIndex(size_type i) { return sizeof(unsigned long long) * 8 - 1 - __builtin_clzll((unsigned long long)((i >> kFirstShift) + 1)); }
+		static size_type	doSegmentBase(size_type k) { return (kFirstSegment << k) - kFirstSegment; }
+		static size_type	doSegmentSize(size_type k) { return kFirstSegment << k; }
+
+		// Stored in the table for a segment whose allocation threw.
+		static pointer		doFailedSegment() { return reinterpret_cast<pointer>(static_cast<uintptr_t>(1)); }
+
+		pointer				doAllocateSegment(size_type k);
+		pointer				doWaitSegment(size_type k) const;
+		void				doFailSegments(size_type first, size_type last);
+
+		template <typename Construct>
+		iterator			doGrowBy(size_type n, Construct construct);
+
+		template <typename... Args>
+		iterator			doEmplaceBack(std::true_type, Args&&... args);
+		template <typename... Args>
+		iterator			doEmplaceBack(std::false_type, Args&&... args);
+
+		std::atomic<pointer>	mSegments[kMaxSegments];
+		allocator_type			mAllocator;
+		unsigned char			mPadSize[MERKOL_CACHE_LINE_SIZE];
+		std::atomic<size_type>	mSize;		// indexes claimed
+		unsigned char			mPadBack[MERKOL_CACHE_LINE_SIZE];
+	}; // concurrent_vector
+
+
+	///////////////////////////////////////////////////////////////////////
+	// ConcurrentVector.imp.begin();									///
+	///////////////////////////////////////////////////////////////////////
+
+	#define MERKOL_CONCURRENT_VECTOR_TEMPLATE	template <typename T, typename Allocator>
+	#define MERKOL_CONCURRENT_VECTOR			concurrent_vector<T, Allocator>
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	const typename MERKOL_CONCURRENT_VECTOR::size_type MERKOL_CONCURRENT_VECTOR::kFirstSegment;
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	const typename MERKOL_CONCURRENT_VECTOR::size_type MERKOL_CONCURRENT_VECTOR::kFirstShift;
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	const typename MERKOL_CONCURRENT_VECTOR::size_type MERKOL_CONCURRENT_VECTOR::kMaxSegments;
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	MERKOL_CONCURRENT_VECTOR::concurrent_vector(const allocator_type& allocator)
+		: mAllocator(allocator)
+	{
+		for (size_type k = 0; k < kMaxSegments; ++k)
+			mSegments[k].store(NULL, std::memory_order_relaxed);
+		mSize.store(0, std::memory_order_relaxed);
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	MERKOL_CONCURRENT_VECTOR::~concurrent_vector()
+	{
+		clear();
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	void MERKOL_CONCURRENT_VECTOR::clear()
+	{
+		const size_type n = mSize.load(std::memory_order_acquire);
+
+		for (size_type k = 0; k < kMaxSegments; ++k)
+		{
+			const pointer segment = mSegments[k].load(std::memory_order_relaxed);
+
+			if (!segment)
+				break;
+			if (segment != doFailedSegment())
+			{
+				const size_type base	= doSegmentBase(k);
+				const size_type count	= (n - base < doSegmentSize(k)) ? n - base : doSegmentSize(k);
+
+				merkol::destruct(segment, segment + count);
+				mAllocator.deallocate(segment, doSegmentSize(k));
+			}
+			mSegments[k].store(NULL, std::memory_order_relaxed);
+		}
+		mSize.store(0, std::memory_order_relaxed);
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	typename MERKOL_CONCURRENT_VECTOR::size_type MERKOL_CONCURRENT_VECTOR::capacity() const M_NOEXCEPT
+	{
+		size_type k = 0;
+
+		while ((k < kMaxSegments) && mSegments[k].load(std::memory_order_acquire))
+			++k;
+		return doSegmentBase(k);
+	}
+
+	// Called by the thread that claimed the first index of segment k, and by nobody else.
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	typename MERKOL_CONCURRENT_VECTOR::pointer MERKOL_CONCURRENT_VECTOR::doAllocateSegment(size_type k)
+	{
+		const pointer segment = mAllocator.allocate(doSegmentSize(k));
+
+		mSegments[k].store(segment, std::memory_order_release);
+		return segment;
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	typename MERKOL_CONCURRENT_VECTOR::pointer MERKOL_CONCURRENT_VECTOR::doWaitSegment(size_type k) const
+	{
+		pointer segment = mSegments[k].load(std::memory_order_acquire);
+
+		for (unsigned spins = 0; !segment; ++spins)
+		{
+			if (spins < 64)
+				merkol::cpu_relax();
+			else
+				std::this_thread::yield();
+			segment = mSegments[k].load(std::memory_order_acquire);
+		}
+		if (segment == doFailedSegment())
+			throw std::bad_alloc();
+		return segment;
+	}
+
+	// After an allocation failed: marks the segments that start in [first, last), which this thread
+	// claimed, so that the threads waiting for them give up.
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	void MERKOL_CONCURRENT_VECTOR::doFailSegments(size_type first, size_type last)
+	{
+		for (size_type k = doSegmentIndex(first); (k < kMaxSegments) && (doSegmentBase(k) < last); ++k)
+		{
+			if (doSegmentBase(k) >= first)
+				mSegments[k].store(doFailedSegment(), std::memory_order_release);
+		}
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	template <typename Construct>
+	typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::doGrowBy(size_type n, Construct construct)
+	{
+		const size_type first	= mSize.fetch_add(n, std::memory_order_relaxed);
+		const size_type last	= first + n;
+		size_type		i		= first;
+
+		try
+		{
+			while (i < last)
+			{
+				const size_type k		= doSegmentIndex(i);
+				const size_type base	= doSegmentBase(k);
+				const size_type end		= (last - base < doSegmentSize(k)) ? last : base + doSegmentSize(k);
+				const pointer	segment	= (i == base) ? doAllocateSegment(k) : doWaitSegment(k);
+
+				for (; i < end; ++i)
+					construct(segment + (i - base));
+			}
+		}
+		catch (...)
+		{
+			doFailSegments(i, last);
+			throw;
+		}
+		return iterator(this, first);
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	inline typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::push_back(const value_type& value)
+	{
+		return emplace_back(value);
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	inline typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::push_back(value_type&& value)
+	{
+		return emplace_back(std::move(value));
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	template <typename... Args>
+	inline typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::emplace_back(Args&&... args)
+	{
+		return doEmplaceBack(std::integral_constant<bool, std::is_nothrow_constructible<value_type, Args&&...>::value>(),
+							 std::forward<Args>(args)...);
+	}
+
+	// The constructor can not throw: build the element in place.
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	template <typename... Args>
+	inline typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::doEmplaceBack(std::true_type, Args&&... args)
+	{
+		return doGrowBy(1, [&](pointer p) { ::new(static_cast<void*>(p)) value_type(std::forward<Args>(args)...); });
+	}
+
+	// The constructor may throw: build the element before claiming its index, then move it in.
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	template <typename... Args>
+	inline typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::doEmplaceBack(std::false_type, Args&&... args)
+	{
+		value_type element(std::forward<Args>(args)...);
+
+		return doGrowBy(1, [&](pointer p) { ::new(static_cast<void*>(p)) value_type(std::move(element)); });
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::grow_by(size_type n)
+	{
+		static_assert(std::is_nothrow_default_constructible<T>::value, "concurrent_vector::grow_by(n) needs a noexcept default constructor");
+
+		return doGrowBy(n, [](pointer p) { ::new(static_cast<void*>(p)) value_type(); });
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	typename MERKOL_CONCURRENT_VECTOR::iterator MERKOL_CONCURRENT_VECTOR::grow_by(size_type n, const value_type& value)
+	{
+		static_assert(std::is_nothrow_copy_constructible<T>::value, "concurrent_vector::grow_by(n, value) needs a noexcept copy constructor");
+
+		return doGrowBy(n, [&value](pointer p) { ::new(static_cast<void*>(p)) value_type(value); });
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	inline typename MERKOL_CONCURRENT_VECTOR::reference MERKOL_CONCURRENT_VECTOR::operator[](size_type i)
+	{
+		const size_type k = doSegmentIndex(i);
+
+		return mSegments[k].load(std::memory_order_acquire)[i - doSegmentBase(k)];
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	inline typename MERKOL_CONCURRENT_VECTOR::const_reference MERKOL_CONCURRENT_VECTOR::operator[](size_type i) const
+	{
+		const size_type k = doSegmentIndex(i);
+
+		return mSegments[k].load(std::memory_order_acquire)[i - doSegmentBase(k)];
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	typename MERKOL_CONCURRENT_VECTOR::reference MERKOL_CONCURRENT_VECTOR::at(size_type i)
+	{
+		if (i >= size())
+			throw std::out_of_range("merkol::concurrent_vector::at -- index out of range");
+		return (*this)[i];
+	}
+
+	MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	typename MERKOL_CONCURRENT_VECTOR::const_reference MERKOL_CONCURRENT_VECTOR::at(size_type i) const
+	{
+		if (i >= size())
+			throw std::out_of_range("merkol::concurrent_vector::at -- index out of range");
+		return (*this)[i];
+	}
+
+	#undef MERKOL_CONCURRENT_VECTOR_TEMPLATE
+	#undef MERKOL_CONCURRENT_VECTOR
+
+	///////////////////////////////////////////////////////////////////////
+	// ConcurrentVector.imp.end();										///
+	///////////////////////////////////////////////////////////////////////
+
+} // namespace merkol
+
+// Standard algorithms (std::sort, std::lower_bound...) see a std:: random access tag.
+namespace std
+{
+	template <typename Vector, typename T>
+	struct iterator_traits<merkol::concurrent_vector_iterator<Vector, T> >
+	{
+		typedef std::random_access_iterator_tag				iterator_category;
+		typedef typename merkol::remove_cv<T>::type			value_type;
+		typedef std::ptrdiff_t								difference_type;
+		typedef T*											pointer;
+		typedef T&											reference;
+	};
+} // namespace std
+
+#endif // MERKOL_CONCURRENT_VECTOR_HPP
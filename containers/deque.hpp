@@ -0,0 +1,1468 @@
+#ifndef MERKOL_DEQUE_HPP
+# define MERKOL_DEQUE_HPP
+
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include "../iterators/iterator.hpp"
+#include "../iterators/reverse_iterator.hpp"
+#include "../auxiliary/trace.hpp"
+#include "../aux_templates/algorithm.hpp"
+#include "../aux_templates/type_traits.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	deque
+
+	Elements live in fixed size blocks of BlockSize elements. A map (an array of block pointers) keeps
+	the blocks in order, with free slots on both sides, so that pushing or popping at either end is O(1)
+	and never moves an element: references to elements stay valid, only iterators are invalidated by
+	insertions at the ends. When the map runs out of slots on one side it is recentred, or doubled when
+	more than half of it is in use; only the block pointers are copied.
+
+		map:	[ -  - b0 b1 b2  -  - ]
+					   |        |
+					   begin    end			(end always points inside an allocated block)
+
+	The default block size is a 4 KB page worth of elements, at least 16. It is a template argument so
+	that a queue of large messages can use smaller blocks and a queue of ints larger ones.
+
+	One block freed by a pop is kept aside and handed out to the next push that needs one, so a work
+	queue cycling through the same number of elements does not call the allocator at all.
+
+	Algorithms: for_each, copy and fill have overloads for deque iterators that run one loop per block
+	over raw pointers (see for_each_segment), so the inner loop is a plain pointer loop the compiler
+	vectorizes and memmove/memset apply. Iterating with ++ over a deque_iterator checks for the block end
+	on every step instead.
+*/
+
+namespace merkol
+{
+	/// deque_default_block_size
+	///
+	/// Elements per block when none is given: a 4 KB page worth, at least 16.
+	template <typename T>
+	struct deque_default_block_size
+		: integral_constant<std::size_t, (sizeof(T) <= 4096 / 16) ? 4096 / sizeof(T) : 16> {};
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	struct dequeBase;
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	class deque;
+
+
+	/// deque_iterator
+	///
+	/// Random access iterator over the blocks of a deque. T is const qualified for const iterators,
+	/// like random_access_iterator. Trivially copyable.
+	template <typename T, std::size_t BlockSize>
+	class deque_iterator
+	{
+		template <typename, typename, std::size_t> friend struct dequeBase;
+		template <typename, typename, std::size_t> friend class deque;
+		template <typename, std::size_t> friend class deque_iterator;
+
+	public:
+		typedef deque_iterator<T, BlockSize>				this_type;
+		typedef T											value_type;
+		typedef T*											pointer;
+		typedef T&											reference;
+		typedef std::ptrdiff_t								difference_type;
+		typedef merkol::random_access_iterator_tag			iterator_category;
+		typedef deque_iterator<const T, BlockSize>			const_iterator;
+		typedef typename merkol::remove_cv<T>::type*		block_pointer;
+		typedef block_pointer*								node_pointer;
+
+		deque_iterator() : mpCurrent(NULL), mpBegin(NULL), mpEnd(NULL), mpNode(NULL) { }
+		deque_iterator(pointer current, node_pointer node) : mpCurrent(current), mpBegin(*node), mpEnd(*node + BlockSize), mpNode(node) { }
+
+		// convertion to const
+		operator const_iterator() const
+		{
+			const_iterator it;
+
+			it.mpCurrent	= mpCurrent;
+			it.mpBegin		= mpBegin;
+			it.mpEnd		= mpEnd;
+			it.mpNode		= mpNode;
+			return it;
+		}
+
+		pointer			base() const { return mpCurrent; }
+		node_pointer	node() const { return mpNode; }
+		pointer			segment_begin() const { return mpBegin; } // start of the block base() is in
+		pointer			segment_end() const { return mpEnd; } // end of that block
+
+		reference	operator*() const { return *mpCurrent; }
+		pointer		operator->() const { return mpCurrent; }
+
+		deque_iterator& operator++()
+		{
+			if (++mpCurrent == mpEnd)
+			{
+				setNode(mpNode + 1);
+				mpCurrent = mpBegin;
+			}
+			return *this;
+		}
+
+		deque_iterator operator++(int)
+		{
+			deque_iterator temp(*this);
+			++(*this);
+			return temp;
+		}
+
+		deque_iterator& operator--()
+		{
+			if (mpCurrent == mpBegin)
+			{
+				setNode(mpNode - 1);
+				mpCurrent = mpEnd;
+			}
+			--mpCurrent;
+			return *this;
+		}
+
+		deque_iterator operator--(int)
+		{
+			deque_iterator temp(*this);
+			--(*this);
+			return temp;
+		}
+
+		deque_iterator& operator+=(difference_type n)
+		{
+			const difference_type offset = n + (mpCurrent - mpBegin);
+
+			if ((offset >= 0) && (offset < (difference_type)BlockSize))
+				mpCurrent += n;
+			else
+			{
+				const difference_type nodeOffset = (offset > 0) ? offset / (difference_type)BlockSize
+																: -(difference_type)((-offset - 1) / (difference_type)BlockSize) - 1;
+				setNode(mpNode + nodeOffset);
+				mpCurrent = mpBegin + (offset - nodeOffset * (difference_type)BlockSize);
+			}
+			return *this;
+		}
+
+		deque_iterator& operator-=(difference_type n) { return (*this += -n); }
+
+		deque_iterator operator+(difference_type n) const
+		{
+			deque_iterator temp(*this);
+			return (temp += n);
+		}
+
+		deque_iterator operator-(difference_type n) const
+		{
+			deque_iterator temp(*this);
+			return (temp += -n);
+		}
+
+		reference operator[](difference_type n) const { return *(*this + n); }
+
+	private:
+		void setNode(node_pointer node)
+		{
+			mpNode	= node;
+			mpBegin	= *node;
+			mpEnd	= mpBegin + BlockSize;
+		}
+
+		pointer			mpCurrent;
+		pointer			mpBegin;	// block mpCurrent is in
+		pointer			mpEnd;
+		node_pointer	mpNode;		// map slot of that block
+	};
+
+	template <typename T1, typename T2, std::size_t BlockSize>
+	inline bool operator==(const deque_iterator<T1, BlockSize>& lhs, const deque_iterator<T2, BlockSize>& rhs)
+	{
+		return (lhs.base() == rhs.base());
+	}
+
+	template <typename T1, typename T2, std::size_t BlockSize>
+	inline bool operator!=(const deque_iterator<T1, BlockSize>& lhs, const deque_iterator<T2, BlockSize>& rhs)
+	{
+		return (lhs.base() != rhs.base());
+	}
+
+	template <typename T1, typename T2, std::size_t BlockSize>
+	inline bool operator<(const deque_iterator<T1, BlockSize>& lhs, const deque_iterator<T2, BlockSize>& rhs)
+	{
+		return (lhs.node() == rhs.node()) ? (lhs.base() < rhs.base()) : (lhs.node() < rhs.node());
+	}
+
+	template <typename T1, typename T2, std::size_t BlockSize>
+	inline bool operator>(const deque_iterator<T1, BlockSize>& lhs, const deque_iterator<T2, BlockSize>& rhs)
+	{
+		return (rhs < lhs);
+	}
+
+	template <typename T1, typename T2, std::size_t BlockSize>
+	inline bool operator<=(const deque_iterator<T1, BlockSize>& lhs, const deque_iterator<T2, BlockSize>& rhs)
+	{
+		return !(rhs < lhs);
+	}
+
+	template <typename T1, typename T2, std::size_t BlockSize>
+	inline bool operator>=(const deque_iterator<T1, BlockSize>& lhs, const deque_iterator<T2, BlockSize>& rhs)
+	{
+		return !(lhs < rhs);
+	}
+
+	template <typename T1, typename T2, std::size_t BlockSize>
+	inline std::ptrdiff_t operator-(const deque_iterator<T1, BlockSize>& lhs, const deque_iterator<T2, BlockSize>& rhs)
+	{
+		return (std::ptrdiff_t)BlockSize * (lhs.node() - rhs.node())
+			+ (lhs.base() - lhs.segment_begin()) - (rhs.base() - rhs.segment_begin());
+	}
+
+	template <typename T, std::size_t BlockSize>
+	inline deque_iterator<T, BlockSize> operator+(std::ptrdiff_t n, const deque_iterator<T, BlockSize>& it)
+	{
+		return (it + n);
+	}
+
+
+	/// for_each_segment
+	///
+	/// Calls f(begin, end) with the pointer range of every block [first, last) covers, in order.
+	/// The segment-aware algorithms below are built on it.
+	template <typename T, std::size_t BlockSize, typename SegmentFunction>
+	inline SegmentFunction for_each_segment(deque_iterator<T, BlockSize> first, deque_iterator<T, BlockSize> last, SegmentFunction f)
+	{
+		typedef typename deque_iterator<T, BlockSize>::node_pointer node_pointer;
+
+		if (first.node() == last.node())
+		{
+			f(first.base(), last.base());
+			return f;
+		}
+		f(first.base(), first.segment_end());
+		for (node_pointer node = first.node() + 1; node != last.node(); ++node)
+			f((T*)*node, (T*)*node + BlockSize);
+		f((T*)*last.node(), last.base());
+		return f;
+	}
+
+	template <typename Function>
+	struct for_each_segment_adaptor
+	{
+		Function f;
+
+		explicit for_each_segment_adaptor(Function function) : f(function) { }
+
+		template <typename Pointer>
+		void operator()(Pointer first, Pointer last)
+		{
+			for (; first != last; ++first)
+				f(*first);
+		}
+	};
+
+	template <typename T, std::size_t BlockSize, typename Function>
+	inline Function for_each(deque_iterator<T, BlockSize> first, deque_iterator<T, BlockSize> last, Function f)
+	{
+		return merkol::for_each_segment(first, last, for_each_segment_adaptor<Function>(f)).f;
+	}
+
+	template <typename Value>
+	struct fill_segment
+	{
+		const Value* value;
+
+		template <typename Pointer>
+		void operator()(Pointer first, Pointer last) { std::fill(first, last, *value); }
+	};
+
+	template <typename T, std::size_t BlockSize, typename Value>
+	inline void fill(deque_iterator<T, BlockSize> first, deque_iterator<T, BlockSize> last, const Value& value)
+	{
+		fill_segment<Value> f;
+
+		f.value = merkol::addressof(value);
+		merkol::for_each_segment(first, last, f);
+	}
+
+	// Copies into a deque one destination block at a time.
+	template <typename T, std::size_t BlockSize>
+	inline deque_iterator<T, BlockSize> copy(const T* first, const T* last, deque_iterator<T, BlockSize> dest)
+	{
+		while (first != last)
+		{
+			const std::ptrdiff_t room	= dest.segment_end() - dest.base();
+			const std::ptrdiff_t n		= ((last - first) < room) ? (last - first) : room;
+
+			std::copy(first, first + n, dest.base());
+			first += n;
+			dest += n;
+		}
+		return dest;
+	}
+
+	template <typename T, std::size_t BlockSize>
+	inline deque_iterator<T, BlockSize> copy(T* first, T* last, deque_iterator<T, BlockSize> dest)
+	{
+		return merkol::copy(static_cast<const T*>(first), static_cast<const T*>(last), dest);
+	}
+
+	template <typename OutputIterator>
+	struct copy_segment
+	{
+		OutputIterator dest;
+
+		explicit copy_segment(OutputIterator d) : dest(d) { }
+
+		template <typename Pointer>
+		void operator()(Pointer first, Pointer last) { dest = merkol::copy(first, last, dest); }
+	};
+
+	// Copies out of a deque one source block at a time; a deque destination is handled by the overload above.
+	template <typename T, std::size_t BlockSize, typename OutputIterator>
+	inline OutputIterator copy(deque_iterator<T, BlockSize> first, deque_iterator<T, BlockSize> last, OutputIterator dest)
+	{
+		return merkol::for_each_segment(first, last, copy_segment<OutputIterator>(dest)).dest;
+	}
+
+
+	/*
+		dequeBase
+		Owns the map and the blocks, like vectorBase owns the buffer of a vector: blocks are allocated and
+		freed here and nowhere else, and the destructor releases them, which keeps the deque constructors
+		free of try/catch. Nothing here constructs or destroys an element.
+
+		Invariants: every map slot in [mItBegin.mpNode, mItEnd.mpNode] holds an allocated block, and
+		mItEnd.mpCurrent is inside its block (never one past it).
+
+		Except in the empty state without a map (mpMap == NULL) a deque is in when default constructed
+		or moved from: both iterators then point at a static element nothing is ever constructed in,
+		with mpEnd one past it, so that the push fast paths fall through to doReserveBack() and
+		doReserveFront(), which allocate the map and the first block. Nothing else needs to tell the
+		two states apart, and moving a deque allocates nothing.
+	*/
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	struct dequeBase
+	{
+		typedef Allocator											allocator_type;
+		typedef std::size_t											size_type;
+		typedef std::ptrdiff_t										difference_type;
+		typedef deque_iterator<T, BlockSize>						iterator;
+		typedef deque_iterator<const T, BlockSize>					const_iterator;
+		typedef typename Allocator::template rebind<T*>::other		map_allocator_type;
+
+		static const size_type kBlockSize	= BlockSize;
+		static const size_type kMinMapSize	= 8;
+
+	protected:
+		T**				mpMap;
+		size_type		mnMapSize;
+		iterator		mItBegin;
+		iterator		mItEnd;
+		T*				mpSpareBlock;	// last block freed, reused by the next allocation
+		allocator_type	mAllocator;
+
+	public:
+		explicit dequeBase(const allocator_type& allocator);
+		dequeBase(const allocator_type& allocator, size_type n);
+		~dequeBase();
+
+		const allocator_type&	get_allocator() const { return mAllocator; }
+		allocator_type&			get_allocator() { return mAllocator; }
+
+	protected:
+		static iterator doEmptyIterator();
+
+		void		doAllocateMap(size_type n);
+		T*			doAllocateBlock();
+		void		doFreeBlock(T* p);
+		void		doFreeBlocks(T** nodes, size_type count);
+		size_type	doReserveBack(size_type n);
+		size_type	doReserveFront(size_type n);
+		void		doReallocateMap(size_type nodesToAdd, bool atFront);
+
+	private:
+		dequeBase(const dequeBase&);
+		dequeBase& operator=(const dequeBase&);
+	}; // dequeBase
+
+
+	///////////////////////////////////////////////////////////////////////
+	// DequeBase.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	// The empty state without a map, see the comment above.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	dequeBase<T, Allocator, BlockSize>::dequeBase(const allocator_type& allocator)
+		: mpMap(NULL),
+		  mnMapSize(0),
+		  mItBegin(doEmptyIterator()),
+		  mItEnd(mItBegin),
+		  mpSpareBlock(NULL),
+		  mAllocator(allocator)
+	{
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	dequeBase<T, Allocator, BlockSize>::dequeBase(const allocator_type& allocator, size_type n)
+		: mpMap(NULL),
+		  mnMapSize(0),
+		  mpSpareBlock(NULL),
+		  mAllocator(allocator)
+	{
+		doAllocateMap(n);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	dequeBase<T, Allocator, BlockSize>::~dequeBase()
+	{
+		MERKOL_TRACE(this, "dequeBase::destructor", mItEnd - mItBegin, mpMap ? (mItEnd.mpNode - mItBegin.mpNode + 1) * kBlockSize : 0);
+		if (mpMap)
+		{
+			doFreeBlocks(mItBegin.mpNode, (size_type)(mItEnd.mpNode - mItBegin.mpNode) + 1);
+			map_allocator_type(mAllocator).deallocate(mpMap, mnMapSize);
+		}
+		if (mpSpareBlock)
+			mAllocator.deallocate(mpSpareBlock, kBlockSize);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename dequeBase<T, Allocator, BlockSize>::iterator
+	dequeBase<T, Allocator, BlockSize>::doEmptyIterator()
+	{
+		static merkol::aligned_buffer<T>	element;
+		static T*							node;
+		iterator							it;
+
+		it.mpCurrent	= element.get();
+		it.mpBegin		= it.mpCurrent;
+		it.mpEnd		= it.mpCurrent + 1;
+		it.mpNode		= &node;
+		return it;
+	}
+
+	// Allocates a map and the blocks for n elements, with begin() at the start of the first block.
+	// Members are only set once everything is allocated, so a throw leaves the deque as it was.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void dequeBase<T, Allocator, BlockSize>::doAllocateMap(size_type n)
+	{
+		const size_type		nodeCount	= n / kBlockSize + 1;
+		const size_type		mapSize		= (nodeCount + 2 > kMinMapSize) ? nodeCount + 2 : kMinMapSize;
+		map_allocator_type	mapAllocator(mAllocator);
+		T** const			map			= mapAllocator.allocate(mapSize);
+		T** const			first		= map + (mapSize - nodeCount) / 2;
+		T**					node		= first;
+
+		try
+		{
+			for (; node != first + nodeCount; ++node)
+				*node = doAllocateBlock();
+		}
+		catch (...)
+		{
+			doFreeBlocks(first, (size_type)(node - first));
+			mapAllocator.deallocate(map, mapSize);
+			throw;
+		}
+		mpMap		= map;
+		mnMapSize	= mapSize;
+		mItBegin	= iterator(*first, first);
+		mItEnd		= iterator(*(first + nodeCount - 1) + n % kBlockSize, first + nodeCount - 1);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline T* dequeBase<T, Allocator, BlockSize>::doAllocateBlock()
+	{
+		if (T* const block = mpSpareBlock)
+		{
+			mpSpareBlock = NULL;
+			return block;
+		}
+		return mAllocator.allocate(kBlockSize);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void dequeBase<T, Allocator, BlockSize>::doFreeBlock(T* p)
+	{
+		if (!mpSpareBlock)
+			mpSpareBlock = p;
+		else
+			mAllocator.deallocate(p, kBlockSize);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void dequeBase<T, Allocator, BlockSize>::doFreeBlocks(T** nodes, size_type count)
+	{
+		for (size_type i = 0; i < count; ++i)
+			doFreeBlock(nodes[i]);
+	}
+
+	// Allocates the blocks needed for n more elements after end() and returns how many were added.
+	// They follow mItEnd.mpNode in the map; the caller frees them if it fails to use them.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename dequeBase<T, Allocator, BlockSize>::size_type
+	dequeBase<T, Allocator, BlockSize>::doReserveBack(size_type n)
+	{
+		const size_type vacancies = (size_type)(mItEnd.mpEnd - mItEnd.mpCurrent) - 1;
+
+		if (n <= vacancies)
+			return 0;
+		if (!mpMap)
+		{
+			doAllocateMap(0);
+			return doReserveBack(n);
+		}
+
+		const size_type blocks = (n - vacancies + kBlockSize - 1) / kBlockSize;
+
+		if (blocks + 1 > mnMapSize - (size_type)(mItEnd.mpNode - mpMap))
+			doReallocateMap(blocks, false);
+
+		size_type i = 1;
+		try
+		{
+			for (; i <= blocks; ++i)
+				mItEnd.mpNode[i] = doAllocateBlock();
+		}
+		catch (...)
+		{
+			doFreeBlocks(mItEnd.mpNode + 1, i - 1);
+			throw;
+		}
+		return blocks;
+	}
+
+	// Same as doReserveBack() for n more elements before begin().
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename dequeBase<T, Allocator, BlockSize>::size_type
+	dequeBase<T, Allocator, BlockSize>::doReserveFront(size_type n)
+	{
+		const size_type vacancies = (size_type)(mItBegin.mpCurrent - mItBegin.mpBegin);
+
+		if (n <= vacancies)
+			return 0;
+		if (!mpMap)
+		{
+			doAllocateMap(0);
+			return doReserveFront(n);
+		}
+
+		const size_type blocks = (n - vacancies + kBlockSize - 1) / kBlockSize;
+
+		if (blocks > (size_type)(mItBegin.mpNode - mpMap))
+			doReallocateMap(blocks, true);
+
+		size_type i = 1;
+		try
+		{
+			for (; i <= blocks; ++i)
+				*(mItBegin.mpNode - i) = doAllocateBlock();
+		}
+		catch (...)
+		{
+			doFreeBlocks(mItBegin.mpNode - (i - 1), i - 1);
+			throw;
+		}
+		return blocks;
+	}
+
+	// Makes room for nodesToAdd more blocks at one end of the map. The used slots are recentred when
+	// the map is less than half full, otherwise the map is doubled.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void dequeBase<T, Allocator, BlockSize>::doReallocateMap(size_type nodesToAdd, bool atFront)
+	{
+		const size_type	oldNodeCount	= (size_type)(mItEnd.mpNode - mItBegin.mpNode) + 1;
+		const size_type	newNodeCount	= oldNodeCount + nodesToAdd;
+		T**				newStart;
+
+		if (mnMapSize > 2 * newNodeCount)
+		{
+			newStart = mpMap + (mnMapSize - newNodeCount) / 2 + (atFront ? nodesToAdd : 0);
+			std::memmove(newStart, mItBegin.mpNode, oldNodeCount * sizeof(T*));
+		}
+		else
+		{
+			const size_type		newMapSize = mnMapSize + ((mnMapSize > nodesToAdd) ? mnMapSize : nodesToAdd) + 2;
+			map_allocator_type	mapAllocator(mAllocator);
+			T** const			newMap = mapAllocator.allocate(newMapSize);
+
+			newStart = newMap + (newMapSize - newNodeCount) / 2 + (atFront ? nodesToAdd : 0);
+			std::memcpy(newStart, mItBegin.mpNode, oldNodeCount * sizeof(T*));
+			mapAllocator.deallocate(mpMap, mnMapSize);
+			MERKOL_TRACE(this, "deque::grow_map", mnMapSize, newMapSize);
+			mpMap		= newMap;
+			mnMapSize	= newMapSize;
+		}
+		mItBegin.mpNode	= newStart;
+		mItEnd.mpNode	= newStart + oldNodeCount - 1;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// DequeBase.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/**
+	 * @brief deque
+	 * Double ended queue over fixed size blocks, see the comment at the top of the file.
+	 *
+	 * @tparam T value type
+	 * @tparam Allocator allocator type, rebound to T* for the map
+	 * @tparam BlockSize elements per block
+	 */
+	template <typename T, typename Allocator = std::allocator<T>, std::size_t BlockSize = deque_default_block_size<T>::value>
+	class deque : public dequeBase<T, Allocator, BlockSize>
+	{
+		typedef dequeBase<T, Allocator, BlockSize>	base_type;
+		typedef deque<T, Allocator, BlockSize>		this_type;
+
+	public:
+		typedef T													value_type;
+		typedef T*													pointer;
+		typedef const T*											const_pointer;
+		typedef T&													reference;
+		typedef const T&											const_reference;
+		typedef typename base_type::iterator						iterator;
+		typedef typename base_type::const_iterator					const_iterator;
+		typedef merkol::reverse_iterator<iterator>					reverse_iterator;
+		typedef merkol::reverse_iterator<const_iterator>			const_reverse_iterator;
+		typedef typename base_type::size_type						size_type;
+		typedef typename base_type::difference_type					difference_type;
+		typedef typename base_type::allocator_type					allocator_type;
+
+		static const size_type kBlockSize = BlockSize;
+
+	public:
+		deque();
+		explicit deque(const allocator_type& allocator);
+		explicit deque(size_type n, const allocator_type& allocator = allocator_type());
+		deque(size_type n, const value_type& value, const allocator_type& allocator = allocator_type());
+		deque(const this_type& other);
+	#if __cplusplus >= 201103L
+		deque(this_type&& other) M_NOEXCEPT;
+	#endif
+
+		template <typename InputIterator>
+		deque(InputIterator first, InputIterator last, const allocator_type& allocator = allocator_type(),
+			  typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type* = 0);
+
+		~deque();
+
+		this_type&	operator=(const this_type& other);
+	#if __cplusplus >= 201103L
+		this_type&	operator=(this_type&& other) M_NOEXCEPT;
+	#endif
+
+		void	assign(size_type n, const value_type& value);
+
+		template <typename InputIterator>
+		void	assign(InputIterator first, InputIterator last,
+					   typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type* = 0);
+
+		// Iterators
+		iterator				begin() M_NOEXCEPT { return this->mItBegin; }
+		const_iterator			begin() const M_NOEXCEPT { return this->mItBegin; }
+		iterator				end() M_NOEXCEPT { return this->mItEnd; }
+		const_iterator			end() const M_NOEXCEPT { return this->mItEnd; }
+		reverse_iterator		rbegin() M_NOEXCEPT { return reverse_iterator(end()); }
+		const_reverse_iterator	rbegin() const M_NOEXCEPT { return const_reverse_iterator(end()); }
+		reverse_iterator		rend() M_NOEXCEPT { return reverse_iterator(begin()); }
+		const_reverse_iterator	rend() const M_NOEXCEPT { return const_reverse_iterator(begin()); }
+
+		// Capacity
+		bool		empty() const M_NOEXCEPT { return this->mItBegin.mpCurrent == this->mItEnd.mpCurrent; }
+		size_type	size() const M_NOEXCEPT { return (size_type)(this->mItEnd - this->mItBegin); }
+		size_type	max_size() const M_NOEXCEPT { return this->mAllocator.max_size(); }
+		void		resize(size_type n);
+		void		resize(size_type n, const value_type& value);
+		void		shrink_to_fit();
+
+		// Element access. operator[] is not checked, at() is.
+		reference		operator[](size_type n) { return this->mItBegin[(difference_type)n]; }
+		const_reference	operator[](size_type n) const { return this->mItBegin[(difference_type)n]; }
+		reference		at(size_type n);
+		const_reference	at(size_type n) const;
+		reference		front() { return *this->mItBegin.mpCurrent; }
+		const_reference	front() const { return *this->mItBegin.mpCurrent; }
+		reference		back();
+		const_reference	back() const;
+
+		// Modifiers
+		void		push_back(const value_type& value);
+		void		push_front(const value_type& value);
+	#if __cplusplus >= 201103L
+		void		push_back(value_type&& value);
+		void		push_front(value_type&& value);
+
+		template <typename... Args>
+		reference	emplace_back(Args&&... args);
+
+		template <typename... Args>
+		reference	emplace_front(Args&&... args);
+	#endif
+		void		pop_back();
+		void		pop_front();
+
+		iterator	insert(const_iterator pos, const value_type& value);
+	#if __cplusplus >= 201103L
+		iterator	insert(const_iterator pos, value_type&& value);
+	#endif
+		iterator	insert(const_iterator pos, size_type n, const value_type& value);
+
+		template <typename InputIterator>
+		iterator	insert(const_iterator pos, InputIterator first, InputIterator last,
+						   typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type* = 0);
+
+		iterator	erase(const_iterator pos);
+		iterator	erase(const_iterator first, const_iterator last);
+		void		clear() M_NOEXCEPT;
+		void		swap(this_type& other);
+
+	protected:
+		// Constructs the elements of a range one block at a time: Constructor is called with the pointer
+		// range of each block and builds every element in it, or destroys what it built and throws.
+		struct fill_constructor
+		{
+			const value_type* value;
+
+			void operator()(pointer first, pointer last) { merkol::uninitialized_fill(first, last, *value); }
+		};
+
+		struct value_constructor
+		{
+			void operator()(pointer first, pointer last) { merkol::uninitialized_value_construct_n(first, last - first); }
+		};
+
+		template <typename ForwardIterator>
+		struct copy_constructor
+		{
+			ForwardIterator source;
+
+			void operator()(pointer first, pointer last)
+			{
+				ForwardIterator mid = source;
+
+				merkol::advance(mid, last - first);
+				merkol::uninitialized_copy(source, mid, first);
+				source = mid;
+			}
+		};
+
+		template <typename Constructor>
+		void	doConstructSegments(iterator first, iterator last, Constructor& construct);
+		template <typename Constructor>
+		void	doConstructBack(size_type n, Constructor& construct);
+		template <typename Constructor>
+		void	doConstructFront(size_type n, Constructor& construct);
+
+		void	doDestroyRange(iterator first, iterator last);
+		void	doEraseBegin(iterator newBegin);
+		void	doEraseEnd(iterator newEnd);
+
+		template <typename InputIterator>
+		void	doAppendRange(InputIterator first, InputIterator last, merkol::input_iterator_tag);
+		template <typename ForwardIterator>
+		void	doAppendRange(ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag);
+		template <typename ForwardIterator>
+		void	doPrependRange(ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag);
+	}; // deque
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Deque.imp.begin();												///
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline deque<T, Allocator, BlockSize>::deque()
+		: base_type(allocator_type())
+	{
+		MERKOL_TRACE(this, "deque::default_constructor", 0, 0);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline deque<T, Allocator, BlockSize>::deque(const allocator_type& allocator)
+		: base_type(allocator)
+	{
+		MERKOL_TRACE(this, "deque::allocator_constructor", 0, 0);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline deque<T, Allocator, BlockSize>::deque(size_type n, const allocator_type& allocator)
+		: base_type(allocator, n)
+	{
+		value_constructor construct;
+
+		doConstructSegments(this->mItBegin, this->mItEnd, construct);
+		MERKOL_TRACE(this, "deque::size_constructor", n, n);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline deque<T, Allocator, BlockSize>::deque(size_type n, const value_type& value, const allocator_type& allocator)
+		: base_type(allocator, n)
+	{
+		fill_constructor construct;
+
+		construct.value = merkol::addressof(value);
+		doConstructSegments(this->mItBegin, this->mItEnd, construct);
+		MERKOL_TRACE(this, "deque::fill_constructor", n, n);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline deque<T, Allocator, BlockSize>::deque(const this_type& other)
+		: base_type(other.mAllocator, other.size())
+	{
+		copy_constructor<const_iterator> construct;
+
+		construct.source = other.begin();
+		doConstructSegments(this->mItBegin, this->mItEnd, construct);
+		MERKOL_TRACE(this, "deque::copy_constructor", size(), size());
+	}
+
+#if __cplusplus >= 201103L
+	// The moved-from deque is left in the empty state without a map: nothing is allocated.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline deque<T, Allocator, BlockSize>::deque(this_type&& other) M_NOEXCEPT
+		: base_type(other.mAllocator)
+	{
+		swap(other);
+	}
+#endif
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename InputIterator>
+	inline deque<T, Allocator, BlockSize>::deque(InputIterator first, InputIterator last, const allocator_type& allocator,
+												 typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type*)
+		: base_type(allocator)
+	{
+		doAppendRange(first, last, typename merkol::iterator_traits<InputIterator>::iterator_category());
+		MERKOL_TRACE(this, "deque::range_constructor", size(), size());
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline deque<T, Allocator, BlockSize>::~deque()
+	{
+		MERKOL_TRACE(this, "deque::destructor", size(), size());
+		doDestroyRange(this->mItBegin, this->mItEnd);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::this_type&
+	deque<T, Allocator, BlockSize>::operator=(const this_type& other)
+	{
+		if (this != &other)
+			assign(other.begin(), other.end());
+		return *this;
+	}
+
+#if __cplusplus >= 201103L
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::this_type&
+	deque<T, Allocator, BlockSize>::operator=(this_type&& other) M_NOEXCEPT
+	{
+		if (this != &other)
+		{
+			clear();
+			swap(other);
+		}
+		return *this;
+	}
+#endif
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::assign(size_type n, const value_type& value)
+	{
+		const size_type currentSize = size();
+
+		if (n <= currentSize)
+		{
+			merkol::fill(begin(), begin() + (difference_type)n, value);
+			doEraseEnd(begin() + (difference_type)n);
+		}
+		else
+		{
+			fill_constructor construct;
+
+			merkol::fill(begin(), end(), value);
+			construct.value = merkol::addressof(value);
+			doConstructBack(n - currentSize, construct);
+		}
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename InputIterator>
+	void deque<T, Allocator, BlockSize>::assign(InputIterator first, InputIterator last,
+												typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type*)
+	{
+		iterator current = begin();
+
+		for (; (first != last) && (current != end()); ++first, ++current)
+			*current = *first;
+		if (first == last)
+			doEraseEnd(current);
+		else
+			doAppendRange(first, last, typename merkol::iterator_traits<InputIterator>::iterator_category());
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::resize(size_type n)
+	{
+		const size_type currentSize = size();
+
+		if (n < currentSize)
+			doEraseEnd(begin() + (difference_type)n);
+		else if (n > currentSize)
+		{
+			value_constructor construct;
+			doConstructBack(n - currentSize, construct);
+		}
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::resize(size_type n, const value_type& value)
+	{
+		const size_type currentSize = size();
+
+		if (n < currentSize)
+			doEraseEnd(begin() + (difference_type)n);
+		else if (n > currentSize)
+		{
+			fill_constructor construct;
+
+			construct.value = merkol::addressof(value);
+			doConstructBack(n - currentSize, construct);
+		}
+	}
+
+	// Blocks are freed as soon as they are empty; only the spare one is left to give back.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::shrink_to_fit()
+	{
+		if (this->mpSpareBlock)
+		{
+			this->mAllocator.deallocate(this->mpSpareBlock, kBlockSize);
+			this->mpSpareBlock = NULL;
+		}
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::at(size_type n)
+	{
+		if (n >= size())
+			throw std::out_of_range("merkol::deque::at -- out of range");
+		return (*this)[n];
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::const_reference
+	deque<T, Allocator, BlockSize>::at(size_type n) const
+	{
+		if (n >= size())
+			throw std::out_of_range("merkol::deque::at -- out of range");
+		return (*this)[n];
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::back()
+	{
+		iterator last(this->mItEnd);
+		return *--last;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::const_reference
+	deque<T, Allocator, BlockSize>::back() const
+	{
+		const_iterator last(this->mItEnd);
+		return *--last;
+	}
+
+	// When the element goes into the last slot of the end block, the next block (where end() moves to)
+	// is allocated first. Elements never move, so value may refer to one of them. The empty state
+	// without a map also lands here and takes the fast path once it has its first block.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_back(const value_type& value)
+	{
+		iterator& last = this->mItEnd;
+
+		if (last.mpCurrent + 1 != last.mpEnd)
+		{
+			::new(static_cast<void*>(last.mpCurrent)) value_type(value);
+			++last.mpCurrent;
+			return;
+		}
+		if (!this->mpMap)
+		{
+			this->doAllocateMap(0);
+			return push_back(value);
+		}
+		this->doReserveBack(1);
+		try
+		{
+			::new(static_cast<void*>(last.mpCurrent)) value_type(value);
+		}
+		catch (...)
+		{
+			this->doFreeBlock(last.mpNode[1]);
+			throw;
+		}
+		last.setNode(last.mpNode + 1);
+		last.mpCurrent = last.mpBegin;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_front(const value_type& value)
+	{
+		iterator& first = this->mItBegin;
+
+		if (first.mpCurrent != first.mpBegin)
+		{
+			::new(static_cast<void*>(first.mpCurrent - 1)) value_type(value);
+			--first.mpCurrent;
+			return;
+		}
+		this->doReserveFront(1);
+		T* const block = *(first.mpNode - 1);
+		try
+		{
+			::new(static_cast<void*>(block + kBlockSize - 1)) value_type(value);
+		}
+		catch (...)
+		{
+			this->doFreeBlock(block);
+			throw;
+		}
+		first.setNode(first.mpNode - 1);
+		first.mpCurrent = first.mpEnd - 1;
+	}
+
+#if __cplusplus >= 201103L
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_back(value_type&& value)
+	{
+		emplace_back(std::move(value));
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::push_front(value_type&& value)
+	{
+		emplace_front(std::move(value));
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename... Args>
+	inline typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::emplace_back(Args&&... args)
+	{
+		iterator&	last = this->mItEnd;
+		pointer		p = last.mpCurrent;
+
+		if (p + 1 != last.mpEnd)
+		{
+			::new(static_cast<void*>(p)) value_type(std::forward<Args>(args)...);
+			++last.mpCurrent;
+			return *p;
+		}
+		if (!this->mpMap)
+		{
+			this->doAllocateMap(0);
+			return emplace_back(std::forward<Args>(args)...);
+		}
+		this->doReserveBack(1);
+		try
+		{
+			::new(static_cast<void*>(p)) value_type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			this->doFreeBlock(last.mpNode[1]);
+			throw;
+		}
+		last.setNode(last.mpNode + 1);
+		last.mpCurrent = last.mpBegin;
+		return *p;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename... Args>
+	inline typename deque<T, Allocator, BlockSize>::reference
+	deque<T, Allocator, BlockSize>::emplace_front(Args&&... args)
+	{
+		iterator& first = this->mItBegin;
+
+		if (first.mpCurrent != first.mpBegin)
+		{
+			::new(static_cast<void*>(first.mpCurrent - 1)) value_type(std::forward<Args>(args)...);
+			return *--first.mpCurrent;
+		}
+		this->doReserveFront(1);
+		T* const block = *(first.mpNode - 1);
+		try
+		{
+			::new(static_cast<void*>(block + kBlockSize - 1)) value_type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			this->doFreeBlock(block);
+			throw;
+		}
+		first.setNode(first.mpNode - 1);
+		first.mpCurrent = first.mpEnd - 1;
+		return *first.mpCurrent;
+	}
+#endif
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::pop_back()
+	{
+		iterator& last = this->mItEnd;
+
+		if (last.mpCurrent == last.mpBegin)
+		{
+			this->doFreeBlock(last.mpBegin);
+			last.setNode(last.mpNode - 1);
+			last.mpCurrent = last.mpEnd;
+		}
+		--last.mpCurrent;
+		last.mpCurrent->~value_type();
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::pop_front()
+	{
+		iterator& first = this->mItBegin;
+
+		first.mpCurrent->~value_type();
+		if (++first.mpCurrent == first.mpEnd)
+		{
+			this->doFreeBlock(first.mpBegin);
+			first.setNode(first.mpNode + 1);
+			first.mpCurrent = first.mpBegin;
+		}
+	}
+
+	// Insertions in the middle add the new elements at the nearer end, then rotate them into place:
+	// O(n + min(distance to the front, distance to the back)) element moves.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::insert(const_iterator pos, const value_type& value)
+	{
+		return insert(pos, 1, value);
+	}
+
+#if __cplusplus >= 201103L
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::insert(const_iterator pos, value_type&& value)
+	{
+		const difference_type index = pos - const_iterator(begin());
+
+		if ((size_type)index < size() / 2)
+		{
+			emplace_front(std::move(value));
+			std::rotate(begin(), begin() + 1, begin() + 1 + index);
+		}
+		else
+		{
+			emplace_back(std::move(value));
+			std::rotate(begin() + index, end() - 1, end());
+		}
+		return begin() + index;
+	}
+#endif
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::insert(const_iterator pos, size_type n, const value_type& value)
+	{
+		const difference_type	index = pos - const_iterator(begin());
+		fill_constructor		construct;
+
+		construct.value = merkol::addressof(value);
+		if ((size_type)index < size() / 2)
+		{
+			doConstructFront(n, construct);
+			std::rotate(begin(), begin() + (difference_type)n, begin() + (difference_type)n + index);
+		}
+		else
+		{
+			const size_type oldSize = size();
+
+			doConstructBack(n, construct);
+			std::rotate(begin() + index, begin() + (difference_type)oldSize, end());
+		}
+		return begin() + index;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename InputIterator>
+	typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::insert(const_iterator pos, InputIterator first, InputIterator last,
+										   typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type*)
+	{
+		typedef typename merkol::iterator_traits<InputIterator>::iterator_category category;
+
+		const difference_type	index	= pos - const_iterator(begin());
+		const size_type			oldSize	= size();
+
+		if (((size_type)index < oldSize / 2) && !merkol::is_same<category, merkol::input_iterator_tag>::value)
+		{
+			doPrependRange(first, last, category());
+			const difference_type n = (difference_type)(size() - oldSize);
+			std::rotate(begin(), begin() + n, begin() + n + index);
+		}
+		else
+		{
+			doAppendRange(first, last, category());
+			std::rotate(begin() + index, begin() + (difference_type)oldSize, end());
+		}
+		return begin() + index;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	// Shifts whichever side of the erased range is shorter over it, then drops as many elements from that end.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	typename deque<T, Allocator, BlockSize>::iterator
+	deque<T, Allocator, BlockSize>::erase(const_iterator first, const_iterator last)
+	{
+		const difference_type	index	= first - const_iterator(begin());
+		const difference_type	n		= last - first;
+		const iterator			pFirst	= begin() + index;
+		const iterator			pLast	= pFirst + n;
+
+		if (n == 0)
+			return pFirst;
+		if ((size_type)index < (size() - (size_type)n) / 2)
+		{
+			merkol::move_backward(begin(), pFirst, pLast);
+			doEraseBegin(begin() + n);
+		}
+		else
+		{
+			merkol::move(pLast, end(), pFirst);
+			doEraseEnd(end() - n);
+		}
+		return begin() + index;
+	}
+
+	// Keeps the block begin() is in, restarting at its first slot.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::clear() M_NOEXCEPT
+	{
+		doEraseEnd(this->mItBegin);
+		this->mItBegin.mpCurrent	= this->mItBegin.mpBegin;
+		this->mItEnd				= this->mItBegin;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::swap(this_type& other)
+	{
+		merkol::swap(this->mpMap, other.mpMap);
+		merkol::swap(this->mnMapSize, other.mnMapSize);
+		merkol::swap(this->mItBegin, other.mItBegin);
+		merkol::swap(this->mItEnd, other.mItEnd);
+		merkol::swap(this->mpSpareBlock, other.mpSpareBlock);
+		merkol::swap(this->mAllocator, other.mAllocator);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename Constructor>
+	void deque<T, Allocator, BlockSize>::doConstructSegments(iterator first, iterator last, Constructor& construct)
+	{
+		iterator current = first;
+
+		try
+		{
+			for (; current.mpNode != last.mpNode; current.setNode(current.mpNode + 1), current.mpCurrent = current.mpBegin)
+				construct(current.mpCurrent, current.mpEnd);
+			construct(current.mpCurrent, last.mpCurrent);
+		}
+		catch (...)
+		{
+			doDestroyRange(first, current);
+			throw;
+		}
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename Constructor>
+	void deque<T, Allocator, BlockSize>::doConstructBack(size_type n, Constructor& construct)
+	{
+		const size_type	blocks	= this->doReserveBack(n);
+		const iterator	newEnd	= this->mItEnd + (difference_type)n;
+
+		try
+		{
+			doConstructSegments(this->mItEnd, newEnd, construct);
+		}
+		catch (...)
+		{
+			this->doFreeBlocks(this->mItEnd.mpNode + 1, blocks);
+			throw;
+		}
+		this->mItEnd = newEnd;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename Constructor>
+	void deque<T, Allocator, BlockSize>::doConstructFront(size_type n, Constructor& construct)
+	{
+		const size_type	blocks		= this->doReserveFront(n);
+		const iterator	newBegin	= this->mItBegin - (difference_type)n;
+
+		try
+		{
+			doConstructSegments(newBegin, this->mItBegin, construct);
+		}
+		catch (...)
+		{
+			this->doFreeBlocks(this->mItBegin.mpNode - blocks, blocks);
+			throw;
+		}
+		this->mItBegin = newBegin;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void deque<T, Allocator, BlockSize>::doDestroyRange(iterator first, iterator last)
+	{
+		if (merkol::is_trivially_destructible<value_type>::value)
+			return;
+		for (; first.mpNode != last.mpNode; first.setNode(first.mpNode + 1), first.mpCurrent = first.mpBegin)
+			merkol::destruct(first.mpCurrent, first.mpEnd);
+		merkol::destruct(first.mpCurrent, last.mpCurrent);
+	}
+
+	// Destroys [begin(), newBegin) and frees the blocks before the one newBegin is in.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::doEraseBegin(iterator newBegin)
+	{
+		doDestroyRange(this->mItBegin, newBegin);
+		this->doFreeBlocks(this->mItBegin.mpNode, (size_type)(newBegin.mpNode - this->mItBegin.mpNode));
+		this->mItBegin = newBegin;
+	}
+
+	// Destroys [newEnd, end()) and frees the blocks after the one newEnd is in.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	void deque<T, Allocator, BlockSize>::doEraseEnd(iterator newEnd)
+	{
+		doDestroyRange(newEnd, this->mItEnd);
+		this->doFreeBlocks(newEnd.mpNode + 1, (size_type)(this->mItEnd.mpNode - newEnd.mpNode));
+		this->mItEnd = newEnd;
+	}
+
+	// Input iterators can only be walked once: push them one by one. If one throws, the elements
+	// pushed so far are removed again.
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename InputIterator>
+	void deque<T, Allocator, BlockSize>::doAppendRange(InputIterator first, InputIterator last, merkol::input_iterator_tag)
+	{
+		const size_type oldSize = size();
+
+		try
+		{
+			for (; first != last; ++first)
+				push_back(*first);
+		}
+		catch (...)
+		{
+			doEraseEnd(begin() + (difference_type)oldSize);
+			throw;
+		}
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename ForwardIterator>
+	void deque<T, Allocator, BlockSize>::doAppendRange(ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag)
+	{
+		copy_constructor<ForwardIterator> construct;
+
+		construct.source = first;
+		doConstructBack((size_type)merkol::distance(first, last), construct);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	template <typename ForwardIterator>
+	void deque<T, Allocator, BlockSize>::doPrependRange(ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag)
+	{
+		copy_constructor<ForwardIterator> construct;
+
+		construct.source = first;
+		doConstructFront((size_type)merkol::distance(first, last), construct);
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// Deque.imp.end();													///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline bool operator==(const deque<T, Allocator, BlockSize>& a, const deque<T, Allocator, BlockSize>& b)
+	{
+		return (a.size() == b.size()) && merkol::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline bool operator!=(const deque<T, Allocator, BlockSize>& a, const deque<T, Allocator, BlockSize>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline bool operator<(const deque<T, Allocator, BlockSize>& a, const deque<T, Allocator, BlockSize>& b)
+	{
+		return merkol::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline bool operator>(const deque<T, Allocator, BlockSize>& a, const deque<T, Allocator, BlockSize>& b)
+	{
+		return b < a;
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline bool operator<=(const deque<T, Allocator, BlockSize>& a, const deque<T, Allocator, BlockSize>& b)
+	{
+		return !(b < a);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline bool operator>=(const deque<T, Allocator, BlockSize>& a, const deque<T, Allocator, BlockSize>& b)
+	{
+		return !(a < b);
+	}
+
+	template <typename T, typename Allocator, std::size_t BlockSize>
+	inline void swap(deque<T, Allocator, BlockSize>& a, deque<T, Allocator, BlockSize>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+// Standard algorithms (std::rotate, std::sort...) see a std:: random access tag.
+namespace std
+{
+	template <typename T, std::size_t BlockSize>
+	struct iterator_traits<merkol::deque_iterator<T, BlockSize> >
+	{
+		typedef std::random_access_iterator_tag				iterator_category;
+		typedef typename merkol::remove_cv<T>::type			value_type;
+		typedef std::ptrdiff_t								difference_type;
+		typedef T*											pointer;
+		typedef T&											reference;
+	};
+} // namespace std
+
+#endif // MERKOL_DEQUE_HPP
@@ -0,0 +1,212 @@
+#ifndef MERKOL_FLAT_HASH_MAP_HPP
+# define MERKOL_FLAT_HASH_MAP_HPP
+
+#include <stdexcept>
+#include <utility>
+#if __cplusplus >= 201103L
+# include <tuple>
+#endif
+#include "flat_hash_table.hpp"
+
+namespace merkol
+{
+	/**
+	 * @brief flat_hash_map
+	 * Unordered map stored in a flat_hash_table (see flat_hash_table.hpp): the key/value pairs live in
+	 * the table's slot array, lookups probe 16 control bytes at a time.
+	 *
+	 * Unlike std::unordered_map, an insertion that grows the table moves the elements, so it invalidates
+	 * references as well as iterators.
+	 */
+	template <typename Key, typename T, typename Hash = merkol::hash<Key>, typename KeyEqual = merkol::equal_to<Key>,
+			  typename Allocator = std::allocator<std::pair<const Key, T> > >
+	class flat_hash_map
+		: public flat_hash_table<std::pair<const Key, T>, Key, merkol::use_first<std::pair<const Key, T> >, Hash, KeyEqual, Allocator, true>
+	{
+		typedef flat_hash_table<std::pair<const Key, T>, Key, merkol::use_first<std::pair<const Key, T> >,
+								Hash, KeyEqual, Allocator, true>							base_type;
+		typedef flat_hash_map<Key, T, Hash, KeyEqual, Allocator>							this_type;
+
+	public:
+		typedef T																		mapped_type;
+		typedef typename base_type::key_type											key_type;
+		typedef typename base_type::value_type											value_type;
+		typedef typename base_type::size_type											size_type;
+		typedef typename base_type::hasher												hasher;
+		typedef typename base_type::key_equal											key_equal;
+		typedef typename base_type::allocator_type										allocator_type;
+		typedef typename base_type::iterator											iterator;
+		typedef typename base_type::const_iterator										const_iterator;
+		typedef typename base_type::insert_return_type									insert_return_type;
+
+	public:
+		explicit flat_hash_map(size_type bucketCount = 0, const hasher& hash = hasher(),
+							   const key_equal& keyEqual = key_equal(), const allocator_type& allocator = allocator_type())
+			: base_type(bucketCount, hash, keyEqual, allocator) { }
+
+		template <typename InputIterator>
+		flat_hash_map(InputIterator first, InputIterator last, size_type bucketCount = 0, const hasher& hash = hasher(),
+					  const key_equal& keyEqual = key_equal(), const allocator_type& allocator = allocator_type())
+			: base_type(bucketCount, hash, keyEqual, allocator)
+		{
+			base_type::insert(first, last);
+		}
+
+		mapped_type&		operator[](const key_type& key);
+	#if __cplusplus >= 201103L
+		mapped_type&		operator[](key_type&& key);
+	#endif
+		mapped_type&		at(const key_type& key);
+		const mapped_type&	at(const key_type& key) const;
+
+	#if __cplusplus >= 201103L
+		template <typename... Args>
+		insert_return_type	try_emplace(const key_type& key, Args&&... args);
+
+		template <typename... Args>
+		insert_return_type	try_emplace(key_type&& key, Args&&... args);
+
+		template <typename M>
+		insert_return_type	insert_or_assign(const key_type& key, M&& value);
+	#endif
+	}; // flat_hash_map
+
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatHashMap.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	// The pair is only built when the key is new, and then without a temporary.
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::mapped_type&
+	flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::operator[](const key_type& key)
+	{
+	#if __cplusplus >= 201103L
+		return try_emplace(key).first->second;
+	#else
+		const typename base_type::insert_position position = this->doFindOrPrepareInsert(key);
+
+		if (!position.found)
+		{
+			::new(static_cast<void*>(this->mpSlots + position.index)) value_type(key, mapped_type());
+			this->doCommitInsert(position);
+		}
+		return this->mpSlots[position.index].second;
+	#endif
+	}
+
+#if __cplusplus >= 201103L
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::mapped_type&
+	flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::operator[](key_type&& key)
+	{
+		return try_emplace(std::move(key)).first->second;
+	}
+#endif
+
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::mapped_type&
+	flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::at(const key_type& key)
+	{
+		const iterator it = this->find(key);
+
+		if (it == this->end())
+			throw std::out_of_range("merkol::flat_hash_map::at -- key not found");
+		return it->second;
+	}
+
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	const typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::mapped_type&
+	flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::at(const key_type& key) const
+	{
+		const const_iterator it = this->find(key);
+
+		if (it == this->end())
+			throw std::out_of_range("merkol::flat_hash_map::at -- key not found");
+		return it->second;
+	}
+
+#if __cplusplus >= 201103L
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	template <typename... Args>
+	typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::insert_return_type
+	flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::try_emplace(const key_type& key, Args&&... args)
+	{
+		const typename base_type::insert_position position = this->doFindOrPrepareInsert(key);
+
+		if (!position.found)
+		{
+			::new(static_cast<void*>(this->mpSlots + position.index))
+				value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+			this->doCommitInsert(position);
+		}
+		return insert_return_type(this->doMakeIterator(position.index), !position.found);
+	}
+
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	template <typename... Args>
+	typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::insert_return_type
+	flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::try_emplace(key_type&& key, Args&&... args)
+	{
+		const typename base_type::insert_position position = this->doFindOrPrepareInsert(key);
+
+		if (!position.found)
+		{
+			::new(static_cast<void*>(this->mpSlots + position.index))
+				value_type(std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+			this->doCommitInsert(position);
+		}
+		return insert_return_type(this->doMakeIterator(position.index), !position.found);
+	}
+
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	template <typename M>
+	typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::insert_return_type
+	flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::insert_or_assign(const key_type& key, M&& value)
+	{
+		insert_return_type result = try_emplace(key, std::forward<M>(value));
+
+		if (!result.second)
+			result.first->second = std::forward<M>(value);
+		return result;
+	}
+#endif
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatHashMap.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+
+	// Equal if they hold the same keys mapped to equal values, in any order.
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	bool operator==(const flat_hash_map<Key, T, Hash, KeyEqual, Allocator>& a, const flat_hash_map<Key, T, Hash, KeyEqual, Allocator>& b)
+	{
+		typedef typename flat_hash_map<Key, T, Hash, KeyEqual, Allocator>::const_iterator const_iterator;
+
+		if (a.size() != b.size())
+			return false;
+		for (const_iterator it = a.begin(); it != a.end(); ++it)
+		{
+			const const_iterator other = b.find(it->first);
+
+			if ((other == b.end()) || !(other->second == it->second))
+				return false;
+		}
+		return true;
+	}
+
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	inline bool operator!=(const flat_hash_map<Key, T, Hash, KeyEqual, Allocator>& a, const flat_hash_map<Key, T, Hash, KeyEqual, Allocator>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename T, typename Hash, typename KeyEqual, typename Allocator>
+	inline void swap(flat_hash_map<Key, T, Hash, KeyEqual, Allocator>& a, flat_hash_map<Key, T, Hash, KeyEqual, Allocator>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_FLAT_HASH_MAP_HPP
@@ -0,0 +1,70 @@
+#ifndef MERKOL_FLAT_HASH_SET_HPP
+# define MERKOL_FLAT_HASH_SET_HPP
+
+#include "flat_hash_table.hpp"
+
+namespace merkol
+{
+	/**
+	 * @brief flat_hash_set
+	 * Unordered set stored in a flat_hash_table (see flat_hash_table.hpp). Elements can not be modified
+	 * through an iterator: both iterator types are constant.
+	 */
+	template <typename Key, typename Hash = merkol::hash<Key>, typename KeyEqual = merkol::equal_to<Key>,
+			  typename Allocator = std::allocator<Key> >
+	class flat_hash_set
+		: public flat_hash_table<Key, Key, merkol::use_self<Key>, Hash, KeyEqual, Allocator, false>
+	{
+		typedef flat_hash_table<Key, Key, merkol::use_self<Key>, Hash, KeyEqual, Allocator, false>	base_type;
+
+	public:
+		typedef typename base_type::size_type											size_type;
+		typedef typename base_type::hasher												hasher;
+		typedef typename base_type::key_equal											key_equal;
+		typedef typename base_type::allocator_type										allocator_type;
+
+	public:
+		explicit flat_hash_set(size_type bucketCount = 0, const hasher& hash = hasher(),
+							   const key_equal& keyEqual = key_equal(), const allocator_type& allocator = allocator_type())
+			: base_type(bucketCount, hash, keyEqual, allocator) { }
+
+		template <typename InputIterator>
+		flat_hash_set(InputIterator first, InputIterator last, size_type bucketCount = 0, const hasher& hash = hasher(),
+					  const key_equal& keyEqual = key_equal(), const allocator_type& allocator = allocator_type())
+			: base_type(bucketCount, hash, keyEqual, allocator)
+		{
+			base_type::insert(first, last);
+		}
+	}; // flat_hash_set
+
+
+	template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+	bool operator==(const flat_hash_set<Key, Hash, KeyEqual, Allocator>& a, const flat_hash_set<Key, Hash, KeyEqual, Allocator>& b)
+	{
+		typedef typename flat_hash_set<Key, Hash, KeyEqual, Allocator>::const_iterator const_iterator;
+
+		if (a.size() != b.size())
+			return false;
+		for (const_iterator it = a.begin(); it != a.end(); ++it)
+		{
+			if (!b.contains(*it))
+				return false;
+		}
+		return true;
+	}
+
+	template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+	inline bool operator!=(const flat_hash_set<Key, Hash, KeyEqual, Allocator>& a, const flat_hash_set<Key, Hash, KeyEqual, Allocator>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename Hash, typename KeyEqual, typename Allocator>
+	inline void swap(flat_hash_set<Key, Hash, KeyEqual, Allocator>& a, flat_hash_set<Key, Hash, KeyEqual, Allocator>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_FLAT_HASH_SET_HPP
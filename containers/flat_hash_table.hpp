@@ -0,0 +1,863 @@
+#ifndef MERKOL_FLAT_HASH_TABLE_HPP
+# define MERKOL_FLAT_HASH_TABLE_HPP
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstring>
+#include <cstddef>
+#include "../iterators/iterator.hpp"
+#include "../auxiliary/trace.hpp"
+#include "../aux_templates/algorithm.hpp"
+#include "../aux_templates/functional.hpp"
+#include "../aux_templates/simd.hpp"
+#include "../aux_templates/type_traits.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	flat_hash_table
+
+	Open addressing table shared by flat_hash_map and flat_hash_set, laid out like Abseil's Swiss table.
+	Values live directly in one array of slots (no node per element), next to an array of one control
+	byte per slot:
+
+		empty		-128	never used since the last rehash: a probe for a key stops here
+		deleted		-2		erased (tombstone): a probe goes on, an insertion may reuse it
+		sentinel	-1		after the last slot, stops iteration
+		full		0..127	the low 7 bits of the element's hash (h2)
+
+	A lookup hashes the key once (through hash_mix, see functional.hpp), starts at slot (hash >> 7) and
+	compares 16 control bytes against h2 with one SSE2 compare (simd::group_match_eq). Only the slots
+	whose byte matches, about one in 128 of the others, are compared with the key. A group with an empty
+	byte ends the search. Groups are probed quadratically (+16, +32, +48... slots), which visits every
+	group of the table because the capacity is 2^k - 1.
+
+	The first 15 control bytes are mirrored after the sentinel, so a group read starting near the end
+	wraps around without a bounds check. An empty table points at a static group holding a sentinel and
+	empty bytes: it allocates nothing and lookups need no special case.
+
+	The table grows to 2 * capacity + 1 when inserting would fill more than 7/8 of the slots, or is
+	rebuilt at the same capacity when most of that space is taken by tombstones. Erasing only leaves a
+	tombstone when the slot is inside a run of 16 full-or-deleted bytes a probe may have walked over.
+
+	Slots are allocated with Allocator, control bytes with Allocator rebound to signed char.
+	Iterators and references are invalidated by a rehash, i.e. by any insertion that grows the table.
+*/
+
+namespace merkol
+{
+	/// flat_hash_ctrl
+	///
+	/// Control byte values and the empty group, see the comment at the top of the file.
+	struct flat_hash_ctrl
+	{
+		enum
+		{
+			kEmpty		= -128,
+			kDeleted	= -2,
+			kSentinel	= -1
+		};
+
+		static const std::size_t kGroupWidth = 16;
+
+		static const signed char* empty_group()
+		{
+			static const signed char group[kGroupWidth] =
+			{
+				kSentinel, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty,
+				kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty, kEmpty
+			};
+			return group;
+		}
+
+		// Number of leading bytes of the group at ctrl that are empty or deleted.
+		static std::size_t count_leading_empty_or_deleted(const signed char* ctrl)
+		{
+			return (std::size_t)__builtin_ctz(~simd::group_match_lt(ctrl, kSentinel));
+		}
+	};
+
+
+	/// flat_hash_iterator
+	///
+	/// Forward iterator over the full slots. T is const qualified for const iterators.
+	template <typename T>
+	class flat_hash_iterator
+	{
+		template <typename> friend class flat_hash_iterator;
+
+	public:
+		typedef flat_hash_iterator<T>					this_type;
+		typedef T										value_type;
+		typedef T*										pointer;
+		typedef T&										reference;
+		typedef std::ptrdiff_t							difference_type;
+		typedef merkol::forward_iterator_tag			iterator_category;
+		typedef flat_hash_iterator<const T>				const_iterator;
+
+		flat_hash_iterator() : mpCtrl(NULL), mpSlot(NULL) { }
+		flat_hash_iterator(const signed char* ctrl, pointer slot) : mpCtrl(ctrl), mpSlot(slot) { }
+
+		// convertion to const
+		operator const_iterator() const
+		{
+			return (const_iterator(mpCtrl, mpSlot));
+		}
+
+		pointer				base() const { return mpSlot; }
+		const signed char*	ctrl() const { return mpCtrl; }
+
+		reference	operator*() const { return *mpSlot; }
+		pointer		operator->() const { return mpSlot; }
+
+		flat_hash_iterator& operator++()
+		{
+			++mpCtrl;
+			++mpSlot;
+			skip_empty_or_deleted();
+			return *this;
+		}
+
+		flat_hash_iterator operator++(int)
+		{
+			flat_hash_iterator temp(*this);
+			++(*this);
+			return temp;
+		}
+
+		// Moves forward to the first full slot or the sentinel, a group at a time.
+		void skip_empty_or_deleted()
+		{
+			while (*mpCtrl < flat_hash_ctrl::kSentinel)
+			{
+				const std::size_t shift = flat_hash_ctrl::count_leading_empty_or_deleted(mpCtrl);
+
+				mpCtrl += shift;
+				mpSlot += shift;
+			}
+		}
+
+	private:
+		const signed char*	mpCtrl;
+		pointer				mpSlot;
+	};
+
+	template <typename T1, typename T2>
+	inline bool operator==(const flat_hash_iterator<T1>& lhs, const flat_hash_iterator<T2>& rhs)
+	{
+		return (lhs.ctrl() == rhs.ctrl());
+	}
+
+	template <typename T1, typename T2>
+	inline bool operator!=(const flat_hash_iterator<T1>& lhs, const flat_hash_iterator<T2>& rhs)
+	{
+		return (lhs.ctrl() != rhs.ctrl());
+	}
+
+
+	/**
+	 * @brief flat_hash_table
+	 * Storage and lookup of flat_hash_map and flat_hash_set.
+	 *
+	 * @tparam Value stored type
+	 * @tparam Key key type
+	 * @tparam ExtractKey function object returning the key of a Value (use_self, use_first)
+	 * @tparam Hash hash function object
+	 * @tparam KeyEqual key comparison function object
+	 * @tparam Allocator allocator of Value
+	 * @tparam MutableIterators false for sets, whose elements can not be modified in place
+	 */
+	template <typename Value, typename Key, typename ExtractKey, typename Hash, typename KeyEqual, typename Allocator, bool MutableIterators>
+	class flat_hash_table
+	{
+		typedef flat_hash_table<Value, Key, ExtractKey, Hash, KeyEqual, Allocator, MutableIterators>	this_type;
+		typedef typename Allocator::template rebind<signed char>::other								ctrl_allocator_type;
+
+	public:
+		typedef Key																		key_type;
+		typedef Value																	value_type;
+		typedef Hash																	hasher;
+		typedef KeyEqual																key_equal;
+		typedef Allocator																allocator_type;
+		typedef Value&																	reference;
+		typedef const Value&															const_reference;
+		typedef Value*																	pointer;
+		typedef const Value*															const_pointer;
+		typedef std::size_t																size_type;
+		typedef std::ptrdiff_t															difference_type;
+		typedef typename merkol::conditional<MutableIterators, flat_hash_iterator<Value>,
+											 flat_hash_iterator<const Value> >::type	iterator;
+		typedef flat_hash_iterator<const Value>											const_iterator;
+		typedef std::pair<iterator, bool>												insert_return_type;
+
+		static const size_type kGroupWidth	= flat_hash_ctrl::kGroupWidth;
+		static const size_type kMinCapacity	= 15;
+
+	protected:
+		signed char*	mpCtrl;			// mnCapacity + kGroupWidth bytes, or the static empty group
+		Value*			mpSlots;		// mnCapacity slots
+		size_type		mnCapacity;		// 0 or 2^k - 1
+		size_type		mnSize;
+		size_type		mnGrowthLeft;	// insertions into empty slots left before a rehash
+		hasher			mHash;
+		key_equal		mKeyEqual;
+		allocator_type	mAllocator;
+
+		// Where an insertion goes: the slot holding the key if found, otherwise the slot to construct the
+		// new element in and the hash to commit with doCommitInsert() once it is constructed.
+		struct insert_position
+		{
+			size_type	index;
+			size_type	hash;
+			bool		found;
+		};
+
+	public:
+		explicit flat_hash_table(size_type bucketCount = 0, const hasher& hash = hasher(),
+								 const key_equal& keyEqual = key_equal(), const allocator_type& allocator = allocator_type());
+		flat_hash_table(const this_type& other);
+	#if __cplusplus >= 201103L
+		flat_hash_table(this_type&& other);
+	#endif
+		~flat_hash_table();
+
+		this_type&	operator=(const this_type& other);
+	#if __cplusplus >= 201103L
+		this_type&	operator=(this_type&& other);
+	#endif
+
+		// Iterators
+		iterator		begin() M_NOEXCEPT;
+		const_iterator	begin() const M_NOEXCEPT;
+		const_iterator	cbegin() const M_NOEXCEPT { return begin(); }
+		iterator		end() M_NOEXCEPT { return doMakeIterator(mnCapacity); }
+		const_iterator	end() const M_NOEXCEPT { return doMakeIterator(mnCapacity); }
+		const_iterator	cend() const M_NOEXCEPT { return end(); }
+
+		// Capacity
+		bool		empty() const M_NOEXCEPT { return mnSize == 0; }
+		size_type	size() const M_NOEXCEPT { return mnSize; }
+		size_type	max_size() const M_NOEXCEPT { return mAllocator.max_size() / 2; }
+		size_type	capacity() const M_NOEXCEPT { return mnCapacity; }
+		size_type	bucket_count() const M_NOEXCEPT { return mnCapacity; }
+		float		load_factor() const M_NOEXCEPT { return mnCapacity ? (float)mnSize / (float)mnCapacity : 0.0f; }
+		float		max_load_factor() const M_NOEXCEPT { return 0.875f; }
+		void		reserve(size_type n);
+		void		rehash(size_type bucketCount);
+
+		// Lookup
+		iterator		find(const key_type& key);
+		const_iterator	find(const key_type& key) const;
+		size_type		count(const key_type& key) const { return (doFind(key, doHash(key)) != mnCapacity) ? 1 : 0; }
+		bool			contains(const key_type& key) const { return doFind(key, doHash(key)) != mnCapacity; }
+
+		// Modifiers
+		insert_return_type	insert(const value_type& value);
+	#if __cplusplus >= 201103L
+		insert_return_type	insert(value_type&& value);
+
+		template <typename... Args>
+		insert_return_type	emplace(Args&&... args);
+	#endif
+
+		template <typename InputIterator>
+		void		insert(InputIterator first, InputIterator last);
+
+		iterator	erase(const_iterator pos);
+		iterator	erase(const_iterator first, const_iterator last);
+		size_type	erase(const key_type& key);
+		void		clear() M_NOEXCEPT;
+		void		swap(this_type& other);
+
+		// Observers
+		hasher			hash_function() const { return mHash; }
+		key_equal		key_eq() const { return mKeyEqual; }
+		allocator_type	get_allocator() const { return mAllocator; }
+
+	protected:
+		static size_type	doH2(size_type hash) { return hash & 0x7F; }
+		static size_type	doGrowth(size_type capacity) { return capacity - capacity / 8; }
+		static size_type	doCapacityFor(size_type n);
+		static size_type	doFindFirstNonFull(const signed char* ctrl, size_type capacity, size_type hash);
+		static void			doSetCtrl(signed char* ctrl, size_type capacity, size_type i, signed char h);
+
+		size_type			doHash(const key_type& key) const { return merkol::hash_mix(mHash(key)); }
+		size_type			doFind(const key_type& key, size_type hash) const;
+		insert_position		doFindOrPrepareInsert(const key_type& key);
+		void				doCommitInsert(const insert_position& position);
+		void				doEraseAt(size_type i);
+		void				doResize(size_type newCapacity);
+		void				doAllocate(size_type capacity);
+		void				doDeallocate();
+		void				doDestroySlots();
+
+		template <typename Arg>
+		insert_return_type	doInsertValue(MERKOL_FORWARD_REF(Arg) value);
+
+		iterator			doMakeIterator(size_type i) { return iterator(mpCtrl + i, mpSlots + i); }
+		const_iterator		doMakeIterator(size_type i) const { return const_iterator(mpCtrl + i, mpSlots + i); }
+	}; // flat_hash_table
+
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatHashTable.imp.begin();										///
+	///////////////////////////////////////////////////////////////////////
+
+# define MERKOL_FLAT_HASH_TABLE_TEMPLATE \
+	template <typename Value, typename Key, typename ExtractKey, typename Hash, typename KeyEqual, typename Allocator, bool MutableIterators>
+# define MERKOL_FLAT_HASH_TABLE flat_hash_table<Value, Key, ExtractKey, Hash, KeyEqual, Allocator, MutableIterators>
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	MERKOL_FLAT_HASH_TABLE::flat_hash_table(size_type bucketCount, const hasher& hash, const key_equal& keyEqual, const allocator_type& allocator)
+		: mpCtrl(const_cast<signed char*>(flat_hash_ctrl::empty_group())),
+		  mpSlots(NULL),
+		  mnCapacity(0),
+		  mnSize(0),
+		  mnGrowthLeft(0),
+		  mHash(hash),
+		  mKeyEqual(keyEqual),
+		  mAllocator(allocator)
+	{
+		if (bucketCount)
+			doResize(doCapacityFor(bucketCount));
+		MERKOL_TRACE(this, "flat_hash_table::constructor", 0, mnCapacity);
+	}
+
+	// Same capacity, so the control bytes are copied as they are and no element is hashed again.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	MERKOL_FLAT_HASH_TABLE::flat_hash_table(const this_type& other)
+		: mpCtrl(const_cast<signed char*>(flat_hash_ctrl::empty_group())),
+		  mpSlots(NULL),
+		  mnCapacity(0),
+		  mnSize(0),
+		  mnGrowthLeft(0),
+		  mHash(other.mHash),
+		  mKeyEqual(other.mKeyEqual),
+		  mAllocator(other.mAllocator)
+	{
+		if (other.mnSize == 0)
+			return;
+		doAllocate(other.mnCapacity);
+
+		size_type i = 0;
+		try
+		{
+			for (; i < mnCapacity; ++i)
+			{
+				if (other.mpCtrl[i] >= 0)
+					::new(static_cast<void*>(mpSlots + i)) value_type(other.mpSlots[i]);
+			}
+		}
+		catch (...)
+		{
+			while (i--)
+			{
+				if (other.mpCtrl[i] >= 0)
+					mpSlots[i].~value_type();
+			}
+			doDeallocate();
+			throw;
+		}
+		std::memcpy(mpCtrl, other.mpCtrl, mnCapacity + kGroupWidth);
+		mnSize			= other.mnSize;
+		mnGrowthLeft	= other.mnGrowthLeft;
+		MERKOL_TRACE(this, "flat_hash_table::copy_constructor", mnSize, mnCapacity);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	MERKOL_FLAT_HASH_TABLE::flat_hash_table(this_type&& other)
+		: mpCtrl(const_cast<signed char*>(flat_hash_ctrl::empty_group())),
+		  mpSlots(NULL),
+		  mnCapacity(0),
+		  mnSize(0),
+		  mnGrowthLeft(0),
+		  mHash(other.mHash),
+		  mKeyEqual(other.mKeyEqual),
+		  mAllocator(other.mAllocator)
+	{
+		swap(other);
+	}
+#endif
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	MERKOL_FLAT_HASH_TABLE::~flat_hash_table()
+	{
+		MERKOL_TRACE(this, "flat_hash_table::destructor", mnSize, mnCapacity);
+		doDestroySlots();
+		doDeallocate();
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::this_type&
+	MERKOL_FLAT_HASH_TABLE::operator=(const this_type& other)
+	{
+		if (this != &other)
+		{
+			this_type temp(other);
+			swap(temp);
+		}
+		return *this;
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::this_type&
+	MERKOL_FLAT_HASH_TABLE::operator=(this_type&& other)
+	{
+		if (this != &other)
+		{
+			this_type temp(std::move(other));
+			swap(temp);
+		}
+		return *this;
+	}
+#endif
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::iterator
+	MERKOL_FLAT_HASH_TABLE::begin() M_NOEXCEPT
+	{
+		iterator it = doMakeIterator(0);
+
+		it.skip_empty_or_deleted();
+		return it;
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::const_iterator
+	MERKOL_FLAT_HASH_TABLE::begin() const M_NOEXCEPT
+	{
+		const_iterator it = doMakeIterator(0);
+
+		it.skip_empty_or_deleted();
+		return it;
+	}
+
+	// Makes room for n elements without a rehash.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::reserve(size_type n)
+	{
+		if (n > mnSize + mnGrowthLeft)
+			doResize(doCapacityFor(n));
+	}
+
+	// Rebuilds the table with at least bucketCount slots (and room for size() elements), which also
+	// drops the tombstones. rehash(0) on an empty table releases its memory.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::rehash(size_type bucketCount)
+	{
+		if ((bucketCount == 0) && (mnSize == 0))
+		{
+			doDeallocate();
+			return;
+		}
+
+		size_type newCapacity = doCapacityFor(mnSize);
+
+		while (newCapacity < bucketCount)
+			newCapacity = newCapacity * 2 + 1;
+		doResize(newCapacity);
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline typename MERKOL_FLAT_HASH_TABLE::iterator
+	MERKOL_FLAT_HASH_TABLE::find(const key_type& key)
+	{
+		return doMakeIterator(doFind(key, doHash(key)));
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline typename MERKOL_FLAT_HASH_TABLE::const_iterator
+	MERKOL_FLAT_HASH_TABLE::find(const key_type& key) const
+	{
+		return doMakeIterator(doFind(key, doHash(key)));
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline typename MERKOL_FLAT_HASH_TABLE::insert_return_type
+	MERKOL_FLAT_HASH_TABLE::insert(const value_type& value)
+	{
+		return doInsertValue(value);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline typename MERKOL_FLAT_HASH_TABLE::insert_return_type
+	MERKOL_FLAT_HASH_TABLE::insert(value_type&& value)
+	{
+		return doInsertValue(std::move(value));
+	}
+
+	// The key is only known once the value is built: build it aside, then move it into its slot if the
+	// key is new.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	template <typename... Args>
+	typename MERKOL_FLAT_HASH_TABLE::insert_return_type
+	MERKOL_FLAT_HASH_TABLE::emplace(Args&&... args)
+	{
+		merkol::aligned_buffer<value_type>	buffer;
+		value_type* const					value = ::new(static_cast<void*>(buffer.mBuffer)) value_type(std::forward<Args>(args)...);
+
+		try
+		{
+			const insert_return_type result = doInsertValue(std::move(*value));
+
+			value->~value_type();
+			return result;
+		}
+		catch (...)
+		{
+			value->~value_type();
+			throw;
+		}
+	}
+#endif
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	template <typename InputIterator>
+	void MERKOL_FLAT_HASH_TABLE::insert(InputIterator first, InputIterator last)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
+	// Returns the iterator following pos. Erasing never rehashes, so other iterators stay valid.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::iterator
+	MERKOL_FLAT_HASH_TABLE::erase(const_iterator pos)
+	{
+		const size_type i = (size_type)(pos.ctrl() - mpCtrl);
+		iterator		next = doMakeIterator(i);
+
+		doEraseAt(i);
+		next.skip_empty_or_deleted();
+		return next;
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::iterator
+	MERKOL_FLAT_HASH_TABLE::erase(const_iterator first, const_iterator last)
+	{
+		while (first != last)
+			first = erase(first);
+		return doMakeIterator((size_type)(last.ctrl() - mpCtrl));
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::size_type
+	MERKOL_FLAT_HASH_TABLE::erase(const key_type& key)
+	{
+		const size_type i = doFind(key, doHash(key));
+
+		if (i == mnCapacity)
+			return 0;
+		doEraseAt(i);
+		return 1;
+	}
+
+	// Keeps the capacity, like vector::clear().
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::clear() M_NOEXCEPT
+	{
+		if (mnCapacity == 0)
+			return;
+		doDestroySlots();
+		std::memset(mpCtrl, flat_hash_ctrl::kEmpty, mnCapacity + kGroupWidth);
+		mpCtrl[mnCapacity]	= flat_hash_ctrl::kSentinel;
+		mnSize				= 0;
+		mnGrowthLeft		= doGrowth(mnCapacity);
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::swap(this_type& other)
+	{
+		merkol::swap(mpCtrl, other.mpCtrl);
+		merkol::swap(mpSlots, other.mpSlots);
+		merkol::swap(mnCapacity, other.mnCapacity);
+		merkol::swap(mnSize, other.mnSize);
+		merkol::swap(mnGrowthLeft, other.mnGrowthLeft);
+		merkol::swap(mHash, other.mHash);
+		merkol::swap(mKeyEqual, other.mKeyEqual);
+		merkol::swap(mAllocator, other.mAllocator);
+	}
+
+	// Smallest capacity (2^k - 1, at least kMinCapacity) that holds n elements below the maximum load.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::size_type
+	MERKOL_FLAT_HASH_TABLE::doCapacityFor(size_type n)
+	{
+		size_type capacity = kMinCapacity;
+
+		while (doGrowth(capacity) < n)
+			capacity = capacity * 2 + 1;
+		return capacity;
+	}
+
+	// First empty or deleted slot on the probe sequence of hash. There always is one: the load is kept
+	// below 7/8.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline typename MERKOL_FLAT_HASH_TABLE::size_type
+	MERKOL_FLAT_HASH_TABLE::doFindFirstNonFull(const signed char* ctrl, size_type capacity, size_type hash)
+	{
+		size_type pos	= (hash >> 7) & capacity;
+		size_type step	= 0;
+
+		for (;;)
+		{
+			const unsigned mask = simd::group_match_lt(ctrl + pos, flat_hash_ctrl::kSentinel);
+
+			if (mask)
+				return (pos + (size_type)__builtin_ctz(mask)) & capacity;
+			step += kGroupWidth;
+			pos = (pos + step) & capacity;
+		}
+	}
+
+	// Sets control byte i and its mirror after the sentinel (for i < kGroupWidth - 1; otherwise the
+	// second store writes byte i again).
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline void MERKOL_FLAT_HASH_TABLE::doSetCtrl(signed char* ctrl, size_type capacity, size_type i, signed char h)
+	{
+		ctrl[i] = h;
+		ctrl[((i - (kGroupWidth - 1)) & capacity) + (kGroupWidth - 1)] = h;
+	}
+
+	// Index of the slot holding key, or mnCapacity.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline typename MERKOL_FLAT_HASH_TABLE::size_type
+	MERKOL_FLAT_HASH_TABLE::doFind(const key_type& key, size_type hash) const
+	{
+		const signed char	h2		= (signed char)doH2(hash);
+		size_type			pos		= (hash >> 7) & mnCapacity;
+		size_type			step	= 0;
+
+		for (;;)
+		{
+			const signed char* const group = mpCtrl + pos;
+
+			for (unsigned mask = simd::group_match_eq(group, h2); mask; mask &= mask - 1)
+			{
+				const size_type i = (pos + (size_type)__builtin_ctz(mask)) & mnCapacity;
+
+				if (mKeyEqual(ExtractKey()(mpSlots[i]), key))
+					return i;
+			}
+			if (simd::group_match_eq(group, flat_hash_ctrl::kEmpty))
+				return mnCapacity;
+			step += kGroupWidth;
+			pos = (pos + step) & mnCapacity;
+		}
+	}
+
+	// Finds key, or the slot a new element with that key goes to, rehashing first if the table is full.
+	// Nothing is modified but the capacity: the caller constructs the element in mpSlots[index] and
+	// then calls doCommitInsert(), so a throwing constructor leaves the table as it was.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	typename MERKOL_FLAT_HASH_TABLE::insert_position
+	MERKOL_FLAT_HASH_TABLE::doFindOrPrepareInsert(const key_type& key)
+	{
+		insert_position position;
+
+		position.hash	= doHash(key);
+		position.index	= doFind(key, position.hash);
+		position.found	= (position.index != mnCapacity);
+		if (position.found)
+			return position;
+
+		position.index = doFindFirstNonFull(mpCtrl, mnCapacity, position.hash);
+		if ((mnGrowthLeft == 0) && (mpCtrl[position.index] != flat_hash_ctrl::kDeleted))
+		{
+			// Mostly tombstones: rebuild at the same size. Otherwise grow.
+			if ((mnCapacity > kGroupWidth) && (mnSize * 32 <= mnCapacity * 25))
+				doResize(mnCapacity);
+			else
+				doResize(mnCapacity ? mnCapacity * 2 + 1 : kMinCapacity);
+			position.index = doFindFirstNonFull(mpCtrl, mnCapacity, position.hash);
+		}
+		return position;
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline void MERKOL_FLAT_HASH_TABLE::doCommitInsert(const insert_position& position)
+	{
+		if (mpCtrl[position.index] == flat_hash_ctrl::kEmpty)
+			--mnGrowthLeft;
+		doSetCtrl(mpCtrl, mnCapacity, position.index, (signed char)doH2(position.hash));
+		++mnSize;
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	template <typename Arg>
+	inline typename MERKOL_FLAT_HASH_TABLE::insert_return_type
+	MERKOL_FLAT_HASH_TABLE::doInsertValue(MERKOL_FORWARD_REF(Arg) value)
+	{
+		const insert_position position = doFindOrPrepareInsert(ExtractKey()(value));
+
+		if (!position.found)
+		{
+			::new(static_cast<void*>(mpSlots + position.index)) value_type(MERKOL_FORWARD(Arg, value));
+			doCommitInsert(position);
+		}
+		return insert_return_type(doMakeIterator(position.index), !position.found);
+	}
+
+	// The slot becomes empty again if no probe can have gone past it: that is the case when the 16 bytes
+	// around it already contain an empty one closer than a group width. Otherwise it is a tombstone.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::doEraseAt(size_type i)
+	{
+		const size_type	before		= (i - kGroupWidth) & mnCapacity;
+		const unsigned	emptyBefore	= simd::group_match_eq(mpCtrl + before, flat_hash_ctrl::kEmpty);
+		const unsigned	emptyAfter	= simd::group_match_eq(mpCtrl + i, flat_hash_ctrl::kEmpty);
+		const bool		wasNeverFull = emptyBefore && emptyAfter &&
+									   ((size_type)(__builtin_clz(emptyBefore) - 16) + (size_type)__builtin_ctz(emptyAfter) < kGroupWidth);
+
+		mpSlots[i].~value_type();
+		doSetCtrl(mpCtrl, mnCapacity, i, wasNeverFull ? flat_hash_ctrl::kEmpty : flat_hash_ctrl::kDeleted);
+		if (wasNeverFull)
+			++mnGrowthLeft;
+		--mnSize;
+	}
+
+	// Moves every element into new arrays of newCapacity slots. Elements are relocated with memcpy when
+	// they are trivially relocatable, otherwise moved (or copied when the move could throw, see
+	// uninitialized_move_if_noexcept) and the old ones destroyed at the end, so a throw leaves the
+	// table untouched.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::doResize(size_type newCapacity)
+	{
+		typedef merkol::is_trivially_relocatable<value_type> relocatable;
+
+		signed char* const	oldCtrl			= mpCtrl;
+		Value* const		oldSlots		= mpSlots;
+		const size_type		oldCapacity		= mnCapacity;
+		const size_type		oldGrowthLeft	= mnGrowthLeft;
+		const size_type		size			= mnSize;
+
+		mpCtrl		= const_cast<signed char*>(flat_hash_ctrl::empty_group());
+		mpSlots		= NULL;
+		mnCapacity	= 0;
+		try
+		{
+			doAllocate(newCapacity);
+		}
+		catch (...)
+		{
+			mpCtrl		= oldCtrl;
+			mpSlots		= oldSlots;
+			mnCapacity	= oldCapacity;
+			throw;
+		}
+
+		size_type i = 0;
+		try
+		{
+			for (; i < oldCapacity; ++i)
+			{
+				if (oldCtrl[i] < 0)
+					continue;
+
+				const size_type hash	= doHash(ExtractKey()(oldSlots[i]));
+				const size_type j		= doFindFirstNonFull(mpCtrl, mnCapacity, hash);
+
+				if (relocatable::value)
+					std::memcpy(static_cast<void*>(mpSlots + j), static_cast<const void*>(oldSlots + i), sizeof(value_type));
+				else
+					merkol::uninitialized_move_if_noexcept(oldSlots + i, oldSlots + i + 1, mpSlots + j);
+				doSetCtrl(mpCtrl, mnCapacity, j, (signed char)doH2(hash));
+			}
+		}
+		catch (...)
+		{
+			if (!relocatable::value)
+				doDestroySlots();
+			doDeallocate();
+			mpCtrl			= oldCtrl;
+			mpSlots			= oldSlots;
+			mnCapacity		= oldCapacity;
+			mnSize			= size;
+			mnGrowthLeft	= oldGrowthLeft;
+			throw;
+		}
+		MERKOL_TRACE(this, "flat_hash_table::rehash", size, newCapacity);
+		mnSize			= size;
+		mnGrowthLeft	= doGrowth(mnCapacity) - size;
+
+		if (!relocatable::value)
+		{
+			for (i = 0; i < oldCapacity; ++i)
+			{
+				if (oldCtrl[i] >= 0)
+					oldSlots[i].~value_type();
+			}
+		}
+		if (oldCapacity)
+		{
+			mAllocator.deallocate(oldSlots, oldCapacity);
+			ctrl_allocator_type(mAllocator).deallocate(oldCtrl, oldCapacity + kGroupWidth);
+		}
+	}
+
+	// Allocates empty arrays of capacity slots. The table must not own any before.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::doAllocate(size_type capacity)
+	{
+		ctrl_allocator_type	ctrlAllocator(mAllocator);
+		signed char* const	ctrl = ctrlAllocator.allocate(capacity + kGroupWidth);
+
+		try
+		{
+			mpSlots = mAllocator.allocate(capacity);
+		}
+		catch (...)
+		{
+			ctrlAllocator.deallocate(ctrl, capacity + kGroupWidth);
+			throw;
+		}
+		std::memset(ctrl, flat_hash_ctrl::kEmpty, capacity + kGroupWidth);
+		ctrl[capacity]	= flat_hash_ctrl::kSentinel;
+		mpCtrl			= ctrl;
+		mnCapacity		= capacity;
+		mnSize			= 0;
+		mnGrowthLeft	= doGrowth(capacity);
+	}
+
+	// Frees the arrays (the elements must be destroyed) and goes back to the static empty group.
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	void MERKOL_FLAT_HASH_TABLE::doDeallocate()
+	{
+		if (mnCapacity)
+		{
+			mAllocator.deallocate(mpSlots, mnCapacity);
+			ctrl_allocator_type(mAllocator).deallocate(mpCtrl, mnCapacity + kGroupWidth);
+		}
+		mpCtrl			= const_cast<signed char*>(flat_hash_ctrl::empty_group());
+		mpSlots			= NULL;
+		mnCapacity		= 0;
+		mnSize			= 0;
+		mnGrowthLeft	= 0;
+	}
+
+	MERKOL_FLAT_HASH_TABLE_TEMPLATE
+	inline void MERKOL_FLAT_HASH_TABLE::doDestroySlots()
+	{
+		if (merkol::is_trivially_destructible<value_type>::value)
+			return;
+		for (size_type i = 0; i < mnCapacity; ++i)
+		{
+			if (mpCtrl[i] >= 0)
+				mpSlots[i].~value_type();
+		}
+	}
+
+# undef MERKOL_FLAT_HASH_TABLE_TEMPLATE
+# undef MERKOL_FLAT_HASH_TABLE
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatHashTable.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+} // namespace merkol
+
+#endif // MERKOL_FLAT_HASH_TABLE_HPP
@@ -0,0 +1,585 @@
+#ifndef MERKOL_FLAT_MAP_HPP
+# define MERKOL_FLAT_MAP_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "vector.hpp"
+#include "../iterators/iterator.hpp"
+#include "../iterators/reverse_iterator.hpp"
+#include "../aux_templates/algorithm.hpp"
+#include "../aux_templates/functional.hpp"
+
+/*
+	flat_map
+
+	Ordered map stored as two sorted vectors: the keys in one, the mapped values in the other, at the
+	same index. A lookup is a binary search over the key vector only, which is contiguous and holds
+	nothing but keys, so its top levels stay in cache and a lookup touches about log2(n) / 2 cache lines
+	less than a search through tree nodes. There is no per element allocation and no per element
+	overhead (std::map needs 32 bytes of node header per entry on 64 bit targets).
+
+	The price is insertion and erasure in the middle, which shift the elements after the position: O(n).
+	flat_map is meant for tables built once and read many times: insert(first, last) sorts the new
+	entries once and merges them with the existing ones in a single pass, O(n + m log m), instead of m
+	separate insertions.
+
+	Like std::flat_map, an iterator dereferences to a pair of references (flat_map_reference) rather than
+	to a stored std::pair, and every insertion or erasure invalidates iterators and references. The key
+	and value containers must be contiguous (merkol::vector, std::vector).
+*/
+
+namespace merkol
+{
+	/// flat_map_reference
+	///
+	/// What a flat_map iterator points to: references to a key and to its mapped value.
+	template <typename Key, typename T>
+	struct flat_map_reference
+	{
+		const Key&	first;
+		T&			second;
+
+		flat_map_reference(const Key& key, T& value) : first(key), second(value) { }
+
+		operator std::pair<Key, typename merkol::remove_const<T>::type>() const
+		{
+			return std::pair<Key, typename merkol::remove_const<T>::type>(first, second);
+		}
+	};
+
+
+	/// flat_map_iterator
+	///
+	/// Random access iterator walking the key and value arrays in step. T is const qualified for const
+	/// iterators. operator-> returns a proxy holding the flat_map_reference.
+	template <typename Key, typename T>
+	class flat_map_iterator
+	{
+		template <typename, typename> friend class flat_map_iterator;
+
+	public:
+		typedef flat_map_iterator<Key, T>							this_type;
+		typedef std::pair<Key, typename merkol::remove_const<T>::type>	value_type;
+		typedef flat_map_reference<Key, T>							reference;
+		typedef std::ptrdiff_t										difference_type;
+		typedef merkol::random_access_iterator_tag					iterator_category;
+		typedef flat_map_iterator<Key, const T>						const_iterator;
+
+		struct pointer
+		{
+			reference ref;
+
+			explicit pointer(const reference& r) : ref(r) { }
+			const reference* operator->() const { return &ref; }
+		};
+
+		flat_map_iterator() : mpKey(NULL), mpValue(NULL) { }
+		flat_map_iterator(const Key* key, T* value) : mpKey(key), mpValue(value) { }
+
+		// convertion to const
+		operator const_iterator() const
+		{
+			return (const_iterator(mpKey, mpValue));
+		}
+
+		const Key*	key_base() const { return mpKey; }
+		T*			value_base() const { return mpValue; }
+
+		reference	operator*() const { return reference(*mpKey, *mpValue); }
+		pointer		operator->() const { return pointer(**this); }
+		reference	operator[](difference_type n) const { return reference(mpKey[n], mpValue[n]); }
+
+		flat_map_iterator&	operator++() { ++mpKey; ++mpValue; return *this; }
+		flat_map_iterator&	operator--() { --mpKey; --mpValue; return *this; }
+		flat_map_iterator	operator++(int) { flat_map_iterator temp(*this); ++(*this); return temp; }
+		flat_map_iterator	operator--(int) { flat_map_iterator temp(*this); --(*this); return temp; }
+
+		flat_map_iterator&	operator+=(difference_type n) { mpKey += n; mpValue += n; return *this; }
+		flat_map_iterator&	operator-=(difference_type n) { mpKey -= n; mpValue -= n; return *this; }
+		flat_map_iterator	operator+(difference_type n) const { return flat_map_iterator(mpKey + n, mpValue + n); }
+		flat_map_iterator	operator-(difference_type n) const { return flat_map_iterator(mpKey - n, mpValue - n); }
+
+	private:
+		const Key*	mpKey;
+		T*			mpValue;
+	};
+
+	template <typename Key, typename T1, typename T2>
+	inline bool operator==(const flat_map_iterator<Key, T1>& lhs, const flat_map_iterator<Key, T2>& rhs)
+	{
+		return (lhs.key_base() == rhs.key_base());
+	}
+
+	template <typename Key, typename T1, typename T2>
+	inline bool operator!=(const flat_map_iterator<Key, T1>& lhs, const flat_map_iterator<Key, T2>& rhs)
+	{
+		return (lhs.key_base() != rhs.key_base());
+	}
+
+	template <typename Key, typename T1, typename T2>
+	inline bool operator<(const flat_map_iterator<Key, T1>& lhs, const flat_map_iterator<Key, T2>& rhs)
+	{
+		return (lhs.key_base() < rhs.key_base());
+	}
+
+	template <typename Key, typename T1, typename T2>
+	inline bool operator>(const flat_map_iterator<Key, T1>& lhs, const flat_map_iterator<Key, T2>& rhs)
+	{
+		return (lhs.key_base() > rhs.key_base());
+	}
+
+	template <typename Key, typename T1, typename T2>
+	inline bool operator<=(const flat_map_iterator<Key, T1>& lhs, const flat_map_iterator<Key, T2>& rhs)
+	{
+		return (lhs.key_base() <= rhs.key_base());
+	}
+
+	template <typename Key, typename T1, typename T2>
+	inline bool operator>=(const flat_map_iterator<Key, T1>& lhs, const flat_map_iterator<Key, T2>& rhs)
+	{
+		return (lhs.key_base() >= rhs.key_base());
+	}
+
+	template <typename Key, typename T1, typename T2>
+	inline std::ptrdiff_t operator-(const flat_map_iterator<Key, T1>& lhs, const flat_map_iterator<Key, T2>& rhs)
+	{
+		return (lhs.key_base() - rhs.key_base());
+	}
+
+	template <typename Key, typename T>
+	inline flat_map_iterator<Key, T> operator+(std::ptrdiff_t n, const flat_map_iterator<Key, T>& it)
+	{
+		return (it + n);
+	}
+
+
+	/**
+	 * @brief flat_map
+	 * Ordered map over a sorted key vector and a parallel value vector, see the comment at the top of the file.
+	 *
+	 * @tparam Key key type
+	 * @tparam T mapped type
+	 * @tparam Compare strict weak ordering of the keys
+	 * @tparam KeyContainer contiguous container of Key
+	 * @tparam MappedContainer contiguous container of T
+	 */
+	template <typename Key, typename T, typename Compare = merkol::less<Key>,
+			  typename KeyContainer = merkol::vector<Key>, typename MappedContainer = merkol::vector<T> >
+	class flat_map
+	{
+		typedef flat_map<Key, T, Compare, KeyContainer, MappedContainer>	this_type;
+
+	public:
+		typedef Key															key_type;
+		typedef T															mapped_type;
+		typedef std::pair<Key, T>											value_type;
+		typedef Compare														key_compare;
+		typedef KeyContainer												key_container_type;
+		typedef MappedContainer												mapped_container_type;
+		typedef flat_map_reference<Key, T>									reference;
+		typedef flat_map_reference<Key, const T>							const_reference;
+		typedef std::size_t													size_type;
+		typedef std::ptrdiff_t												difference_type;
+		typedef flat_map_iterator<Key, T>									iterator;
+		typedef flat_map_iterator<Key, const T>								const_iterator;
+		typedef merkol::reverse_iterator<iterator>							reverse_iterator;
+		typedef merkol::reverse_iterator<const_iterator>					const_reverse_iterator;
+		typedef std::pair<iterator, bool>									insert_return_type;
+
+		// Orders value_type by key, e.g. to sort a batch before insert(first, last).
+		struct value_compare
+		{
+			key_compare comp;
+
+			explicit value_compare(const key_compare& c) : comp(c) { }
+			bool operator()(const value_type& a, const value_type& b) const { return comp(a.first, b.first); }
+		};
+
+	protected:
+		KeyContainer		mKeys;
+		MappedContainer		mValues;
+		key_compare			mCompare;
+
+	public:
+		flat_map() : mKeys(), mValues(), mCompare() { }
+		explicit flat_map(const key_compare& compare) : mKeys(), mValues(), mCompare(compare) { }
+
+		template <typename InputIterator>
+		flat_map(InputIterator first, InputIterator last, const key_compare& compare = key_compare())
+			: mKeys(), mValues(), mCompare(compare)
+		{
+			insert(first, last);
+		}
+
+		// Iterators
+		iterator				begin() M_NOEXCEPT { return iterator(mKeys.data(), mValues.data()); }
+		const_iterator			begin() const M_NOEXCEPT { return const_iterator(mKeys.data(), mValues.data()); }
+		iterator				end() M_NOEXCEPT { return begin() + (difference_type)mKeys.size(); }
+		const_iterator			end() const M_NOEXCEPT { return begin() + (difference_type)mKeys.size(); }
+		reverse_iterator		rbegin() M_NOEXCEPT { return reverse_iterator(end()); }
+		const_reverse_iterator	rbegin() const M_NOEXCEPT { return const_reverse_iterator(end()); }
+		reverse_iterator		rend() M_NOEXCEPT { return reverse_iterator(begin()); }
+		const_reverse_iterator	rend() const M_NOEXCEPT { return const_reverse_iterator(begin()); }
+
+		// Capacity
+		bool		empty() const M_NOEXCEPT { return mKeys.empty(); }
+		size_type	size() const M_NOEXCEPT { return mKeys.size(); }
+		size_type	max_size() const M_NOEXCEPT { return mKeys.max_size(); }
+		size_type	capacity() const M_NOEXCEPT { return mKeys.capacity(); }
+		void		reserve(size_type n) { mKeys.reserve(n); mValues.reserve(n); }
+		void		shrink_to_fit() { mKeys.shrink_to_fit(); mValues.shrink_to_fit(); }
+
+		// Element access
+		mapped_type&		operator[](const key_type& key);
+		mapped_type&		at(const key_type& key);
+		const mapped_type&	at(const key_type& key) const;
+
+		// The underlying containers, sorted by key.
+		const key_container_type&		keys() const M_NOEXCEPT { return mKeys; }
+		const mapped_container_type&	values() const M_NOEXCEPT { return mValues; }
+
+		// Lookup
+		iterator		find(const key_type& key);
+		const_iterator	find(const key_type& key) const;
+		size_type		count(const key_type& key) const { return (find(key) != end()) ? 1 : 0; }
+		bool			contains(const key_type& key) const { return find(key) != end(); }
+		iterator		lower_bound(const key_type& key) { return begin() + doLowerBound(key); }
+		const_iterator	lower_bound(const key_type& key) const { return begin() + doLowerBound(key); }
+		iterator		upper_bound(const key_type& key) { return begin() + doUpperBound(key); }
+		const_iterator	upper_bound(const key_type& key) const { return begin() + doUpperBound(key); }
+
+		std::pair<iterator, iterator>				equal_range(const key_type& key);
+		std::pair<const_iterator, const_iterator>	equal_range(const key_type& key) const;
+
+		// Modifiers
+		insert_return_type	insert(const value_type& value);
+		template <typename InputIterator>
+		void				insert(InputIterator first, InputIterator last);
+	#if __cplusplus >= 201103L
+		insert_return_type	insert(value_type&& value);
+
+		template <typename... Args>
+		insert_return_type	emplace(Args&&... args);
+
+		template <typename... Args>
+		insert_return_type	try_emplace(const key_type& key, Args&&... args);
+
+		template <typename M>
+		insert_return_type	insert_or_assign(const key_type& key, M&& value);
+	#endif
+
+		iterator	erase(const_iterator pos);
+		iterator	erase(const_iterator first, const_iterator last);
+		size_type	erase(const key_type& key);
+		void		clear() M_NOEXCEPT { mKeys.clear(); mValues.clear(); }
+		void		swap(this_type& other);
+
+		// Observers
+		key_compare		key_comp() const { return mCompare; }
+		value_compare	value_comp() const { return value_compare(mCompare); }
+
+	protected:
+		size_type	doLowerBound(const key_type& key) const;
+		size_type	doUpperBound(const key_type& key) const;
+		bool		doFound(size_type i, const key_type& key) const { return (i != mKeys.size()) && !mCompare(key, mKeys[i]); }
+
+		template <typename KeyArg, typename ValueArg>
+		iterator	doInsertAt(size_type i, MERKOL_FORWARD_REF(KeyArg) key, MERKOL_FORWARD_REF(ValueArg) value);
+	}; // flat_map
+
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatMap.imp.begin();												///
+	///////////////////////////////////////////////////////////////////////
+
+# define MERKOL_FLAT_MAP_TEMPLATE	template <typename Key, typename T, typename Compare, typename KeyContainer, typename MappedContainer>
+# define MERKOL_FLAT_MAP			flat_map<Key, T, Compare, KeyContainer, MappedContainer>
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	inline typename MERKOL_FLAT_MAP::size_type
+	MERKOL_FLAT_MAP::doLowerBound(const key_type& key) const
+	{
+		return (size_type)(merkol::lower_bound(mKeys.data(), mKeys.data() + mKeys.size(), key, mCompare) - mKeys.data());
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	inline typename MERKOL_FLAT_MAP::size_type
+	MERKOL_FLAT_MAP::doUpperBound(const key_type& key) const
+	{
+		return (size_type)(merkol::upper_bound(mKeys.data(), mKeys.data() + mKeys.size(), key, mCompare) - mKeys.data());
+	}
+
+	// Inserts the key and the value at index i of their vectors. If the value can not be inserted, the
+	// key is taken out again.
+	MERKOL_FLAT_MAP_TEMPLATE
+	template <typename KeyArg, typename ValueArg>
+	typename MERKOL_FLAT_MAP::iterator
+	MERKOL_FLAT_MAP::doInsertAt(size_type i, MERKOL_FORWARD_REF(KeyArg) key, MERKOL_FORWARD_REF(ValueArg) value)
+	{
+		mKeys.insert(mKeys.begin() + (difference_type)i, MERKOL_FORWARD(KeyArg, key));
+		try
+		{
+			mValues.insert(mValues.begin() + (difference_type)i, MERKOL_FORWARD(ValueArg, value));
+		}
+		catch (...)
+		{
+			mKeys.erase(mKeys.begin() + (difference_type)i);
+			throw;
+		}
+		return begin() + (difference_type)i;
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	typename MERKOL_FLAT_MAP::mapped_type&
+	MERKOL_FLAT_MAP::operator[](const key_type& key)
+	{
+		const size_type i = doLowerBound(key);
+
+		if (doFound(i, key))
+			return mValues[i];
+		return doInsertAt(i, key, mapped_type())->second;
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	typename MERKOL_FLAT_MAP::mapped_type&
+	MERKOL_FLAT_MAP::at(const key_type& key)
+	{
+		const size_type i = doLowerBound(key);
+
+		if (!doFound(i, key))
+			throw std::out_of_range("merkol::flat_map::at -- key not found");
+		return mValues[i];
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	const typename MERKOL_FLAT_MAP::mapped_type&
+	MERKOL_FLAT_MAP::at(const key_type& key) const
+	{
+		const size_type i = doLowerBound(key);
+
+		if (!doFound(i, key))
+			throw std::out_of_range("merkol::flat_map::at -- key not found");
+		return mValues[i];
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	inline typename MERKOL_FLAT_MAP::iterator
+	MERKOL_FLAT_MAP::find(const key_type& key)
+	{
+		const size_type i = doLowerBound(key);
+
+		return doFound(i, key) ? begin() + (difference_type)i : end();
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	inline typename MERKOL_FLAT_MAP::const_iterator
+	MERKOL_FLAT_MAP::find(const key_type& key) const
+	{
+		const size_type i = doLowerBound(key);
+
+		return doFound(i, key) ? begin() + (difference_type)i : end();
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	std::pair<typename MERKOL_FLAT_MAP::iterator, typename MERKOL_FLAT_MAP::iterator>
+	MERKOL_FLAT_MAP::equal_range(const key_type& key)
+	{
+		const size_type i = doLowerBound(key);
+
+		return std::pair<iterator, iterator>(begin() + (difference_type)i, begin() + (difference_type)(i + (doFound(i, key) ? 1 : 0)));
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	std::pair<typename MERKOL_FLAT_MAP::const_iterator, typename MERKOL_FLAT_MAP::const_iterator>
+	MERKOL_FLAT_MAP::equal_range(const key_type& key) const
+	{
+		const size_type i = doLowerBound(key);
+
+		return std::pair<const_iterator, const_iterator>(begin() + (difference_type)i, begin() + (difference_type)(i + (doFound(i, key) ? 1 : 0)));
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	typename MERKOL_FLAT_MAP::insert_return_type
+	MERKOL_FLAT_MAP::insert(const value_type& value)
+	{
+		const size_type i = doLowerBound(value.first);
+
+		if (doFound(i, value.first))
+			return insert_return_type(begin() + (difference_type)i, false);
+		return insert_return_type(doInsertAt(i, value.first, value.second), true);
+	}
+
+	// Bulk insertion: the batch is copied aside, sorted by key (stable, so that the first of several
+	// equal keys wins, as with repeated insert()) and merged with the current entries into new vectors
+	// in one pass. Existing keys keep their values. O(n + m log m) for m new entries. If moving an entry
+	// throws, the map is left empty.
+	MERKOL_FLAT_MAP_TEMPLATE
+	template <typename InputIterator>
+	void MERKOL_FLAT_MAP::insert(InputIterator first, InputIterator last)
+	{
+		merkol::vector<value_type> batch(first, last);
+
+		if (batch.empty())
+			return;
+		std::stable_sort(batch.begin(), batch.end(), value_comp());
+
+		KeyContainer	keys;
+		MappedContainer	values;
+		size_type		i = 0;
+		size_type		j = 0;
+		const size_type	n = mKeys.size();
+		const size_type	m = batch.size();
+
+		keys.reserve(n + m);
+		values.reserve(n + m);
+		try
+		{
+			while ((i < n) || (j < m))
+			{
+				if ((j == m) || ((i < n) && !mCompare(batch[j].first, mKeys[i])))
+				{
+					// existing entry first; batch entries with the same key are dropped
+					for (; (j < m) && !mCompare(mKeys[i], batch[j].first); ++j)
+						;
+					keys.push_back(MERKOL_MOVE(mKeys[i]));
+					values.push_back(MERKOL_MOVE(mValues[i]));
+					++i;
+				}
+				else
+				{
+					keys.push_back(MERKOL_MOVE(batch[j].first));
+					values.push_back(MERKOL_MOVE(batch[j].second));
+					// later batch entries with the same key are dropped
+					for (++j; (j < m) && !mCompare(keys.back(), batch[j].first); ++j)
+						;
+				}
+			}
+		}
+		catch (...)
+		{
+			clear();		// entries may have been moved from: keep the vectors the same length
+			throw;
+		}
+		mKeys.swap(keys);
+		mValues.swap(values);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_FLAT_MAP_TEMPLATE
+	typename MERKOL_FLAT_MAP::insert_return_type
+	MERKOL_FLAT_MAP::insert(value_type&& value)
+	{
+		const size_type i = doLowerBound(value.first);
+
+		if (doFound(i, value.first))
+			return insert_return_type(begin() + (difference_type)i, false);
+		return insert_return_type(doInsertAt(i, std::move(value.first), std::move(value.second)), true);
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	template <typename... Args>
+	typename MERKOL_FLAT_MAP::insert_return_type
+	MERKOL_FLAT_MAP::emplace(Args&&... args)
+	{
+		return insert(value_type(std::forward<Args>(args)...));
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	template <typename... Args>
+	typename MERKOL_FLAT_MAP::insert_return_type
+	MERKOL_FLAT_MAP::try_emplace(const key_type& key, Args&&... args)
+	{
+		const size_type i = doLowerBound(key);
+
+		if (doFound(i, key))
+			return insert_return_type(begin() + (difference_type)i, false);
+		return insert_return_type(doInsertAt(i, key, mapped_type(std::forward<Args>(args)...)), true);
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	template <typename M>
+	typename MERKOL_FLAT_MAP::insert_return_type
+	MERKOL_FLAT_MAP::insert_or_assign(const key_type& key, M&& value)
+	{
+		const size_type i = doLowerBound(key);
+
+		if (doFound(i, key))
+		{
+			mValues[i] = std::forward<M>(value);
+			return insert_return_type(begin() + (difference_type)i, false);
+		}
+		return insert_return_type(doInsertAt(i, key, std::forward<M>(value)), true);
+	}
+#endif
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	inline typename MERKOL_FLAT_MAP::iterator
+	MERKOL_FLAT_MAP::erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	typename MERKOL_FLAT_MAP::iterator
+	MERKOL_FLAT_MAP::erase(const_iterator first, const_iterator last)
+	{
+		const difference_type i = first - const_iterator(begin());
+		const difference_type j = last - const_iterator(begin());
+
+		mKeys.erase(mKeys.begin() + i, mKeys.begin() + j);
+		mValues.erase(mValues.begin() + i, mValues.begin() + j);
+		return begin() + i;
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	typename MERKOL_FLAT_MAP::size_type
+	MERKOL_FLAT_MAP::erase(const key_type& key)
+	{
+		const size_type i = doLowerBound(key);
+
+		if (!doFound(i, key))
+			return 0;
+		erase(begin() + (difference_type)i);
+		return 1;
+	}
+
+	MERKOL_FLAT_MAP_TEMPLATE
+	void MERKOL_FLAT_MAP::swap(this_type& other)
+	{
+		mKeys.swap(other.mKeys);
+		mValues.swap(other.mValues);
+		merkol::swap(mCompare, other.mCompare);
+	}
+
+# undef MERKOL_FLAT_MAP_TEMPLATE
+# undef MERKOL_FLAT_MAP
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatMap.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename Key, typename T, typename Compare, typename KeyContainer, typename MappedContainer>
+	inline bool operator==(const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& a,
+						   const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& b)
+	{
+		return (a.keys() == b.keys()) && (a.values() == b.values());
+	}
+
+	template <typename Key, typename T, typename Compare, typename KeyContainer, typename MappedContainer>
+	inline bool operator!=(const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& a,
+						   const flat_map<Key, T, Compare, KeyContainer, MappedContainer>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename T, typename Compare, typename KeyContainer, typename MappedContainer>
+	inline void swap(flat_map<Key, T, Compare, KeyContainer, MappedContainer>& a, flat_map<Key, T, Compare, KeyContainer, MappedContainer>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_FLAT_MAP_HPP
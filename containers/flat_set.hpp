@@ -0,0 +1,262 @@
+#ifndef MERKOL_FLAT_SET_HPP
+# define MERKOL_FLAT_SET_HPP
+
+#include <algorithm>
+#include <utility>
+#include "vector.hpp"
+#include "../aux_templates/algorithm.hpp"
+#include "../aux_templates/functional.hpp"
+
+namespace merkol
+{
+	/**
+	 * @brief flat_set
+	 * Ordered set stored as a sorted vector of keys, searched with the branchless merkol::lower_bound.
+	 * Same trade-offs as flat_map (see flat_map.hpp): cheap, cache friendly lookups and O(n) insertion or
+	 * erasure in the middle, which invalidates every iterator. Both iterator types are constant.
+	 *
+	 * @tparam Key key type
+	 * @tparam Compare strict weak ordering of the keys
+	 * @tparam KeyContainer contiguous container of Key
+	 */
+	template <typename Key, typename Compare = merkol::less<Key>, typename KeyContainer = merkol::vector<Key> >
+	class flat_set
+	{
+		typedef flat_set<Key, Compare, KeyContainer>	this_type;
+
+	public:
+		typedef Key											key_type;
+		typedef Key											value_type;
+		typedef Compare										key_compare;
+		typedef Compare										value_compare;
+		typedef KeyContainer								container_type;
+		typedef const Key&									reference;
+		typedef const Key&									const_reference;
+		typedef std::size_t									size_type;
+		typedef std::ptrdiff_t								difference_type;
+		typedef typename KeyContainer::const_iterator		iterator;
+		typedef typename KeyContainer::const_iterator		const_iterator;
+		typedef typename KeyContainer::const_reverse_iterator	reverse_iterator;
+		typedef typename KeyContainer::const_reverse_iterator	const_reverse_iterator;
+		typedef std::pair<iterator, bool>					insert_return_type;
+
+	protected:
+		KeyContainer	mKeys;
+		key_compare		mCompare;
+
+	public:
+		flat_set() : mKeys(), mCompare() { }
+		explicit flat_set(const key_compare& compare) : mKeys(), mCompare(compare) { }
+
+		template <typename InputIterator>
+		flat_set(InputIterator first, InputIterator last, const key_compare& compare = key_compare())
+			: mKeys(), mCompare(compare)
+		{
+			insert(first, last);
+		}
+
+		// Iterators
+		const_iterator			begin() const M_NOEXCEPT { return mKeys.begin(); }
+		const_iterator			end() const M_NOEXCEPT { return mKeys.end(); }
+		const_reverse_iterator	rbegin() const M_NOEXCEPT { return mKeys.rbegin(); }
+		const_reverse_iterator	rend() const M_NOEXCEPT { return mKeys.rend(); }
+
+		// Capacity
+		bool		empty() const M_NOEXCEPT { return mKeys.empty(); }
+		size_type	size() const M_NOEXCEPT { return mKeys.size(); }
+		size_type	max_size() const M_NOEXCEPT { return mKeys.max_size(); }
+		size_type	capacity() const M_NOEXCEPT { return mKeys.capacity(); }
+		void		reserve(size_type n) { mKeys.reserve(n); }
+		void		shrink_to_fit() { mKeys.shrink_to_fit(); }
+
+		// The underlying container, sorted.
+		const container_type&	keys() const M_NOEXCEPT { return mKeys; }
+
+		// Lookup
+		const_iterator	find(const key_type& key) const;
+		size_type		count(const key_type& key) const { return (find(key) != end()) ? 1 : 0; }
+		bool			contains(const key_type& key) const { return find(key) != end(); }
+		const_iterator	lower_bound(const key_type& key) const { return begin() + doLowerBound(key); }
+		const_iterator	upper_bound(const key_type& key) const { return begin() + doUpperBound(key); }
+
+		std::pair<const_iterator, const_iterator>	equal_range(const key_type& key) const;
+
+		// Modifiers
+		insert_return_type	insert(const value_type& value);
+		template <typename InputIterator>
+		void				insert(InputIterator first, InputIterator last);
+	#if __cplusplus >= 201103L
+		insert_return_type	insert(value_type&& value);
+
+		template <typename... Args>
+		insert_return_type	emplace(Args&&... args) { return insert(value_type(std::forward<Args>(args)...)); }
+	#endif
+
+		iterator	erase(const_iterator pos);
+		iterator	erase(const_iterator first, const_iterator last);
+		size_type	erase(const key_type& key);
+		void		clear() M_NOEXCEPT { mKeys.clear(); }
+		void		swap(this_type& other);
+
+		// Observers
+		key_compare		key_comp() const { return mCompare; }
+		value_compare	value_comp() const { return mCompare; }
+
+	protected:
+		size_type	doLowerBound(const key_type& key) const;
+		size_type	doUpperBound(const key_type& key) const;
+		bool		doFound(size_type i, const key_type& key) const { return (i != mKeys.size()) && !mCompare(key, mKeys[i]); }
+
+		// Mutable iterator into mKeys, for the container's own insert and erase.
+		typename KeyContainer::iterator	doKeyAt(size_type i) { return mKeys.begin() + (difference_type)i; }
+	}; // flat_set
+
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatSet.imp.begin();												///
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	inline typename flat_set<Key, Compare, KeyContainer>::size_type
+	flat_set<Key, Compare, KeyContainer>::doLowerBound(const key_type& key) const
+	{
+		return (size_type)(merkol::lower_bound(mKeys.data(), mKeys.data() + mKeys.size(), key, mCompare) - mKeys.data());
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	inline typename flat_set<Key, Compare, KeyContainer>::size_type
+	flat_set<Key, Compare, KeyContainer>::doUpperBound(const key_type& key) const
+	{
+		return (size_type)(merkol::upper_bound(mKeys.data(), mKeys.data() + mKeys.size(), key, mCompare) - mKeys.data());
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	inline typename flat_set<Key, Compare, KeyContainer>::const_iterator
+	flat_set<Key, Compare, KeyContainer>::find(const key_type& key) const
+	{
+		const size_type i = doLowerBound(key);
+
+		return doFound(i, key) ? begin() + (difference_type)i : end();
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	std::pair<typename flat_set<Key, Compare, KeyContainer>::const_iterator, typename flat_set<Key, Compare, KeyContainer>::const_iterator>
+	flat_set<Key, Compare, KeyContainer>::equal_range(const key_type& key) const
+	{
+		const size_type i = doLowerBound(key);
+
+		return std::pair<const_iterator, const_iterator>(begin() + (difference_type)i, begin() + (difference_type)(i + (doFound(i, key) ? 1 : 0)));
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	typename flat_set<Key, Compare, KeyContainer>::insert_return_type
+	flat_set<Key, Compare, KeyContainer>::insert(const value_type& value)
+	{
+		const size_type i = doLowerBound(value);
+
+		if (doFound(i, value))
+			return insert_return_type(begin() + (difference_type)i, false);
+		mKeys.insert(doKeyAt(i), value);
+		return insert_return_type(begin() + (difference_type)i, true);
+	}
+
+#if __cplusplus >= 201103L
+	template <typename Key, typename Compare, typename KeyContainer>
+	typename flat_set<Key, Compare, KeyContainer>::insert_return_type
+	flat_set<Key, Compare, KeyContainer>::insert(value_type&& value)
+	{
+		const size_type i = doLowerBound(value);
+
+		if (doFound(i, value))
+			return insert_return_type(begin() + (difference_type)i, false);
+		mKeys.insert(doKeyAt(i), std::move(value));
+		return insert_return_type(begin() + (difference_type)i, true);
+	}
+#endif
+
+	// Bulk insertion: the batch is appended, sorted on its own (stable, so that the first of several equal
+	// keys is the one kept) and merged with the old elements in one pass, then the duplicates are removed.
+	// O(n + m log m) for m new keys, against O(n m) for m calls to insert(). If the comparison or a move
+	// throws on the way, old and new keys are mixed up: the set is left empty.
+	template <typename Key, typename Compare, typename KeyContainer>
+	template <typename InputIterator>
+	void flat_set<Key, Compare, KeyContainer>::insert(InputIterator first, InputIterator last)
+	{
+		const size_type n = mKeys.size();
+
+		mKeys.insert(mKeys.end(), first, last);
+		try
+		{
+			std::stable_sort(doKeyAt(n), mKeys.end(), mCompare);
+			std::inplace_merge(mKeys.begin(), doKeyAt(n), mKeys.end(), mCompare);
+			mKeys.erase(std::unique(mKeys.begin(), mKeys.end(), merkol::not_ordered<Key, Compare>(mCompare)), mKeys.end());
+		}
+		catch (...)
+		{
+			clear();
+			throw;
+		}
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	inline typename flat_set<Key, Compare, KeyContainer>::iterator
+	flat_set<Key, Compare, KeyContainer>::erase(const_iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	typename flat_set<Key, Compare, KeyContainer>::iterator
+	flat_set<Key, Compare, KeyContainer>::erase(const_iterator first, const_iterator last)
+	{
+		const difference_type i = first - begin();
+
+		mKeys.erase(doKeyAt(i), doKeyAt(last - begin()));
+		return begin() + i;
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	typename flat_set<Key, Compare, KeyContainer>::size_type
+	flat_set<Key, Compare, KeyContainer>::erase(const key_type& key)
+	{
+		const size_type i = doLowerBound(key);
+
+		if (!doFound(i, key))
+			return 0;
+		mKeys.erase(doKeyAt(i));
+		return 1;
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	void flat_set<Key, Compare, KeyContainer>::swap(this_type& other)
+	{
+		mKeys.swap(other.mKeys);
+		merkol::swap(mCompare, other.mCompare);
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// FlatSet.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	inline bool operator==(const flat_set<Key, Compare, KeyContainer>& a, const flat_set<Key, Compare, KeyContainer>& b)
+	{
+		return (a.keys() == b.keys());
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	inline bool operator!=(const flat_set<Key, Compare, KeyContainer>& a, const flat_set<Key, Compare, KeyContainer>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename Compare, typename KeyContainer>
+	inline void swap(flat_set<Key, Compare, KeyContainer>& a, flat_set<Key, Compare, KeyContainer>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_FLAT_SET_HPP
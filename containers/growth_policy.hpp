@@ -0,0 +1,88 @@
+#ifndef GROWTH_POLICY_HPP
+# define GROWTH_POLICY_HPP
+
+#include <cstddef>
+
+namespace merkol
+{
+	/*
+		Growth policies
+		vectorBase::getNewCapacity() asks its GrowthPolicy for the next capacity whenever an insertion
+		does not fit. A policy is any type with a static member
+
+			static std::size_t grow(std::size_t currentCapacity, std::size_t elementSize);
+
+		that returns a capacity strictly greater than currentCapacity. vectorBase takes care of
+		clamping the result to max_size() and of raising it to the size actually required
+		(e.g. insert(pos, 1000, value) on a vector with capacity 4).
+
+		Any geometric factor keeps push_back amortized O(1); the factor only trades the number of
+		reallocations against the unused tail of the buffer.
+	*/
+
+	/// growth_policy_double
+	///
+	/// Doubles the capacity. Fewest reallocations (log2(n)), up to 50% of the buffer unused.
+	/// This is the default.
+	struct growth_policy_double
+	{
+		static std::size_t grow(std::size_t currentCapacity, std::size_t /*elementSize*/)
+		{
+			return (currentCapacity > 0) ? (currentCapacity * 2) : 1;
+		}
+	};
+
+	/// growth_policy_one_and_half
+	///
+	/// Grows by 1.5x. Because 1 + 1.5 + 1.5^2 + ... eventually exceeds the next request, the sum of the
+	/// blocks freed so far becomes large enough to hold the next one, so a first-fit allocator can
+	/// reuse them. With 2x the new block is always larger than everything freed before it.
+	struct growth_policy_one_and_half
+	{
+		static std::size_t grow(std::size_t currentCapacity, std::size_t /*elementSize*/)
+		{
+			return (currentCapacity > 1) ? (currentCapacity + currentCapacity / 2) : (currentCapacity + 1);
+		}
+	};
+
+	/// growth_policy_size_class
+	///
+	/// Grows by 1.5x and then rounds the byte size up to the size class the allocator would hand out
+	/// anyway, so the slack at the end of the block becomes usable capacity instead of being wasted.
+	/// The classes follow the usual jemalloc/tcmalloc layout:
+	///     <= 128 bytes    multiples of 16
+	///     <= 4 KiB        4 classes per power of two
+	///     larger          multiples of the 4 KiB page
+	struct growth_policy_size_class
+	{
+		static std::size_t round_to_size_class(std::size_t bytes)
+		{
+			if (bytes <= 16)
+				return 16;
+			if (bytes <= 128)
+				return (bytes + 15) & ~(std::size_t)15;
+			if (bytes <= 4096)
+			{
+				std::size_t power = 128;
+				while (power < bytes)
+					power <<= 1;
+				const std::size_t step = power / 8; // 4 classes between power/2 and power
+				return (bytes + step - 1) / step * step;
+			}
+			return (bytes + 4095) & ~(std::size_t)4095;
+		}
+
+		static std::size_t grow(std::size_t currentCapacity, std::size_t elementSize)
+		{
+			const std::size_t wanted = growth_policy_one_and_half::grow(currentCapacity, elementSize);
+			const std::size_t maxElements = (std::size_t)-1 / (elementSize * 2);
+
+			if (wanted > maxElements) // leave the clamping to the caller
+				return wanted;
+			return round_to_size_class(wanted * elementSize) / elementSize;
+		}
+	};
+
+} // namespace merkol
+
+#endif // GROWTH_POLICY_HPP
@@ -0,0 +1,234 @@
+#ifndef MERKOL_MAP_HPP
+# define MERKOL_MAP_HPP
+
+#include <stdexcept>
+#include <utility>
+#if __cplusplus >= 201103L
+# include <tuple>
+#endif
+#include "rb_tree.hpp"
+
+namespace merkol
+{
+	/**
+	 * @brief map
+	 * Ordered map on a red-black tree with pooled nodes (see rb_tree.hpp). Same interface and iterator
+	 * validity as std::map: inserting never invalidates anything, erasing only the erased elements.
+	 */
+	template <typename Key, typename T, typename Compare = merkol::less<Key>,
+			  typename Allocator = std::allocator<std::pair<const Key, T> > >
+	class map
+		: public rb_tree<std::pair<const Key, T>, Key, merkol::use_first<std::pair<const Key, T> >, Compare, Allocator, true, true>
+	{
+		typedef rb_tree<std::pair<const Key, T>, Key, merkol::use_first<std::pair<const Key, T> >,
+						Compare, Allocator, true, true>										base_type;
+		typedef map<Key, T, Compare, Allocator>												this_type;
+
+	public:
+		typedef T																		mapped_type;
+		typedef typename base_type::key_type											key_type;
+		typedef typename base_type::value_type											value_type;
+		typedef typename base_type::size_type											size_type;
+		typedef typename base_type::key_compare											key_compare;
+		typedef typename base_type::allocator_type										allocator_type;
+		typedef typename base_type::iterator											iterator;
+		typedef typename base_type::const_iterator										const_iterator;
+		typedef typename base_type::insert_return_type									insert_return_type;
+
+		// Orders value_type by key.
+		struct value_compare
+		{
+			key_compare comp;
+
+			explicit value_compare(const key_compare& c) : comp(c) { }
+			bool operator()(const value_type& a, const value_type& b) const { return comp(a.first, b.first); }
+		};
+
+	public:
+		explicit map(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator) { }
+
+		// O(n) when [first, last) is sorted, see rb_tree::insert(first, last).
+		template <typename InputIterator>
+		map(InputIterator first, InputIterator last, const key_compare& compare = key_compare(),
+			const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator)
+		{
+			base_type::insert(first, last);
+		}
+
+		mapped_type&		operator[](const key_type& key);
+		mapped_type&		at(const key_type& key);
+		const mapped_type&	at(const key_type& key) const;
+
+		value_compare		value_comp() const { return value_compare(this->mCompare); }
+
+	#if __cplusplus >= 201103L
+		template <typename... Args>
+		insert_return_type	try_emplace(const key_type& key, Args&&... args);
+
+		template <typename M>
+		insert_return_type	insert_or_assign(const key_type& key, M&& value);
+	#endif
+	}; // map
+
+
+	/**
+	 * @brief multimap
+	 * Ordered map that keeps several elements with the same key, in insertion order.
+	 */
+	template <typename Key, typename T, typename Compare = merkol::less<Key>,
+			  typename Allocator = std::allocator<std::pair<const Key, T> > >
+	class multimap
+		: public rb_tree<std::pair<const Key, T>, Key, merkol::use_first<std::pair<const Key, T> >, Compare, Allocator, true, false>
+	{
+		typedef rb_tree<std::pair<const Key, T>, Key, merkol::use_first<std::pair<const Key, T> >,
+						Compare, Allocator, true, false>									base_type;
+
+	public:
+		typedef T																		mapped_type;
+		typedef typename base_type::key_compare											key_compare;
+		typedef typename base_type::allocator_type										allocator_type;
+
+	public:
+		explicit multimap(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator) { }
+
+		template <typename InputIterator>
+		multimap(InputIterator first, InputIterator last, const key_compare& compare = key_compare(),
+				 const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator)
+		{
+			base_type::insert(first, last);
+		}
+	}; // multimap
+
+
+	///////////////////////////////////////////////////////////////////////
+	// Map.imp.begin();													///
+	///////////////////////////////////////////////////////////////////////
+
+	// The node is only created when the key is new.
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	typename map<Key, T, Compare, Allocator>::mapped_type&
+	map<Key, T, Compare, Allocator>::operator[](const key_type& key)
+	{
+	#if __cplusplus >= 201103L
+		return try_emplace(key).first->second;
+	#else
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		if (rbtree_node_base* const existing = this->doFindUniquePosition(key, parent, insertLeft))
+			return iterator(existing)->second;
+		return this->doLink(this->doCreateNode(value_type(key, mapped_type())), parent, insertLeft)->second;
+	#endif
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	typename map<Key, T, Compare, Allocator>::mapped_type&
+	map<Key, T, Compare, Allocator>::at(const key_type& key)
+	{
+		const iterator it = this->find(key);
+
+		if (it == this->end())
+			throw std::out_of_range("merkol::map::at -- key not found");
+		return it->second;
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	const typename map<Key, T, Compare, Allocator>::mapped_type&
+	map<Key, T, Compare, Allocator>::at(const key_type& key) const
+	{
+		const const_iterator it = this->find(key);
+
+		if (it == this->end())
+			throw std::out_of_range("merkol::map::at -- key not found");
+		return it->second;
+	}
+
+#if __cplusplus >= 201103L
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	template <typename... Args>
+	typename map<Key, T, Compare, Allocator>::insert_return_type
+	map<Key, T, Compare, Allocator>::try_emplace(const key_type& key, Args&&... args)
+	{
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		if (rbtree_node_base* const existing = this->doFindUniquePosition(key, parent, insertLeft))
+			return insert_return_type(iterator(existing), false);
+		return insert_return_type(this->doLink(this->doCreateNode(std::piecewise_construct, std::forward_as_tuple(key),
+																 std::forward_as_tuple(std::forward<Args>(args)...)),
+											   parent, insertLeft), true);
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	template <typename M>
+	typename map<Key, T, Compare, Allocator>::insert_return_type
+	map<Key, T, Compare, Allocator>::insert_or_assign(const key_type& key, M&& value)
+	{
+		insert_return_type result = try_emplace(key, std::forward<M>(value));
+
+		if (!result.second)
+			result.first->second = std::forward<M>(value);
+		return result;
+	}
+#endif
+
+	///////////////////////////////////////////////////////////////////////
+	// Map.imp.end();													///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline bool operator==(const map<Key, T, Compare, Allocator>& a, const map<Key, T, Compare, Allocator>& b)
+	{
+		return (a.size() == b.size()) && merkol::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline bool operator!=(const map<Key, T, Compare, Allocator>& a, const map<Key, T, Compare, Allocator>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline bool operator<(const map<Key, T, Compare, Allocator>& a, const map<Key, T, Compare, Allocator>& b)
+	{
+		return merkol::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline void swap(map<Key, T, Compare, Allocator>& a, map<Key, T, Compare, Allocator>& b)
+	{
+		a.swap(b);
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline bool operator==(const multimap<Key, T, Compare, Allocator>& a, const multimap<Key, T, Compare, Allocator>& b)
+	{
+		return (a.size() == b.size()) && merkol::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline bool operator!=(const multimap<Key, T, Compare, Allocator>& a, const multimap<Key, T, Compare, Allocator>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline bool operator<(const multimap<Key, T, Compare, Allocator>& a, const multimap<Key, T, Compare, Allocator>& b)
+	{
+		return merkol::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template <typename Key, typename T, typename Compare, typename Allocator>
+	inline void swap(multimap<Key, T, Compare, Allocator>& a, multimap<Key, T, Compare, Allocator>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_MAP_HPP
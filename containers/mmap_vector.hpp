@@ -0,0 +1,659 @@
+#ifndef MERKOL_MMAP_VECTOR_HPP
+# define MERKOL_MMAP_VECTOR_HPP
+
+#if __cplusplus < 201103L
+# error "mmap_vector.hpp requires C++11"
+#endif
+
+#if !defined(__unix__) && !defined(__APPLE__)
+# error "mmap_vector.hpp requires POSIX mmap"
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <stdint.h>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "growth_policy.hpp"
+#include "../iterators/random_access_iterator.hpp"
+#include "../iterators/reverse_iterator.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	mmap_vector
+
+	A vector of trivially copyable elements whose storage is a file mapped with mmap(MAP_SHARED): the
+	elements are the bytes of the file, so a vector written by one run is there, as is, for the next one.
+	Opening a multi-GB table costs an open and an mmap; pages are read from the page cache or the disk
+	when first touched, and are shared by every process mapping the same file.
+
+	The file starts with a 64 byte header (magic, format version, sizeof(T), size), followed by the
+	elements; its length is the capacity, rounded up to whole pages:
+
+		| header | element 0 | element 1 | ... | element size - 1 | unused capacity ... |
+		0        64                                                                 file length
+
+	The header keeps the size up to date on every change, so the elements pushed before a crash of the
+	process are there on the next open (they are in the page cache already; a crash of the machine loses
+	what was not written back, see sync()). Opening a file checks the magic, the version and sizeof(T);
+	the layout of T itself (and the byte order) must be the same in the program that wrote the file.
+
+	Growing follows GrowthPolicy like merkol::vector: ftruncate extends the file (sparse, the new pages
+	take no disk space until written) and the mapping is extended with mremap on Linux, or remapped
+	elsewhere. Neither copies an element, but the mapping may move: like for merkol::vector, growing
+	invalidates pointers, references and iterators.
+
+	Modes (kMapReadWrite by default):
+		kMapReadWrite	opens the file, or creates an empty vector if there is none (or it is empty);
+		kMapCreate		creates the file, or truncates an existing one to an empty vector;
+		kMapReadOnly	opens an existing file with PROT_READ: nothing is copied or written. Modifiers
+						throw std::logic_error; writing through a reference or an iterator is a
+						segmentation fault.
+	sync() writes the dirty pages back with msync, advise() passes an access pattern to madvise, e.g.
+	kAdviseSequential before a scan (more read ahead) or kAdviseRandom for lookups (no read ahead).
+	System call failures throw std::system_error, a file that is not a vector of T std::runtime_error.
+
+	The vector owns the file descriptor and the mapping, so it can be moved but not copied; a moved from
+	vector can only be assigned to or destroyed. Two mmap_vector objects writing to the same file, in one
+	process or several, see each other's elements but not each other's size: one writer per file.
+*/
+
+namespace merkol
+{
+	enum mmap_mode
+	{
+		kMapReadWrite,
+		kMapCreate,
+		kMapReadOnly
+	};
+
+	enum mmap_advice
+	{
+		kAdviseNormal,
+		kAdviseSequential,
+		kAdviseRandom,
+		kAdviseWillNeed,
+		kAdviseDontNeed
+	};
+
+	// First bytes of an mmap_vector file.
+	struct mmap_vector_header
+	{
+		char		mMagic[8];
+		uint32_t	mVersion;
+		uint32_t	mElementSize;
+		uint64_t	mSize;
+		char		mReserved[40];
+	};
+
+	static const char kMmapVectorMagic[8] = { 'M', 'E', 'R', 'K', 'O', 'L', 'M', 'V' };
+
+	/**
+	 * @brief mmap_vector
+	 * Vector of trivially copyable T stored in a memory mapped file (see above).
+	 *
+	 * @tparam GrowthPolicy see growth_policy.hpp
+	 */
+	template <typename T, typename GrowthPolicy = merkol::growth_policy_double>
+	class mmap_vector
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "mmap_vector elements must be trivially copyable");
+
+		typedef mmap_vector<T, GrowthPolicy>	this_type;
+
+	public:
+		typedef T													value_type;
+		typedef T*													pointer;
+		typedef const T*											const_pointer;
+		typedef T&													reference;
+		typedef const T&											const_reference;
+		typedef std::size_t											size_type;
+		typedef std::ptrdiff_t										difference_type;
+		typedef merkol::random_access_iterator<value_type>			iterator;
+		typedef merkol::random_access_iterator<const value_type>	const_iterator;
+		typedef merkol::reverse_iterator<iterator>					reverse_iterator;
+		typedef merkol::reverse_iterator<const_iterator>			const_reverse_iterator;
+
+		static const size_type	kHeaderSize	= sizeof(mmap_vector_header);
+		static const uint32_t	kVersion	= 1;
+
+		static_assert(kHeaderSize == 64, "mmap_vector_header must be 64 bytes");
+		static_assert(alignof(T) <= kHeaderSize, "mmap_vector elements must be aligned to at most 64 bytes");
+
+	protected:
+		int				mnFile;			// file descriptor, -1 if none
+		unsigned char*	mpMap;			// the whole file, header first
+		size_type		mnMapBytes;		// length of the file and of the mapping
+		pointer			mpBegin;
+		pointer			mpEnd;
+		pointer			mpCapacity;
+		bool			mbReadOnly;
+
+	public:
+		explicit mmap_vector(const char* path, mmap_mode mode = kMapReadWrite);
+		mmap_vector(this_type&& other) M_NOEXCEPT;
+		~mmap_vector();
+
+		mmap_vector(const this_type&) = delete;
+		this_type&	operator=(const this_type&) = delete;
+		this_type&	operator=(this_type&& other) M_NOEXCEPT;
+
+		// Iterators
+		iterator				begin() M_NOEXCEPT { return iterator(mpBegin); }
+		const_iterator			begin() const M_NOEXCEPT { return const_iterator(mpBegin); }
+		iterator				end() M_NOEXCEPT { return iterator(mpEnd); }
+		const_iterator			end() const M_NOEXCEPT { return const_iterator(mpEnd); }
+		reverse_iterator		rbegin() M_NOEXCEPT { return reverse_iterator(end()); }
+		const_reverse_iterator	rbegin() const M_NOEXCEPT { return const_reverse_iterator(end()); }
+		reverse_iterator		rend() M_NOEXCEPT { return reverse_iterator(begin()); }
+		const_reverse_iterator	rend() const M_NOEXCEPT { return const_reverse_iterator(begin()); }
+
+		// Element access
+		pointer			data() M_NOEXCEPT { return mpBegin; }
+		const_pointer	data() const M_NOEXCEPT { return mpBegin; }
+
+		reference		at(size_type n);
+		const_reference	at(size_type n) const;
+		reference		operator[](size_type n) { return at(n); }
+		const_reference	operator[](size_type n) const { return at(n); }
+		reference		front() { return *mpBegin; }
+		const_reference	front() const { return *mpBegin; }
+		reference		back() { return *(mpEnd - 1); }
+		const_reference	back() const { return *(mpEnd - 1); }
+
+		// Capacity
+		bool		empty() const M_NOEXCEPT { return mpBegin == mpEnd; }
+		size_type	size() const M_NOEXCEPT { return (size_type)(mpEnd - mpBegin); }
+		size_type	capacity() const M_NOEXCEPT { return (size_type)(mpCapacity - mpBegin); }
+		size_type	max_size() const M_NOEXCEPT { return ((size_type)-1 / 2 - kHeaderSize) / sizeof(T); }
+		void		reserve(size_type n);
+		void		shrink_to_fit();
+
+		// Modifiers
+		void		clear();
+		void		push_back(const value_type& value);
+		template <typename... Args>
+		reference	emplace_back(Args&&... args);
+		void		pop_back();
+		void		resize(size_type n);
+		void		resize(size_type n, const value_type& value);
+		iterator	insert(const_iterator pos, const value_type& value) { return insert(pos, 1, value); }
+		iterator	insert(const_iterator pos, size_type n, const value_type& value);
+		template <typename ForwardIterator, typename = typename std::enable_if<!std::is_integral<ForwardIterator>::value>::type>
+		iterator	insert(const_iterator pos, ForwardIterator first, ForwardIterator last);
+		iterator	erase(const_iterator pos) { return erase(pos, pos + 1); }
+		iterator	erase(const_iterator first, const_iterator last);
+		void		swap(this_type& other) M_NOEXCEPT;
+
+		// File
+		bool		read_only() const M_NOEXCEPT { return mbReadOnly; }
+		void		sync(bool wait = true);
+		bool		advise(mmap_advice advice);
+
+	protected:
+		mmap_vector_header*	doHeader() const { return reinterpret_cast<mmap_vector_header*>(mpMap); }
+
+		static size_type	doPageSize() { return (size_type)sysconf(_SC_PAGESIZE); }
+		static size_type	doFileBytes(size_type n);
+		static void			doThrowErrno(const char* what);
+
+		void		doOpen(const char* path, mmap_mode mode);
+		void		doMap(size_type bytes, size_type n);
+		void		doAdopt(void* map, size_type bytes, size_type n);
+		void		doRemap(size_type bytes);
+		void		doClose() M_NOEXCEPT;
+		void		doResizeFile(size_type n);
+		void		doGrow(size_type minCapacity);
+		void		doCheckWritable() const;
+		void		doSetEnd(pointer end) { mpEnd = end; doHeader()->mSize = (uint64_t)(end - mpBegin); }
+		pointer		doMakeGap(const_iterator pos, size_type n);
+	}; // mmap_vector
+
+
+	///////////////////////////////////////////////////////////////////////
+	// MmapVector.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+# define MERKOL_MMAP_VECTOR_TEMPLATE	template <typename T, typename GrowthPolicy>
+# define MERKOL_MMAP_VECTOR				mmap_vector<T, GrowthPolicy>
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	const typename MERKOL_MMAP_VECTOR::size_type MERKOL_MMAP_VECTOR::kHeaderSize;
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	const uint32_t MERKOL_MMAP_VECTOR::kVersion;
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	MERKOL_MMAP_VECTOR::mmap_vector(const char* path, mmap_mode mode)
+		: mnFile(-1), mpMap(NULL), mnMapBytes(0), mpBegin(NULL), mpEnd(NULL), mpCapacity(NULL), mbReadOnly(mode == kMapReadOnly)
+	{
+		try
+		{
+			doOpen(path, mode);
+		}
+		catch (...)
+		{
+			doClose();
+			throw;
+		}
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	MERKOL_MMAP_VECTOR::mmap_vector(this_type&& other) M_NOEXCEPT
+		: mnFile(other.mnFile), mpMap(other.mpMap), mnMapBytes(other.mnMapBytes), mpBegin(other.mpBegin), mpEnd(other.mpEnd),
+		  mpCapacity(other.mpCapacity), mbReadOnly(other.mbReadOnly)
+	{
+		other.mnFile		= -1;
+		other.mpMap			= NULL;
+		other.mnMapBytes	= 0;
+		other.mpBegin		= NULL;
+		other.mpEnd			= NULL;
+		other.mpCapacity	= NULL;
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline MERKOL_MMAP_VECTOR::~mmap_vector()
+	{
+		doClose();
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	typename MERKOL_MMAP_VECTOR::this_type&
+	MERKOL_MMAP_VECTOR::operator=(this_type&& other) M_NOEXCEPT
+	{
+		if (this != &other)
+		{
+			this_type moved(std::move(other));
+
+			swap(moved);
+		}
+		return *this;
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::swap(this_type& other) M_NOEXCEPT
+	{
+		std::swap(mnFile, other.mnFile);
+		std::swap(mpMap, other.mpMap);
+		std::swap(mnMapBytes, other.mnMapBytes);
+		std::swap(mpBegin, other.mpBegin);
+		std::swap(mpEnd, other.mpEnd);
+		std::swap(mpCapacity, other.mpCapacity);
+		std::swap(mbReadOnly, other.mbReadOnly);
+	}
+
+	// Length of a file holding n elements: whole pages.
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline typename MERKOL_MMAP_VECTOR::size_type
+	MERKOL_MMAP_VECTOR::doFileBytes(size_type n)
+	{
+		const size_type pageSize = doPageSize();
+
+		return (kHeaderSize + n * sizeof(T) + pageSize - 1) / pageSize * pageSize;
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doThrowErrno(const char* what)
+	{
+		throw std::system_error(errno, std::generic_category(), what);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doOpen(const char* path, mmap_mode mode)
+	{
+		int flags = O_RDONLY;
+
+		if (mode == kMapReadWrite)
+			flags = O_RDWR | O_CREAT;
+		else if (mode == kMapCreate)
+			flags = O_RDWR | O_CREAT | O_TRUNC;
+		mnFile = ::open(path, flags | O_CLOEXEC, 0644);
+		if (mnFile < 0)
+			doThrowErrno("merkol::mmap_vector -- open");
+
+		struct stat info;
+
+		if (::fstat(mnFile, &info) != 0)
+			doThrowErrno("merkol::mmap_vector -- fstat");
+
+		const size_type bytes = (size_type)info.st_size;
+
+		if ((bytes == 0) && !mbReadOnly)	// new file: an empty vector
+		{
+			const size_type newBytes = doFileBytes(0);
+
+			if (::ftruncate(mnFile, (off_t)newBytes) != 0)
+				doThrowErrno("merkol::mmap_vector -- ftruncate");
+			doMap(newBytes, 0);
+			std::memcpy(doHeader()->mMagic, kMmapVectorMagic, sizeof(kMmapVectorMagic));
+			doHeader()->mVersion		= kVersion;
+			doHeader()->mElementSize	= (uint32_t)sizeof(T);
+			doHeader()->mSize			= 0;
+			return;
+		}
+		if (bytes < kHeaderSize)
+			throw std::runtime_error("merkol::mmap_vector -- not an mmap_vector file");
+
+		mmap_vector_header header;
+
+		if (::pread(mnFile, &header, sizeof(header), 0) != (ssize_t)sizeof(header))
+			doThrowErrno("merkol::mmap_vector -- read");
+		if (std::memcmp(header.mMagic, kMmapVectorMagic, sizeof(kMmapVectorMagic)) != 0)
+			throw std::runtime_error("merkol::mmap_vector -- not an mmap_vector file");
+		if (header.mVersion != kVersion)
+			throw std::runtime_error("merkol::mmap_vector -- unsupported file version");
+		if (header.mElementSize != sizeof(T))
+			throw std::runtime_error("merkol::mmap_vector -- element size does not match the file");
+		if (header.mSize > (bytes - kHeaderSize) / sizeof(T))
+			throw std::runtime_error("merkol::mmap_vector -- file is truncated");
+		doMap(bytes, (size_type)header.mSize);
+	}
+
+	// Maps the first bytes of the file, holding n elements.
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doMap(size_type bytes, size_type n)
+	{
+		const int	protection	= mbReadOnly ? PROT_READ : (PROT_READ | PROT_WRITE);
+		void* const	map			= ::mmap(NULL, bytes, protection, MAP_SHARED, mnFile, 0);
+
+		if (map == MAP_FAILED)
+			doThrowErrno("merkol::mmap_vector -- mmap");
+		doAdopt(map, bytes, n);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doAdopt(void* map, size_type bytes, size_type n)
+	{
+		mpMap		= static_cast<unsigned char*>(map);
+		mnMapBytes	= bytes;
+		mpBegin		= reinterpret_cast<pointer>(mpMap + kHeaderSize);
+		mpEnd		= mpBegin + n;
+		mpCapacity	= mpBegin + (bytes - kHeaderSize) / sizeof(T);
+	}
+
+	// Moves the mapping to the new length of the file, wherever it fits: mremap on Linux, which keeps
+	// the pages mapped, a new mapping elsewhere.
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doRemap(size_type bytes)
+	{
+	#ifdef __linux__
+		void* const map = ::mremap(mpMap, mnMapBytes, bytes, MREMAP_MAYMOVE);
+	#else
+		void* const map = ::mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, mnFile, 0);
+	#endif
+
+		if (map == MAP_FAILED)
+			doThrowErrno("merkol::mmap_vector -- remap");
+	#ifndef __linux__
+		::munmap(mpMap, mnMapBytes);
+	#endif
+		doAdopt(map, bytes, size());
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doClose() M_NOEXCEPT
+	{
+		if (mpMap != NULL)
+			::munmap(mpMap, mnMapBytes);
+		if (mnFile >= 0)
+			::close(mnFile);
+		mnFile		= -1;
+		mpMap		= NULL;
+		mnMapBytes	= 0;
+		mpBegin		= NULL;
+		mpEnd		= NULL;
+		mpCapacity	= NULL;
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline void MERKOL_MMAP_VECTOR::doCheckWritable() const
+	{
+		if (mbReadOnly)
+			throw std::logic_error("merkol::mmap_vector -- read only");
+	}
+
+	// Sets the file, and the mapping, to a capacity of n elements. A longer file is mapped after it is
+	// extended, a shorter one truncated after the mapping is, so that no page of the mapping is ever
+	// past the end of the file (touching it would raise SIGBUS).
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doResizeFile(size_type n)
+	{
+		const size_type bytes = doFileBytes(n);
+
+		if (bytes > mnMapBytes)
+		{
+			if (::ftruncate(mnFile, (off_t)bytes) != 0)
+				doThrowErrno("merkol::mmap_vector -- ftruncate");
+			try
+			{
+				doRemap(bytes);
+			}
+			catch (...)
+			{
+				// Back to the mapped length. If that fails too, the file is only longer than its capacity.
+				(void)!::ftruncate(mnFile, (off_t)mnMapBytes);
+				throw;
+			}
+		}
+		else if (bytes < mnMapBytes)
+		{
+			doRemap(bytes);
+			if (::ftruncate(mnFile, (off_t)bytes) != 0)
+				doThrowErrno("merkol::mmap_vector -- ftruncate");
+		}
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::doGrow(size_type minCapacity)
+	{
+		if (minCapacity > max_size())
+			throw std::length_error("merkol::mmap_vector -- requested size exceeds max_size()");
+
+		size_type newCapacity = GrowthPolicy::grow(capacity(), sizeof(T));
+
+		if ((newCapacity < minCapacity) || (newCapacity > max_size()))
+			newCapacity = (minCapacity > newCapacity) ? minCapacity : max_size();
+		doResizeFile(newCapacity);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline typename MERKOL_MMAP_VECTOR::reference
+	MERKOL_MMAP_VECTOR::at(size_type n)
+	{
+		if (n >= size())
+			throw std::out_of_range("merkol::mmap_vector -- out of range");
+		return mpBegin[n];
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline typename MERKOL_MMAP_VECTOR::const_reference
+	MERKOL_MMAP_VECTOR::at(size_type n) const
+	{
+		if (n >= size())
+			throw std::out_of_range("merkol::mmap_vector -- out of range");
+		return mpBegin[n];
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::reserve(size_type n)
+	{
+		doCheckWritable();
+		if (n > max_size())
+			throw std::length_error("merkol::mmap_vector -- requested size exceeds max_size()");
+		if (n > capacity())
+			doResizeFile(n);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::shrink_to_fit()
+	{
+		doCheckWritable();
+		doResizeFile(size());
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline void MERKOL_MMAP_VECTOR::clear()
+	{
+		doCheckWritable();
+		doSetEnd(mpBegin);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline void MERKOL_MMAP_VECTOR::push_back(const value_type& value)
+	{
+		doCheckWritable();
+		if (mpEnd == mpCapacity)
+		{
+			const value_type copy(value);	// value may be an element, which growing moves
+
+			doGrow(size() + 1);
+			*mpEnd = copy;
+		}
+		else
+			*mpEnd = value;
+		doSetEnd(mpEnd + 1);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	template <typename... Args>
+	inline typename MERKOL_MMAP_VECTOR::reference
+	MERKOL_MMAP_VECTOR::emplace_back(Args&&... args)
+	{
+		const value_type value(std::forward<Args>(args)...);
+
+		push_back(value);
+		return back();
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	inline void MERKOL_MMAP_VECTOR::pop_back()
+	{
+		doCheckWritable();
+		doSetEnd(mpEnd - 1);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::resize(size_type n)
+	{
+		doCheckWritable();
+		if (n > capacity())
+			doGrow(n);
+		if (n > size())
+			merkol::uninitialized_value_construct_n(mpEnd, n - size());
+		doSetEnd(mpBegin + n);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::resize(size_type n, const value_type& value)
+	{
+		const value_type copy(value);
+
+		doCheckWritable();
+		if (n > capacity())
+			doGrow(n);
+		for (pointer p = mpEnd; p < mpBegin + n; ++p)
+			*p = copy;
+		doSetEnd(mpBegin + n);
+	}
+
+	// Opens a gap of n elements at pos, growing if needed, and returns it. The size includes the gap.
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	typename MERKOL_MMAP_VECTOR::pointer
+	MERKOL_MMAP_VECTOR::doMakeGap(const_iterator pos, size_type n)
+	{
+		const size_type index = (size_type)(pos.base() - mpBegin);
+
+		doCheckWritable();
+		if (n > max_size() - size())
+			throw std::length_error("merkol::mmap_vector -- requested size exceeds max_size()");
+		if (size() + n > capacity())
+			doGrow(size() + n);
+
+		pointer const gap = mpBegin + index;
+
+		std::memmove(static_cast<void*>(gap + n), static_cast<const void*>(gap), (size_type)(mpEnd - gap) * sizeof(T));
+		doSetEnd(mpEnd + n);
+		return gap;
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	typename MERKOL_MMAP_VECTOR::iterator
+	MERKOL_MMAP_VECTOR::insert(const_iterator pos, size_type n, const value_type& value)
+	{
+		const value_type	copy(value);
+		pointer const		gap = doMakeGap(pos, n);
+
+		for (size_type i = 0; i < n; ++i)
+			gap[i] = copy;
+		return iterator(gap);
+	}
+
+	// The range must not be in the vector itself.
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	template <typename ForwardIterator, typename>
+	typename MERKOL_MMAP_VECTOR::iterator
+	MERKOL_MMAP_VECTOR::insert(const_iterator pos, ForwardIterator first, ForwardIterator last)
+	{
+		const size_type	n	= (size_type)std::distance(first, last);
+		pointer const	gap	= doMakeGap(pos, n);
+
+		std::copy(first, last, gap);
+		return iterator(gap);
+	}
+
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	typename MERKOL_MMAP_VECTOR::iterator
+	MERKOL_MMAP_VECTOR::erase(const_iterator first, const_iterator last)
+	{
+		pointer const gap = mpBegin + (first.base() - mpBegin);
+
+		doCheckWritable();
+		std::memmove(static_cast<void*>(gap), static_cast<const void*>(last.base()), (size_type)(mpEnd - last.base()) * sizeof(T));
+		doSetEnd(mpEnd - (last.base() - first.base()));
+		return iterator(gap);
+	}
+
+	// Writes the modified pages of the file back to the disk, and waits for it unless !wait.
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	void MERKOL_MMAP_VECTOR::sync(bool wait)
+	{
+		if (mbReadOnly || (mpMap == NULL))
+			return;
+		if (::msync(mpMap, mnMapBytes, wait ? MS_SYNC : MS_ASYNC) != 0)
+			doThrowErrno("merkol::mmap_vector -- msync");
+	}
+
+	// A hint only: returns false if madvise refused it.
+	MERKOL_MMAP_VECTOR_TEMPLATE
+	bool MERKOL_MMAP_VECTOR::advise(mmap_advice advice)
+	{
+		static const int kAdvice[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED, MADV_DONTNEED };
+
+		return (mpMap != NULL) && (::madvise(mpMap, mnMapBytes, kAdvice[advice]) == 0);
+	}
+
+# undef MERKOL_MMAP_VECTOR_TEMPLATE
+# undef MERKOL_MMAP_VECTOR
+
+	///////////////////////////////////////////////////////////////////////
+	// MmapVector.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename T, typename GrowthPolicy>
+	inline void swap(mmap_vector<T, GrowthPolicy>& a, mmap_vector<T, GrowthPolicy>& b) M_NOEXCEPT
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_MMAP_VECTOR_HPP
@@ -0,0 +1,397 @@
+#ifndef MERKOL_MPMC_QUEUE_HPP
+# define MERKOL_MPMC_QUEUE_HPP
+
+#if __cplusplus < 201103L
+# error "mpmc_queue.hpp requires C++11"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdint.h>
+#include <utility>
+#include "../auxiliary/futex.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	mpmc_queue
+
+	A bounded queue for any number of producer and consumer threads, without locks (D. Vyukov's bounded
+	MPMC queue). The capacity is rounded up to a power of two. Every slot holds an element and a sequence
+	number that tells which turn the slot is at:
+
+		sequence == pos				free for the push that claims position pos
+		sequence == pos + 1			holds the element of position pos, for the pop that claims pos
+		sequence == pos + capacity	popped, free for the push of the next lap
+
+	A push reads the enqueue position, checks the slot's sequence and claims the position with a
+	compare-and-swap; then it constructs the element and publishes it by storing pos + 1 into the
+	sequence (release). A pop does the same with the dequeue position and stores pos + capacity once it
+	has moved the element out. Producers only contend with producers on the enqueue position and
+	consumers with consumers on the dequeue position; the two positions are MERKOL_CACHE_LINE_SIZE bytes
+	apart. A push that finds its slot still holding the previous lap's element reports the queue full,
+	a pop that finds its slot not yet published reports it empty: try_push and try_pop never wait.
+
+	push, emplace and pop block instead. They retry for a short while, then sleep on a futex (see
+	auxiliary/futex.hpp): a consumer counts itself in mPopWaiters, fences, tries once more and sleeps on
+	mPushEpoch; whichever way it leaves, it takes itself off the count again. While the count is not zero,
+	every push bumps the epoch and wakes one sleeper. The same goes for producers waiting for room. Only
+	the waiting thread changes its own registration, so the count never drops below the number of threads
+	that may be asleep; and since the other side checks it after a full fence, a wakeup can not be lost.
+	When nobody sleeps, which is the common case under load, the cost to the other side is that fence and
+	one load.
+
+	The slots come from the Allocator (rebound to the slot type) in one block, allocated by the
+	constructor. Slots are not padded to a cache line each: neighbouring slots written by different
+	threads at the same time share lines, a fair price for not multiplying the memory by eight for small
+	elements.
+
+	If constructing an element throws after its push claimed a position, the slot is published as a hole
+	that pops skip. If moving an element out throws, try_pop and pop destroy it, free its slot and
+	rethrow.
+*/
+
+namespace merkol
+{
+	/**
+	 * @brief mpmc_queue
+	 * Bounded multi producer, multi consumer queue with per slot sequence numbers (see above). All member
+	 * functions may be called from any thread, except the destructor.
+	 */
+	template <typename T, typename Allocator = std::allocator<T> >
+	class mpmc_queue
+	{
+	public:
+		typedef T																		value_type;
+		typedef T&																		reference;
+		typedef const T&																const_reference;
+		typedef std::size_t																size_type;
+		typedef Allocator																allocator_type;
+
+	public:
+		// capacity is rounded up to a power of two, at least 2.
+		explicit mpmc_queue(size_type capacity, const allocator_type& allocator = allocator_type());
+		~mpmc_queue();
+
+		mpmc_queue(const mpmc_queue&) = delete;
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+		// false when the queue is full (nothing is constructed) or empty.
+		bool			try_push(const value_type& value);
+		bool			try_push(value_type&& value);
+		template <typename... Args>
+		bool			try_emplace(Args&&... args);
+		bool			try_pop(value_type& value);
+
+		// Wait for room, or for an element.
+		void			push(const value_type& value);
+		void			push(value_type&& value);
+		template <typename... Args>
+		void			emplace(Args&&... args);
+		void			pop(value_type& value);
+
+		size_type		size() const M_NOEXCEPT;		// a snapshot
+		bool			empty() const M_NOEXCEPT { return size() == 0; }
+		size_type		capacity() const M_NOEXCEPT { return mMask + 1; }
+
+		allocator_type	get_allocator() const { return allocator_type(mAllocator); }
+
+	protected:
+		static const unsigned kSpins	= 64;	// failed tries before a blocking call sleeps
+
+		struct slot
+		{
+			std::atomic<size_type>		mSequence;
+			bool						mHole;		// the push of this position threw: no element
+			merkol::aligned_buffer<T>	mValue;
+
+			T*	value() { return reinterpret_cast<T*>(mValue.mBuffer); }
+		};
+
+		typedef typename Allocator::template rebind<slot>::other	slot_allocator_type;
+
+		// Read only after construction.
+		slot*					mpSlots;
+		size_type				mMask;
+		slot_allocator_type		mAllocator;
+
+		unsigned char			mPadEnqueue[MERKOL_CACHE_LINE_SIZE];
+		std::atomic<size_type>	mEnqueuePos;
+		unsigned char			mPadDequeue[MERKOL_CACHE_LINE_SIZE];
+		std::atomic<size_type>	mDequeuePos;
+		unsigned char			mPadWaiters[MERKOL_CACHE_LINE_SIZE];
+
+		// Only written while a thread sleeps or wakes others.
+		std::atomic<uint32_t>	mPushEpoch;		// consumers sleep on it
+		std::atomic<uint32_t>	mPopEpoch;		// producers sleep on it
+		std::atomic<uint32_t>	mPopWaiters;
+		std::atomic<uint32_t>	mPushWaiters;
+		unsigned char			mPadBack[MERKOL_CACHE_LINE_SIZE];
+
+		void			doNotify(std::atomic<uint32_t>& waiters, std::atomic<uint32_t>& epoch);
+	}; // mpmc_queue
+
+
+	///////////////////////////////////////////////////////////////////////
+	// MpmcQueue.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	#define MERKOL_MPMC_QUEUE_TEMPLATE	template <typename T, typename Allocator>
+	#define MERKOL_MPMC_QUEUE			mpmc_queue<T, Allocator>
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	const unsigned MERKOL_MPMC_QUEUE::kSpins;
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	MERKOL_MPMC_QUEUE::mpmc_queue(size_type capacity, const allocator_type& allocator)
+		: mpSlots(NULL), mMask(1), mAllocator(allocator)
+	{
+		while (mMask + 1 < capacity)
+			mMask = mMask * 2 + 1;
+		mpSlots = mAllocator.allocate(mMask + 1);
+		for (size_type i = 0; i <= mMask; ++i)
+			::new(static_cast<void*>(&mpSlots[i].mSequence)) std::atomic<size_type>(i);
+		mEnqueuePos.store(0, std::memory_order_relaxed);
+		mDequeuePos.store(0, std::memory_order_relaxed);
+		mPushEpoch.store(0, std::memory_order_relaxed);
+		mPopEpoch.store(0, std::memory_order_relaxed);
+		mPopWaiters.store(0, std::memory_order_relaxed);
+		mPushWaiters.store(0, std::memory_order_relaxed);
+	}
+
+	// Destroys the elements left. No other thread may use the queue any more.
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	MERKOL_MPMC_QUEUE::~mpmc_queue()
+	{
+		const size_type end = mEnqueuePos.load(std::memory_order_acquire);
+
+		for (size_type pos = mDequeuePos.load(std::memory_order_relaxed); pos != end; ++pos)
+		{
+			if (!mpSlots[pos & mMask].mHole)
+				mpSlots[pos & mMask].value()->~value_type();
+		}
+		mAllocator.deallocate(mpSlots, mMask + 1);
+	}
+
+	// After a push (or a pop): wakes one thread sleeping for it, if any. The fence orders the publication
+	// of the slot before the load of the count; a sleeper registers then fences before its last try.
+	// The count is left alone: a woken thread takes itself off, so pushes made before it gets to run wake
+	// further sleepers, each with a system call, rather than none at all.
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	inline void MERKOL_MPMC_QUEUE::doNotify(std::atomic<uint32_t>& waiters, std::atomic<uint32_t>& epoch)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waiters.load(std::memory_order_relaxed) != 0)
+		{
+			epoch.fetch_add(1, std::memory_order_relaxed);
+			merkol::futex_wake(epoch, 1);
+		}
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	inline bool MERKOL_MPMC_QUEUE::try_push(const value_type& value)
+	{
+		return try_emplace(value);
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	inline bool MERKOL_MPMC_QUEUE::try_push(value_type&& value)
+	{
+		return try_emplace(std::move(value));
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	template <typename... Args>
+	bool MERKOL_MPMC_QUEUE::try_emplace(Args&&... args)
+	{
+		size_type	pos	= mEnqueuePos.load(std::memory_order_relaxed);
+		slot*		s;
+
+		for (;;)
+		{
+			s = &mpSlots[pos & mMask];
+
+			const std::ptrdiff_t turn = (std::ptrdiff_t)(s->mSequence.load(std::memory_order_acquire) - pos);
+
+			if (turn == 0)
+			{
+				if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (turn < 0)
+				return false;		// the previous lap's element is still there: full
+			else
+				pos = mEnqueuePos.load(std::memory_order_relaxed);
+		}
+
+		try
+		{
+			::new(static_cast<void*>(s->value())) value_type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			// The position is claimed and later ones may be too: publish it as a hole, which the pop
+			// that claims it skips.
+			s->mHole = true;
+			s->mSequence.store(pos + 1, std::memory_order_release);
+			doNotify(mPopWaiters, mPushEpoch);
+			throw;
+		}
+		s->mHole = false;
+		s->mSequence.store(pos + 1, std::memory_order_release);
+		doNotify(mPopWaiters, mPushEpoch);
+		return true;
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	bool MERKOL_MPMC_QUEUE::try_pop(value_type& value)
+	{
+		size_type	pos	= mDequeuePos.load(std::memory_order_relaxed);
+		slot*		s;
+
+		for (;;)
+		{
+			s = &mpSlots[pos & mMask];
+
+			const std::ptrdiff_t turn = (std::ptrdiff_t)(s->mSequence.load(std::memory_order_acquire) - (pos + 1));
+
+			if (turn == 0)
+			{
+				if (!mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					continue;
+				if (!s->mHole)
+					break;
+				s->mSequence.store(pos + mMask + 1, std::memory_order_release);
+				doNotify(mPushWaiters, mPopEpoch);
+				pos = mDequeuePos.load(std::memory_order_relaxed);
+			}
+			else if (turn < 0)
+				return false;		// not published yet: empty
+			else
+				pos = mDequeuePos.load(std::memory_order_relaxed);
+		}
+
+		value_type* const element = s->value();
+
+		try
+		{
+			value = std::move(*element);
+		}
+		catch (...)
+		{
+			element->~value_type();
+			s->mSequence.store(pos + mMask + 1, std::memory_order_release);
+			doNotify(mPushWaiters, mPopEpoch);
+			throw;
+		}
+		element->~value_type();
+		s->mSequence.store(pos + mMask + 1, std::memory_order_release);
+		doNotify(mPushWaiters, mPopEpoch);
+		return true;
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	inline void MERKOL_MPMC_QUEUE::push(const value_type& value)
+	{
+		emplace(value);
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	inline void MERKOL_MPMC_QUEUE::push(value_type&& value)
+	{
+		emplace(std::move(value));
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	template <typename... Args>
+	void MERKOL_MPMC_QUEUE::emplace(Args&&... args)
+	{
+		for (unsigned spins = 0; ; ++spins)
+		{
+			// try_emplace only forwards args once it has claimed a slot, so they are still intact here.
+			if (try_emplace(std::forward<Args>(args)...))
+				return;
+			if (spins < kSpins)
+			{
+				merkol::cpu_relax();
+				continue;
+			}
+
+			const uint32_t	epoch = mPopEpoch.load(std::memory_order_relaxed);
+			bool			done;
+
+			mPushWaiters.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			try
+			{
+				done = try_emplace(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				mPushWaiters.fetch_sub(1, std::memory_order_relaxed);
+				throw;
+			}
+			if (!done)
+				merkol::futex_wait(mPopEpoch, epoch);
+			mPushWaiters.fetch_sub(1, std::memory_order_relaxed);		// this thread's own registration only
+			if (done)
+				return;
+		}
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	void MERKOL_MPMC_QUEUE::pop(value_type& value)
+	{
+		for (unsigned spins = 0; ; ++spins)
+		{
+			if (try_pop(value))
+				return;
+			if (spins < kSpins)
+			{
+				merkol::cpu_relax();
+				continue;
+			}
+
+			const uint32_t	epoch = mPushEpoch.load(std::memory_order_relaxed);
+			bool			done;
+
+			mPopWaiters.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			try
+			{
+				done = try_pop(value);
+			}
+			catch (...)
+			{
+				mPopWaiters.fetch_sub(1, std::memory_order_relaxed);
+				throw;
+			}
+			if (!done)
+				merkol::futex_wait(mPushEpoch, epoch);
+			mPopWaiters.fetch_sub(1, std::memory_order_relaxed);		// this thread's own registration only
+			if (done)
+				return;
+		}
+	}
+
+	MERKOL_MPMC_QUEUE_TEMPLATE
+	typename MERKOL_MPMC_QUEUE::size_type MERKOL_MPMC_QUEUE::size() const M_NOEXCEPT
+	{
+		const size_type dequeued	= mDequeuePos.load(std::memory_order_acquire);
+		const size_type enqueued	= mEnqueuePos.load(std::memory_order_acquire);
+		const size_type n			= enqueued - dequeued;
+
+		return ((std::ptrdiff_t)n < 0) ? 0 : (n > mMask + 1) ? mMask + 1 : n;
+	}
+
+	#undef MERKOL_MPMC_QUEUE_TEMPLATE
+	#undef MERKOL_MPMC_QUEUE
+
+	///////////////////////////////////////////////////////////////////////
+	// MpmcQueue.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+} // namespace merkol
+
+#endif // MERKOL_MPMC_QUEUE_HPP
@@ -0,0 +1,667 @@
+#ifndef MERKOL_PRIORITY_QUEUE_HPP
+# define MERKOL_PRIORITY_QUEUE_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include "vector.hpp"
+#include "../aux_templates/algorithm.hpp"
+#include "../aux_templates/functional.hpp"
+#include "../aux_templates/type_traits.hpp"
+
+/*
+	d_ary_heap, priority_queue, indexed_heap
+
+	A d-ary heap is an array in which the element at i is not ordered before (by Compare) any of its D
+	children at D i + 1 ... D i + D; the top, the largest element, is at 0. Compared with a binary heap:
+		- it is log2(D) times shallower, so a push climbs fewer levels and a pop walks down fewer levels;
+		- the children of a node are contiguous: with D = 4 and 8 byte elements they take 32 bytes, at
+		  most two cache lines and usually one, where a binary heap larger than the cache misses on
+		  every level;
+		- each level of a pop costs D - 1 comparisons to find the largest child instead of 1.
+	D = 4 is the usual optimum for elements of a few words (A. LaMarca and R. Ladner, "The Influence of
+	Caches on the Performance of Heaps"). std::priority_queue is a binary heap.
+
+	pop is Floyd's bottom-up sift: the hole left by the top walks down to a leaf along the largest
+	children without looking at the last element, which then climbs back up from that leaf. The last
+	element of a heap almost always belongs near the bottom, so this saves nearly one comparison per
+	level. replace_top (pop then push of a new element, the step of an event loop or a scheduler) sifts
+	the new element down from the top once.
+
+	priority_queue has the interface and template parameters of std::priority_queue, on a binary
+	d_ary_heap. Both work on data() of their container, without the bounds checks of
+	merkol::vector::operator[].
+
+	indexed_heap is a d-ary heap whose elements are addressed by a handle, returned by push and valid
+	until the element leaves the heap (the handle is then reused). A table from handle to position in
+	the heap, updated on every move, gives decrease_key, update and erase in O(log n). Dijkstra's
+	algorithm or a timer queue can then change the priority of a queued element in place, instead of
+	pushing a second copy and skipping the stale one when it comes out ("lazy deletion"), which lets
+	the heap grow up to the number of edges. Every element is stored with its handle, so that sifting
+	compares elements of the heap array only.
+*/
+
+namespace merkol
+{
+	// Position of the largest of the children [first, first + D) of a node, cut at n. The selection
+	// is written as a conditional move: which child is largest is a coin toss on random keys.
+	template <std::size_t D, typename T, typename Compare>
+	inline std::size_t d_ary_largest_child(const T* heap, std::size_t first, std::size_t n, Compare& comp)
+	{
+		std::size_t largest = first;
+
+		if (first + D <= n)		// all D children, a loop of constant length
+		{
+			for (std::size_t i = first + 1; i < first + D; ++i)
+				largest = comp(heap[largest], heap[i]) ? i : largest;
+		}
+		else
+		{
+			for (std::size_t i = first + 1; i < n; ++i)
+				largest = comp(heap[largest], heap[i]) ? i : largest;
+		}
+		return largest;
+	}
+
+	/**
+	 * @brief d_ary_heap
+	 * Max-heap (by Compare) of D-ary nodes over a contiguous container (see above).
+	 *
+	 * @tparam D number of children per node, at least 2
+	 * @tparam Compare strict weak ordering; top() is an element no other one is ordered after
+	 * @tparam Container contiguous sequence of T with data(), push_back and pop_back
+	 */
+	template <typename T, std::size_t D = 4, typename Compare = merkol::less<T>, typename Container = merkol::vector<T> >
+	class d_ary_heap
+	{
+		typedef d_ary_heap<T, D, Compare, Container>	this_type;
+
+	public:
+		typedef typename Container::value_type			value_type;
+		typedef Container								container_type;
+		typedef Compare									value_compare;
+		typedef typename Container::size_type			size_type;
+		typedef const value_type&						reference;
+		typedef const value_type&						const_reference;
+
+		static const std::size_t kArity = D;
+
+	protected:
+		Container	mContainer;
+		Compare		mCompare;
+
+	public:
+		d_ary_heap() : mContainer(), mCompare() { }
+		explicit d_ary_heap(const value_compare& compare) : mContainer(), mCompare(compare) { }
+
+		// Builds the heap from container in O(n).
+		d_ary_heap(const value_compare& compare, const container_type& container) : mContainer(container), mCompare(compare)
+		{
+			doMakeHeap();
+		}
+
+		template <typename InputIterator>
+		d_ary_heap(InputIterator first, InputIterator last, const value_compare& compare = value_compare())
+			: mContainer(), mCompare(compare)
+		{
+			mContainer.insert(mContainer.end(), first, last);
+			doMakeHeap();
+		}
+
+		// Capacity
+		bool		empty() const { return mContainer.empty(); }
+		size_type	size() const { return mContainer.size(); }
+		size_type	capacity() const { return mContainer.capacity(); }
+		void		reserve(size_type n) { mContainer.reserve(n); }
+
+		// Element access
+		const_reference	top() const { return *mContainer.data(); }
+
+		// The heap array: top first, then the levels one after the other.
+		const container_type&	container() const { return mContainer; }
+
+		// Modifiers
+		void	push(const value_type& value);
+	#if __cplusplus >= 201103L
+		void	push(value_type&& value);
+
+		template <typename... Args>
+		void	emplace(Args&&... args);
+	#endif
+		void	pop();
+		void	replace_top(const value_type& value);
+	#if __cplusplus >= 201103L
+		void	replace_top(value_type&& value);
+	#endif
+		void	clear() { mContainer.clear(); }
+		void	swap(this_type& other);
+
+		// Observers
+		value_compare	value_comp() const { return mCompare; }
+
+	protected:
+		value_type*	doData() { return mContainer.data(); }
+
+		void	doSiftUp(size_type i);
+		void	doSiftDown(size_type i, value_type& value);
+		void	doMakeHeap();
+	}; // d_ary_heap
+
+
+	///////////////////////////////////////////////////////////////////////
+	// DAryHeap.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+# define MERKOL_D_ARY_HEAP_TEMPLATE		template <typename T, std::size_t D, typename Compare, typename Container>
+# define MERKOL_D_ARY_HEAP				d_ary_heap<T, D, Compare, Container>
+
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	const std::size_t MERKOL_D_ARY_HEAP::kArity;
+
+	// Moves the element at i up to its place.
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	void MERKOL_D_ARY_HEAP::doSiftUp(size_type i)
+	{
+		value_type* const	heap = doData();
+		value_type			value(MERKOL_MOVE(heap[i]));
+
+		while (i > 0)
+		{
+			const size_type parent = (i - 1) / D;
+
+			if (!mCompare(heap[parent], value))
+				break;
+			heap[i] = MERKOL_MOVE(heap[parent]);
+			i = parent;
+		}
+		heap[i] = MERKOL_MOVE(value);
+	}
+
+	// Fills the hole at i with value, moving larger children up as long as there are.
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	void MERKOL_D_ARY_HEAP::doSiftDown(size_type i, value_type& value)
+	{
+		value_type* const	heap	= doData();
+		const size_type		n		= mContainer.size();
+
+		for (size_type child = i * D + 1; child < n; child = i * D + 1)
+		{
+			const size_type largest = merkol::d_ary_largest_child<D>(heap, child, n, mCompare);
+
+			if (!mCompare(value, heap[largest]))
+				break;
+			heap[i] = MERKOL_MOVE(heap[largest]);
+			i = largest;
+		}
+		heap[i] = MERKOL_MOVE(value);
+	}
+
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	void MERKOL_D_ARY_HEAP::doMakeHeap()
+	{
+		const size_type n = mContainer.size();
+
+		if (n < 2)
+			return;
+		for (size_type i = (n - 2) / D + 1; i-- > 0; )
+		{
+			value_type value(MERKOL_MOVE(doData()[i]));
+
+			doSiftDown(i, value);
+		}
+	}
+
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	inline void MERKOL_D_ARY_HEAP::push(const value_type& value)
+	{
+		mContainer.push_back(value);
+		doSiftUp(mContainer.size() - 1);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	inline void MERKOL_D_ARY_HEAP::push(value_type&& value)
+	{
+		mContainer.push_back(std::move(value));
+		doSiftUp(mContainer.size() - 1);
+	}
+
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	template <typename... Args>
+	inline void MERKOL_D_ARY_HEAP::emplace(Args&&... args)
+	{
+		mContainer.emplace_back(std::forward<Args>(args)...);
+		doSiftUp(mContainer.size() - 1);
+	}
+#endif
+
+	// Floyd's pop: the hole walks down to a leaf, then the last element climbs up from there.
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	void MERKOL_D_ARY_HEAP::pop()
+	{
+		const size_type n = mContainer.size() - 1;
+
+		if (n == 0)
+		{
+			mContainer.pop_back();
+			return;
+		}
+
+		value_type* const	heap = doData();
+		value_type			last(MERKOL_MOVE(heap[n]));
+		size_type			hole = 0;
+
+		mContainer.pop_back();
+		for (size_type child = 1; child < n; child = hole * D + 1)
+		{
+			const size_type largest = merkol::d_ary_largest_child<D>(heap, child, n, mCompare);
+
+			heap[hole] = MERKOL_MOVE(heap[largest]);
+			hole = largest;
+		}
+		while (hole > 0)
+		{
+			const size_type parent = (hole - 1) / D;
+
+			if (!mCompare(heap[parent], last))
+				break;
+			heap[hole] = MERKOL_MOVE(heap[parent]);
+			hole = parent;
+		}
+		heap[hole] = MERKOL_MOVE(last);
+	}
+
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	inline void MERKOL_D_ARY_HEAP::replace_top(const value_type& value)
+	{
+		value_type copy(value);
+
+		doSiftDown(0, copy);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	inline void MERKOL_D_ARY_HEAP::replace_top(value_type&& value)
+	{
+		doSiftDown(0, value);
+	}
+#endif
+
+	MERKOL_D_ARY_HEAP_TEMPLATE
+	inline void MERKOL_D_ARY_HEAP::swap(this_type& other)
+	{
+		mContainer.swap(other.mContainer);
+		merkol::swap(mCompare, other.mCompare);
+	}
+
+# undef MERKOL_D_ARY_HEAP_TEMPLATE
+# undef MERKOL_D_ARY_HEAP
+
+	///////////////////////////////////////////////////////////////////////
+	// DAryHeap.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename T, std::size_t D, typename Compare, typename Container>
+	inline void swap(d_ary_heap<T, D, Compare, Container>& a, d_ary_heap<T, D, Compare, Container>& b)
+	{
+		a.swap(b);
+	}
+
+
+	/**
+	 * @brief priority_queue
+	 * std::priority_queue on a binary d_ary_heap (see above).
+	 *
+	 * @tparam Container contiguous sequence of T with data(), push_back and pop_back
+	 * @tparam Compare strict weak ordering; top() is an element no other one is ordered after
+	 */
+	template <typename T, typename Container = merkol::vector<T>, typename Compare = merkol::less<typename Container::value_type> >
+	class priority_queue : public d_ary_heap<T, 2, Compare, Container>
+	{
+		typedef d_ary_heap<T, 2, Compare, Container>	base_type;
+
+	public:
+		typedef typename base_type::value_compare		value_compare;
+		typedef typename base_type::container_type		container_type;
+
+		priority_queue() : base_type() { }
+		explicit priority_queue(const value_compare& compare) : base_type(compare) { }
+		priority_queue(const value_compare& compare, const container_type& container) : base_type(compare, container) { }
+
+		template <typename InputIterator>
+		priority_queue(InputIterator first, InputIterator last, const value_compare& compare = value_compare())
+			: base_type(first, last, compare) { }
+	}; // priority_queue
+
+	template <typename T, typename Container, typename Compare>
+	inline void swap(priority_queue<T, Container, Compare>& a, priority_queue<T, Container, Compare>& b)
+	{
+		a.swap(b);
+	}
+
+
+	/**
+	 * @brief indexed_heap
+	 * D-ary max-heap (by Compare) whose elements are addressed by handles (see above). With
+	 * merkol::greater it is a min-heap, the usual queue of Dijkstra's algorithm.
+	 *
+	 * @tparam D number of children per node, at least 2
+	 * @tparam Compare strict weak ordering; top() is an element no other one is ordered after
+	 */
+	template <typename T, std::size_t D = 4, typename Compare = merkol::less<T> >
+	class indexed_heap
+	{
+		typedef indexed_heap<T, D, Compare>	this_type;
+
+	public:
+		typedef T								value_type;
+		typedef Compare							value_compare;
+		typedef std::size_t						size_type;
+		typedef std::size_t						handle_type;
+		typedef const T&						reference;
+		typedef const T&						const_reference;
+
+		static const handle_type kInvalidHandle = (handle_type)-1;
+
+	protected:
+		struct entry
+		{
+			T			mValue;
+			handle_type	mHandle;
+
+			entry(const T& value, handle_type handle) : mValue(value), mHandle(handle) { }
+		#if __cplusplus >= 201103L
+			entry(T&& value, handle_type handle) : mValue(std::move(value)), mHandle(handle) { }
+		#endif
+		};
+
+		// Orders entries by value.
+		struct entry_compare
+		{
+			Compare	mCompare;
+
+			explicit entry_compare(const Compare& compare) : mCompare(compare) { }
+			bool operator()(const entry& a, const entry& b) const { return mCompare(a.mValue, b.mValue); }
+		};
+
+		merkol::vector<entry>		mHeap;
+		merkol::vector<size_type>	mPositions;	// heap position of every handle, kInvalidHandle if free
+		merkol::vector<handle_type>	mFree;		// free handles, reused last in first out
+		entry_compare				mCompare;
+
+	public:
+		indexed_heap() : mHeap(), mPositions(), mFree(), mCompare(Compare()) { }
+		explicit indexed_heap(const value_compare& compare) : mHeap(), mPositions(), mFree(), mCompare(compare) { }
+
+		// Capacity
+		bool		empty() const { return mHeap.empty(); }
+		size_type	size() const { return mHeap.size(); }
+		void		reserve(size_type n);
+
+		// Element access
+		const_reference	top() const { return mHeap.data()->mValue; }
+		handle_type		top_handle() const { return mHeap.data()->mHandle; }
+
+		// True if handle is the handle of an element in the heap.
+		bool			contains(handle_type handle) const;
+
+		// The element of handle; throws std::out_of_range if handle is not in the heap.
+		const_reference	operator[](handle_type handle) const { return mHeap.data()[doPosition(handle)].mValue; }
+
+		// Modifiers
+		handle_type	push(const value_type& value);
+	#if __cplusplus >= 201103L
+		handle_type	push(value_type&& value);
+	#endif
+		void		pop();
+
+		// Replaces the element of handle with value, which must not be ordered before it: value moves
+		// toward the top only (with merkol::greater, a smaller key).
+		void		decrease_key(handle_type handle, const value_type& value);
+
+		// Replaces the element of handle with value, in either direction.
+		void		update(handle_type handle, const value_type& value);
+
+		void		erase(handle_type handle);
+		void		clear();
+		void		swap(this_type& other);
+
+		// Observers
+		value_compare	value_comp() const { return mCompare.mCompare; }
+
+	protected:
+		size_type	doPosition(handle_type handle) const;
+		handle_type	doAcquireHandle();
+		void		doReleaseHandle(handle_type handle);
+		void		doPlace(entry* heap, size_type i, entry& e) { heap[i] = MERKOL_MOVE(e); mPositions.data()[heap[i].mHandle] = i; }
+		void		doSiftUp(size_type i);
+		void		doSiftDown(size_type i);
+		void		doRemoveAt(size_type i);
+	}; // indexed_heap
+
+
+	///////////////////////////////////////////////////////////////////////
+	// IndexedHeap.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+# define MERKOL_INDEXED_HEAP_TEMPLATE	template <typename T, std::size_t D, typename Compare>
+# define MERKOL_INDEXED_HEAP			indexed_heap<T, D, Compare>
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	const typename MERKOL_INDEXED_HEAP::handle_type MERKOL_INDEXED_HEAP::kInvalidHandle;
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline void MERKOL_INDEXED_HEAP::reserve(size_type n)
+	{
+		mHeap.reserve(n);
+		mPositions.reserve(n);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline bool MERKOL_INDEXED_HEAP::contains(handle_type handle) const
+	{
+		return (handle < mPositions.size()) && (mPositions.data()[handle] != kInvalidHandle);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline typename MERKOL_INDEXED_HEAP::size_type
+	MERKOL_INDEXED_HEAP::doPosition(handle_type handle) const
+	{
+		if (!contains(handle))
+			throw std::out_of_range("merkol::indexed_heap -- invalid handle");
+		return mPositions.data()[handle];
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline typename MERKOL_INDEXED_HEAP::handle_type
+	MERKOL_INDEXED_HEAP::doAcquireHandle()
+	{
+		if (mFree.empty())
+		{
+			mPositions.push_back(kInvalidHandle);
+			return mPositions.size() - 1;
+		}
+
+		const handle_type handle = mFree.back();
+
+		mFree.pop_back();
+		return handle;
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline void MERKOL_INDEXED_HEAP::doReleaseHandle(handle_type handle)
+	{
+		mPositions.data()[handle] = kInvalidHandle;
+		mFree.push_back(handle);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	void MERKOL_INDEXED_HEAP::doSiftUp(size_type i)
+	{
+		entry* const	heap = mHeap.data();
+		entry			e(MERKOL_MOVE(heap[i]));
+
+		while (i > 0)
+		{
+			const size_type parent = (i - 1) / D;
+
+			if (!mCompare(heap[parent], e))
+				break;
+			doPlace(heap, i, heap[parent]);
+			i = parent;
+		}
+		doPlace(heap, i, e);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	void MERKOL_INDEXED_HEAP::doSiftDown(size_type i)
+	{
+		entry* const	heap	= mHeap.data();
+		const size_type	n		= mHeap.size();
+		entry			e(MERKOL_MOVE(heap[i]));
+
+		for (size_type child = i * D + 1; child < n; child = i * D + 1)
+		{
+			const size_type largest = merkol::d_ary_largest_child<D>(heap, child, n, mCompare);
+
+			if (!mCompare(e, heap[largest]))
+				break;
+			doPlace(heap, i, heap[largest]);
+			i = largest;
+		}
+		doPlace(heap, i, e);
+	}
+
+	// Removes the entry at i: the last entry takes its place and moves up or down from there.
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	void MERKOL_INDEXED_HEAP::doRemoveAt(size_type i)
+	{
+		const size_type last = mHeap.size() - 1;
+
+		doReleaseHandle(mHeap.data()[i].mHandle);
+		if (i != last)
+		{
+			entry* const heap = mHeap.data();
+
+			doPlace(heap, i, heap[last]);
+		}
+		mHeap.pop_back();
+		if (i == last)
+			return;
+		if ((i > 0) && mCompare(mHeap.data()[(i - 1) / D], mHeap.data()[i]))
+			doSiftUp(i);
+		else
+			doSiftDown(i);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	typename MERKOL_INDEXED_HEAP::handle_type
+	MERKOL_INDEXED_HEAP::push(const value_type& value)
+	{
+		const handle_type handle = doAcquireHandle();
+
+		try
+		{
+			mHeap.push_back(entry(value, handle));
+		}
+		catch (...)
+		{
+			doReleaseHandle(handle);
+			throw;
+		}
+		mPositions.data()[handle] = mHeap.size() - 1;
+		doSiftUp(mHeap.size() - 1);
+		return handle;
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	typename MERKOL_INDEXED_HEAP::handle_type
+	MERKOL_INDEXED_HEAP::push(value_type&& value)
+	{
+		const handle_type handle = doAcquireHandle();
+
+		try
+		{
+			mHeap.push_back(entry(std::move(value), handle));
+		}
+		catch (...)
+		{
+			doReleaseHandle(handle);
+			throw;
+		}
+		mPositions.data()[handle] = mHeap.size() - 1;
+		doSiftUp(mHeap.size() - 1);
+		return handle;
+	}
+#endif
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline void MERKOL_INDEXED_HEAP::pop()
+	{
+		doRemoveAt(0);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline void MERKOL_INDEXED_HEAP::decrease_key(handle_type handle, const value_type& value)
+	{
+		const size_type i = doPosition(handle);
+
+		mHeap.data()[i].mValue = value;
+		doSiftUp(i);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	void MERKOL_INDEXED_HEAP::update(handle_type handle, const value_type& value)
+	{
+		const size_type	i		= doPosition(handle);
+		entry* const	heap	= mHeap.data();
+		const bool		up		= mCompare.mCompare(heap[i].mValue, value);
+
+		heap[i].mValue = value;
+		if (up)
+			doSiftUp(i);
+		else
+			doSiftDown(i);
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	inline void MERKOL_INDEXED_HEAP::erase(handle_type handle)
+	{
+		doRemoveAt(doPosition(handle));
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	void MERKOL_INDEXED_HEAP::clear()
+	{
+		mHeap.clear();
+		mPositions.clear();
+		mFree.clear();
+	}
+
+	MERKOL_INDEXED_HEAP_TEMPLATE
+	void MERKOL_INDEXED_HEAP::swap(this_type& other)
+	{
+		mHeap.swap(other.mHeap);
+		mPositions.swap(other.mPositions);
+		mFree.swap(other.mFree);
+		merkol::swap(mCompare, other.mCompare);
+	}
+
+# undef MERKOL_INDEXED_HEAP_TEMPLATE
+# undef MERKOL_INDEXED_HEAP
+
+	///////////////////////////////////////////////////////////////////////
+	// IndexedHeap.imp.end();											///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename T, std::size_t D, typename Compare>
+	inline void swap(indexed_heap<T, D, Compare>& a, indexed_heap<T, D, Compare>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_PRIORITY_QUEUE_HPP
@@ -0,0 +1,1444 @@
+#ifndef MERKOL_RB_TREE_HPP
+# define MERKOL_RB_TREE_HPP
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+#if __cplusplus >= 201103L
+# include <tuple>
+#endif
+#include "vector.hpp"
+#include "../iterators/iterator.hpp"
+#include "../iterators/reverse_iterator.hpp"
+#include "../auxiliary/trace.hpp"
+#include "../aux_templates/algorithm.hpp"
+#include "../aux_templates/functional.hpp"
+#include "../aux_templates/type_traits.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	rb_tree
+
+	Red-black tree behind map, multimap, set and multiset. The layout is the classic one: an anchor node
+	lives in the container, its parent is the root, its left and right the leftmost and rightmost nodes,
+	and the root's parent is the anchor, so that begin() is O(1) and end() is the anchor itself.
+
+		node:	left | right | parent + colour | value
+
+	The colour is kept in the low bit of the parent pointer (nodes are at least pointer aligned), so a
+	node costs three pointers on top of the value: 24 bytes on 64 bit targets against 32 for std::map.
+
+	Nodes come from a pool owned by the tree (rbtree_node_pool): slabs of nodes allocated through the
+	allocator, growing geometrically from 8 nodes to 64 KB, carved in order and recycled through a free
+	list. So an insertion costs a pointer bump instead of a call to malloc, a map does not pay malloc's
+	per block header, and nodes inserted one after the other sit next to each other in memory, which
+	helps the in-order walk. Memory of erased nodes is reused by the same tree and only given back by
+	clear() or the destructor. clear() does not visit the nodes when the values are trivially destructible.
+
+	Bulk construction: insert(first, last) into an empty tree creates all the nodes, checks whether they
+	came in order (sorting them once if not) and links them into a balanced tree directly, O(n) for
+	sorted input, instead of n searches and rebalancings. The copy constructor goes the same way.
+	insert(hint, value) is O(1) amortized when the value goes right before the hint, in particular at
+	end() for ascending keys; insert(first, last) into a non empty tree uses end() as the hint.
+*/
+
+namespace merkol
+{
+	enum rbtree_color
+	{
+		kRBTreeColorRed		= 0,
+		kRBTreeColorBlack	= 1
+	};
+
+	/// rbtree_node_base
+	///
+	/// Links of a node. The parent pointer and the colour share mParentColor.
+	struct rbtree_node_base
+	{
+		rbtree_node_base*	mpLeft;
+		rbtree_node_base*	mpRight;
+		std::size_t			mParentColor;
+
+		rbtree_node_base*	parent() const { return reinterpret_cast<rbtree_node_base*>(mParentColor & ~(std::size_t)1); }
+		rbtree_color		color() const { return (rbtree_color)(mParentColor & 1); }
+		bool				is_red() const { return (mParentColor & 1) == kRBTreeColorRed; }
+		bool				is_black() const { return (mParentColor & 1) == kRBTreeColorBlack; }
+
+		void	set_parent(rbtree_node_base* p) { mParentColor = reinterpret_cast<std::size_t>(p) | (mParentColor & 1); }
+		void	set_color(rbtree_color c) { mParentColor = (mParentColor & ~(std::size_t)1) | (std::size_t)c; }
+		void	set_parent_color(rbtree_node_base* p, rbtree_color c) { mParentColor = reinterpret_cast<std::size_t>(p) | (std::size_t)c; }
+	};
+
+	template <typename Value>
+	struct rbtree_node : public rbtree_node_base
+	{
+		Value	mValue;
+	};
+
+
+	///////////////////////////////////////////////////////////////////////
+	// RBTreeAlgorithms.imp.begin();									///
+	///////////////////////////////////////////////////////////////////////
+
+	inline rbtree_node_base* rbtree_min(rbtree_node_base* x)
+	{
+		while (x->mpLeft)
+			x = x->mpLeft;
+		return x;
+	}
+
+	inline rbtree_node_base* rbtree_max(rbtree_node_base* x)
+	{
+		while (x->mpRight)
+			x = x->mpRight;
+		return x;
+	}
+
+	// In-order successor. The successor of the rightmost node is the anchor.
+	inline rbtree_node_base* rbtree_increment(rbtree_node_base* x)
+	{
+		if (x->mpRight)
+			return rbtree_min(x->mpRight);
+
+		rbtree_node_base* y = x->parent();
+		while (x == y->mpRight)
+		{
+			x = y;
+			y = y->parent();
+		}
+		// Stepping off the rightmost node when it is the root: x went up to the anchor, whose right link
+		// is the root itself.
+		return (x->mpRight != y) ? y : x;
+	}
+
+	// In-order predecessor. The predecessor of the anchor (end()) is the rightmost node: the anchor is
+	// the only red node whose grandparent is itself.
+	inline rbtree_node_base* rbtree_decrement(rbtree_node_base* x)
+	{
+		if (x->is_red() && (x->parent()->parent() == x))
+			return x->mpRight;
+		if (x->mpLeft)
+			return rbtree_max(x->mpLeft);
+
+		rbtree_node_base* y = x->parent();
+		while (x == y->mpLeft)
+		{
+			x = y;
+			y = y->parent();
+		}
+		return y;
+	}
+
+	inline void rbtree_rotate_left(rbtree_node_base* x, rbtree_node_base* anchor)
+	{
+		rbtree_node_base* const y = x->mpRight;
+
+		x->mpRight = y->mpLeft;
+		if (y->mpLeft)
+			y->mpLeft->set_parent(x);
+		y->set_parent(x->parent());
+		if (x == anchor->parent())
+			anchor->set_parent(y);
+		else if (x == x->parent()->mpLeft)
+			x->parent()->mpLeft = y;
+		else
+			x->parent()->mpRight = y;
+		y->mpLeft = x;
+		x->set_parent(y);
+	}
+
+	inline void rbtree_rotate_right(rbtree_node_base* x, rbtree_node_base* anchor)
+	{
+		rbtree_node_base* const y = x->mpLeft;
+
+		x->mpLeft = y->mpRight;
+		if (y->mpRight)
+			y->mpRight->set_parent(x);
+		y->set_parent(x->parent());
+		if (x == anchor->parent())
+			anchor->set_parent(y);
+		else if (x == x->parent()->mpRight)
+			x->parent()->mpRight = y;
+		else
+			x->parent()->mpLeft = y;
+		y->mpRight = x;
+		x->set_parent(y);
+	}
+
+	/// rbtree_insert
+	///
+	/// Links the new node x as the left or right child of parent (which has no child on that side, or is
+	/// the anchor of an empty tree) and restores the red-black properties.
+	inline void rbtree_insert(rbtree_node_base* x, rbtree_node_base* parent, bool insertLeft, rbtree_node_base* anchor)
+	{
+		x->mpLeft	= NULL;
+		x->mpRight	= NULL;
+		x->set_parent_color(parent, kRBTreeColorRed);
+
+		if (insertLeft)
+		{
+			parent->mpLeft = x; // also the leftmost node when parent is the anchor
+			if (parent == anchor)
+			{
+				anchor->set_parent(x);
+				anchor->mpRight = x;
+			}
+			else if (parent == anchor->mpLeft)
+				anchor->mpLeft = x;
+		}
+		else
+		{
+			parent->mpRight = x;
+			if (parent == anchor->mpRight)
+				anchor->mpRight = x;
+		}
+
+		while ((x != anchor->parent()) && x->parent()->is_red())
+		{
+			rbtree_node_base* xp	= x->parent();
+			rbtree_node_base* xpp	= xp->parent();
+
+			if (xp == xpp->mpLeft)
+			{
+				rbtree_node_base* const uncle = xpp->mpRight;
+
+				if (uncle && uncle->is_red())
+				{
+					xp->set_color(kRBTreeColorBlack);
+					uncle->set_color(kRBTreeColorBlack);
+					xpp->set_color(kRBTreeColorRed);
+					x = xpp;
+					continue;
+				}
+				if (x == xp->mpRight)
+				{
+					x = xp;
+					rbtree_rotate_left(x, anchor);
+					xp = x->parent();
+				}
+				xp->set_color(kRBTreeColorBlack);
+				xpp->set_color(kRBTreeColorRed);
+				rbtree_rotate_right(xpp, anchor);
+			}
+			else
+			{
+				rbtree_node_base* const uncle = xpp->mpLeft;
+
+				if (uncle && uncle->is_red())
+				{
+					xp->set_color(kRBTreeColorBlack);
+					uncle->set_color(kRBTreeColorBlack);
+					xpp->set_color(kRBTreeColorRed);
+					x = xpp;
+					continue;
+				}
+				if (x == xp->mpLeft)
+				{
+					x = xp;
+					rbtree_rotate_right(x, anchor);
+					xp = x->parent();
+				}
+				xp->set_color(kRBTreeColorBlack);
+				xpp->set_color(kRBTreeColorRed);
+				rbtree_rotate_left(xpp, anchor);
+			}
+		}
+		anchor->parent()->set_color(kRBTreeColorBlack);
+	}
+
+	/// rbtree_erase
+	///
+	/// Unlinks z from the tree and restores the red-black properties. z is not freed.
+	inline void rbtree_erase(rbtree_node_base* z, rbtree_node_base* anchor)
+	{
+		rbtree_node_base*	y		= z;	// node actually taken out of its place: z, or its successor
+		rbtree_node_base*	x		= NULL;	// child that takes y's place, may be NULL
+		rbtree_node_base*	xParent	= NULL;
+
+		if (!y->mpLeft)
+			x = y->mpRight;
+		else if (!y->mpRight)
+			x = y->mpLeft;
+		else
+		{
+			y = rbtree_min(y->mpRight);
+			x = y->mpRight;
+		}
+
+		rbtree_color removedColor;
+		if (y != z)
+		{
+			// z has two children: its successor y moves into z's place, y's right child into y's.
+			z->mpLeft->set_parent(y);
+			y->mpLeft = z->mpLeft;
+			if (y != z->mpRight)
+			{
+				xParent = y->parent();
+				if (x)
+					x->set_parent(xParent);
+				xParent->mpLeft = x;
+				y->mpRight = z->mpRight;
+				z->mpRight->set_parent(y);
+			}
+			else
+				xParent = y;
+
+			rbtree_node_base* const zp = z->parent();
+			if (anchor->parent() == z)
+				anchor->set_parent(y);
+			else if (zp->mpLeft == z)
+				zp->mpLeft = y;
+			else
+				zp->mpRight = y;
+			removedColor = y->color();
+			y->set_parent_color(zp, z->color());
+		}
+		else
+		{
+			rbtree_node_base* const zp = z->parent();
+
+			xParent = zp;
+			if (x)
+				x->set_parent(zp);
+			if (anchor->parent() == z)
+				anchor->set_parent(x);
+			else if (zp->mpLeft == z)
+				zp->mpLeft = x;
+			else
+				zp->mpRight = x;
+			if (anchor->mpLeft == z)
+				anchor->mpLeft = z->mpRight ? rbtree_min(x) : zp;
+			if (anchor->mpRight == z)
+				anchor->mpRight = z->mpLeft ? rbtree_max(x) : zp;
+			removedColor = z->color();
+		}
+
+		if (removedColor == kRBTreeColorRed)
+			return;
+
+		// A black node left the path through x: x carries an extra black until it reaches a red node or
+		// the root, or a rotation absorbs it.
+		while ((x != anchor->parent()) && (!x || x->is_black()))
+		{
+			if (x == xParent->mpLeft)
+			{
+				rbtree_node_base* w = xParent->mpRight;
+
+				if (w->is_red())
+				{
+					w->set_color(kRBTreeColorBlack);
+					xParent->set_color(kRBTreeColorRed);
+					rbtree_rotate_left(xParent, anchor);
+					w = xParent->mpRight;
+				}
+				if ((!w->mpLeft || w->mpLeft->is_black()) && (!w->mpRight || w->mpRight->is_black()))
+				{
+					w->set_color(kRBTreeColorRed);
+					x		= xParent;
+					xParent	= xParent->parent();
+				}
+				else
+				{
+					if (!w->mpRight || w->mpRight->is_black())
+					{
+						w->mpLeft->set_color(kRBTreeColorBlack);
+						w->set_color(kRBTreeColorRed);
+						rbtree_rotate_right(w, anchor);
+						w = xParent->mpRight;
+					}
+					w->set_color(xParent->color());
+					xParent->set_color(kRBTreeColorBlack);
+					if (w->mpRight)
+						w->mpRight->set_color(kRBTreeColorBlack);
+					rbtree_rotate_left(xParent, anchor);
+					break;
+				}
+			}
+			else
+			{
+				rbtree_node_base* w = xParent->mpLeft;
+
+				if (w->is_red())
+				{
+					w->set_color(kRBTreeColorBlack);
+					xParent->set_color(kRBTreeColorRed);
+					rbtree_rotate_right(xParent, anchor);
+					w = xParent->mpLeft;
+				}
+				if ((!w->mpRight || w->mpRight->is_black()) && (!w->mpLeft || w->mpLeft->is_black()))
+				{
+					w->set_color(kRBTreeColorRed);
+					x		= xParent;
+					xParent	= xParent->parent();
+				}
+				else
+				{
+					if (!w->mpLeft || w->mpLeft->is_black())
+					{
+						w->mpRight->set_color(kRBTreeColorBlack);
+						w->set_color(kRBTreeColorRed);
+						rbtree_rotate_left(w, anchor);
+						w = xParent->mpLeft;
+					}
+					w->set_color(xParent->color());
+					xParent->set_color(kRBTreeColorBlack);
+					if (w->mpLeft)
+						w->mpLeft->set_color(kRBTreeColorBlack);
+					rbtree_rotate_right(xParent, anchor);
+					break;
+				}
+			}
+		}
+		if (x)
+			x->set_color(kRBTreeColorBlack);
+	}
+
+	/// rbtree_build
+	///
+	/// Links nodes[0, n), already in order, into a balanced subtree under parent and returns its root.
+	/// Every level above redDepth is full, so making the nodes at redDepth red and all the others black
+	/// gives every path the same number of black nodes.
+	inline rbtree_node_base* rbtree_build(void* const* nodes, std::size_t n, std::size_t depth, std::size_t redDepth,
+										  rbtree_node_base* parent)
+	{
+		if (n == 0)
+			return NULL;
+
+		const std::size_t		mid		= n / 2;
+		rbtree_node_base* const	node	= static_cast<rbtree_node_base*>(nodes[mid]);
+
+		node->set_parent_color(parent, (depth == redDepth) ? kRBTreeColorRed : kRBTreeColorBlack);
+		node->mpLeft	= rbtree_build(nodes, mid, depth + 1, redDepth, node);
+		node->mpRight	= rbtree_build(nodes + mid + 1, n - mid - 1, depth + 1, redDepth, node);
+		return node;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// RBTreeAlgorithms.imp.end();										///
+	///////////////////////////////////////////////////////////////////////
+
+
+	/// rbtree_node_pool
+	///
+	/// Node storage of one tree: slabs obtained from the allocator, handed out in address order, and a
+	/// free list of the nodes given back. The first node sized slot of every slab holds the slab header.
+	template <typename Node, typename Allocator>
+	class rbtree_node_pool
+	{
+		typedef typename Allocator::template rebind<Node>::other	node_allocator_type;
+
+		struct slab
+		{
+			slab*		mpNext;
+			std::size_t	mnNodes;	// nodes after the header slot
+		};
+
+		struct free_node
+		{
+			free_node*	mpNext;
+		};
+
+	public:
+		static const std::size_t kMinSlabNodes	= 8;
+		static const std::size_t kMaxSlabNodes	= (64 * 1024 / sizeof(Node) > kMinSlabNodes) ? 64 * 1024 / sizeof(Node) : kMinSlabNodes;
+
+		explicit rbtree_node_pool(const Allocator& allocator)
+			: mpSlabs(NULL), mpFree(NULL), mpCurrent(NULL), mpEnd(NULL), mnNextSlabNodes(kMinSlabNodes), mAllocator(allocator) { }
+
+		~rbtree_node_pool() { release(); }
+
+		Node* allocate()
+		{
+			if (mpFree)
+			{
+				free_node* const node = mpFree;
+
+				mpFree = node->mpNext;
+				return reinterpret_cast<Node*>(node);
+			}
+			if (mpCurrent == mpEnd)
+				doAddSlab();
+			return mpCurrent++;
+		}
+
+		void deallocate(Node* p)
+		{
+			free_node* const node = reinterpret_cast<free_node*>(p);
+
+			node->mpNext	= mpFree;
+			mpFree			= node;
+		}
+
+		// Gives every slab back to the allocator, whatever is still in use.
+		void release()
+		{
+			while (mpSlabs)
+			{
+				slab* const next = mpSlabs->mpNext;
+
+				mAllocator.deallocate(reinterpret_cast<Node*>(mpSlabs), mpSlabs->mnNodes + 1);
+				mpSlabs = next;
+			}
+			mpFree			= NULL;
+			mpCurrent		= NULL;
+			mpEnd			= NULL;
+			mnNextSlabNodes	= kMinSlabNodes;
+		}
+
+		void swap(rbtree_node_pool& other)
+		{
+			merkol::swap(mpSlabs, other.mpSlabs);
+			merkol::swap(mpFree, other.mpFree);
+			merkol::swap(mpCurrent, other.mpCurrent);
+			merkol::swap(mpEnd, other.mpEnd);
+			merkol::swap(mnNextSlabNodes, other.mnNextSlabNodes);
+			merkol::swap(mAllocator, other.mAllocator);
+		}
+
+		// Bytes obtained from the allocator.
+		std::size_t bytes() const
+		{
+			std::size_t total = 0;
+
+			for (const slab* s = mpSlabs; s; s = s->mpNext)
+				total += (s->mnNodes + 1) * sizeof(Node);
+			return total;
+		}
+
+		Allocator	get_allocator() const { return Allocator(mAllocator); }
+		std::size_t	max_size() const { return mAllocator.max_size(); }
+
+	private:
+		rbtree_node_pool(const rbtree_node_pool&);
+		rbtree_node_pool& operator=(const rbtree_node_pool&);
+
+		void doAddSlab()
+		{
+			const std::size_t	n		= mnNextSlabNodes;
+			Node* const			nodes	= mAllocator.allocate(n + 1);
+			slab* const			header	= reinterpret_cast<slab*>(nodes);
+
+			header->mpNext	= mpSlabs;
+			header->mnNodes	= n;
+			mpSlabs			= header;
+			mpCurrent		= nodes + 1;
+			mpEnd			= nodes + 1 + n;
+			if (mnNextSlabNodes < kMaxSlabNodes)
+				mnNextSlabNodes = (n * 2 < kMaxSlabNodes) ? n * 2 : kMaxSlabNodes;
+			MERKOL_TRACE(this, "rbtree_node_pool::new_slab", n, n);
+		}
+
+		slab*				mpSlabs;
+		free_node*			mpFree;
+		Node*				mpCurrent;	// next never used node of the newest slab
+		Node*				mpEnd;
+		std::size_t			mnNextSlabNodes;
+		node_allocator_type	mAllocator;
+	}; // rbtree_node_pool
+
+
+	/// rbtree_iterator
+	///
+	/// Bidirectional iterator over the nodes, in order. T is const qualified for const iterators.
+	template <typename T>
+	class rbtree_iterator
+	{
+		template <typename> friend class rbtree_iterator;
+
+	public:
+		typedef rbtree_iterator<T>										this_type;
+		typedef T														value_type;
+		typedef T*														pointer;
+		typedef T&														reference;
+		typedef std::ptrdiff_t											difference_type;
+		typedef merkol::bidirectional_iterator_tag						iterator_category;
+		typedef rbtree_iterator<const T>								const_iterator;
+		typedef rbtree_node<typename merkol::remove_const<T>::type>		node_type;
+
+		rbtree_iterator() : mpNode(NULL) { }
+		explicit rbtree_iterator(rbtree_node_base* node) : mpNode(node) { }
+
+		// convertion to const
+		operator const_iterator() const
+		{
+			return (const_iterator(mpNode));
+		}
+
+		rbtree_node_base*	node() const { return mpNode; }
+
+		reference	operator*() const { return static_cast<node_type*>(mpNode)->mValue; }
+		pointer		operator->() const { return merkol::addressof(static_cast<node_type*>(mpNode)->mValue); }
+
+		rbtree_iterator&	operator++() { mpNode = rbtree_increment(mpNode); return *this; }
+		rbtree_iterator&	operator--() { mpNode = rbtree_decrement(mpNode); return *this; }
+		rbtree_iterator		operator++(int) { rbtree_iterator temp(*this); mpNode = rbtree_increment(mpNode); return temp; }
+		rbtree_iterator		operator--(int) { rbtree_iterator temp(*this); mpNode = rbtree_decrement(mpNode); return temp; }
+
+	private:
+		rbtree_node_base*	mpNode;
+	};
+
+	template <typename T1, typename T2>
+	inline bool operator==(const rbtree_iterator<T1>& lhs, const rbtree_iterator<T2>& rhs)
+	{
+		return (lhs.node() == rhs.node());
+	}
+
+	template <typename T1, typename T2>
+	inline bool operator!=(const rbtree_iterator<T1>& lhs, const rbtree_iterator<T2>& rhs)
+	{
+		return (lhs.node() != rhs.node());
+	}
+
+
+	/**
+	 * @brief rb_tree
+	 * Storage and lookup of map, multimap, set and multiset.
+	 *
+	 * @tparam Value stored type
+	 * @tparam Key key type
+	 * @tparam ExtractKey function object returning the key of a Value (use_self, use_first)
+	 * @tparam Compare strict weak ordering of the keys
+	 * @tparam Allocator allocator of Value, rebound to the node type
+	 * @tparam MutableIterators false for sets, whose elements can not be modified in place
+	 * @tparam UniqueKeys false for multimap and multiset
+	 */
+	template <typename Value, typename Key, typename ExtractKey, typename Compare, typename Allocator, bool MutableIterators, bool UniqueKeys>
+	class rb_tree
+	{
+		typedef rb_tree<Value, Key, ExtractKey, Compare, Allocator, MutableIterators, UniqueKeys>	this_type;
+
+	public:
+		typedef Key																		key_type;
+		typedef Value																	value_type;
+		typedef Compare																	key_compare;
+		typedef Allocator																allocator_type;
+		typedef Value&																	reference;
+		typedef const Value&															const_reference;
+		typedef Value*																	pointer;
+		typedef const Value*															const_pointer;
+		typedef std::size_t																size_type;
+		typedef std::ptrdiff_t															difference_type;
+		typedef rbtree_node<Value>														node_type;
+		typedef typename merkol::conditional<MutableIterators, rbtree_iterator<Value>,
+											 rbtree_iterator<const Value> >::type		iterator;
+		typedef rbtree_iterator<const Value>											const_iterator;
+		typedef merkol::reverse_iterator<iterator>										reverse_iterator;
+		typedef merkol::reverse_iterator<const_iterator>								const_reverse_iterator;
+		typedef typename merkol::conditional<UniqueKeys, std::pair<iterator, bool>,
+											 iterator>::type							insert_return_type;
+
+	protected:
+		typedef rbtree_node_pool<node_type, Allocator>									node_pool_type;
+		typedef integral_constant<bool, UniqueKeys>										unique_keys;
+
+		rbtree_node_base	mAnchor;	// parent: root, left: leftmost node, right: rightmost node
+		size_type			mnSize;
+		key_compare			mCompare;
+		node_pool_type		mPool;
+
+	public:
+		explicit rb_tree(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type());
+		rb_tree(const this_type& other);
+	#if __cplusplus >= 201103L
+		rb_tree(this_type&& other);
+	#endif
+		~rb_tree();
+
+		this_type&	operator=(const this_type& other);
+	#if __cplusplus >= 201103L
+		this_type&	operator=(this_type&& other);
+	#endif
+
+		// Iterators
+		iterator				begin() M_NOEXCEPT { return iterator(mAnchor.mpLeft); }
+		const_iterator			begin() const M_NOEXCEPT { return const_iterator(mAnchor.mpLeft); }
+		const_iterator			cbegin() const M_NOEXCEPT { return begin(); }
+		iterator				end() M_NOEXCEPT { return iterator(&mAnchor); }
+		const_iterator			end() const M_NOEXCEPT { return const_iterator(const_cast<rbtree_node_base*>(&mAnchor)); }
+		const_iterator			cend() const M_NOEXCEPT { return end(); }
+		reverse_iterator		rbegin() M_NOEXCEPT { return reverse_iterator(end()); }
+		const_reverse_iterator	rbegin() const M_NOEXCEPT { return const_reverse_iterator(end()); }
+		reverse_iterator		rend() M_NOEXCEPT { return reverse_iterator(begin()); }
+		const_reverse_iterator	rend() const M_NOEXCEPT { return const_reverse_iterator(begin()); }
+
+		// Capacity
+		bool		empty() const M_NOEXCEPT { return mnSize == 0; }
+		size_type	size() const M_NOEXCEPT { return mnSize; }
+		size_type	max_size() const M_NOEXCEPT { return mPool.max_size(); }
+		size_type	pool_bytes() const M_NOEXCEPT { return mPool.bytes(); }
+
+		// Lookup
+		iterator		find(const key_type& key);
+		const_iterator	find(const key_type& key) const;
+		size_type		count(const key_type& key) const;
+		bool			contains(const key_type& key) const { return find(key) != end(); }
+		iterator		lower_bound(const key_type& key) { return iterator(doLowerBound(key)); }
+		const_iterator	lower_bound(const key_type& key) const { return const_iterator(doLowerBound(key)); }
+		iterator		upper_bound(const key_type& key) { return iterator(doUpperBound(key)); }
+		const_iterator	upper_bound(const key_type& key) const { return const_iterator(doUpperBound(key)); }
+
+		std::pair<iterator, iterator>				equal_range(const key_type& key);
+		std::pair<const_iterator, const_iterator>	equal_range(const key_type& key) const;
+
+		// Modifiers
+		insert_return_type	insert(const value_type& value) { return doInsertValue(value, unique_keys()); }
+		iterator			insert(const_iterator hint, const value_type& value) { return doInsertHint(hint, value); }
+	#if __cplusplus >= 201103L
+		insert_return_type	insert(value_type&& value) { return doInsertValue(std::move(value), unique_keys()); }
+		iterator			insert(const_iterator hint, value_type&& value) { return doInsertHint(hint, std::move(value)); }
+
+		template <typename... Args>
+		insert_return_type	emplace(Args&&... args);
+
+		template <typename... Args>
+		iterator			emplace_hint(const_iterator hint, Args&&... args);
+	#endif
+
+		template <typename InputIterator>
+		void		insert(InputIterator first, InputIterator last);
+
+		iterator	erase(const_iterator pos);
+		iterator	erase(const_iterator first, const_iterator last);
+		size_type	erase(const key_type& key);
+		void		clear() M_NOEXCEPT;
+		void		swap(this_type& other);
+
+		// Observers
+		key_compare		key_comp() const { return mCompare; }
+		allocator_type	get_allocator() const { return mPool.get_allocator(); }
+
+		// Checks the red-black and ordering properties and the anchor links; for tests.
+		bool		validate() const;
+
+	protected:
+		static const key_type&	doKey(const rbtree_node_base* node) { return ExtractKey()(static_cast<const node_type*>(node)->mValue); }
+		rbtree_node_base*		doRoot() const { return mAnchor.parent(); }
+		rbtree_node_base*		doAnchor() const { return const_cast<rbtree_node_base*>(&mAnchor); }
+		void					doResetAnchor();
+
+		// Orders nodes by key, to sort the nodes of a bulk insertion.
+		struct node_compare
+		{
+			key_compare compare;
+
+			explicit node_compare(const key_compare& c) : compare(c) { }
+			bool operator()(const void* a, const void* b) const { return compare(doKey(doNode(a)), doKey(doNode(b))); }
+		};
+
+		static rbtree_node_base*	doNode(const void* p) { return static_cast<rbtree_node_base*>(const_cast<void*>(p)); }
+
+		// a goes before b: strictly for unique keys, or equal keys allowed
+		bool	doBefore(const key_type& a, const key_type& b) const { return UniqueKeys ? mCompare(a, b) : !mCompare(b, a); }
+
+		rbtree_node_base*	doLowerBound(const key_type& key) const;
+		rbtree_node_base*	doUpperBound(const key_type& key) const;
+		rbtree_node_base*	doFindUniquePosition(const key_type& key, rbtree_node_base*& parent, bool& insertLeft) const;
+		void				doFindMultiPosition(const key_type& key, bool front, rbtree_node_base*& parent, bool& insertLeft) const;
+		bool				doFindHintPosition(const_iterator hint, const key_type& key, rbtree_node_base*& parent, bool& insertLeft) const;
+		iterator			doLink(node_type* node, rbtree_node_base* parent, bool insertLeft);
+
+	#if __cplusplus >= 201103L
+		template <typename... Args>
+		node_type*			doCreateNode(Args&&... args);
+	#else
+		template <typename Arg>
+		node_type*			doCreateNode(const Arg& value);
+	#endif
+		void				doDestroyNode(node_type* node);
+		void				doDestroySubtree(rbtree_node_base* node);
+
+		template <typename Arg>
+		std::pair<iterator, bool>	doInsertValue(MERKOL_FORWARD_REF(Arg) value, true_type);
+		template <typename Arg>
+		iterator					doInsertValue(MERKOL_FORWARD_REF(Arg) value, false_type);
+		template <typename Arg>
+		iterator					doInsertHint(const_iterator hint, MERKOL_FORWARD_REF(Arg) value);
+		std::pair<iterator, bool>	doInsertNode(node_type* node, true_type);
+		iterator					doInsertNode(node_type* node, false_type);
+		iterator					doInsertNodeHint(const_iterator hint, node_type* node);
+
+		static iterator		doIterator(const std::pair<iterator, bool>& result) { return result.first; }
+		static iterator		doIterator(const iterator& it) { return it; }
+
+		template <typename InputIterator>
+		void				doBuild(InputIterator first, InputIterator last);
+	}; // rb_tree
+
+
+	///////////////////////////////////////////////////////////////////////
+	// RBTree.imp.begin();												///
+	///////////////////////////////////////////////////////////////////////
+
+# define MERKOL_RB_TREE_TEMPLATE \
+	template <typename Value, typename Key, typename ExtractKey, typename Compare, typename Allocator, bool MutableIterators, bool UniqueKeys>
+# define MERKOL_RB_TREE rb_tree<Value, Key, ExtractKey, Compare, Allocator, MutableIterators, UniqueKeys>
+
+	MERKOL_RB_TREE_TEMPLATE
+	MERKOL_RB_TREE::rb_tree(const key_compare& compare, const allocator_type& allocator)
+		: mAnchor(),
+		  mnSize(0),
+		  mCompare(compare),
+		  mPool(allocator)
+	{
+		doResetAnchor();
+		MERKOL_TRACE(this, "rb_tree::constructor", 0, 0);
+	}
+
+	// The other tree is already in order: its nodes are copied and linked into a balanced tree in O(n).
+	MERKOL_RB_TREE_TEMPLATE
+	MERKOL_RB_TREE::rb_tree(const this_type& other)
+		: mAnchor(),
+		  mnSize(0),
+		  mCompare(other.mCompare),
+		  mPool(other.get_allocator())
+	{
+		doResetAnchor();
+		doBuild(other.begin(), other.end());
+		MERKOL_TRACE(this, "rb_tree::copy_constructor", mnSize, 0);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_RB_TREE_TEMPLATE
+	MERKOL_RB_TREE::rb_tree(this_type&& other)
+		: mAnchor(),
+		  mnSize(0),
+		  mCompare(other.mCompare),
+		  mPool(other.get_allocator())
+	{
+		doResetAnchor();
+		swap(other);
+	}
+#endif
+
+	MERKOL_RB_TREE_TEMPLATE
+	MERKOL_RB_TREE::~rb_tree()
+	{
+		MERKOL_TRACE(this, "rb_tree::destructor", mnSize, 0);
+		clear();
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::this_type&
+	MERKOL_RB_TREE::operator=(const this_type& other)
+	{
+		if (this != &other)
+		{
+			this_type temp(other);
+			swap(temp);
+		}
+		return *this;
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::this_type&
+	MERKOL_RB_TREE::operator=(this_type&& other)
+	{
+		if (this != &other)
+		{
+			this_type temp(std::move(other));
+			swap(temp);
+		}
+		return *this;
+	}
+#endif
+
+	// Empty tree: no root, the anchor is its own leftmost and rightmost node. The anchor is red, which is
+	// how rbtree_decrement tells it from the root.
+	MERKOL_RB_TREE_TEMPLATE
+	inline void MERKOL_RB_TREE::doResetAnchor()
+	{
+		mAnchor.set_parent_color(NULL, kRBTreeColorRed);
+		mAnchor.mpLeft	= &mAnchor;
+		mAnchor.mpRight	= &mAnchor;
+		mnSize			= 0;
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	inline rbtree_node_base* MERKOL_RB_TREE::doLowerBound(const key_type& key) const
+	{
+		rbtree_node_base* result	= doAnchor();
+		rbtree_node_base* x			= doRoot();
+
+		while (x)
+		{
+			if (!mCompare(doKey(x), key))
+			{
+				result	= x;
+				x		= x->mpLeft;
+			}
+			else
+				x = x->mpRight;
+		}
+		return result;
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	inline rbtree_node_base* MERKOL_RB_TREE::doUpperBound(const key_type& key) const
+	{
+		rbtree_node_base* result	= doAnchor();
+		rbtree_node_base* x			= doRoot();
+
+		while (x)
+		{
+			if (mCompare(key, doKey(x)))
+			{
+				result	= x;
+				x		= x->mpLeft;
+			}
+			else
+				x = x->mpRight;
+		}
+		return result;
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	inline typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::find(const key_type& key)
+	{
+		rbtree_node_base* const node = doLowerBound(key);
+
+		return ((node != &mAnchor) && !mCompare(key, doKey(node))) ? iterator(node) : end();
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	inline typename MERKOL_RB_TREE::const_iterator
+	MERKOL_RB_TREE::find(const key_type& key) const
+	{
+		rbtree_node_base* const node = doLowerBound(key);
+
+		return ((node != &mAnchor) && !mCompare(key, doKey(node))) ? const_iterator(node) : end();
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::size_type
+	MERKOL_RB_TREE::count(const key_type& key) const
+	{
+		if (UniqueKeys)
+			return contains(key) ? 1 : 0;
+
+		const std::pair<const_iterator, const_iterator> range = equal_range(key);
+
+		return (size_type)std::distance(range.first, range.second);
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	std::pair<typename MERKOL_RB_TREE::iterator, typename MERKOL_RB_TREE::iterator>
+	MERKOL_RB_TREE::equal_range(const key_type& key)
+	{
+		return std::pair<iterator, iterator>(lower_bound(key), upper_bound(key));
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	std::pair<typename MERKOL_RB_TREE::const_iterator, typename MERKOL_RB_TREE::const_iterator>
+	MERKOL_RB_TREE::equal_range(const key_type& key) const
+	{
+		return std::pair<const_iterator, const_iterator>(lower_bound(key), upper_bound(key));
+	}
+
+	// Unique keys: returns the node holding key, or NULL and where a new node for key is to be linked.
+	MERKOL_RB_TREE_TEMPLATE
+	rbtree_node_base* MERKOL_RB_TREE::doFindUniquePosition(const key_type& key, rbtree_node_base*& parent, bool& insertLeft) const
+	{
+		rbtree_node_base*	x		= doRoot();
+		rbtree_node_base*	y		= doAnchor();
+		bool				left	= true;
+
+		while (x)
+		{
+			y		= x;
+			left	= mCompare(key, doKey(x));
+			x		= left ? x->mpLeft : x->mpRight;
+		}
+
+		// key is greater than everything up to the predecessor of the would-be position; only that
+		// predecessor can be equal to key.
+		rbtree_node_base* before = y;
+		if (left)
+		{
+			if (y == mAnchor.mpLeft)
+			{
+				parent		= y;
+				insertLeft	= true;
+				return NULL;
+			}
+			before = rbtree_decrement(y);
+		}
+		if (mCompare(doKey(before), key))
+		{
+			parent		= y;
+			insertLeft	= left;
+			return NULL;
+		}
+		return before;
+	}
+
+	// Equal keys allowed: the position after the last element equal to key, or before the first one if
+	// front is true.
+	MERKOL_RB_TREE_TEMPLATE
+	void MERKOL_RB_TREE::doFindMultiPosition(const key_type& key, bool front, rbtree_node_base*& parent, bool& insertLeft) const
+	{
+		rbtree_node_base*	x		= doRoot();
+		rbtree_node_base*	y		= doAnchor();
+		bool				left	= true;
+
+		while (x)
+		{
+			y		= x;
+			left	= front ? !mCompare(doKey(x), key) : mCompare(key, doKey(x));
+			x		= left ? x->mpLeft : x->mpRight;
+		}
+		parent		= y;
+		insertLeft	= left;
+	}
+
+	// Where key goes if it belongs right before or right after hint: O(1) plus the step to the
+	// neighbour. Returns false when the hint is of no use (or, for unique keys, when key may be in the
+	// tree already); the caller then searches from the root, which for equal keys allowed gives the
+	// position after the equal range: the closest one to a hint past the range. For a hint before the
+	// range, the closest is the front of the range, found here from the root.
+	MERKOL_RB_TREE_TEMPLATE
+	bool MERKOL_RB_TREE::doFindHintPosition(const_iterator hint, const key_type& key, rbtree_node_base*& parent, bool& insertLeft) const
+	{
+		rbtree_node_base* const pos = hint.node();
+
+		if (pos == &mAnchor)
+		{
+			if (mnSize && doBefore(doKey(mAnchor.mpRight), key))
+			{
+				parent		= mAnchor.mpRight;
+				insertLeft	= false;
+				return true;
+			}
+			return false;
+		}
+		if (doBefore(key, doKey(pos)))
+		{
+			if (pos == mAnchor.mpLeft)
+			{
+				parent		= pos;
+				insertLeft	= true;
+				return true;
+			}
+
+			rbtree_node_base* const before = rbtree_decrement(pos);
+			if (doBefore(doKey(before), key))
+			{
+				// either before has no right child or pos has no left child
+				parent		= before->mpRight ? pos : before;
+				insertLeft	= (before->mpRight != NULL);
+				return true;
+			}
+			return false;
+		}
+		if (doBefore(doKey(pos), key))
+		{
+			if (pos == mAnchor.mpRight)
+			{
+				parent		= pos;
+				insertLeft	= false;
+				return true;
+			}
+
+			rbtree_node_base* const after = rbtree_increment(pos);
+			if (doBefore(key, doKey(after)))
+			{
+				parent		= pos->mpRight ? after : pos;
+				insertLeft	= (pos->mpRight != NULL);
+				return true;
+			}
+			if (!UniqueKeys)
+			{
+				doFindMultiPosition(key, true, parent, insertLeft);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	inline typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::doLink(node_type* node, rbtree_node_base* parent, bool insertLeft)
+	{
+		rbtree_insert(node, parent, insertLeft, &mAnchor);
+		++mnSize;
+		return iterator(node);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename... Args>
+	typename MERKOL_RB_TREE::node_type*
+	MERKOL_RB_TREE::doCreateNode(Args&&... args)
+	{
+		node_type* const node = mPool.allocate();
+
+		try
+		{
+			::new(static_cast<void*>(merkol::addressof(node->mValue))) value_type(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			mPool.deallocate(node);
+			throw;
+		}
+		return node;
+	}
+#else
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename Arg>
+	typename MERKOL_RB_TREE::node_type*
+	MERKOL_RB_TREE::doCreateNode(const Arg& value)
+	{
+		node_type* const node = mPool.allocate();
+
+		try
+		{
+			::new(static_cast<void*>(merkol::addressof(node->mValue))) value_type(value);
+		}
+		catch (...)
+		{
+			mPool.deallocate(node);
+			throw;
+		}
+		return node;
+	}
+#endif
+
+	MERKOL_RB_TREE_TEMPLATE
+	inline void MERKOL_RB_TREE::doDestroyNode(node_type* node)
+	{
+		node->mValue.~value_type();
+		mPool.deallocate(node);
+	}
+
+	// Destroys the values of a subtree without unlinking or freeing anything: the pool is released right
+	// after. Recurses on the right children only, so the depth is the height of the tree at most.
+	MERKOL_RB_TREE_TEMPLATE
+	void MERKOL_RB_TREE::doDestroySubtree(rbtree_node_base* node)
+	{
+		while (node)
+		{
+			doDestroySubtree(node->mpRight);
+
+			rbtree_node_base* const left = node->mpLeft;
+			static_cast<node_type*>(node)->mValue.~value_type();
+			node = left;
+		}
+	}
+
+	// The node is only created once the key is known to be new.
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename Arg>
+	std::pair<typename MERKOL_RB_TREE::iterator, bool>
+	MERKOL_RB_TREE::doInsertValue(MERKOL_FORWARD_REF(Arg) value, true_type)
+	{
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		if (rbtree_node_base* const existing = doFindUniquePosition(ExtractKey()(value), parent, insertLeft))
+			return std::pair<iterator, bool>(iterator(existing), false);
+		return std::pair<iterator, bool>(doLink(doCreateNode(MERKOL_FORWARD(Arg, value)), parent, insertLeft), true);
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename Arg>
+	typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::doInsertValue(MERKOL_FORWARD_REF(Arg) value, false_type)
+	{
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		doFindMultiPosition(ExtractKey()(value), false, parent, insertLeft);
+		return doLink(doCreateNode(MERKOL_FORWARD(Arg, value)), parent, insertLeft);
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename Arg>
+	typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::doInsertHint(const_iterator hint, MERKOL_FORWARD_REF(Arg) value)
+	{
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		if (doFindHintPosition(hint, ExtractKey()(value), parent, insertLeft))
+			return doLink(doCreateNode(MERKOL_FORWARD(Arg, value)), parent, insertLeft);
+		return doIterator(doInsertValue(MERKOL_FORWARD(Arg, value), unique_keys()));
+	}
+
+	// For emplace: the node is built first, to get at the key. A duplicate is destroyed again.
+	MERKOL_RB_TREE_TEMPLATE
+	std::pair<typename MERKOL_RB_TREE::iterator, bool>
+	MERKOL_RB_TREE::doInsertNode(node_type* node, true_type)
+	{
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		if (rbtree_node_base* const existing = doFindUniquePosition(doKey(node), parent, insertLeft))
+		{
+			doDestroyNode(node);
+			return std::pair<iterator, bool>(iterator(existing), false);
+		}
+		return std::pair<iterator, bool>(doLink(node, parent, insertLeft), true);
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::doInsertNode(node_type* node, false_type)
+	{
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		doFindMultiPosition(doKey(node), false, parent, insertLeft);
+		return doLink(node, parent, insertLeft);
+	}
+
+#if __cplusplus >= 201103L
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename... Args>
+	typename MERKOL_RB_TREE::insert_return_type
+	MERKOL_RB_TREE::emplace(Args&&... args)
+	{
+		return doInsertNode(doCreateNode(std::forward<Args>(args)...), unique_keys());
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename... Args>
+	typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::emplace_hint(const_iterator hint, Args&&... args)
+	{
+		return doInsertNodeHint(hint, doCreateNode(std::forward<Args>(args)...));
+	}
+#endif
+
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::doInsertNodeHint(const_iterator hint, node_type* node)
+	{
+		rbtree_node_base*	parent;
+		bool				insertLeft;
+
+		if (doFindHintPosition(hint, doKey(node), parent, insertLeft))
+			return doLink(node, parent, insertLeft);
+		return doIterator(doInsertNode(node, unique_keys()));
+	}
+
+	// Into an empty tree the range is built in one go (see doBuild), otherwise each element is inserted
+	// with end() as the hint (the node is made first: *first need not be a value_type), O(1) amortized
+	// per element while they come in ascending order past the current maximum.
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename InputIterator>
+	void MERKOL_RB_TREE::insert(InputIterator first, InputIterator last)
+	{
+		if (mnSize == 0)
+		{
+			doBuild(first, last);
+			return;
+		}
+		for (; first != last; ++first)
+			doInsertNodeHint(end(), doCreateNode(*first));
+	}
+
+	// Builds the whole tree from a range, the tree being empty. All the nodes are created first; if they
+	// are not in order they are sorted (stable, so that the first of several equal keys comes first and
+	// is the one kept by unique trees). Then rbtree_build links them, O(n).
+	MERKOL_RB_TREE_TEMPLATE
+	template <typename InputIterator>
+	void MERKOL_RB_TREE::doBuild(InputIterator first, InputIterator last)
+	{
+		// void*: std::stable_sort swaps with an unqualified swap(), which for pointers to merkol types
+		// would also find the unconstrained merkol::swap and be ambiguous.
+		merkol::vector<void*> nodes;
+
+		try
+		{
+			for (; first != last; ++first)
+			{
+				nodes.push_back(NULL);
+				nodes.back() = static_cast<rbtree_node_base*>(doCreateNode(*first));
+			}
+		}
+		catch (...)
+		{
+			for (size_type i = 0; (i < nodes.size()) && nodes[i]; ++i)
+				doDestroyNode(static_cast<node_type*>(doNode(nodes[i])));
+			throw;
+		}
+
+		size_type n = nodes.size();
+		if (n == 0)
+			return;
+
+		size_type i = 1;
+		while ((i < n) && doBefore(doKey(doNode(nodes[i - 1])), doKey(doNode(nodes[i]))))
+			++i;
+		if (i < n)
+		{
+			std::stable_sort(nodes.begin(), nodes.end(), node_compare(mCompare));
+			if (UniqueKeys)
+			{
+				size_type kept = 1;
+
+				for (i = 1; i < n; ++i)
+				{
+					if (mCompare(doKey(doNode(nodes[kept - 1])), doKey(doNode(nodes[i]))))
+						nodes[kept++] = nodes[i];
+					else
+						doDestroyNode(static_cast<node_type*>(doNode(nodes[i])));
+				}
+				n = kept;
+			}
+		}
+
+		size_type redDepth = 0;
+		while (((size_type)2 << redDepth) <= n)
+			++redDepth;
+
+		rbtree_node_base* const root = rbtree_build(nodes.data(), n, 0, redDepth, &mAnchor);
+		root->set_color(kRBTreeColorBlack);
+		mAnchor.set_parent(root);
+		mAnchor.mpLeft	= doNode(nodes[0]);
+		mAnchor.mpRight	= doNode(nodes[n - 1]);
+		mnSize			= n;
+		MERKOL_TRACE(this, "rb_tree::build", n, 0);
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::erase(const_iterator pos)
+	{
+		rbtree_node_base* const node = pos.node();
+		rbtree_node_base* const next = rbtree_increment(node);
+
+		rbtree_erase(node, &mAnchor);
+		doDestroyNode(static_cast<node_type*>(node));
+		--mnSize;
+		return iterator(next);
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::iterator
+	MERKOL_RB_TREE::erase(const_iterator first, const_iterator last)
+	{
+		if ((first == begin()) && (last == end()))
+		{
+			clear();
+			return end();
+		}
+		while (first != last)
+			first = erase(first);
+		return iterator(last.node());
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	typename MERKOL_RB_TREE::size_type
+	MERKOL_RB_TREE::erase(const key_type& key)
+	{
+		const std::pair<iterator, iterator>	range	= equal_range(key);
+		const size_type						n		= mnSize;
+
+		erase(range.first, range.second);
+		return n - mnSize;
+	}
+
+	// All the memory goes back to the allocator. Trivially destructible values are not visited at all.
+	MERKOL_RB_TREE_TEMPLATE
+	void MERKOL_RB_TREE::clear() M_NOEXCEPT
+	{
+		if (!merkol::is_trivially_destructible<value_type>::value)
+			doDestroySubtree(doRoot());
+		mPool.release();
+		doResetAnchor();
+	}
+
+	// The root's parent link points at the anchor, which is part of the object: it has to follow.
+	MERKOL_RB_TREE_TEMPLATE
+	void MERKOL_RB_TREE::swap(this_type& other)
+	{
+		merkol::swap(mAnchor, other.mAnchor);
+		merkol::swap(mnSize, other.mnSize);
+		merkol::swap(mCompare, other.mCompare);
+		mPool.swap(other.mPool);
+
+		this_type* const trees[2] = { this, &other };
+		for (int i = 0; i < 2; ++i)
+		{
+			rbtree_node_base* const anchor = &trees[i]->mAnchor;
+
+			if (anchor->parent())
+				anchor->parent()->set_parent(anchor);
+			else
+			{
+				anchor->mpLeft	= anchor;
+				anchor->mpRight	= anchor;
+			}
+		}
+	}
+
+	MERKOL_RB_TREE_TEMPLATE
+	bool MERKOL_RB_TREE::validate() const
+	{
+		const rbtree_node_base* const root = doRoot();
+
+		if (!root)
+			return (mnSize == 0) && (mAnchor.mpLeft == &mAnchor) && (mAnchor.mpRight == &mAnchor);
+		if (!root->is_black() || (root->parent() != &mAnchor) || (mAnchor.mpLeft != rbtree_min(doRoot()))
+			|| (mAnchor.mpRight != rbtree_max(doRoot())))
+			return false;
+
+		// Every node is in order with its successor, no red node has a red child, and every path from a
+		// node to a leaf has as many black nodes as the path along the leftmost branch.
+		size_type blackHeight = 0;
+		for (const rbtree_node_base* x = root; x; x = x->mpLeft)
+			blackHeight += x->is_black() ? 1 : 0;
+
+		size_type n = 0;
+		for (const_iterator it = begin(); it != end(); ++it, ++n)
+		{
+			const rbtree_node_base* const x = it.node();
+
+			if ((x->mpLeft && (x->mpLeft->parent() != x)) || (x->mpRight && (x->mpRight->parent() != x)))
+				return false;
+			if (x->is_red() && ((x->mpLeft && x->mpLeft->is_red()) || (x->mpRight && x->mpRight->is_red())))
+				return false;
+			if ((x != mAnchor.mpRight) && !doBefore(doKey(x), doKey(rbtree_increment(const_cast<rbtree_node_base*>(x)))))
+				return false;
+			if (!x->mpLeft || !x->mpRight)
+			{
+				size_type black = 0;
+
+				for (const rbtree_node_base* y = x; y != &mAnchor; y = y->parent())
+					black += y->is_black() ? 1 : 0;
+				if (black != blackHeight)
+					return false;
+			}
+		}
+		return n == mnSize;
+	}
+
+# undef MERKOL_RB_TREE_TEMPLATE
+# undef MERKOL_RB_TREE
+
+	///////////////////////////////////////////////////////////////////////
+	// RBTree.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+} // namespace merkol
+
+
+namespace std
+{
+	template <typename T>
+	struct iterator_traits<merkol::rbtree_iterator<T> >
+	{
+		typedef std::bidirectional_iterator_tag				iterator_category;
+		typedef typename merkol::remove_cv<T>::type			value_type;
+		typedef std::ptrdiff_t								difference_type;
+		typedef T*											pointer;
+		typedef T&											reference;
+	};
+} // namespace std
+
+#endif // MERKOL_RB_TREE_HPP
@@ -0,0 +1,122 @@
+#ifndef MERKOL_SET_HPP
+# define MERKOL_SET_HPP
+
+#include "rb_tree.hpp"
+
+namespace merkol
+{
+	/**
+	 * @brief set
+	 * Ordered set on a red-black tree with pooled nodes (see rb_tree.hpp). Elements can not be modified
+	 * through an iterator: both iterator types are constant.
+	 */
+	template <typename Key, typename Compare = merkol::less<Key>, typename Allocator = std::allocator<Key> >
+	class set
+		: public rb_tree<Key, Key, merkol::use_self<Key>, Compare, Allocator, false, true>
+	{
+		typedef rb_tree<Key, Key, merkol::use_self<Key>, Compare, Allocator, false, true>	base_type;
+
+	public:
+		typedef typename base_type::key_compare											key_compare;
+		typedef typename base_type::key_compare											value_compare;
+		typedef typename base_type::allocator_type										allocator_type;
+
+	public:
+		explicit set(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator) { }
+
+		// O(n) when [first, last) is sorted, see rb_tree::insert(first, last).
+		template <typename InputIterator>
+		set(InputIterator first, InputIterator last, const key_compare& compare = key_compare(),
+			const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator)
+		{
+			base_type::insert(first, last);
+		}
+
+		value_compare	value_comp() const { return this->mCompare; }
+	}; // set
+
+
+	/**
+	 * @brief multiset
+	 * Ordered set that keeps equal elements, in insertion order.
+	 */
+	template <typename Key, typename Compare = merkol::less<Key>, typename Allocator = std::allocator<Key> >
+	class multiset
+		: public rb_tree<Key, Key, merkol::use_self<Key>, Compare, Allocator, false, false>
+	{
+		typedef rb_tree<Key, Key, merkol::use_self<Key>, Compare, Allocator, false, false>	base_type;
+
+	public:
+		typedef typename base_type::key_compare											key_compare;
+		typedef typename base_type::key_compare											value_compare;
+		typedef typename base_type::allocator_type										allocator_type;
+
+	public:
+		explicit multiset(const key_compare& compare = key_compare(), const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator) { }
+
+		template <typename InputIterator>
+		multiset(InputIterator first, InputIterator last, const key_compare& compare = key_compare(),
+				 const allocator_type& allocator = allocator_type())
+			: base_type(compare, allocator)
+		{
+			base_type::insert(first, last);
+		}
+
+		value_compare	value_comp() const { return this->mCompare; }
+	}; // multiset
+
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline bool operator==(const set<Key, Compare, Allocator>& a, const set<Key, Compare, Allocator>& b)
+	{
+		return (a.size() == b.size()) && merkol::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline bool operator!=(const set<Key, Compare, Allocator>& a, const set<Key, Compare, Allocator>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline bool operator<(const set<Key, Compare, Allocator>& a, const set<Key, Compare, Allocator>& b)
+	{
+		return merkol::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline void swap(set<Key, Compare, Allocator>& a, set<Key, Compare, Allocator>& b)
+	{
+		a.swap(b);
+	}
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline bool operator==(const multiset<Key, Compare, Allocator>& a, const multiset<Key, Compare, Allocator>& b)
+	{
+		return (a.size() == b.size()) && merkol::equal(a.begin(), a.end(), b.begin());
+	}
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline bool operator!=(const multiset<Key, Compare, Allocator>& a, const multiset<Key, Compare, Allocator>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline bool operator<(const multiset<Key, Compare, Allocator>& a, const multiset<Key, Compare, Allocator>& b)
+	{
+		return merkol::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	template <typename Key, typename Compare, typename Allocator>
+	inline void swap(multiset<Key, Compare, Allocator>& a, multiset<Key, Compare, Allocator>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+#endif // MERKOL_SET_HPP
@@ -0,0 +1,442 @@
+#ifndef SMALL_VECTOR_HPP
+# define SMALL_VECTOR_HPP
+
+#include <cstddef>
+#include <new>
+#include "vector.hpp"
+
+namespace merkol
+{
+	/*
+		small_vector
+		A vector that keeps up to N elements in a buffer inside the object and only goes to the heap
+		when it grows beyond that. It is a merkol::vector whose allocator hands out the inline buffer
+		when it is free, so insertion, growth (GrowthPolicy), iterators and the whole interface are
+		the ones of vector:
+
+			small_vector<T, N>		owns the inline storage.
+			small_vector_base<T>	everything else; the inline capacity is a run-time value, so a function
+									can take a small_vector_base<T>& and accept any N without being
+									instantiated once per N.
+
+		The vector starts out on the inline buffer with capacity N. Growing past N moves the elements to
+		a heap block and gives the inline buffer back; shrink_to_fit() brings them back when they fit.
+
+		swap and move construction/assignment exchange heap blocks but move inline elements one by one.
+		Do not slice a small_vector_base into a plain vector: its allocator refers to the inline buffer.
+	*/
+
+	// State of the inline buffer, shared by every copy of the allocator of one small_vector.
+	struct small_buffer_header
+	{
+		void*		mpBuffer;
+		std::size_t	mCapacity;
+		bool		mInUse;
+	};
+
+	/// small_buffer_allocator
+	///
+	/// Returns the inline buffer for a request that fits while it is free, and the heap otherwise.
+	/// Copies refer to the same small_buffer_header, so a temporary vector built with a copy of the
+	/// allocator (see vector::assign) and then swapped in hands the buffer back correctly.
+	template <typename T>
+	class small_buffer_allocator
+	{
+	public:
+		typedef T					value_type;
+		typedef T*					pointer;
+		typedef const T*			const_pointer;
+		typedef T&					reference;
+		typedef const T&			const_reference;
+		typedef std::size_t			size_type;
+		typedef std::ptrdiff_t		difference_type;
+
+		template <typename U>
+		struct rebind { typedef small_buffer_allocator<U> other; };
+
+		small_buffer_allocator() : mpHeader(NULL) { }
+		explicit small_buffer_allocator(small_buffer_header* header) : mpHeader(header) { }
+		template <typename U>
+		small_buffer_allocator(const small_buffer_allocator<U>& /*other*/) : mpHeader(NULL) { } // a rebound allocator has no buffer for U
+
+		pointer allocate(size_type n, const void* /*hint*/ = 0)
+		{
+			if (mpHeader && !mpHeader->mInUse && (n <= mpHeader->mCapacity))
+			{
+				mpHeader->mInUse = true;
+				return static_cast<pointer>(mpHeader->mpBuffer);
+			}
+			return static_cast<pointer>(::operator new(n * sizeof(T)));
+		}
+
+		void deallocate(pointer p, size_type /*n*/)
+		{
+			if (mpHeader && (p == mpHeader->mpBuffer))
+				mpHeader->mInUse = false;
+			else
+				::operator delete(static_cast<void*>(p));
+		}
+
+		size_type	max_size() const { return (size_type)-1 / sizeof(T) / 2; }
+
+		bool		operator==(const small_buffer_allocator& other) const { return mpHeader == other.mpHeader; }
+		bool		operator!=(const small_buffer_allocator& other) const { return mpHeader != other.mpHeader; }
+
+	private:
+		template <typename U>
+		friend class small_buffer_allocator;
+
+		small_buffer_header*	mpHeader;
+	}; // small_buffer_allocator
+
+
+	/// small_vector_base
+	///
+	/// The N-independent part of small_vector. Not constructible on its own.
+	template <typename T, typename GrowthPolicy = merkol::growth_policy_double>
+	class small_vector_base : public merkol::vector<T, small_buffer_allocator<T>, GrowthPolicy>
+	{
+		typedef merkol::vector<T, small_buffer_allocator<T>, GrowthPolicy>	base_type;
+		typedef small_vector_base<T, GrowthPolicy>							this_type;
+
+	public:
+		typedef typename base_type::value_type		value_type;
+		typedef typename base_type::pointer			pointer;
+		typedef typename base_type::size_type		size_type;
+		typedef typename base_type::allocator_type	allocator_type;
+
+		bool		is_inline() const { return this->mpBegin == mHeader.mpBuffer; }
+		size_type	inline_capacity() const { return mHeader.mCapacity; }
+
+		this_type&	operator=(const this_type& other);
+	#if __cplusplus >= 201103L
+		this_type&	operator=(this_type&& other);
+	#endif
+
+		void		shrink_to_fit();
+		void		swap(this_type& other);
+
+	protected:
+		small_vector_base(void* buffer, size_type n);
+		~small_vector_base();
+
+		void		doResetToInline();
+		void		doMoveFrom(this_type& other);
+		void		doSwapElements(this_type& other);
+
+		small_buffer_header		mHeader;
+
+	private:
+		small_vector_base(const this_type& other); // small_vector copies through assign()
+	}; // small_vector_base
+
+
+	/// small_vector
+	///
+	/// merkol::vector with room for N elements inside the object.
+	template <typename T, std::size_t N, typename GrowthPolicy = merkol::growth_policy_double>
+	class small_vector : public small_vector_base<T, GrowthPolicy>
+	{
+		typedef small_vector_base<T, GrowthPolicy>		base_type;
+		typedef small_vector<T, N, GrowthPolicy>		this_type;
+
+	public:
+		typedef typename base_type::value_type		value_type;
+		typedef typename base_type::size_type		size_type;
+
+		static const size_type kInlineCapacity = N;
+
+		small_vector();
+		explicit small_vector(size_type n);
+		small_vector(size_type n, const value_type& value);
+		template <typename InputIterator>
+		small_vector(InputIterator first, InputIterator last, typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type* = 0);
+		small_vector(const this_type& other);
+		small_vector(const base_type& other);
+	#if __cplusplus >= 201103L
+		small_vector(this_type&& other);
+		small_vector(base_type&& other);
+	#endif
+
+		this_type&	operator=(const this_type& other);
+		this_type&	operator=(const base_type& other);
+	#if __cplusplus >= 201103L
+		this_type&	operator=(this_type&& other);
+		this_type&	operator=(base_type&& other);
+	#endif
+
+	private:
+		merkol::aligned_buffer<T>	mBuffer[N];
+	}; // small_vector
+
+
+	///////////////////////////////////////////////////////////////////////
+	// small_vector_base												///
+	///////////////////////////////////////////////////////////////////////
+
+	// mHeader is set up after the vector base, which only stores its address. buffer is the raw storage
+	// of the derived small_vector, not constructed yet either, but nothing is built in it before this
+	// constructor returns.
+	template <typename T, typename GrowthPolicy>
+	inline small_vector_base<T, GrowthPolicy>::small_vector_base(void* buffer, size_type n)
+		: base_type(allocator_type(&mHeader))
+	{
+		mHeader.mpBuffer	= buffer;
+		mHeader.mCapacity	= n;
+		mHeader.mInUse		= false;
+		doResetToInline();
+	}
+
+	// Releases everything here so that the vector destructors find an empty vector and never touch the
+	// inline buffer or mHeader after their lifetime.
+	template <typename T, typename GrowthPolicy>
+	inline small_vector_base<T, GrowthPolicy>::~small_vector_base()
+	{
+		this->clear();
+		if (!is_inline())
+			this->doFree(this->mpBegin, this->capacity());
+		this->mpBegin		= NULL;
+		this->mpEnd			= NULL;
+		this->internalPtr()	= NULL;
+	}
+
+	template <typename T, typename GrowthPolicy>
+	inline typename small_vector_base<T, GrowthPolicy>::this_type&
+	small_vector_base<T, GrowthPolicy>::operator=(const this_type& other)
+	{
+		if (this != &other)
+			this->assign(other.mpBegin, other.mpEnd);
+		return (*this);
+	}
+
+#if __cplusplus >= 201103L
+	template <typename T, typename GrowthPolicy>
+	inline typename small_vector_base<T, GrowthPolicy>::this_type&
+	small_vector_base<T, GrowthPolicy>::operator=(this_type&& other)
+	{
+		if (this != &other)
+		{
+			this->clear();
+			doMoveFrom(other);
+		}
+		return (*this);
+	}
+#endif
+
+	// Points the vector at the empty inline buffer. Whatever it owned before must have been released.
+	template <typename T, typename GrowthPolicy>
+	inline void small_vector_base<T, GrowthPolicy>::doResetToInline()
+	{
+		pointer const buffer = static_cast<pointer>(mHeader.mpBuffer);
+
+		this->mpBegin		= buffer;
+		this->mpEnd			= buffer;
+		this->internalPtr()	= buffer + mHeader.mCapacity;
+		mHeader.mInUse		= true;
+	}
+
+	// Takes the content of other, which is left empty. This vector must be empty.
+	// A heap block changes hands; inline elements are moved into our storage.
+	template <typename T, typename GrowthPolicy>
+	void small_vector_base<T, GrowthPolicy>::doMoveFrom(this_type& other)
+	{
+		if (!other.is_inline())
+		{
+			if (!is_inline())
+				this->doFree(this->mpBegin, this->capacity());
+			mHeader.mInUse		= false;
+			this->mpBegin		= other.mpBegin;
+			this->mpEnd			= other.mpEnd;
+			this->internalPtr()	= other.internalPtr();
+			other.doResetToInline();
+		}
+		else
+		{
+			this->reserve(other.size());
+			this->mpEnd = merkol::uninitialized_move(other.mpBegin, other.mpEnd, this->mpBegin);
+			other.clear();
+		}
+	}
+
+	// Swaps the common prefix in place and moves the tail of the longer vector over.
+	template <typename T, typename GrowthPolicy>
+	void small_vector_base<T, GrowthPolicy>::doSwapElements(this_type& other)
+	{
+		this_type&		longer	= (this->size() >= other.size()) ? *this : other;
+		this_type&		shorter	= (this->size() >= other.size()) ? other : *this;
+		const size_type	n		= shorter.size();
+
+		shorter.reserve(longer.size());
+		for (size_type i = 0; i < n; ++i)
+			merkol::swap(longer.mpBegin[i], shorter.mpBegin[i]);
+		shorter.mpEnd = merkol::uninitialized_move(longer.mpBegin + n, longer.mpEnd, shorter.mpEnd);
+		merkol::destruct(longer.mpBegin + n, longer.mpEnd);
+		longer.mpEnd = longer.mpBegin + n;
+	}
+
+	template <typename T, typename GrowthPolicy>
+	void small_vector_base<T, GrowthPolicy>::swap(this_type& other)
+	{
+		if (this == &other)
+			return;
+		if (!is_inline() && !other.is_inline())
+		{
+			merkol::swap(this->mpBegin, other.mpBegin);
+			merkol::swap(this->mpEnd, other.mpEnd);
+			merkol::swap(this->internalPtr(), other.internalPtr());
+			return;
+		}
+
+		this_type&	onHeap		= is_inline() ? other : *this;
+		this_type&	onInline	= is_inline() ? *this : other;
+
+		// One heap block: move the inline elements into the other inline buffer, then hand the block over.
+		if (!onHeap.is_inline() && (onInline.size() <= onHeap.mHeader.mCapacity))
+		{
+			pointer const	buffer		= static_cast<pointer>(onHeap.mHeader.mpBuffer);
+			pointer const	pNewEnd		= merkol::uninitialized_move(onInline.mpBegin, onInline.mpEnd, buffer);
+			pointer const	heapBegin	= onHeap.mpBegin;
+			pointer const	heapEnd		= onHeap.mpEnd;
+			pointer const	heapCap		= onHeap.internalPtr();
+
+			onHeap.doResetToInline();
+			onHeap.mpEnd = pNewEnd;
+
+			onInline.clear();
+			onInline.mHeader.mInUse		= false;
+			onInline.mpBegin			= heapBegin;
+			onInline.mpEnd				= heapEnd;
+			onInline.internalPtr()		= heapCap;
+			return;
+		}
+		doSwapElements(other);
+	}
+
+	template <typename T, typename GrowthPolicy>
+	void small_vector_base<T, GrowthPolicy>::shrink_to_fit()
+	{
+		if (is_inline())
+			return;
+		if (this->size() > mHeader.mCapacity)
+		{
+			base_type::shrink_to_fit();
+			return;
+		}
+
+		pointer const	buffer	= static_cast<pointer>(mHeader.mpBuffer);
+		pointer const	pNewEnd	= merkol::uninitialized_move_if_noexcept(this->mpBegin, this->mpEnd, buffer);
+
+		MERKOL_TRACE(this, "small_vector::shrink_to_inline", this->size(), mHeader.mCapacity);
+		merkol::destruct(this->mpBegin, this->mpEnd);
+		this->doFree(this->mpBegin, this->capacity());
+		doResetToInline();
+		this->mpEnd = pNewEnd;
+	}
+
+	template <typename T, typename GrowthPolicy>
+	inline void swap(small_vector_base<T, GrowthPolicy>& a, small_vector_base<T, GrowthPolicy>& b)
+	{
+		a.swap(b);
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// small_vector														///
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline small_vector<T, N, GrowthPolicy>::small_vector()
+		: base_type(mBuffer, N)
+	{
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline small_vector<T, N, GrowthPolicy>::small_vector(size_type n)
+		: base_type(mBuffer, N)
+	{
+		this->resize(n);
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline small_vector<T, N, GrowthPolicy>::small_vector(size_type n, const value_type& value)
+		: base_type(mBuffer, N)
+	{
+		this->assign(n, value);
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	template <typename InputIterator>
+	inline small_vector<T, N, GrowthPolicy>::small_vector(InputIterator first, InputIterator last,
+														  typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type*)
+		: base_type(mBuffer, N)
+	{
+		this->assign(first, last);
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline small_vector<T, N, GrowthPolicy>::small_vector(const this_type& other)
+		: base_type(mBuffer, N)
+	{
+		this->assign(other.begin(), other.end());
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline small_vector<T, N, GrowthPolicy>::small_vector(const base_type& other)
+		: base_type(mBuffer, N)
+	{
+		this->assign(other.begin(), other.end());
+	}
+
+#if __cplusplus >= 201103L
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline small_vector<T, N, GrowthPolicy>::small_vector(this_type&& other)
+		: base_type(mBuffer, N)
+	{
+		this->doMoveFrom(other);
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline small_vector<T, N, GrowthPolicy>::small_vector(base_type&& other)
+		: base_type(mBuffer, N)
+	{
+		this->doMoveFrom(other);
+	}
+#endif
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline typename small_vector<T, N, GrowthPolicy>::this_type&
+	small_vector<T, N, GrowthPolicy>::operator=(const this_type& other)
+	{
+		base_type::operator=(other);
+		return (*this);
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline typename small_vector<T, N, GrowthPolicy>::this_type&
+	small_vector<T, N, GrowthPolicy>::operator=(const base_type& other)
+	{
+		base_type::operator=(other);
+		return (*this);
+	}
+
+#if __cplusplus >= 201103L
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline typename small_vector<T, N, GrowthPolicy>::this_type&
+	small_vector<T, N, GrowthPolicy>::operator=(this_type&& other)
+	{
+		base_type::operator=(std::move(other));
+		return (*this);
+	}
+
+	template <typename T, std::size_t N, typename GrowthPolicy>
+	inline typename small_vector<T, N, GrowthPolicy>::this_type&
+	small_vector<T, N, GrowthPolicy>::operator=(base_type&& other)
+	{
+		base_type::operator=(std::move(other));
+		return (*this);
+	}
+#endif
+
+} // namespace merkol
+
+#endif // SMALL_VECTOR_HPP
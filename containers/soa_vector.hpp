@@ -0,0 +1,790 @@
+#ifndef MERKOL_SOA_VECTOR_HPP
+# define MERKOL_SOA_VECTOR_HPP
+
+#if __cplusplus < 201103L
+# error "soa_vector.hpp requires C++11"
+#endif
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "../aux_templates/type_traits.hpp"
+#include "../iterators/iterator_traits.hpp"
+#include "../memory/memory.hpp"
+#include "growth_policy.hpp"
+#include "vector.hpp"
+
+/*
+	soa_vector
+
+	A vector of records stored as a structure of arrays: soa_vector<A, B, C> keeps all the A fields in
+	one contiguous array, all the B fields in the next one and so on, so that a loop over one field reads
+	nothing else and the compiler can vectorize it. The columns share one allocation, made through
+	vectorBase (the same allocate, free and length checks as merkol::vector) in units of soa_block:
+
+		| A[0] ... A[capacity - 1] pad | B[0] ... B[capacity - 1] pad | C[0] ... pad |
+
+	Every column starts at a multiple of MERKOL_CACHE_LINE_SIZE bytes from the start of the allocation.
+	Growing reallocates the block and relocates column by column (memcpy for trivially relocatable
+	fields), with the strong guarantee. Moving or copying is decided once for the whole row: if any field
+	could throw from its move constructor (and can be copied), every copyable column is copied, otherwise
+	every column is moved. A column that had to be moved anyway (a move only field) is moved back if a
+	later one throws. The old elements are only destroyed once every column has been built.
+
+	Access:
+		column<I>()		a column_span<F> over field I of the first size() rows, for the kernels
+		data<I>()		the same column as a pointer
+		v[i], iterators	rows, as tuples of references (std::tuple<A&, B&, C&>): std::get<1>(v[i]) = b;
+		push_back		one argument per field, or a std::tuple<A, B, C>
+
+	Row iterators are random access iterators with a proxy reference, like vector<bool>'s. Reading
+	algorithms (for_each, find_if, copy to another container) work with them; algorithms that swap
+	elements through the references (std::sort) do not.
+
+	soa_vector<Fields...> uses std::allocator and doubles its capacity; basic_soa_vector takes the
+	allocator (rebound to soa_block) and the growth policy first.
+*/
+
+namespace merkol
+{
+	/// soa_block
+	///
+	/// Allocation unit of soa_vector: one cache line, aligned for any fundamental type.
+	struct soa_block
+	{
+		alignas(std::max_align_t) unsigned char	mBytes[MERKOL_CACHE_LINE_SIZE];
+	};
+
+
+	/// column_span
+	///
+	/// A pointer and a size: one column of a soa_vector. T is const qualified for const vectors.
+	template <typename T>
+	class column_span
+	{
+	public:
+		typedef typename merkol::remove_cv<T>::type		value_type;
+		typedef T										element_type;
+		typedef T*										pointer;
+		typedef T&										reference;
+		typedef T*										iterator;
+		typedef std::size_t								size_type;
+
+		column_span() : mpData(NULL), mnSize(0) { }
+		column_span(pointer data, size_type size) : mpData(data), mnSize(size) { }
+
+		pointer		data() const { return mpData; }
+		size_type	size() const { return mnSize; }
+		bool		empty() const { return mnSize == 0; }
+		iterator	begin() const { return mpData; }
+		iterator	end() const { return mpData + mnSize; }
+		reference	operator[](size_type i) const { return mpData[i]; }
+
+	private:
+		pointer		mpData;
+		size_type	mnSize;
+	};
+
+
+	/// soa_iterator
+	///
+	/// Random access iterator over the rows of a soa_vector: the vector and an index. Dereferencing
+	/// builds the row's tuple of references.
+	template <typename Vector, typename Reference>
+	class soa_iterator
+	{
+		template <typename, typename> friend class soa_iterator;
+
+	public:
+		typedef typename Vector::value_type					value_type;
+		typedef Reference									reference;
+		typedef std::ptrdiff_t								difference_type;
+		typedef merkol::random_access_iterator_tag			iterator_category;
+
+		// operator-> on a proxy: holds the row.
+		struct pointer
+		{
+			Reference	mRow;
+
+			Reference*	operator->() { return &mRow; }
+		};
+
+		soa_iterator() : mpVector(NULL), mnIndex(0) { }
+		soa_iterator(Vector* vector, std::size_t index) : mpVector(vector), mnIndex(index) { }
+
+		// convertion to const
+		template <typename V, typename R>
+		soa_iterator(const soa_iterator<V, R>& other) : mpVector(other.mpVector), mnIndex(other.mnIndex) { }
+
+		std::size_t	index() const { return mnIndex; }
+
+		reference	operator*() const { return (*mpVector)[mnIndex]; }
+		pointer		operator->() const { pointer p = { (*mpVector)[mnIndex] }; return p; }
+		reference	operator[](difference_type n) const { return (*mpVector)[mnIndex + n]; }
+
+		soa_iterator&	operator++() { ++mnIndex; return *this; }
+		soa_iterator	operator++(int) { soa_iterator temp(*this); ++mnIndex; return temp; }
+		soa_iterator&	operator--() { --mnIndex; return *this; }
+		soa_iterator	operator--(int) { soa_iterator temp(*this); --mnIndex; return temp; }
+
+		soa_iterator&	operator+=(difference_type n) { mnIndex += n; return *this; }
+		soa_iterator&	operator-=(difference_type n) { mnIndex -= n; return *this; }
+		soa_iterator	operator+(difference_type n) const { return soa_iterator(mpVector, mnIndex + n); }
+		soa_iterator	operator-(difference_type n) const { return soa_iterator(mpVector, mnIndex - n); }
+
+	private:
+		Vector*		mpVector;
+		std::size_t	mnIndex;
+	};
+
+	template <typename V1, typename R1, typename V2, typename R2>
+	inline bool operator==(const soa_iterator<V1, R1>& lhs, const soa_iterator<V2, R2>& rhs)
+	{
+		return (lhs.index() == rhs.index());
+	}
+
+	template <typename V1, typename R1, typename V2, typename R2>
+	inline bool operator!=(const soa_iterator<V1, R1>& lhs, const soa_iterator<V2, R2>& rhs)
+	{
+		return (lhs.index() != rhs.index());
+	}
+
+	template <typename V1, typename R1, typename V2, typename R2>
+	inline bool operator<(const soa_iterator<V1, R1>& lhs, const soa_iterator<V2, R2>& rhs)
+	{
+		return (lhs.index() < rhs.index());
+	}
+
+	template <typename V1, typename R1, typename V2, typename R2>
+	inline bool operator>(const soa_iterator<V1, R1>& lhs, const soa_iterator<V2, R2>& rhs)
+	{
+		return (rhs < lhs);
+	}
+
+	template <typename V1, typename R1, typename V2, typename R2>
+	inline bool operator<=(const soa_iterator<V1, R1>& lhs, const soa_iterator<V2, R2>& rhs)
+	{
+		return !(rhs < lhs);
+	}
+
+	template <typename V1, typename R1, typename V2, typename R2>
+	inline bool operator>=(const soa_iterator<V1, R1>& lhs, const soa_iterator<V2, R2>& rhs)
+	{
+		return !(lhs < rhs);
+	}
+
+	template <typename V1, typename R1, typename V2, typename R2>
+	inline std::ptrdiff_t operator-(const soa_iterator<V1, R1>& lhs, const soa_iterator<V2, R2>& rhs)
+	{
+		return (std::ptrdiff_t)(lhs.index() - rhs.index());
+	}
+
+	template <typename V, typename R>
+	inline soa_iterator<V, R> operator+(std::ptrdiff_t n, const soa_iterator<V, R>& it)
+	{
+		return it + n;
+	}
+
+
+	/**
+	 * @brief basic_soa_vector
+	 * Vector of records (Fields...) stored column by column in one allocation (see above).
+	 *
+	 * @tparam Allocator any allocator, rebound to soa_block
+	 * @tparam GrowthPolicy capacity growth, in rows (see growth_policy.hpp)
+	 */
+	template <typename Allocator, typename GrowthPolicy, typename... Fields>
+	class basic_soa_vector
+		: protected vectorBase<soa_block, typename Allocator::template rebind<soa_block>::other, GrowthPolicy>
+	{
+		typedef vectorBase<soa_block, typename Allocator::template rebind<soa_block>::other, GrowthPolicy>	base_type;
+		typedef basic_soa_vector<Allocator, GrowthPolicy, Fields...>											this_type;
+		typedef std::tuple<Fields*...>																			columns_type;
+
+		static_assert(sizeof...(Fields) > 0, "soa_vector needs at least one field");
+
+	public:
+		typedef std::tuple<Fields...>													value_type;
+		typedef std::tuple<Fields&...>													reference;
+		typedef std::tuple<const Fields&...>											const_reference;
+		typedef soa_iterator<this_type, reference>										iterator;
+		typedef soa_iterator<const this_type, const_reference>							const_iterator;
+		typedef std::size_t																size_type;
+		typedef std::ptrdiff_t															difference_type;
+		typedef typename base_type::allocator_type										allocator_type;
+
+		template <std::size_t I>
+		using field_type = typename std::tuple_element<I, value_type>::type;
+
+		static const size_type kFieldCount	= sizeof...(Fields);
+		static const size_type kBlockSize	= sizeof(soa_block);
+
+	public:
+		explicit basic_soa_vector(const allocator_type& allocator = allocator_type());
+		explicit basic_soa_vector(size_type n, const allocator_type& allocator = allocator_type());
+		basic_soa_vector(const basic_soa_vector& other);
+		basic_soa_vector(basic_soa_vector&& other);
+		~basic_soa_vector();
+
+		basic_soa_vector&	operator=(const basic_soa_vector& other);
+		basic_soa_vector&	operator=(basic_soa_vector&& other);
+		void				swap(basic_soa_vector& other);
+
+		iterator			begin() { return iterator(this, 0); }
+		const_iterator		begin() const { return const_iterator(this, 0); }
+		iterator			end() { return iterator(this, mnSize); }
+		const_iterator		end() const { return const_iterator(this, mnSize); }
+
+		size_type			size() const M_NOEXCEPT { return mnSize; }
+		bool				empty() const M_NOEXCEPT { return mnSize == 0; }
+		size_type			capacity() const M_NOEXCEPT { return mnCapacity; }
+		size_type			max_size() const M_NOEXCEPT;
+
+		void				reserve(size_type n);
+		void				resize(size_type n);
+		void				clear() M_NOEXCEPT;
+
+		reference			operator[](size_type i) { return doRow(i, merkol::make_index_sequence<kFieldCount>()); }
+		const_reference		operator[](size_type i) const { return doRow(i, merkol::make_index_sequence<kFieldCount>()); }
+		reference			back() { return (*this)[mnSize - 1]; }
+		const_reference		back() const { return (*this)[mnSize - 1]; }
+
+		template <std::size_t I>
+		field_type<I>*							data() { return std::get<I>(mColumns); }
+		template <std::size_t I>
+		const field_type<I>*					data() const { return std::get<I>(mColumns); }
+		template <std::size_t I>
+		column_span<field_type<I> >				column() { return column_span<field_type<I> >(std::get<I>(mColumns), mnSize); }
+		template <std::size_t I>
+		column_span<const field_type<I> >		column() const { return column_span<const field_type<I> >(std::get<I>(mColumns), mnSize); }
+
+		void				push_back(const Fields&... values);
+		void				push_back(const value_type& row);
+		void				push_back(value_type&& row);
+		void				pop_back();
+
+		allocator_type		get_allocator() const { return base_type::get_allocator(); }
+
+	protected:
+		size_type		mnSize;
+		size_type		mnCapacity;
+		columns_type	mColumns;
+
+		typedef merkol::integral_constant<bool, true>	fields_done;
+		typedef merkol::integral_constant<bool, false>	fields_left;
+
+		template <std::size_t I>
+		struct is_last_field : merkol::integral_constant<bool, (I == sizeof...(Fields))> {};
+
+		// True when some field from I on could throw half way through a move: rows are then copied.
+		template <std::size_t I, bool Last = (I == sizeof...(Fields))>
+		struct copies_rows : merkol::integral_constant<bool, merkol::move_if_noexcept_cond<field_type<I> >::value ||
+															 copies_rows<I + 1>::value> {};
+		template <std::size_t I>
+		struct copies_rows<I, true> : merkol::false_type {};
+
+		// Column I is copied on reallocation, rather than moved.
+		template <std::size_t I>
+		struct copies_column : merkol::integral_constant<bool, copies_rows<0>::value &&
+															   merkol::is_copy_constructible<field_type<I> >::value> {};
+
+		// A block and the columns laid out in it, freed by the destructor unless adopted.
+		struct buffer
+		{
+			this_type*		mpOwner;
+			soa_block*		mpBlocks;
+			size_type		mnBlocks;
+			columns_type	mColumns;
+
+			buffer(this_type* owner, size_type capacity);
+			~buffer() { mpOwner->doFree(mpBlocks, mnBlocks); }
+		};
+
+		static std::size_t	doColumnBytes(size_type capacity, std::size_t fieldSize) { return (capacity * fieldSize + kBlockSize - 1) / kBlockSize * kBlockSize; }
+		static std::size_t	doRowBytes();
+		static size_type	doBlockCount(size_type capacity);
+		template <std::size_t... I>
+		static columns_type	doColumns(soa_block* blocks, size_type capacity, merkol::index_sequence<I...>);
+
+		template <std::size_t... I>
+		reference			doRow(size_type i, merkol::index_sequence<I...>) { return reference(std::get<I>(mColumns)[i]...); }
+		template <std::size_t... I>
+		const_reference		doRow(size_type i, merkol::index_sequence<I...>) const { return const_reference(std::get<I>(mColumns)[i]...); }
+
+		size_type			doGrowCapacity(size_type required);
+		void				doAdopt(buffer& fresh, size_type capacity);
+
+		template <std::size_t... I>
+		static void			doDestroy(columns_type& columns, size_type first, size_type last, merkol::index_sequence<I...>);
+		template <std::size_t... I>
+		void				doDestroyRelocated(merkol::index_sequence<I...>);
+
+		// Each of these runs over the fields from I on, and undoes field I if a later one throws.
+		template <std::size_t I, typename Refs>
+		static void			doConstructRow(columns_type& columns, size_type row, Refs& refs, fields_left);
+		template <std::size_t I, typename Refs>
+		static void			doConstructRow(columns_type&, size_type, Refs&, fields_done) { }
+		template <std::size_t I>
+		static void			doMoveColumns(columns_type& from, columns_type& to, size_type n, fields_left);
+		template <std::size_t I>
+		static void			doMoveColumns(columns_type&, columns_type&, size_type, fields_done) { }
+		template <typename Field>
+		static void			doRelocateColumn(Field* source, Field* dest, size_type n, merkol::true_type) { merkol::uninitialized_copy(static_cast<const Field*>(source), static_cast<const Field*>(source) + n, dest); }
+		template <typename Field>
+		static void			doRelocateColumn(Field* source, Field* dest, size_type n, merkol::false_type) { merkol::uninitialized_move(source, source + n, dest); }
+		template <typename Field>
+		static void			doRestoreColumn(Field*, Field*, size_type, merkol::true_type) { }
+		template <typename Field>
+		static void			doRestoreColumn(Field* source, Field* dest, size_type n, merkol::false_type);
+		template <std::size_t I>
+		static void			doCopyColumns(const columns_type& from, columns_type& to, size_type n, fields_left);
+		template <std::size_t I>
+		static void			doCopyColumns(const columns_type&, columns_type&, size_type, fields_done) { }
+		template <std::size_t I>
+		static void			doValueConstruct(columns_type& columns, size_type first, size_type n, fields_left);
+		template <std::size_t I>
+		static void			doValueConstruct(columns_type&, size_type, size_type, fields_done) { }
+
+		template <typename Refs>
+		void				doPushBack(Refs& refs);
+		void				doReallocate(size_type capacity);
+	}; // basic_soa_vector
+
+
+	/// soa_vector
+	///
+	/// basic_soa_vector with std::allocator and doubling growth.
+	template <typename... Fields>
+	using soa_vector = basic_soa_vector<std::allocator<soa_block>, merkol::growth_policy_double, Fields...>;
+
+
+	///////////////////////////////////////////////////////////////////////
+	// SoaVector.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	#define MERKOL_SOA_VECTOR_TEMPLATE	template <typename Allocator, typename GrowthPolicy, typename... Fields>
+	#define MERKOL_SOA_VECTOR			basic_soa_vector<Allocator, GrowthPolicy, Fields...>
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	const typename MERKOL_SOA_VECTOR::size_type MERKOL_SOA_VECTOR::kFieldCount;
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	const typename MERKOL_SOA_VECTOR::size_type MERKOL_SOA_VECTOR::kBlockSize;
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	std::size_t MERKOL_SOA_VECTOR::doRowBytes()
+	{
+		const std::size_t	sizes[]	= { sizeof(Fields)... };
+		std::size_t			bytes	= 0;
+
+		for (size_type i = 0; i < kFieldCount; ++i)
+			bytes += sizes[i];
+		return bytes;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	typename MERKOL_SOA_VECTOR::size_type MERKOL_SOA_VECTOR::doBlockCount(size_type capacity)
+	{
+		const std::size_t	sizes[]	= { sizeof(Fields)... };
+		std::size_t			bytes	= 0;
+
+		for (size_type i = 0; i < kFieldCount; ++i)
+			bytes += doColumnBytes(capacity, sizes[i]);
+		return bytes / kBlockSize;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <std::size_t... I>
+	typename MERKOL_SOA_VECTOR::columns_type MERKOL_SOA_VECTOR::doColumns(soa_block* blocks, size_type capacity, merkol::index_sequence<I...>)
+	{
+		const std::size_t	sizes[]		= { sizeof(Fields)... };
+		std::size_t			offsets[]	= { I... };
+		std::size_t			offset		= 0;
+
+		for (size_type i = 0; i < kFieldCount; ++i)
+		{
+			offsets[i] = offset;
+			offset += doColumnBytes(capacity, sizes[i]);
+		}
+
+		unsigned char* const bytes = reinterpret_cast<unsigned char*>(blocks);
+
+		return blocks ? columns_type(reinterpret_cast<Fields*>(bytes + offsets[I])...) : columns_type();
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR::buffer::buffer(this_type* owner, size_type capacity)
+		: mpOwner(owner), mpBlocks(NULL), mnBlocks(doBlockCount(capacity))
+	{
+		mpBlocks	= owner->doAllocate(mnBlocks);
+		mColumns	= doColumns(mpBlocks, capacity, merkol::make_index_sequence<kFieldCount>());
+	}
+
+	// The largest block the allocator can give, less the padding of every column.
+	MERKOL_SOA_VECTOR_TEMPLATE
+	typename MERKOL_SOA_VECTOR::size_type MERKOL_SOA_VECTOR::max_size() const M_NOEXCEPT
+	{
+		const size_type blocks = base_type::get_allocator().max_size();
+		const size_type limit	= (size_type)-1 / kBlockSize;
+
+		return ((blocks < limit ? blocks : limit) - kFieldCount) * kBlockSize / doRowBytes();
+	}
+
+	// Takes over fresh, a block of capacity rows whose columns hold the mnSize (or mnSize + 1) rows.
+	MERKOL_SOA_VECTOR_TEMPLATE
+	void MERKOL_SOA_VECTOR::doAdopt(buffer& fresh, size_type capacity)
+	{
+		merkol::swap(this->mpBegin, fresh.mpBlocks);
+		fresh.mnBlocks	= (size_type)(this->internalPtr() - fresh.mpBlocks);
+		this->mpEnd		= this->mpBegin + doBlockCount(capacity);
+		this->internalPtr() = this->mpEnd;
+		mColumns		= fresh.mColumns;
+		mnCapacity		= capacity;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR::basic_soa_vector(const allocator_type& allocator)
+		: base_type(allocator), mnSize(0), mnCapacity(0), mColumns()
+	{
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR::basic_soa_vector(size_type n, const allocator_type& allocator)
+		: base_type(allocator), mnSize(0), mnCapacity(0), mColumns()
+	{
+		resize(n);
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR::basic_soa_vector(const basic_soa_vector& other)
+		: base_type(other.get_allocator()), mnSize(0), mnCapacity(0), mColumns()
+	{
+		if (other.mnSize)
+		{
+			buffer fresh(this, other.mnSize);
+
+			doCopyColumns<0>(other.mColumns, fresh.mColumns, other.mnSize, fields_left());
+			doAdopt(fresh, other.mnSize);
+			mnSize = other.mnSize;
+		}
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR::basic_soa_vector(basic_soa_vector&& other)
+		: base_type(other.get_allocator()), mnSize(0), mnCapacity(0), mColumns()
+	{
+		swap(other);
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR::~basic_soa_vector()
+	{
+		doDestroy(mColumns, 0, mnSize, merkol::make_index_sequence<kFieldCount>());
+		// vectorBase frees the block
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR& MERKOL_SOA_VECTOR::operator=(const basic_soa_vector& other)
+	{
+		if (this != &other)
+		{
+			basic_soa_vector temp(other);
+
+			swap(temp);
+		}
+		return *this;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	MERKOL_SOA_VECTOR& MERKOL_SOA_VECTOR::operator=(basic_soa_vector&& other)
+	{
+		swap(other);
+		return *this;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	void MERKOL_SOA_VECTOR::swap(basic_soa_vector& other)
+	{
+		merkol::swap(this->mpBegin, other.mpBegin);
+		merkol::swap(this->mpEnd, other.mpEnd);
+		merkol::swap(this->mCapacityAllocator, other.mCapacityAllocator);
+		merkol::swap(mnSize, other.mnSize);
+		merkol::swap(mnCapacity, other.mnCapacity);
+		mColumns.swap(other.mColumns);
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <std::size_t... I>
+	void MERKOL_SOA_VECTOR::doDestroy(columns_type& columns, size_type first, size_type last, merkol::index_sequence<I...>)
+	{
+		const int expand[] = { 0, (merkol::destruct(std::get<I>(columns) + first, std::get<I>(columns) + last), 0)... };
+
+		(void)expand;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <std::size_t I, typename Refs>
+	void MERKOL_SOA_VECTOR::doConstructRow(columns_type& columns, size_type row, Refs& refs, fields_left)
+	{
+		typedef field_type<I>										field;
+		typedef typename std::tuple_element<I, Refs>::type			source;
+
+		field* const p = std::get<I>(columns) + row;
+
+		::new(static_cast<void*>(p)) field(std::forward<source>(std::get<I>(refs)));
+		try
+		{
+			doConstructRow<I + 1>(columns, row, refs, is_last_field<I + 1>());
+		}
+		catch (...)
+		{
+			p->~field();
+			throw;
+		}
+	}
+
+	// Builds the n rows of from in to, column by column: trivially relocatable columns are copied bytewise,
+	// the others copied or moved as the whole row is (see copies_column). The sources are left for the
+	// caller to destroy or, if this throws, as they were: moved columns are moved back.
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <std::size_t I>
+	void MERKOL_SOA_VECTOR::doMoveColumns(columns_type& from, columns_type& to, size_type n, fields_left)
+	{
+		typedef field_type<I> field;
+
+		field* const source = std::get<I>(from);
+		field* const dest	= std::get<I>(to);
+
+		if (merkol::is_trivially_relocatable<field>::value)
+		{
+			if (n)
+				std::memcpy(static_cast<void*>(dest), static_cast<const void*>(source), n * sizeof(field));
+			doMoveColumns<I + 1>(from, to, n, is_last_field<I + 1>());
+			return;
+		}
+		doRelocateColumn(source, dest, n, copies_column<I>());
+		try
+		{
+			doMoveColumns<I + 1>(from, to, n, is_last_field<I + 1>());
+		}
+		catch (...)
+		{
+			doRestoreColumn(source, dest, n, copies_column<I>());
+			merkol::destruct(dest, dest + n);
+			throw;
+		}
+	}
+
+	// Undoes the move of a column, the move of a later one having thrown: the moved from sources are
+	// rebuilt from the new elements (a column is only moved when it can not be copied, or when no column
+	// can throw from a move).
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <typename Field>
+	void MERKOL_SOA_VECTOR::doRestoreColumn(Field* source, Field* dest, size_type n, merkol::false_type)
+	{
+		for (size_type i = 0; i < n; ++i)
+		{
+			source[i].~Field();
+			::new(static_cast<void*>(source + i)) Field(std::move(dest[i]));
+		}
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <std::size_t I>
+	void MERKOL_SOA_VECTOR::doCopyColumns(const columns_type& from, columns_type& to, size_type n, fields_left)
+	{
+		typedef field_type<I> field;
+
+		field* const dest = std::get<I>(to);
+
+		merkol::uninitialized_copy(static_cast<const field*>(std::get<I>(from)), static_cast<const field*>(std::get<I>(from)) + n, dest);
+		try
+		{
+			doCopyColumns<I + 1>(from, to, n, is_last_field<I + 1>());
+		}
+		catch (...)
+		{
+			merkol::destruct(dest, dest + n);
+			throw;
+		}
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <std::size_t I>
+	void MERKOL_SOA_VECTOR::doValueConstruct(columns_type& columns, size_type first, size_type n, fields_left)
+	{
+		typedef field_type<I> field;
+
+		field* const dest = std::get<I>(columns) + first;
+
+		merkol::uninitialized_value_construct_n(dest, n);
+		try
+		{
+			doValueConstruct<I + 1>(columns, first, n, is_last_field<I + 1>());
+		}
+		catch (...)
+		{
+			merkol::destruct(dest, dest + n);
+			throw;
+		}
+	}
+
+	// Once every column is in the new block, destroys the moved from elements. Columns of trivially
+	// relocatable fields were copied bytewise: their elements now live in the new block and are left alone.
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <std::size_t... I>
+	void MERKOL_SOA_VECTOR::doDestroyRelocated(merkol::index_sequence<I...>)
+	{
+		const int expand[] = { 0, (merkol::is_trivially_relocatable<field_type<I> >::value
+									? 0 : (merkol::destruct(std::get<I>(mColumns), std::get<I>(mColumns) + mnSize), 0))... };
+
+		(void)expand;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	typename MERKOL_SOA_VECTOR::size_type MERKOL_SOA_VECTOR::doGrowCapacity(size_type required)
+	{
+		size_type capacity = GrowthPolicy::grow(mnCapacity, doRowBytes());
+
+		if ((capacity <= mnCapacity) || (capacity > max_size()))
+			capacity = max_size();
+		if (required > max_size())
+			throw std::length_error("merkol::soa_vector -- requested size exceeds max_size()");
+		return (capacity < required) ? required : capacity;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	void MERKOL_SOA_VECTOR::doReallocate(size_type capacity)
+	{
+		buffer fresh(this, capacity);
+
+		doMoveColumns<0>(mColumns, fresh.mColumns, mnSize, fields_left());
+		doDestroyRelocated(merkol::make_index_sequence<kFieldCount>());
+		doAdopt(fresh, capacity);
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	template <typename Refs>
+	void MERKOL_SOA_VECTOR::doPushBack(Refs& refs)
+	{
+		if (mnSize < mnCapacity)
+		{
+			doConstructRow<0>(mColumns, mnSize, refs, fields_left());
+			++mnSize;
+			return;
+		}
+
+		// The new row is built before the old ones move: refs may point into this vector.
+		const size_type	capacity = doGrowCapacity(mnSize + 1);
+		buffer			fresh(this, capacity);
+
+		doConstructRow<0>(fresh.mColumns, mnSize, refs, fields_left());
+		try
+		{
+			doMoveColumns<0>(mColumns, fresh.mColumns, mnSize, fields_left());
+		}
+		catch (...)
+		{
+			doDestroy(fresh.mColumns, mnSize, mnSize + 1, merkol::make_index_sequence<kFieldCount>());
+			throw;
+		}
+		doDestroyRelocated(merkol::make_index_sequence<kFieldCount>());
+		doAdopt(fresh, capacity);
+		++mnSize;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	inline void MERKOL_SOA_VECTOR::push_back(const Fields&... values)
+	{
+		std::tuple<const Fields&...> refs(values...);
+
+		doPushBack(refs);
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	inline void MERKOL_SOA_VECTOR::push_back(const value_type& row)
+	{
+		doPushBack(row);
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	inline void MERKOL_SOA_VECTOR::push_back(value_type&& row)
+	{
+		doPushBack(row);
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	inline void MERKOL_SOA_VECTOR::pop_back()
+	{
+		--mnSize;
+		doDestroy(mColumns, mnSize, mnSize + 1, merkol::make_index_sequence<kFieldCount>());
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	void MERKOL_SOA_VECTOR::reserve(size_type n)
+	{
+		if (n > mnCapacity)
+		{
+			if (n > max_size())
+				throw std::length_error("merkol::soa_vector -- requested size exceeds max_size()");
+			doReallocate(n);
+		}
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	void MERKOL_SOA_VECTOR::resize(size_type n)
+	{
+		if (n < mnSize)
+		{
+			doDestroy(mColumns, n, mnSize, merkol::make_index_sequence<kFieldCount>());
+			mnSize = n;
+			return;
+		}
+		if (n > mnCapacity)
+			doReallocate(doGrowCapacity(n));
+		doValueConstruct<0>(mColumns, mnSize, n - mnSize, fields_left());
+		mnSize = n;
+	}
+
+	MERKOL_SOA_VECTOR_TEMPLATE
+	void MERKOL_SOA_VECTOR::clear() M_NOEXCEPT
+	{
+		doDestroy(mColumns, 0, mnSize, merkol::make_index_sequence<kFieldCount>());
+		mnSize = 0;
+	}
+
+	#undef MERKOL_SOA_VECTOR_TEMPLATE
+	#undef MERKOL_SOA_VECTOR
+
+	///////////////////////////////////////////////////////////////////////
+	// SoaVector.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+
+	template <typename Allocator, typename GrowthPolicy, typename... Fields>
+	inline void swap(basic_soa_vector<Allocator, GrowthPolicy, Fields...>& a, basic_soa_vector<Allocator, GrowthPolicy, Fields...>& b)
+	{
+		a.swap(b);
+	}
+
+} // namespace merkol
+
+// Standard algorithms see a std:: random access tag.
+namespace std
+{
+	template <typename Vector, typename Reference>
+	struct iterator_traits<merkol::soa_iterator<Vector, Reference> >
+	{
+		typedef std::random_access_iterator_tag									iterator_category;
+		typedef typename merkol::soa_iterator<Vector, Reference>::value_type	value_type;
+		typedef std::ptrdiff_t													difference_type;
+		typedef typename merkol::soa_iterator<Vector, Reference>::pointer		pointer;
+		typedef Reference														reference;
+	};
+} // namespace std
+
+#endif // MERKOL_SOA_VECTOR_HPP
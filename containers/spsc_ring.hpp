@@ -0,0 +1,332 @@
+#ifndef MERKOL_SPSC_RING_HPP
+# define MERKOL_SPSC_RING_HPP
+
+#if __cplusplus < 201103L
+# error "spsc_ring.hpp requires C++11"
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+#include "../aux_templates/type_traits.hpp"
+#include "../memory/memory.hpp"
+
+/*
+	spsc_ring
+
+	A bounded queue between exactly one producer thread and one consumer thread, without locks. The
+	elements live in an array of Capacity slots (a power of two, so that an index is reduced with a mask)
+	allocated once by the constructor. Two free running counters say where the queue is:
+
+		tail	slots pushed so far, written by the producer only
+		head	slots popped so far, written by the consumer only
+
+	The producer constructs an element in slot tail & (Capacity - 1), then publishes it by storing tail + 1
+	with release semantics; the consumer loads tail with acquire semantics before reading the slot, and
+	frees it the same way through head. tail - head is the size, between 0 and Capacity.
+
+	Each side keeps a private copy of the other side's counter (mHeadCache for the producer, mTailCache
+	for the consumer) and only reloads the shared one when the copy says the ring is full, or empty. While
+	the ring is neither, a push or a pop touches nothing but the cache line of its own side and the slot,
+	so the two cores do not pass the counters' cache lines back and forth on every element. The two sides
+	are MERKOL_CACHE_LINE_SIZE bytes apart, with padding in front and at the back as well, which keeps
+	them on separate lines whatever the alignment of the ring object itself.
+
+	push_n and pop_n move a batch with one counter update: the batch covers at most two contiguous spans
+	of slots (before and after the wrap), each copied with uninitialized_copy, that is with memcpy when T
+	is trivially copyable, and popped into the destination with memcpy as well.
+
+	Calling a producer function from two threads at once, or a consumer function from two threads at
+	once, is a data race. size() and empty() may be called from either thread and are only a snapshot.
+*/
+
+namespace merkol
+{
+	/**
+	 * @brief spsc_ring
+	 * Lock-free single producer, single consumer ring buffer (see above). Producer functions: try_push,
+	 * try_emplace, push_n. Consumer functions: try_pop, front, pop, pop_n.
+	 *
+	 * @tparam Capacity number of slots, a power of two, at least 2
+	 */
+	template <typename T, std::size_t Capacity, typename Allocator = std::allocator<T> >
+	class spsc_ring
+	{
+		static_assert((Capacity >= 2) && ((Capacity & (Capacity - 1)) == 0), "spsc_ring capacity must be a power of two");
+
+	public:
+		typedef T																		value_type;
+		typedef T*																		pointer;
+		typedef const T*																const_pointer;
+		typedef T&																		reference;
+		typedef const T&																const_reference;
+		typedef std::size_t																size_type;
+		typedef Allocator																allocator_type;
+
+		static const size_type kCapacity	= Capacity;
+
+	public:
+		explicit spsc_ring(const allocator_type& allocator = allocator_type());
+		~spsc_ring();
+
+		spsc_ring(const spsc_ring&) = delete;
+		spsc_ring& operator=(const spsc_ring&) = delete;
+
+		// Producer. false (or fewer than n) when the ring is full; nothing is constructed then.
+		bool			try_push(const value_type& value);
+		bool			try_push(value_type&& value);
+		template <typename... Args>
+		bool			try_emplace(Args&&... args);
+		size_type		push_n(const value_type* first, size_type n);
+
+		// Consumer. false (or fewer than n) when the ring is empty.
+		bool			try_pop(value_type& value);
+		pointer			front();				// NULL when empty; the element stays in the ring until pop()
+		void			pop();					// the ring must not be empty
+		size_type		pop_n(value_type* dest, size_type n);
+
+		size_type		size() const M_NOEXCEPT;
+		bool			empty() const M_NOEXCEPT { return size() == 0; }
+		static constexpr size_type	capacity() M_NOEXCEPT { return Capacity; }
+
+		allocator_type	get_allocator() const { return mAllocator; }
+
+	protected:
+		static const size_type kMask		= Capacity - 1;
+
+		struct consumer_side
+		{
+			std::atomic<size_type>	mHead;
+			size_type				mTailCache;
+			pointer					mpSlots;
+		};
+
+		struct producer_side
+		{
+			std::atomic<size_type>	mTail;
+			size_type				mHeadCache;
+			pointer					mpSlots;
+		};
+
+		unsigned char	mPadFront[MERKOL_CACHE_LINE_SIZE];
+		consumer_side	mConsumer;
+		unsigned char	mPadMiddle[MERKOL_CACHE_LINE_SIZE];
+		producer_side	mProducer;
+		unsigned char	mPadBack[MERKOL_CACHE_LINE_SIZE];
+		allocator_type	mAllocator;
+
+		size_type		doFreeSlots(size_type tail, size_type wanted);
+		size_type		doFilledSlots(size_type head, size_type wanted);
+		void			doPopSpan(pointer first, size_type n, value_type* dest, merkol::true_type);
+		void			doPopSpan(pointer first, size_type n, value_type* dest, merkol::false_type);
+	}; // spsc_ring
+
+
+	///////////////////////////////////////////////////////////////////////
+	// SpscRing.imp.begin();											///
+	///////////////////////////////////////////////////////////////////////
+
+	#define MERKOL_SPSC_RING_TEMPLATE	template <typename T, std::size_t Capacity, typename Allocator>
+	#define MERKOL_SPSC_RING			spsc_ring<T, Capacity, Allocator>
+
+	MERKOL_SPSC_RING_TEMPLATE
+	const typename MERKOL_SPSC_RING::size_type MERKOL_SPSC_RING::kCapacity;
+
+	MERKOL_SPSC_RING_TEMPLATE
+	const typename MERKOL_SPSC_RING::size_type MERKOL_SPSC_RING::kMask;
+
+	MERKOL_SPSC_RING_TEMPLATE
+	MERKOL_SPSC_RING::spsc_ring(const allocator_type& allocator)
+		: mAllocator(allocator)
+	{
+		const pointer slots = mAllocator.allocate(Capacity);
+
+		mConsumer.mHead.store(0, std::memory_order_relaxed);
+		mConsumer.mTailCache	= 0;
+		mConsumer.mpSlots		= slots;
+		mProducer.mTail.store(0, std::memory_order_relaxed);
+		mProducer.mHeadCache	= 0;
+		mProducer.mpSlots		= slots;
+	}
+
+	// Destroys what was pushed and not popped. Both threads must be done with the ring.
+	MERKOL_SPSC_RING_TEMPLATE
+	MERKOL_SPSC_RING::~spsc_ring()
+	{
+		const size_type tail = mProducer.mTail.load(std::memory_order_acquire);
+
+		for (size_type head = mConsumer.mHead.load(std::memory_order_relaxed); head != tail; ++head)
+			mConsumer.mpSlots[head & kMask].~value_type();
+		mAllocator.deallocate(mConsumer.mpSlots, Capacity);
+	}
+
+	// Up to wanted free slots after tail, reloading head only when the cached copy does not show enough.
+	MERKOL_SPSC_RING_TEMPLATE
+	inline typename MERKOL_SPSC_RING::size_type MERKOL_SPSC_RING::doFreeSlots(size_type tail, size_type wanted)
+	{
+		size_type free = Capacity - (tail - mProducer.mHeadCache);
+
+		if (free < wanted)
+		{
+			mProducer.mHeadCache = mConsumer.mHead.load(std::memory_order_acquire);
+			free = Capacity - (tail - mProducer.mHeadCache);
+		}
+		return (free < wanted) ? free : wanted;
+	}
+
+	// Up to wanted filled slots from head, reloading tail only when the cached copy does not show enough.
+	MERKOL_SPSC_RING_TEMPLATE
+	inline typename MERKOL_SPSC_RING::size_type MERKOL_SPSC_RING::doFilledSlots(size_type head, size_type wanted)
+	{
+		size_type filled = mConsumer.mTailCache - head;
+
+		if (filled < wanted)
+		{
+			mConsumer.mTailCache = mProducer.mTail.load(std::memory_order_acquire);
+			filled = mConsumer.mTailCache - head;
+		}
+		return (filled < wanted) ? filled : wanted;
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	inline bool MERKOL_SPSC_RING::try_push(const value_type& value)
+	{
+		return try_emplace(value);
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	inline bool MERKOL_SPSC_RING::try_push(value_type&& value)
+	{
+		return try_emplace(std::move(value));
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	template <typename... Args>
+	inline bool MERKOL_SPSC_RING::try_emplace(Args&&... args)
+	{
+		const size_type tail = mProducer.mTail.load(std::memory_order_relaxed);
+
+		if (doFreeSlots(tail, 1) == 0)
+			return false;
+		::new(static_cast<void*>(mProducer.mpSlots + (tail & kMask))) value_type(std::forward<Args>(args)...);
+		mProducer.mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Pushes copies of the first min(n, free slots) elements of [first, first + n) and returns how many.
+	// If a copy throws, none of the batch is pushed.
+	MERKOL_SPSC_RING_TEMPLATE
+	typename MERKOL_SPSC_RING::size_type MERKOL_SPSC_RING::push_n(const value_type* first, size_type n)
+	{
+		const size_type tail	= mProducer.mTail.load(std::memory_order_relaxed);
+		const size_type count	= doFreeSlots(tail, n);
+		const size_type index	= tail & kMask;
+		const size_type span	= (count < Capacity - index) ? count : Capacity - index;
+		const pointer	slots	= mProducer.mpSlots;
+
+		merkol::uninitialized_copy(first, first + span, slots + index);
+		try
+		{
+			merkol::uninitialized_copy(first + span, first + count, slots);
+		}
+		catch (...)
+		{
+			merkol::destruct(slots + index, slots + index + span);
+			throw;
+		}
+		mProducer.mTail.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	inline bool MERKOL_SPSC_RING::try_pop(value_type& value)
+	{
+		const size_type head = mConsumer.mHead.load(std::memory_order_relaxed);
+
+		if (doFilledSlots(head, 1) == 0)
+			return false;
+
+		value_type& slot = mConsumer.mpSlots[head & kMask];
+
+		value = std::move(slot);
+		slot.~value_type();
+		mConsumer.mHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	inline typename MERKOL_SPSC_RING::pointer MERKOL_SPSC_RING::front()
+	{
+		const size_type head = mConsumer.mHead.load(std::memory_order_relaxed);
+
+		return (doFilledSlots(head, 1) == 0) ? NULL : mConsumer.mpSlots + (head & kMask);
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	inline void MERKOL_SPSC_RING::pop()
+	{
+		const size_type head = mConsumer.mHead.load(std::memory_order_relaxed);
+
+		mConsumer.mpSlots[head & kMask].~value_type();
+		mConsumer.mHead.store(head + 1, std::memory_order_release);
+	}
+
+	// Trivially copyable: the slots are copied out in one memcpy and need no destructor.
+	MERKOL_SPSC_RING_TEMPLATE
+	inline void MERKOL_SPSC_RING::doPopSpan(pointer first, size_type n, value_type* dest, merkol::true_type)
+	{
+		if (n)
+			std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), n * sizeof(value_type));
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	inline void MERKOL_SPSC_RING::doPopSpan(pointer first, size_type n, value_type* dest, merkol::false_type)
+	{
+		for (pointer last = first + n; first != last; ++first, ++dest)
+		{
+			*dest = std::move(*first);
+			first->~value_type();
+		}
+	}
+
+	// Moves the first min(n, size()) elements into [dest, dest + n) (assigned, not constructed) and returns
+	// how many. The assignments must not throw.
+	MERKOL_SPSC_RING_TEMPLATE
+	typename MERKOL_SPSC_RING::size_type MERKOL_SPSC_RING::pop_n(value_type* dest, size_type n)
+	{
+		const size_type head	= mConsumer.mHead.load(std::memory_order_relaxed);
+		const size_type count	= doFilledSlots(head, n);
+		const size_type index	= head & kMask;
+		const size_type span	= (count < Capacity - index) ? count : Capacity - index;
+		const pointer	slots	= mConsumer.mpSlots;
+
+		doPopSpan(slots + index, span, dest, merkol::is_trivially_copyable<value_type>());
+		doPopSpan(slots, count - span, dest + span, merkol::is_trivially_copyable<value_type>());
+		mConsumer.mHead.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	MERKOL_SPSC_RING_TEMPLATE
+	typename MERKOL_SPSC_RING::size_type MERKOL_SPSC_RING::size() const M_NOEXCEPT
+	{
+		// head first: tail only grows, so tail - head can not underflow, but it can overshoot while the
+		// consumer pops in between.
+		const size_type head	= mConsumer.mHead.load(std::memory_order_acquire);
+		const size_type tail	= mProducer.mTail.load(std::memory_order_acquire);
+
+		return (tail - head > Capacity) ? Capacity : tail - head;
+	}
+
+	#undef MERKOL_SPSC_RING_TEMPLATE
+	#undef MERKOL_SPSC_RING
+
+	///////////////////////////////////////////////////////////////////////
+	// SpscRing.imp.end();												///
+	///////////////////////////////////////////////////////////////////////
+
+} // namespace merkol
+
+#endif // MERKOL_SPSC_RING_HPP
@@ -4,12 +4,16 @@
 #include <memory>
 #include <iostream>
 #include <utility>
+#include <new>
+#include <stdexcept>
+#include <algorithm>
 #include "../iterators/random_access_iterator.hpp"
 #include "../iterators/reverse_iterator.hpp"
-#include "../auxiliary/information_printer.hpp"
+#include "../auxiliary/trace.hpp"
 #include "../aux_templates/algorithm.hpp"
 #include "../aux_templates/utils.hpp"
 #include "../memory/memory.hpp"
+#include "growth_policy.hpp"
 
 // for test
 // #include <chrono>
@@ -46,7 +50,7 @@ namespace merkol
 		"Bir nesnenin tamamen oluşturulmuş temel sınıfları ve üyeleri,
 		o blok için bir yapıcı veya yıkıcının işlev deneme bloğunun işleyicisine girmeden önce yok edilmelidir."
 	*/
-	template <typename T, typename Allocator>
+	template <typename T, typename Allocator, typename GrowthPolicy = merkol::growth_policy_double>
 	struct vectorBase
 	{
 		typedef Allocator			allocator_type;
@@ -82,6 +86,9 @@ namespace merkol
 	protected:
 		T*		doAllocate(size_type n);
 		void	doFree(T* p, size_type n);
+		T*		doReallocate(T* p, size_type n, size_type newN);
+		void	doNoteUsage(merkol::true_type);
+		void	doNoteUsage(merkol::false_type) { }
 	}; // vectorBase
 
 
@@ -89,8 +96,8 @@ namespace merkol
 	// VectorBase.imp.begin();											///
 	///////////////////////////////////////////////////////////////////////
 
-	template<typename T, typename Allocator>
-	inline vectorBase<T, Allocator>::vectorBase() 
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline vectorBase<T, Allocator, GrowthPolicy>::vectorBase() 
 		: 
 		mpBegin(NULL),
 		mpEnd(NULL),
@@ -99,8 +106,8 @@ namespace merkol
 		// check_vector_assertion<T, Allocator>();
 	}
 
-	template<typename T, typename Allocator>
-	inline vectorBase<T, Allocator>::vectorBase(const allocator_type& allocator)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline vectorBase<T, Allocator, GrowthPolicy>::vectorBase(const allocator_type& allocator)
 		: 
 		mpBegin(NULL),
 		mpEnd(NULL),
@@ -109,8 +116,8 @@ namespace merkol
 	}
 
 
-	template<typename T, typename Allocator>
-	inline vectorBase<T, Allocator>::vectorBase(size_type n, const allocator_type& allocator)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline vectorBase<T, Allocator, GrowthPolicy>::vectorBase(size_type n, const allocator_type& allocator)
 		: mCapacityAllocator(NULL, allocator)
 	{
 		mpBegin	= doAllocate(n);
@@ -118,43 +125,46 @@ namespace merkol
 		internalPtr() = mpBegin + n;
 	}
 
-	template<typename T, typename Allocator>
-	inline vectorBase<T, Allocator>::~vectorBase()
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline vectorBase<T, Allocator, GrowthPolicy>::~vectorBase()
 	{
-		print_info("merkol::vectorBase::destructor");
+		MERKOL_TRACE(this, "vectorBase::destructor", mpEnd - mpBegin, internalPtr() - mpBegin);
 		// std::this_thread::sleep_for(std::chrono::seconds(3));
 		if (mpBegin)
-			internalAllocator().deallocate(mpBegin, (internalPtr() - mpBegin) * sizeof(T));
+		{
+			doNoteUsage(merkol::allocator_tracks_usage<Allocator>());
+			internalAllocator().deallocate(mpBegin, (size_type)(internalPtr() - mpBegin));
+		}
 	}
 
-	template<typename T, typename Allocator>
-	inline typename vectorBase<T, Allocator>::allocator_type&
-	vectorBase<T, Allocator>::get_allocator()
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vectorBase<T, Allocator, GrowthPolicy>::allocator_type&
+	vectorBase<T, Allocator, GrowthPolicy>::get_allocator()
 	{
 		return (internalAllocator());
 	}
 
-	template<typename T, typename Allocator>
-	inline const typename vectorBase<T, Allocator>::allocator_type&
-	vectorBase<T, Allocator>::get_allocator() const
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline const typename vectorBase<T, Allocator, GrowthPolicy>::allocator_type&
+	vectorBase<T, Allocator, GrowthPolicy>::get_allocator() const
 	{
 		return (internalAllocator());
 	}
 
-	template<typename T, typename Allocator>
-	inline void vectorBase<T, Allocator>::set_allocator(const allocator_type& allocator)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void vectorBase<T, Allocator, GrowthPolicy>::set_allocator(const allocator_type& allocator)
 	{
 		internalAllocator() = allocator;
 	}
 
-	template<typename T, typename Allocator>
-	inline T* vectorBase<T, Allocator>::doAllocate(size_type n)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline T* vectorBase<T, Allocator, GrowthPolicy>::doAllocate(size_type n)
 	{
 		if (n > internalAllocator().max_size())
 			throw std::length_error("merkol::vector -- requested size exceeds max_size()");
 		if (n)
 		{
-			T*	ptr = (T*)internalAllocator().allocate(n * sizeof(T));
+			T*	ptr = (T*)internalAllocator().allocate(n);
 			if (!ptr)
 				throw std::runtime_error("merkol::vector -- memory allocation failed");
 			return ptr;
@@ -162,18 +172,54 @@ namespace merkol
 		return NULL;
 	}
 
-	template<typename T, typename Allocator>
-	inline void vectorBase<T, Allocator>::doFree(T* p, size_type n)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void vectorBase<T, Allocator, GrowthPolicy>::doFree(T* p, size_type n)
 	{
 		if (p)
-			internalAllocator().deallocate(p, n * sizeof(T));
+			internalAllocator().deallocate(p, n);
+	}
+
+	// Resizes the block p of n elements to newN elements through Allocator::reallocate().
+	// Only instantiated for allocators for which merkol::allocator_can_reallocate is true.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline T* vectorBase<T, Allocator, GrowthPolicy>::doReallocate(T* p, size_type n, size_type newN)
+	{
+		if (newN > internalAllocator().max_size())
+			throw std::length_error("merkol::vector -- requested size exceeds max_size()");
+		if (!newN)
+		{
+			doFree(p, n);
+			return NULL;
+		}
+		if (!p)
+			return doAllocate(newN);
+
+		T*	ptr = (T*)internalAllocator().reallocate(p, n, newN);
+		if (!ptr)
+			throw std::runtime_error("merkol::vector -- memory allocation failed");
+		return ptr;
 	}
 
-	template<typename T, typename Allocator>
-	inline typename vectorBase<T, Allocator>::size_type
-	vectorBase<T, Allocator>::getNewCapacity(size_type currentCapacity)
+	// Tells the allocator how much of the block was used when the vector is destroyed, which is what shows
+	// over-reservation. Only instantiated for allocators for which merkol::allocator_tracks_usage is true.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void vectorBase<T, Allocator, GrowthPolicy>::doNoteUsage(merkol::true_type)
 	{
-		return (currentCapacity > 0) ? (currentCapacity * 2) : 1;
+		internalAllocator().note_usage(mpBegin, (size_type)(internalPtr() - mpBegin), (size_type)(mpEnd - mpBegin));
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vectorBase<T, Allocator, GrowthPolicy>::size_type
+	vectorBase<T, Allocator, GrowthPolicy>::getNewCapacity(size_type currentCapacity)
+	{
+		const size_type maxCapacity = internalAllocator().max_size();
+		const size_type newCapacity = GrowthPolicy::grow(currentCapacity, sizeof(T));
+
+		// The policy may overflow or overshoot for huge vectors; doAllocate() still reports a request
+		// that can really not be satisfied.
+		if (newCapacity <= currentCapacity || newCapacity > maxCapacity)
+			return (currentCapacity < maxCapacity) ? maxCapacity : currentCapacity + 1;
+		return newCapacity;
 	}
 
 	///////////////////////////////////////////////////////////////////////
@@ -188,11 +234,11 @@ namespace merkol
 	 * @tparam T value type
 	 * @tparam Allocator allocator type
 	 */
-	template <typename T, typename Allocator = std::allocator<T> >
-	class vector : public vectorBase<T, Allocator>
+	template <typename T, typename Allocator = std::allocator<T>, typename GrowthPolicy = merkol::growth_policy_double>
+	class vector : public vectorBase<T, Allocator, GrowthPolicy>
 	{
-		typedef	vectorBase<T, Allocator>	base_type;
-		typedef	vector<T, Allocator>		this_type;
+		typedef	vectorBase<T, Allocator, GrowthPolicy>	base_type;
+		typedef	vector<T, Allocator, GrowthPolicy>		this_type;
 	// protected: std >= c++11 
 	// 	using base_type::mpBegin;
 	// 	using base_type::mpEnd;
@@ -208,9 +254,9 @@ namespace merkol
 		typedef T&														reference;
 		typedef const T&												const_reference;
 		typedef merkol::random_access_iterator<value_type>				iterator;
-		typedef const merkol::random_access_iterator<const value_type>	const_iterator;
+		typedef merkol::random_access_iterator<const value_type>		const_iterator;
 		typedef merkol::reverse_iterator<iterator>						reverse_iterator;
-		typedef const merkol::reverse_iterator<const_iterator>			const_reverse_iterator;
+		typedef merkol::reverse_iterator<const_iterator>				const_reverse_iterator;
 		typedef typename base_type::size_type							size_type;
 		typedef typename base_type::difference_type						difference_type;
 		typedef typename base_type::allocator_type						allocator_type; // || tt Allocator allocator_type;
@@ -222,6 +268,9 @@ namespace merkol
 		explicit vector(size_type n, const allocator_type& allocator = Allocator());
 		vector(size_type n, const value_type& val, const Allocator& allocator = Allocator());
 		vector(const this_type& other);
+	#if __cplusplus >= 201103L
+		vector(this_type&& other) M_NOEXCEPT;
+	#endif
 		
 		// note: this has pre-C++11 semantics:
 		// this constructor is equivalent to the constructor vector(static_cast<size_type>(first), static_cast<value_type>(last), allocator) if InputIterator is an integral type.
@@ -233,6 +282,9 @@ namespace merkol
 
 		// Copy assignment operator
 		this_type&	operator=(const this_type& other);
+	#if __cplusplus >= 201103L
+		this_type&	operator=(this_type&& other) M_NOEXCEPT;
+	#endif
 		
 		//base_type->get_allocator();
 		
@@ -275,12 +327,19 @@ namespace merkol
 		size_type	size() const;
 		size_type	capacity() const;
 		void		reserve(size_type n);
+		void		shrink_to_fit();
 		//base_type->max_size();
 
 		// Modifiers
 		void		clear() M_NOEXCEPT;
 		iterator	insert(const_iterator pos, const T& value);
 		iterator	insert(const_iterator pos, size_type count, const T& value);
+	#if __cplusplus >= 201103L
+		iterator	insert(const_iterator pos, T&& value);
+
+		template<typename... Args>
+		iterator	emplace(const_iterator pos, Args&&... args);
+	#endif
 
 		// note: this has pre-C++11 semantics:
 		// this function is equivalent to insert(const_iterator position, static_cast<size_type>(first), static_cast<value_type>(last)) if InputIterator is an integral type.
@@ -293,45 +352,92 @@ namespace merkol
 
 		void		push_back(const value_type& val);
 		void		pop_back(void);
+	#if __cplusplus >= 201103L
+		void		push_back(value_type&& val);
+
+		template<typename... Args>
+		reference	emplace_back(Args&&... args);
+	#endif
 
 		void		resize(size_type count);
 		void		resize(size_type count, const value_type& value);
 
 		void		swap(vector& other);
+
+	protected:
+		// True when growing can hand the whole buffer to Allocator::reallocate(): the elements survive a
+		// byte copy, and the allocator may extend the block in place or remap its pages.
+		typedef merkol::integral_constant<bool, merkol::is_trivially_relocatable<T>::value &&
+												merkol::allocator_can_reallocate<Allocator>::value> reallocate_in_place_type;
+
+		void		doRealloc(size_type n);
+		void		doReallocInPlace(size_type n, merkol::true_type);
+		void		doReallocInPlace(size_type n, merkol::false_type);
+		void		doGrow(size_type minCapacity);
+		void		doInsertValues(pointer pos, size_type n, const value_type& value);
+	#if __cplusplus >= 201103L
+		template<typename... Args>
+		void		doInsertValueEnd(Args&&... args);
+		template<typename... Args>
+		void		doInsertValue(pointer pos, Args&&... args);
+	#else
+		void		doInsertValueEnd(const value_type& value);
+	#endif
+
+		template<typename Integer>
+		void		doInsertFromIterator(pointer pos, Integer n, Integer value, merkol::true_type);
+		template<typename InputIterator>
+		void		doInsertFromIterator(pointer pos, InputIterator first, InputIterator last, merkol::false_type);
+
+		template<typename InputIterator>
+		void		doInsertRange(pointer pos, InputIterator first, InputIterator last, merkol::input_iterator_tag);
+		template<typename ForwardIterator>
+		void		doInsertRange(pointer pos, ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag);
+
+		template<typename Integer>
+		void		doAssignFromIterator(Integer n, Integer value, merkol::true_type);
+		template<typename InputIterator>
+		void		doAssignFromIterator(InputIterator first, InputIterator last, merkol::false_type);
+
+		template<typename InputIterator>
+		void		doAssignRange(InputIterator first, InputIterator last, merkol::input_iterator_tag);
+		template<typename ForwardIterator>
+		void		doAssignRange(ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag);
 	};
 
-	template<typename T, typename Allocator>
-	inline merkol::vector<T, Allocator>::vector() : base_type()
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline merkol::vector<T, Allocator, GrowthPolicy>::vector() : base_type()
 	{
-		print_info("vector::default_constructor");
+		MERKOL_TRACE(this, "vector::default_constructor", 0, 0);
 		// Empty
 	}
 
-	template<typename T, typename Allocator>
-	inline merkol::vector<T, Allocator>::vector(const Allocator& alloc) M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline merkol::vector<T, Allocator, GrowthPolicy>::vector(const Allocator& alloc) M_NOEXCEPT
 	: base_type(alloc)
 	{
-		print_info("vector::allocator_constructor");
+		MERKOL_TRACE(this, "vector::allocator_constructor", 0, 0);
 		// Empty
 	}
 
-	template<typename T, typename Allocator>
-	inline merkol::vector<T, Allocator>::vector(size_type n, const allocator_type& allocator)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline merkol::vector<T, Allocator, GrowthPolicy>::vector(size_type n, const allocator_type& allocator)
 	: base_type(n, allocator)
 	{
 		merkol::uninitialized_value_construct_n(this->mpBegin, n);
 		//std::uninitialized_fill(this->__begin_, this->__begin_ + n, value_type());
 		this->mpEnd = this->mpBegin + n;
+		MERKOL_TRACE(this, "vector::size_constructor", n, n);
 	}
 
 
-	template<typename T, typename Allocator>
-	inline merkol::vector<T, Allocator>::vector(size_type n, const value_type& val, const Allocator& alloc)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline merkol::vector<T, Allocator, GrowthPolicy>::vector(size_type n, const value_type& val, const Allocator& alloc)
 	: base_type(n, alloc)
 	{
-		print_info("vector(size_type n, const value_type& val, const Allocator& alloc)");
-		std::uninitialized_fill(this->mpBegin, this->mpBegin + n, val);
+		merkol::uninitialized_fill(this->mpBegin, this->mpBegin + n, val);
 		this->mpEnd = this->mpBegin + n;
+		MERKOL_TRACE(this, "vector::fill_constructor", n, n);
 		// for (size_type i = 0; i < n; i++)
 		// 	std::cout << *(this->mpBegin + i) << std::endl;
 	}
@@ -339,215 +445,253 @@ namespace merkol
 	// note: this has pre-C++11 semantics:
 	// this constructor is equivalent to the constructor vector(static_cast<size_type>(first), static_cast<value_type>(last), allocator) if InputIterator is an integral type.
 	// SFINAE Required
-	template<typename T, typename Allocator>
+	template<typename T, typename Allocator, typename GrowthPolicy>
 	template<typename InputIterator>
-	inline merkol::vector<T, Allocator>::vector(InputIterator first, InputIterator last, const Allocator& alloc,
+	inline merkol::vector<T, Allocator, GrowthPolicy>::vector(InputIterator first, InputIterator last, const Allocator& alloc,
 													typename merkol::enable_if<!merkol::is_integral<InputIterator>::value>::type*)
-	: base_type(static_cast<size_type>(merkol::distance(first, last), alloc))
+	: base_type(static_cast<size_type>(merkol::distance(first, last)), alloc)
 	{
-		print_info("Input iter constructor");
-		this->mpEnd = std::uninitialized_copy(first, last, this->mpBegin);
+		this->mpEnd = merkol::uninitialized_copy(first, last, this->mpBegin);
+		MERKOL_TRACE(this, "vector::range_constructor", this->mpEnd - this->mpBegin, this->internalPtr() - this->mpBegin);
 	}
 	
-	template<typename T, typename Allocator>
-	inline merkol::vector<T, Allocator>::vector(const this_type& other)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline merkol::vector<T, Allocator, GrowthPolicy>::vector(const this_type& other)
 	: base_type(other.size(), other.internalAllocator())
 	{
-		print_info("Copy constructor");
-		this->mpEnd = std::uninitialized_copy(other.mpBegin, other.mpEnd, this->mpBegin);
+		this->mpEnd = merkol::uninitialized_copy(other.mpBegin, other.mpEnd, this->mpBegin);
+		MERKOL_TRACE(this, "vector::copy_constructor", this->mpEnd - this->mpBegin, this->internalPtr() - this->mpBegin);
 	}
+
+#if __cplusplus >= 201103L
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline merkol::vector<T, Allocator, GrowthPolicy>::vector(this_type&& other) M_NOEXCEPT
+	: base_type(other.internalAllocator())
+	{
+		this->mpBegin		= other.mpBegin;
+		this->mpEnd			= other.mpEnd;
+		this->internalPtr()	= other.internalPtr();
+
+		other.mpBegin		= NULL;
+		other.mpEnd			= NULL;
+		other.internalPtr()	= NULL;
+	}
+#endif
 	
-	template <typename T, typename Allocator>
-	inline merkol::vector<T, Allocator>::~vector()
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline merkol::vector<T, Allocator, GrowthPolicy>::~vector()
 	{
-		print_info("merkol::vector::destructor");
+		MERKOL_TRACE(this, "vector::destructor", this->mpEnd - this->mpBegin, this->internalPtr() - this->mpBegin);
 		merkol::destruct(this->mpBegin, this->mpEnd);
 	}
 
 	// Copy assignment operator
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::this_type&
-	merkol::vector<T, Allocator>::operator=(const this_type& other)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::this_type&
+	merkol::vector<T, Allocator, GrowthPolicy>::operator=(const this_type& other)
+	{
+		if (this != &other)
+			doAssignRange(other.mpBegin, other.mpEnd, merkol::random_access_iterator_tag());
+		return (*this);
+	}
+
+#if __cplusplus >= 201103L
+	// Move assignment operator
+	// Our buffer is released first and the other one is then taken over with its allocator, so
+	// nothing is allocated or copied and, like the move constructor, it cannot throw.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::this_type&
+	merkol::vector<T, Allocator, GrowthPolicy>::operator=(this_type&& other) M_NOEXCEPT
 	{
-		print_info("merkol::vector::operator=");
 		if (this != &other)
 		{
-			
+			clear();
+			this->doFree(this->mpBegin, capacity());
+			this->mpBegin		= NULL;
+			this->mpEnd			= NULL;
+			this->internalPtr()	= NULL;
+			swap(other);
 		}
 		return (*this);
 	}
+#endif
 
-	template<typename T, typename Allocator>
-	void merkol::vector<T, Allocator>::assign(size_type n, const value_type& value)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::assign(size_type n, const value_type& value)
 	{
-		if (n > size_type(this->internalAllocator() - this->mpBegin)) // if n > capacity
+		if (n > size_type(this->internalPtr() - this->mpBegin)) // if n > capacity
 		{
-			this_type temp(n, value); // We have little choice but to reallocate with new memory.
+			this_type temp(n, value, this->internalAllocator()); // We have little choice but to reallocate with new memory.
 			swap(temp);
 		}
 		else if (n > size_type(this->mpEnd - this->mpBegin)) // if n > size
 		{
 			std::fill(this->mpBegin, this->mpEnd, value);
-			std::uninitialized_fill_n(this->mpEnd, n - size_type(this->mpEnd - this->mpBegin), value);
-			this->mpEnd += n - size_type(this->mpEnd - this->mpBegin);
+			this->mpEnd = merkol::uninitialized_fill_n(this->mpEnd, n - size_type(this->mpEnd - this->mpBegin), value);
 		}
 		else // else 0 <= n <= size
 		{
 			std::fill_n(this->mpBegin, n, value);
-			// erase(this->mpBegin + n, this->mpEnd);
+			merkol::destruct(this->mpBegin + n, this->mpEnd);
+			this->mpEnd = this->mpBegin + n;
 		}
 
 	}
 
-
-	// template<typename InputIterator> //SFINAE Required
-	// void	assign(InputIterator first, InputIterator last);
+	// note: this has pre-C++11 semantics:
+	// this function is equivalent to assign(static_cast<size_type>(first), static_cast<value_type>(last)) if InputIterator is an integral type.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename InputIterator>
+	void merkol::vector<T, Allocator, GrowthPolicy>::assign(InputIterator first, InputIterator last)
+	{
+		doAssignFromIterator(first, last, merkol::is_integral<InputIterator>());
+	}
 
 
 
 	// Iterators
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::iterator 
-		merkol::vector<T, Allocator>::begin() M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::begin() M_NOEXCEPT
 	{
-		return this->mpBegin;
+		return iterator(this->mpBegin);
 	}
 
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_iterator 
-		merkol::vector<T, Allocator>::begin() const M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::begin() const M_NOEXCEPT
 	{
-		return this->mpBegin;
+		return const_iterator(this->mpBegin);
 
 	}
 
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::iterator 
-		merkol::vector<T, Allocator>::end() M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::end() M_NOEXCEPT
 	{
-		return this->mpEnd;
+		return iterator(this->mpEnd);
 
 	}
 
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_iterator 
-		merkol::vector<T, Allocator>::end() const M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::end() const M_NOEXCEPT
 	{
-		return this->mpEnd;
+		return const_iterator(this->mpEnd);
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::reverse_iterator 
-		merkol::vector<T, Allocator>::rbegin() M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::reverse_iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::rbegin() M_NOEXCEPT
 	{
-		return reverse_iterator(this->mpEnd);
+		return reverse_iterator(iterator(this->mpEnd));
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_reverse_iterator 
-		merkol::vector<T, Allocator>::rbegin() const M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_reverse_iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::rbegin() const M_NOEXCEPT
 	{
-		return const_reverse_iterator(this->mpEnd);
+		return const_reverse_iterator(const_iterator(this->mpEnd));
 	}
 
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::reverse_iterator 
-		merkol::vector<T, Allocator>::rend() M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::reverse_iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::rend() M_NOEXCEPT
 	{
-		return reverse_iterator(this->mpBegin);
+		return reverse_iterator(iterator(this->mpBegin));
 	}
 
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_reverse_iterator 
-		merkol::vector<T, Allocator>::rend() const M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_reverse_iterator 
+		merkol::vector<T, Allocator, GrowthPolicy>::rend() const M_NOEXCEPT
 	{
-		return const_reverse_iterator(this->mpBegin);
+		return const_reverse_iterator(const_iterator(this->mpBegin));
 	}
 	
 
 
 	// Element access
 
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::pointer 
-		merkol::vector<T, Allocator>::data() M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::pointer 
+		merkol::vector<T, Allocator, GrowthPolicy>::data() M_NOEXCEPT
 	{
 		return this->mpBegin;
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_pointer 
-		merkol::vector<T, Allocator>::data() const M_NOEXCEPT
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_pointer 
+		merkol::vector<T, Allocator, GrowthPolicy>::data() const M_NOEXCEPT
 	{
 		return this->mpBegin;
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::reference 
-		merkol::vector<T, Allocator>::at(size_type n)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::at(size_type n)
 	{
 		if (n >= static_cast<size_type>(this->mpEnd - this->mpBegin))
 			throw std::out_of_range("merkol::vector::at -- out of range");
 		return *(this->mpBegin + n);
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_reference 
-		merkol::vector<T, Allocator>::at(size_type n) const
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::at(size_type n) const
 	{
 		if (n >= static_cast<size_type>(this->mpEnd - this->mpBegin))
 			throw std::out_of_range("merkol::vector::at -- out of range");
 		return *(this->mpBegin + n);
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::reference 
-		merkol::vector<T, Allocator>::front()
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::front()
 	{
-		if ((this->mpBegin == nullptr) || (this->mpEnd <= this->mpBegin))
+		if ((this->mpBegin == NULL) || (this->mpEnd <= this->mpBegin))
 			std::cerr << "merkol::vector::front() -- empty vector" << std::endl;
 		return *this->mpBegin;
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_reference 
-		merkol::vector<T, Allocator>::front() const
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::front() const
 	{
-		if ((this->mpBegin == nullptr) || (this->mpEnd <= this->mpBegin))
+		if ((this->mpBegin == NULL) || (this->mpEnd <= this->mpBegin))
 			std::cerr << "merkol::vector::front() -- empty vector" << std::endl;
 		return *this->mpBegin;
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::reference 
-		merkol::vector<T, Allocator>::back()
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::back()
 	{
-		if ((this->mpBegin == nullptr) || (this->mpEnd <= this->mpBegin))
+		if ((this->mpBegin == NULL) || (this->mpEnd <= this->mpBegin))
 			std::cerr << "merkol::vector::front() -- empty vector" << std::endl;
 		return *(this->mpEnd - 1);
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_reference 
-		merkol::vector<T, Allocator>::back() const
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::back() const
 	{
-		if ((this->mpBegin == nullptr) || (this->mpEnd <= this->mpBegin))
+		if ((this->mpBegin == NULL) || (this->mpEnd <= this->mpBegin))
 			std::cerr << "merkol::vector::front() -- empty vector" << std::endl;
 		return *(this->mpEnd - 1);
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::reference 
-		merkol::vector<T, Allocator>::operator[](size_type n)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::operator[](size_type n)
 	{
 		if (n >= static_cast<size_type>(this->mpEnd - this->mpBegin))
 			throw std::out_of_range("merkol::vector::operator[] -- out of range");
 		return *(this->mpBegin + n);
 	}
 	
-	template<typename T, typename Allocator>
-	typename merkol::vector<T, Allocator>::const_reference 
-		merkol::vector<T, Allocator>::operator[](size_type n) const
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::const_reference 
+		merkol::vector<T, Allocator, GrowthPolicy>::operator[](size_type n) const
 	{
 		if (n >= static_cast<size_type>(this->mpEnd - this->mpBegin))
 			throw std::out_of_range("merkol::vector::operator[] -- out of range");
@@ -556,41 +700,625 @@ namespace merkol
 
 
 	// Capacity
-	template<typename T, typename Allocator>
-	bool merkol::vector<T, Allocator>::empty() const
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	bool merkol::vector<T, Allocator, GrowthPolicy>::empty() const
 	{
 		return (this->mpBegin == this->mpEnd);
 	}
 
-	template<typename T, typename Allocator>
-	inline typename vector<T, Allocator>::size_type
-	merkol::vector<T, Allocator>::size() const
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::size_type
+	merkol::vector<T, Allocator, GrowthPolicy>::size() const
 	{
 		return (size_type)(this->mpEnd - this->mpBegin);
 	}
-	// size_type	capacity() const;
-	// void		reserve(size_type n);
-	// //base_type->max_size();
-
-
-	// // Modifiers
-	// void		clear() M_NOEXCEPT;
-	// iterator	insert(const_iterator pos, const T& value);
-	// iterator	insert(const_iterator pos, size_type count, const T& value);
-	// // note: this has pre-C++11 semantics:
-	// // this function is equivalent to insert(const_iterator position, static_cast<size_type>(first), static_cast<value_type>(last)) if InputIterator is an integral type.
-	// // ie. same as insert(const_iterator position, size_type n, const value_type& value)
-	// template<typename InputIterator> // SFINAE Required
-	// iterator	insert(const_iterator pos, InputIterator first, InputIterator last);
-	// iterator	erase(iterator pos);
-	// iterator	erase(iterator first, iterator last);
-	// void		push_back(const value_type& val);
-	// void		pop_back(void);
-	// void		resize(size_type count);
-	// void		resize(size_type count, const value_type& value);
-	
-	template<typename T, typename Allocator>
-	void merkol::vector<T, Allocator>::swap(vector& other)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline typename vector<T, Allocator, GrowthPolicy>::size_type
+	merkol::vector<T, Allocator, GrowthPolicy>::capacity() const
+	{
+		return (size_type)(this->internalPtr() - this->mpBegin);
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::reserve(size_type n)
+	{
+		if (n > capacity())
+			doRealloc(n);
+	}
+
+	// Non-binding in the standard; here it always reallocates to exactly size() elements.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::shrink_to_fit()
+	{
+		if (capacity() > size())
+			doRealloc(size());
+	}
+
+
+	// Modifiers
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::clear() M_NOEXCEPT
+	{
+		merkol::destruct(this->mpBegin, this->mpEnd);
+		this->mpEnd = this->mpBegin;
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator
+	merkol::vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, const T& value)
+	{
+	#if __cplusplus >= 201103L
+		return emplace(pos, value);
+	#else
+		const size_type index = (size_type)(pos.base() - this->mpBegin);
+
+		if ((this->mpEnd == this->internalPtr()) && (pos.base() == this->mpEnd))
+			doInsertValueEnd(value);
+		else
+			doInsertValues(this->mpBegin + index, 1, value);
+		return iterator(this->mpBegin + index);
+	#endif
+	}
+
+#if __cplusplus >= 201103L
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator
+	merkol::vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, T&& value)
+	{
+		return emplace(pos, std::move(value));
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename... Args>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator
+	merkol::vector<T, Allocator, GrowthPolicy>::emplace(const_iterator pos, Args&&... args)
+	{
+		const size_type index = (size_type)(pos.base() - this->mpBegin);
+
+		if ((this->mpEnd < this->internalPtr()) && (pos.base() == this->mpEnd))
+		{
+			::new((void*)this->mpEnd) value_type(std::forward<Args>(args)...);
+			++this->mpEnd;
+		}
+		else if (pos.base() == this->mpEnd)
+			doInsertValueEnd(std::forward<Args>(args)...);
+		else
+			doInsertValue(this->mpBegin + index, std::forward<Args>(args)...);
+		return iterator(this->mpBegin + index);
+	}
+#endif
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator
+	merkol::vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, size_type count, const T& value)
+	{
+		const size_type index = (size_type)(pos.base() - this->mpBegin);
+
+		doInsertValues(this->mpBegin + index, count, value);
+		return iterator(this->mpBegin + index);
+	}
+
+	// note: this has pre-C++11 semantics:
+	// this function is equivalent to insert(const_iterator position, static_cast<size_type>(first), static_cast<value_type>(last)) if InputIterator is an integral type.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename InputIterator>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator
+	merkol::vector<T, Allocator, GrowthPolicy>::insert(const_iterator pos, InputIterator first, InputIterator last)
+	{
+		const size_type index = (size_type)(pos.base() - this->mpBegin);
+
+		doInsertFromIterator(this->mpBegin + index, first, last, merkol::is_integral<InputIterator>());
+		return iterator(this->mpBegin + index);
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator
+	merkol::vector<T, Allocator, GrowthPolicy>::erase(iterator pos)
+	{
+		return erase(pos, pos + 1);
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	typename merkol::vector<T, Allocator, GrowthPolicy>::iterator
+	merkol::vector<T, Allocator, GrowthPolicy>::erase(iterator first, iterator last)
+	{
+		if (first != last)
+		{
+			pointer const pNewEnd = merkol::move(last.base(), this->mpEnd, first.base());
+
+			merkol::destruct(pNewEnd, this->mpEnd);
+			this->mpEnd = pNewEnd;
+		}
+		return first;
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::push_back(const value_type& val)
+	{
+		if (this->mpEnd < this->internalPtr())
+		{
+			::new((void*)this->mpEnd) value_type(val);
+			++this->mpEnd;
+		}
+		else
+			doInsertValueEnd(val);
+	}
+
+	// The vector must not be empty, as for deque::pop_back().
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::pop_back(void)
+	{
+		--this->mpEnd;
+		this->mpEnd->~value_type();
+	}
+
+#if __cplusplus >= 201103L
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::push_back(value_type&& val)
+	{
+		emplace_back(std::move(val));
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename... Args>
+	inline typename merkol::vector<T, Allocator, GrowthPolicy>::reference
+	merkol::vector<T, Allocator, GrowthPolicy>::emplace_back(Args&&... args)
+	{
+		if (this->mpEnd < this->internalPtr())
+		{
+			::new((void*)this->mpEnd) value_type(std::forward<Args>(args)...);
+			++this->mpEnd;
+		}
+		else
+			doInsertValueEnd(std::forward<Args>(args)...);
+		return *(this->mpEnd - 1);
+	}
+#endif
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::resize(size_type count)
+	{
+		const size_type currentSize = size();
+
+		if (count > currentSize)
+		{
+			if (count > capacity())
+				doGrow(count);
+			this->mpEnd = merkol::uninitialized_value_construct_n(this->mpEnd, count - currentSize);
+		}
+		else
+		{
+			merkol::destruct(this->mpBegin + count, this->mpEnd);
+			this->mpEnd = this->mpBegin + count;
+		}
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::resize(size_type count, const value_type& value)
+	{
+		const size_type currentSize = size();
+
+		if (count > currentSize)
+			doInsertValues(this->mpEnd, count - currentSize, value);
+		else
+		{
+			merkol::destruct(this->mpBegin + count, this->mpEnd);
+			this->mpEnd = this->mpBegin + count;
+		}
+	}
+
+
+	///////////////////////////////////////////////////////////////////////
+	// reallocation and insertion helpers								///
+	///////////////////////////////////////////////////////////////////////
+
+	// Moves the elements to a new buffer of exactly n elements.
+	// Strong guarantee: elements are only moved when that can not throw (see uninitialized_relocate),
+	// so if relocation throws, the vector is left untouched.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doRealloc(size_type n)
+	{
+		if (reallocate_in_place_type::value)
+		{
+			doReallocInPlace(n, reallocate_in_place_type());
+			return;
+		}
+
+		pointer const	pNewData = this->doAllocate(n);
+		pointer			pNewEnd;
+
+		try
+		{
+			pNewEnd = merkol::uninitialized_relocate(this->mpBegin, this->mpEnd, pNewData);
+		}
+		catch (...)
+		{
+			this->doFree(pNewData, n);
+			throw;
+		}
+		MERKOL_TRACE(this, "vector::realloc", size(), n);
+		this->doFree(this->mpBegin, capacity());
+
+		this->mpBegin		= pNewData;
+		this->mpEnd			= pNewEnd;
+		this->internalPtr()	= pNewData + n;
+	}
+
+	// doRealloc() for trivially relocatable elements and an allocator with reallocate(): the allocator
+	// resizes the block itself (realloc, mremap...), often without touching the elements at all.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doReallocInPlace(size_type n, merkol::true_type)
+	{
+		const size_type	prevSize = size();
+		pointer const	pNewData = this->doReallocate(this->mpBegin, capacity(), n);
+
+		MERKOL_TRACE(this, "vector::realloc_in_place", prevSize, n);
+		this->mpBegin		= pNewData;
+		this->mpEnd			= pNewData + prevSize;
+		this->internalPtr()	= pNewData + n;
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::doReallocInPlace(size_type /*n*/, merkol::false_type)
+	{
+		// Never called: doRealloc() and doInsertValueEnd() only take this path when reallocate_in_place_type is true.
+	}
+
+	// Reallocates to the next capacity chosen by the GrowthPolicy, or to minCapacity if that is larger.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::doGrow(size_type minCapacity)
+	{
+		const size_type newCapacity = this->getNewCapacity(capacity());
+
+		doRealloc((newCapacity < minCapacity) ? minCapacity : newCapacity);
+	}
+
+	// push_back() when the buffer is full. The new element is constructed before the old ones are
+	// relocated, while 'value' (or 'args') is still valid even if it refers to an element of this vector.
+	// When the allocator reallocates in place, the old buffer may be gone by the time the new slot exists,
+	// so the element is built aside first and then relocated into the slot with a memcpy.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+#if __cplusplus >= 201103L
+	template<typename... Args>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doInsertValueEnd(Args&&... args)
+#else
+	void merkol::vector<T, Allocator, GrowthPolicy>::doInsertValueEnd(const value_type& value)
+#endif
+	{
+		const size_type	prevSize	= size();
+		const size_type	newCapacity	= this->getNewCapacity(capacity());
+
+		if (reallocate_in_place_type::value)
+		{
+			merkol::aligned_buffer<value_type>	element;
+
+		#if __cplusplus >= 201103L
+			::new((void*)element.get()) value_type(std::forward<Args>(args)...);
+		#else
+			::new((void*)element.get()) value_type(value);
+		#endif
+			try
+			{
+				doReallocInPlace(newCapacity, reallocate_in_place_type());
+			}
+			catch (...)
+			{
+				element.get()->~value_type();
+				throw;
+			}
+			std::memcpy((void*)this->mpEnd, (const void*)element.get(), sizeof(value_type));
+			++this->mpEnd;
+			return;
+		}
+
+		pointer const	pNewData	= this->doAllocate(newCapacity);
+		pointer			pNewEnd;
+
+		try
+		{
+		#if __cplusplus >= 201103L
+			::new((void*)(pNewData + prevSize)) value_type(std::forward<Args>(args)...);
+		#else
+			::new((void*)(pNewData + prevSize)) value_type(value);
+		#endif
+		}
+		catch (...)
+		{
+			this->doFree(pNewData, newCapacity);
+			throw;
+		}
+		try
+		{
+			pNewEnd = merkol::uninitialized_relocate(this->mpBegin, this->mpEnd, pNewData);
+		}
+		catch (...)
+		{
+			(pNewData + prevSize)->~value_type();
+			this->doFree(pNewData, newCapacity);
+			throw;
+		}
+		MERKOL_TRACE(this, "vector::realloc", prevSize, newCapacity);
+		this->doFree(this->mpBegin, capacity());
+
+		this->mpBegin		= pNewData;
+		this->mpEnd			= pNewEnd + 1;
+		this->internalPtr()	= pNewData + newCapacity;
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doInsertValues(pointer pos, size_type n, const value_type& value)
+	{
+		if (n == 0)
+			return;
+		if (n <= size_type(this->internalPtr() - this->mpEnd)) // fits in the current buffer
+		{
+			const value_type	temp(value); // 'value' may refer to an element that is about to be shifted.
+			const size_type		elemsAfter	= (size_type)(this->mpEnd - pos);
+			pointer const		pOldEnd		= this->mpEnd;
+
+			if (elemsAfter > n)
+			{
+				this->mpEnd = merkol::uninitialized_move(this->mpEnd - n, this->mpEnd, this->mpEnd);
+				merkol::move_backward(pos, pOldEnd - n, pOldEnd);
+				std::fill(pos, pos + n, temp);
+			}
+			else
+			{
+				this->mpEnd = merkol::uninitialized_fill_n(this->mpEnd, n - elemsAfter, temp);
+				this->mpEnd = merkol::uninitialized_move(pos, pOldEnd, this->mpEnd);
+				std::fill(pos, pOldEnd, temp);
+			}
+		}
+		else
+		{
+			const size_type	prevSize	= size();
+			const size_type	growth		= this->getNewCapacity(capacity());
+			const size_type	newCapacity	= (growth < prevSize + n) ? (prevSize + n) : growth;
+			pointer const	pNewData	= this->doAllocate(newCapacity);
+			pointer			pNewEnd		= pNewData;
+
+			// Each step cleans up after itself when it throws, so pNewEnd always marks what is
+			// fully constructed. The old buffer stays valid until the end, 'value' included.
+			try
+			{
+				pNewEnd = merkol::uninitialized_move_if_noexcept(this->mpBegin, pos, pNewData);
+				pNewEnd = merkol::uninitialized_fill_n(pNewEnd, n, value);
+				pNewEnd = merkol::uninitialized_move_if_noexcept(pos, this->mpEnd, pNewEnd);
+			}
+			catch (...)
+			{
+				merkol::destruct(pNewData, pNewEnd);
+				this->doFree(pNewData, newCapacity);
+				throw;
+			}
+			MERKOL_TRACE(this, "vector::realloc", prevSize, newCapacity);
+			merkol::destruct(this->mpBegin, this->mpEnd);
+			this->doFree(this->mpBegin, capacity());
+
+			this->mpBegin		= pNewData;
+			this->mpEnd			= pNewEnd;
+			this->internalPtr()	= pNewData + newCapacity;
+		}
+	}
+
+#if __cplusplus >= 201103L
+	// emplace() anywhere but at the end.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename... Args>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doInsertValue(pointer pos, Args&&... args)
+	{
+		if (this->mpEnd < this->internalPtr())
+		{
+			value_type temp(std::forward<Args>(args)...); // 'args' may refer to an element that is about to be shifted.
+
+			::new((void*)this->mpEnd) value_type(std::move(*(this->mpEnd - 1)));
+			++this->mpEnd;
+			std::move_backward(pos, this->mpEnd - 2, this->mpEnd - 1);
+			*pos = std::move(temp);
+		}
+		else
+		{
+			const size_type	index		= (size_type)(pos - this->mpBegin);
+			const size_type	newCapacity	= this->getNewCapacity(capacity());
+			pointer const	pNewData	= this->doAllocate(newCapacity);
+			pointer			pNewEnd		= pNewData;
+
+			try
+			{
+				::new((void*)(pNewData + index)) value_type(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				this->doFree(pNewData, newCapacity);
+				throw;
+			}
+			try
+			{
+				pNewEnd = merkol::uninitialized_move_if_noexcept(this->mpBegin, pos, pNewData);
+				++pNewEnd;
+				pNewEnd = merkol::uninitialized_move_if_noexcept(pos, this->mpEnd, pNewEnd);
+			}
+			catch (...)
+			{
+				if (pNewEnd == pNewData) // the prefix failed, only the new element is alive
+					(pNewData + index)->~value_type();
+				else
+					merkol::destruct(pNewData, pNewEnd);
+				this->doFree(pNewData, newCapacity);
+				throw;
+			}
+			MERKOL_TRACE(this, "vector::realloc", size(), newCapacity);
+			merkol::destruct(this->mpBegin, this->mpEnd);
+			this->doFree(this->mpBegin, capacity());
+
+			this->mpBegin		= pNewData;
+			this->mpEnd			= pNewEnd;
+			this->internalPtr()	= pNewData + newCapacity;
+		}
+	}
+#endif
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename Integer>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::doInsertFromIterator(pointer pos, Integer n, Integer value, merkol::true_type)
+	{
+		doInsertValues(pos, static_cast<size_type>(n), static_cast<value_type>(value));
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename InputIterator>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::doInsertFromIterator(pointer pos, InputIterator first, InputIterator last, merkol::false_type)
+	{
+		doInsertRange(pos, first, last, typename merkol::iterator_traits<InputIterator>::iterator_category());
+	}
+
+	// Single pass iterators: the length is unknown, so insert one element at a time.
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename InputIterator>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doInsertRange(pointer pos, InputIterator first, InputIterator last, merkol::input_iterator_tag)
+	{
+		size_type index = (size_type)(pos - this->mpBegin);
+
+		for (; first != last; ++first, ++index)
+			doInsertValues(this->mpBegin + index, 1, *first);
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename ForwardIterator>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doInsertRange(pointer pos, ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag)
+	{
+		const size_type n = (size_type)merkol::distance(first, last);
+
+		if (n == 0)
+			return;
+		if (n <= size_type(this->internalPtr() - this->mpEnd)) // fits in the current buffer
+		{
+			const size_type	elemsAfter	= (size_type)(this->mpEnd - pos);
+			pointer const	pOldEnd		= this->mpEnd;
+
+			if (elemsAfter > n)
+			{
+				this->mpEnd = merkol::uninitialized_move(this->mpEnd - n, this->mpEnd, this->mpEnd);
+				merkol::move_backward(pos, pOldEnd - n, pOldEnd);
+				std::copy(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), pos);
+			}
+			else
+			{
+				ForwardIterator mid = first;
+
+				merkol::advance(mid, elemsAfter);
+				this->mpEnd = merkol::uninitialized_copy(mid, last, this->mpEnd);
+				this->mpEnd = merkol::uninitialized_move(pos, pOldEnd, this->mpEnd);
+				std::copy(merkol::unwrap_iterator(first), merkol::unwrap_iterator(mid), pos);
+			}
+		}
+		else
+		{
+			const size_type	prevSize	= size();
+			const size_type	growth		= this->getNewCapacity(capacity());
+			const size_type	newCapacity	= (growth < prevSize + n) ? (prevSize + n) : growth;
+			pointer const	pNewData	= this->doAllocate(newCapacity);
+			pointer			pNewEnd		= pNewData;
+
+			try
+			{
+				pNewEnd = merkol::uninitialized_move_if_noexcept(this->mpBegin, pos, pNewData);
+				pNewEnd = merkol::uninitialized_copy(first, last, pNewEnd);
+				pNewEnd = merkol::uninitialized_move_if_noexcept(pos, this->mpEnd, pNewEnd);
+			}
+			catch (...)
+			{
+				merkol::destruct(pNewData, pNewEnd);
+				this->doFree(pNewData, newCapacity);
+				throw;
+			}
+			MERKOL_TRACE(this, "vector::realloc", prevSize, newCapacity);
+			merkol::destruct(this->mpBegin, this->mpEnd);
+			this->doFree(this->mpBegin, capacity());
+
+			this->mpBegin		= pNewData;
+			this->mpEnd			= pNewEnd;
+			this->internalPtr()	= pNewData + newCapacity;
+		}
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename Integer>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::doAssignFromIterator(Integer n, Integer value, merkol::true_type)
+	{
+		assign(static_cast<size_type>(n), static_cast<value_type>(value));
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename InputIterator>
+	inline void merkol::vector<T, Allocator, GrowthPolicy>::doAssignFromIterator(InputIterator first, InputIterator last, merkol::false_type)
+	{
+		doAssignRange(first, last, typename merkol::iterator_traits<InputIterator>::iterator_category());
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename InputIterator>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doAssignRange(InputIterator first, InputIterator last, merkol::input_iterator_tag)
+	{
+		pointer position = this->mpBegin;
+
+		for (; (position != this->mpEnd) && (first != last); ++position, ++first)
+			*position = *first;
+		if (first == last)
+		{
+			merkol::destruct(position, this->mpEnd);
+			this->mpEnd = position;
+		}
+		else
+			doInsertRange(this->mpEnd, first, last, merkol::input_iterator_tag());
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	template<typename ForwardIterator>
+	void merkol::vector<T, Allocator, GrowthPolicy>::doAssignRange(ForwardIterator first, ForwardIterator last, merkol::forward_iterator_tag)
+	{
+		const size_type n = (size_type)merkol::distance(first, last);
+
+		if (n > capacity()) // Reallocate, there is no point in reusing the old elements.
+		{
+			pointer const	pNewData = this->doAllocate(n);
+			pointer			pNewEnd;
+
+			try
+			{
+				pNewEnd = merkol::uninitialized_copy(first, last, pNewData);
+			}
+			catch (...)
+			{
+				this->doFree(pNewData, n);
+				throw;
+			}
+			merkol::destruct(this->mpBegin, this->mpEnd);
+			this->doFree(this->mpBegin, capacity());
+
+			this->mpBegin		= pNewData;
+			this->mpEnd			= pNewEnd;
+			this->internalPtr()	= pNewData + n;
+		}
+		else if (n <= size())
+		{
+			pointer const pNewEnd = std::copy(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), this->mpBegin);
+
+			merkol::destruct(pNewEnd, this->mpEnd);
+			this->mpEnd = pNewEnd;
+		}
+		else
+		{
+			ForwardIterator mid = first;
+
+			merkol::advance(mid, size());
+			std::copy(merkol::unwrap_iterator(first), merkol::unwrap_iterator(mid), this->mpBegin);
+			this->mpEnd = merkol::uninitialized_copy(mid, last, this->mpEnd);
+		}
+	}
+
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	void merkol::vector<T, Allocator, GrowthPolicy>::swap(vector& other)
 	{
 		merkol::swap(this->mpBegin, other.mpBegin);
 		merkol::swap(this->mpEnd, other.mpEnd);
@@ -616,61 +1344,60 @@ namespace merkol
 	///////////////////////////////////////////////////////////////////////
 	// non-member relational operators overload(vector global operators)///
 	///////////////////////////////////////////////////////////////////////
-	template<typename T, typename Allocator>
+	template<typename T, typename Allocator, typename GrowthPolicy>
 	inline bool
-	operator==(const merkol::vector<T, Allocator>& a, const merkol::vector<T, Allocator>& b)
+	operator==(const merkol::vector<T, Allocator, GrowthPolicy>& a, const merkol::vector<T, Allocator, GrowthPolicy>& b)
 	{
 		return ((a.size() == b.size()) && merkol::equal(a.begin(), a.end(), b.begin()));
 		return 0;
 
 	}
 
-	template<typename T, typename Allocator>
+	template<typename T, typename Allocator, typename GrowthPolicy>
 	inline bool
-	operator!=(const merkol::vector<T, Allocator>& a, const merkol::vector<T, Allocator>& b)
+	operator!=(const merkol::vector<T, Allocator, GrowthPolicy>& a, const merkol::vector<T, Allocator, GrowthPolicy>& b)
 	{
-		return ((a.size() == b.size()) && !merkol::equal(a.begin(), a.end(), b.begin()));
-		return 0;
+		return !(a == b);
 	}
 
-	template<typename T, typename Allocator>
+	template<typename T, typename Allocator, typename GrowthPolicy>
 	inline bool
-	operator<(const merkol::vector<T, Allocator>& a, const merkol::vector<T, Allocator>& b)
+	operator<(const merkol::vector<T, Allocator, GrowthPolicy>& a, const merkol::vector<T, Allocator, GrowthPolicy>& b)
 	{
 		return merkol::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
 		return 0;
 
 	}
 
-	template<typename T, typename Allocator>
+	template<typename T, typename Allocator, typename GrowthPolicy>
 	inline bool
-	operator>(const merkol::vector<T, Allocator>& a, const merkol::vector<T, Allocator>& b)
+	operator>(const merkol::vector<T, Allocator, GrowthPolicy>& a, const merkol::vector<T, Allocator, GrowthPolicy>& b)
 	{
 		return (b < a);
 		return 0;
 
 	}
 
-	template<typename T, typename Allocator>
+	template<typename T, typename Allocator, typename GrowthPolicy>
 	inline bool
-	operator<=(const merkol::vector<T, Allocator>& a, const merkol::vector<T, Allocator>& b)
+	operator<=(const merkol::vector<T, Allocator, GrowthPolicy>& a, const merkol::vector<T, Allocator, GrowthPolicy>& b)
 	{
 		return !(b < a);
 		return 0;
 
 	}
 
-	template<typename T, typename Allocator>
+	template<typename T, typename Allocator, typename GrowthPolicy>
 	inline bool
-	operator>=(const merkol::vector<T, Allocator>& a, const merkol::vector<T, Allocator>& b)
+	operator>=(const merkol::vector<T, Allocator, GrowthPolicy>& a, const merkol::vector<T, Allocator, GrowthPolicy>& b)
 	{
 		return !(a < b);
 		return 0;
 
 	}
 
-	template <typename T, typename Allocator>
-	inline void swap(vector<T, Allocator>& a, vector<T, Allocator>& b)
+	template<typename T, typename Allocator, typename GrowthPolicy>
+	inline void swap(vector<T, Allocator, GrowthPolicy>& a, vector<T, Allocator, GrowthPolicy>& b)
 	{
 		a.swap(b);
 	}
@@ -4,15 +4,7 @@
 
 namespace merkol
 {
-	// Iterator categories
-	// Every iterator is defined as belonging to one of the iterator categories that
-	// we define here. These categories come directly from the C++ standard.
-	struct input_iterator_tag { };
-	struct output_iterator_tag { };
-	struct forward_iterator_tag			: public input_iterator_tag { };
-	struct bidirectional_iterator_tag	: public forward_iterator_tag { };
-	struct random_access_iterator_tag	: public bidirectional_iterator_tag { };
-	// struct contiguous_iterator_tag		: public random_access_iterator_tag { }; // CXX20
+	// Iterator categories are defined in iterator_traits.hpp, next to the traits that refer to them.
 
 
 	/**
@@ -47,6 +39,10 @@ namespace merkol
 	template <typename T>
 	struct is_input_iterator_tagged : public valid_iterator_tag_res<false, T> { };
 
+	template <>
+	struct is_input_iterator_tagged<merkol::contiguous_iterator_tag>
+		: public valid_iterator_tag_res<true, merkol::contiguous_iterator_tag> { };
+
 	template <>
 	struct is_input_iterator_tagged<merkol::random_access_iterator_tag>
 		: public valid_iterator_tag_res<true, merkol::random_access_iterator_tag> { };
@@ -73,6 +69,10 @@ namespace merkol
 	template <typename T>
 	struct is_my_iterator_tagged : public valid_iterator_tag_res<false, T> { };
 	
+	template <>
+	struct is_my_iterator_tagged<merkol::contiguous_iterator_tag>
+		: public valid_iterator_tag_res<true, merkol::contiguous_iterator_tag> { };
+
 	template <>
 	struct is_my_iterator_tagged<merkol::random_access_iterator_tag>
 		: public valid_iterator_tag_res<true, merkol::random_access_iterator_tag> { };
@@ -117,6 +117,52 @@ namespace merkol
 		return merkol::_distance(first, last, typename iterator_traits<_InputIterator>::iterator_category());
 	}
 
+	template <typename _InputIterator, typename _Distance>
+	inline void _advance(_InputIterator& it, _Distance n, merkol::input_iterator_tag)
+	{
+		for (; n > 0; --n) ++it;
+	}
+
+	template <typename _BidirIterator, typename _Distance>
+	inline void _advance(_BidirIterator& it, _Distance n, merkol::bidirectional_iterator_tag)
+	{
+		if (n > 0)
+			for (; n > 0; --n) ++it;
+		else
+			for (; n < 0; ++n) --it;
+	}
+
+	template <typename _RandIterator, typename _Distance>
+	inline void _advance(_RandIterator& it, _Distance n, merkol::random_access_iterator_tag)
+	{
+		it += n;
+	}
+
+	template <typename _InputIterator, typename _Distance>
+	inline void advance(_InputIterator& it, _Distance n)
+	{
+		merkol::_advance(it, n, typename iterator_traits<_InputIterator>::iterator_category());
+	}
+
+	/// unwrap_iterator
+	///
+	/// Returns the raw pointer behind a contiguous iterator, and any other iterator unchanged.
+	/// Algorithms call it on their arguments before dispatching, so that the overloads taking T*
+	/// (memcpy, memmove, memcmp, SIMD) are reached from container iterators too. Contiguous iterator
+	/// types add an overload next to their definition; rewrap_iterator(it, p) turns the pointer an
+	/// algorithm returns back into an iterator of the type of it.
+	template <typename Iterator>
+	inline Iterator unwrap_iterator(Iterator it)
+	{
+		return it;
+	}
+
+	template <typename Iterator>
+	inline Iterator rewrap_iterator(Iterator /*original*/, Iterator it)
+	{
+		return it;
+	}
+
 
 	/**
 	 * Call when the iterator tested does not meet demand.
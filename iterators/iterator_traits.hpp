@@ -3,6 +3,8 @@
 
 //**stl_iterator_base_types.h line 160**
 #include <typeinfo>
+#include <cstddef>
+#include <iterator>
 
 namespace merkol
 {
@@ -33,20 +35,58 @@ namespace merkol
 	// 	typedef typename Iterator::reference         reference;
 	// };
 
+	// Iterator categories
+	// Every iterator is defined as belonging to one of the iterator categories that
+	// we define here. These categories come directly from the C++ standard.
+	struct input_iterator_tag { };
+	struct output_iterator_tag { };
+	struct forward_iterator_tag			: public input_iterator_tag { };
+	struct bidirectional_iterator_tag	: public forward_iterator_tag { };
+	struct random_access_iterator_tag	: public bidirectional_iterator_tag { };
+	// Random access iterators whose elements are adjacent in memory: pointers and the iterators of
+	// vector-like containers. Algorithms unwrap them to raw pointers, see unwrap_iterator in iterator.hpp.
+	struct contiguous_iterator_tag		: public random_access_iterator_tag { };
+
+	// Iterators coming from the standard library carry std:: tags. merkol::iterator_traits maps them to
+	// the matching merkol:: tag so that tag dispatch inside the library (distance, advance, insert...)
+	// only ever has to deal with one family of tags.
+	template <typename Tag>
+	struct normalize_iterator_tag { typedef Tag type; };
+
+	template <>
+	struct normalize_iterator_tag<std::input_iterator_tag> { typedef merkol::input_iterator_tag type; };
+
+	template <>
+	struct normalize_iterator_tag<std::output_iterator_tag> { typedef merkol::output_iterator_tag type; };
+
+	template <>
+	struct normalize_iterator_tag<std::forward_iterator_tag> { typedef merkol::forward_iterator_tag type; };
+
+	template <>
+	struct normalize_iterator_tag<std::bidirectional_iterator_tag> { typedef merkol::bidirectional_iterator_tag type; };
+
+	template <>
+	struct normalize_iterator_tag<std::random_access_iterator_tag> { typedef merkol::random_access_iterator_tag type; };
+
+#if __cplusplus > 201703L
+	template <>
+	struct normalize_iterator_tag<std::contiguous_iterator_tag> { typedef merkol::contiguous_iterator_tag type; };
+#endif
+
 	template <typename T>
 	struct iterator_traits {
-		typedef typename T::value_type			value_type;
-		typedef typename T::difference_type		difference_type;
-		typedef typename T::iterator_category	iterator_category;
-		typedef typename T::pointer				pointer;
-		typedef typename T::reference			reference;
+		typedef typename T::value_type												value_type;
+		typedef typename T::difference_type											difference_type;
+		typedef typename normalize_iterator_tag<typename T::iterator_category>::type	iterator_category;
+		typedef typename T::pointer													pointer;
+		typedef typename T::reference												reference;
 	};
 
 	// Partial specialization for pointer types.
 	template <typename T>
 	struct iterator_traits<T*>
 	{
-		typedef std::random_access_iterator_tag	iterator_category;
+		typedef merkol::contiguous_iterator_tag	iterator_category;
 		typedef T								value_type;
 		typedef T*								pointer;
 		typedef T&								reference;
@@ -57,7 +97,7 @@ namespace merkol
 	template <typename T>
 	struct iterator_traits<const T*>
 	{
-		typedef std::random_access_iterator_tag		iterator_category;
+		typedef merkol::contiguous_iterator_tag		iterator_category;
 		typedef T									value_type;
 		typedef const T*							pointer;
 		typedef const T&							reference;
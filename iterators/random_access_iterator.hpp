@@ -5,7 +5,7 @@
 #include <cstddef> // std::ptrdiff_t
 #include "iterator.hpp"
 #include "../aux_templates/nullptr.hpp"
-#include "../auxiliary/information_printer.hpp"
+#include "../aux_templates/type_traits.hpp"
 
 /**
  * // Forward iterator requirements
@@ -35,24 +35,16 @@ namespace merkol
 		typedef T*											pointer;
 		typedef T&											reference;
 		typedef std::ptrdiff_t								difference_type;
-		typedef merkol::random_access_iterator_tag			iterator_category;
+		typedef merkol::contiguous_iterator_tag				iterator_category;
 		typedef merkol::random_access_iterator<const T>		const_iterator;
 	private:
 		pointer	mPointer;
 	public:
 		// constructors
-		random_access_iterator() : mPointer(nullptr) { print_info("vector::random_access_iterator::default_constructor"); };
-		explicit random_access_iterator(const pointer& ref) : mPointer(ref) { print_info("vector::random_access_iterator::pointer_constructor"); }; // avoid implicitly call
-		random_access_iterator(const random_access_iterator& instance) { *this = instance; /*       */print_info("vector::random_access_iterator::copy_constructor"); };
-		~random_access_iterator() { print_info("vector::random_access_iterator::destructor"); };
-
-		// copy assignment
-		random_access_iterator& operator=(const random_access_iterator& rhs)
-		{
-			if (this != &rhs)
-				this->mPointer = rhs.mPointer;
-			return (*this);
-		}
+		// Copy, assignment and destruction are the implicit ones, so the iterator is trivially copyable:
+		// it is passed in a register and an optimized loop over it is the same as one over a pointer.
+		random_access_iterator() : mPointer(NULL) { };
+		explicit random_access_iterator(const pointer& ref) : mPointer(ref) { }; // avoid implicitly call
 
 		// get underlying pointer address
 		pointer base() const
@@ -118,12 +110,12 @@ namespace merkol
 			return (this->mPointer[n]);
 		}
 
-		random_access_iterator operator+(difference_type rhs)
+		random_access_iterator operator+(difference_type rhs) const
 		{
 			return (random_access_iterator(this->mPointer + rhs));
 		}
 
-		random_access_iterator operator-(difference_type rhs)
+		random_access_iterator operator-(difference_type rhs) const
 		{
 			return (random_access_iterator(this->mPointer - rhs));
 		}
@@ -180,7 +172,52 @@ namespace merkol
 		return (lhs.base() > rhs.base());
 	}
 
+	template <typename Iterator1, typename Iterator2>
+	inline typename random_access_iterator<Iterator1>::difference_type
+	operator-(const random_access_iterator<Iterator1>& lhs, const random_access_iterator<Iterator2>& rhs)
+	{
+		return (lhs.base() - rhs.base());
+	}
+
+	template <typename T>
+	inline random_access_iterator<T>
+	operator+(typename random_access_iterator<T>::difference_type n, const random_access_iterator<T>& it)
+	{
+		return (it + n);
+	}
+
+	// See unwrap_iterator in iterator.hpp.
+	template <typename T>
+	inline T* unwrap_iterator(random_access_iterator<T> it)
+	{
+		return it.base();
+	}
+
+	template <typename T>
+	inline random_access_iterator<T> rewrap_iterator(random_access_iterator<T> /*original*/, T* p)
+	{
+		return random_access_iterator<T>(p);
+	}
+
 } // namespace merkol
 
+// Standard algorithms see std:: tags. Under C++20 the iterator also models std::contiguous_iterator,
+// which lets the standard library take its own pointer paths.
+namespace std
+{
+	template <typename T>
+	struct iterator_traits<merkol::random_access_iterator<T> >
+	{
+		typedef std::random_access_iterator_tag							iterator_category;
+	#if __cplusplus > 201703L
+		typedef std::contiguous_iterator_tag							iterator_concept;
+	#endif
+		typedef typename merkol::remove_cv<T>::type						value_type;
+		typedef std::ptrdiff_t											difference_type;
+		typedef T*														pointer;
+		typedef T&														reference;
+	};
+} // namespace std
+
 
 #endif
\ No newline at end of file
@@ -3,7 +3,6 @@
 
 #include "iterator_traits.hpp"
 #include "random_access_iterator.hpp"
-#include <iostream>
 
 namespace merkol
 {
@@ -17,6 +16,11 @@ namespace merkol
 	protected:
 		Iter	mIterator;
 		typedef merkol::iterator_traits<Iter>	traits_type;
+
+		template<typename P>
+		static P*		doToPointer(P* p) { return p; }
+		template<typename I>
+		static typename merkol::iterator_traits<I>::pointer	doToPointer(const I& i) { return i.operator->(); }
 	public:
 		typedef Iter											iterator_type;
 		typedef typename traits_type::iterator_category			iterator_category;
@@ -25,17 +29,16 @@ namespace merkol
 		typedef typename traits_type::pointer					pointer;
 		typedef typename traits_type::reference					reference;
 	public:
-		reverse_iterator() : mIterator() { std::cout << "merkol::reverse_iterator::default_constructor" << std::endl; } // It's important that we construct mIterator, because if Iterator is a pointer, there's a difference between doing it and not.
-		explicit reverse_iterator(iterator_type i) : mIterator(i) { std::cout << typeid(value_type).name() << std::endl; }
-		reverse_iterator(const reverse_iterator& ri) : mIterator(ri.mIterator) { std::cout << "merkol::reverse_iterator::copy_constrcutor" << std::endl; }
+		reverse_iterator() : mIterator() { } // It's important that we construct mIterator, because if Iterator is a pointer, there's a difference between doing it and not.
+		explicit reverse_iterator(iterator_type i) : mIterator(i) { }
+		reverse_iterator(const reverse_iterator& ri) : mIterator(ri.mIterator) { }
 
 		template<typename U>
 		reverse_iterator(const reverse_iterator<U>& ri) : mIterator(ri.base()) { }
 
 		template<typename U> // try return type reverse_iterator<Iterator>& whats the diff
 		reverse_iterator& operator=(const reverse_iterator<U>& other)
-			{ mIterator = other.base(); return (*this);
-				std::cout << "merkol::reverse_iterator::copy_assignment_operator=" << std::endl; }
+			{ mIterator = other.base(); return (*this); }
 
 		iterator_type base() const
 			{ return mIterator; }
@@ -46,11 +49,13 @@ namespace merkol
 			return *--tmp;
 		}
 
+		// Goes through the base iterator's own operator->, so that an iterator whose reference is a proxy
+		// (flat_map's pair of references) can hand out its pointer proxy: &operator*() would take the
+		// address of a temporary.
 		pointer	operator->() const
 		{
-			// iterator_type tmp(mIterator);
-			// return --tmp;
-			return &(operator*());
+			iterator_type tmp(mIterator);
+			return doToPointer(--tmp);
 		}
 
 		reverse_iterator& operator++(void)
@@ -0,0 +1,329 @@
+#ifndef ARENA_HPP
+# define ARENA_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "memory.hpp"
+
+namespace merkol
+{
+	/*
+		monotonic_arena
+		Bump pointer allocator over a chain of chunks obtained from malloc. An allocation is an add and a
+		compare; memory is given back all at once by reset() or rewind(), both O(1), and the chunks are
+		kept for the next round. Meant for request scoped data: build the vectors of one request in the
+		arena, then reset it when the request is done.
+
+			monotonic_arena		arena(64 * 1024);
+			{
+				merkol::vector<int, merkol::arena_allocator<int> > ids((merkol::arena_allocator<int>(arena)));
+				...
+			}
+			arena.reset();
+
+		deallocate() only gives memory back when it is the last allocation, which is exactly what a vector
+		does when it is destroyed right after it was built, so a short lived vector costs nothing.
+		For the same reason reallocate() of the last allocation grows it in place while the chunk has room;
+		arena_allocator advertises it (allocator_can_reallocate), so a vector of trivially relocatable
+		elements that is the last thing allocated grows without copying.
+
+		Chunks start at the size given to the constructor and double up to kMaxChunkSize. Allocations that
+		do not fit in a chunk get one of their own.
+
+		Not thread safe: use one arena per thread or per request.
+	*/
+	class monotonic_arena
+	{
+		struct chunk
+		{
+			chunk*		mpNext;
+			std::size_t	mSize; // usable bytes after the header
+		};
+
+	public:
+		static const std::size_t kDefaultChunkSize	= 64 * 1024;
+		static const std::size_t kMaxChunkSize		= 16 * 1024 * 1024;
+		static const std::size_t kMaxAlign			= 16; // what malloc guarantees on the platforms we target
+
+		/// marker
+		///
+		/// Position in the arena returned by mark(); rewind() frees everything allocated after it.
+		class marker
+		{
+			friend class monotonic_arena;
+
+			chunk*	mpChunk;
+			char*	mpCurrent;
+		};
+
+		explicit monotonic_arena(std::size_t initialChunkSize = kDefaultChunkSize);
+		~monotonic_arena();
+
+		void*		allocate(std::size_t bytes, std::size_t alignment = kMaxAlign);
+		void		deallocate(void* p, std::size_t bytes);
+		void*		reallocate(void* p, std::size_t bytes, std::size_t newBytes, std::size_t alignment = kMaxAlign);
+
+		void		reset();
+		void		release();
+		marker		mark() const;
+		void		rewind(const marker& position);
+
+		std::size_t	capacity() const;
+
+	private:
+		monotonic_arena(const monotonic_arena&);
+		monotonic_arena& operator=(const monotonic_arena&);
+
+		static const std::size_t kHeaderSize = (sizeof(chunk) + kMaxAlign - 1) & ~(kMaxAlign - 1);
+
+		static char*	chunkData(chunk* c) { return reinterpret_cast<char*>(c) + kHeaderSize; }
+
+		void*		allocateSlow(std::size_t bytes, std::size_t alignment);
+		void		useChunk(chunk* c);
+
+		chunk*		mpHead;
+		chunk*		mpChunk;	// chunk mpCurrent points into
+		char*		mpCurrent;
+		char*		mpEnd;
+		std::size_t	mNextChunkSize;
+	}; // monotonic_arena
+
+
+	inline monotonic_arena::monotonic_arena(std::size_t initialChunkSize)
+		: mpHead(NULL),
+		  mpChunk(NULL),
+		  mpCurrent(NULL),
+		  mpEnd(NULL),
+		  mNextChunkSize(initialChunkSize ? initialChunkSize : kDefaultChunkSize)
+	{
+	}
+
+	inline monotonic_arena::~monotonic_arena()
+	{
+		release();
+	}
+
+	inline void* monotonic_arena::allocate(std::size_t bytes, std::size_t alignment)
+	{
+		const std::size_t padding = (std::size_t)(-(std::ptrdiff_t)mpCurrent) & (alignment - 1);
+
+		if (bytes + padding <= (std::size_t)(mpEnd - mpCurrent) && bytes)
+		{
+			char* const p = mpCurrent + padding;
+
+			mpCurrent = p + bytes;
+			return p;
+		}
+		return allocateSlow(bytes ? bytes : 1, alignment);
+	}
+
+	// Only the last allocation can be given back.
+	inline void monotonic_arena::deallocate(void* p, std::size_t bytes)
+	{
+		if (static_cast<char*>(p) + bytes == mpCurrent)
+			mpCurrent = static_cast<char*>(p);
+	}
+
+	// Grows or shrinks the last allocation in place when the chunk allows it. Anything else is copied to a
+	// new allocation; the old block stays where it is until the next reset().
+	inline void* monotonic_arena::reallocate(void* p, std::size_t bytes, std::size_t newBytes, std::size_t alignment)
+	{
+		char* const cp = static_cast<char*>(p);
+
+		if (cp + bytes == mpCurrent)
+		{
+			if (newBytes <= (std::size_t)(mpEnd - cp))
+			{
+				mpCurrent = cp + newBytes;
+				return p;
+			}
+		}
+		else if (newBytes <= bytes)
+			return p;
+
+		void* const q = allocate(newBytes, alignment);
+		std::memcpy(q, p, (bytes < newBytes) ? bytes : newBytes);
+		return q;
+	}
+
+	inline void monotonic_arena::reset()
+	{
+		if (mpHead)
+			useChunk(mpHead);
+	}
+
+	inline void monotonic_arena::release()
+	{
+		while (mpHead)
+		{
+			chunk* const next = mpHead->mpNext;
+
+			std::free(mpHead);
+			mpHead = next;
+		}
+		mpChunk		= NULL;
+		mpCurrent	= NULL;
+		mpEnd		= NULL;
+	}
+
+	inline monotonic_arena::marker monotonic_arena::mark() const
+	{
+		marker position;
+
+		position.mpChunk	= mpChunk;
+		position.mpCurrent	= mpCurrent;
+		return position;
+	}
+
+	inline void monotonic_arena::rewind(const marker& position)
+	{
+		if (!position.mpChunk) // taken before the first allocation
+		{
+			reset();
+			return;
+		}
+		useChunk(position.mpChunk);
+		mpCurrent = position.mpCurrent;
+	}
+
+	inline std::size_t monotonic_arena::capacity() const
+	{
+		std::size_t total = 0;
+
+		for (chunk* c = mpHead; c; c = c->mpNext)
+			total += c->mSize;
+		return total;
+	}
+
+	inline void monotonic_arena::useChunk(chunk* c)
+	{
+		mpChunk		= c;
+		mpCurrent	= chunkData(c);
+		mpEnd		= mpCurrent + c->mSize;
+	}
+
+	// The current chunk is full. Move to the next kept chunk if the request fits in it (chunks too small for
+	// it are freed), or append a new one.
+	inline void* monotonic_arena::allocateSlow(std::size_t bytes, std::size_t alignment)
+	{
+		const std::size_t needed = bytes + ((alignment > kMaxAlign) ? alignment : 0);
+
+		while (mpChunk && mpChunk->mpNext)
+		{
+			chunk* const next = mpChunk->mpNext;
+
+			if (next->mSize >= needed)
+			{
+				useChunk(next);
+				return allocate(bytes, alignment);
+			}
+			mpChunk->mpNext = next->mpNext;
+			std::free(next);
+		}
+
+		const std::size_t	size	= (needed > mNextChunkSize) ? needed : mNextChunkSize;
+		chunk* const		c		= static_cast<chunk*>(std::malloc(kHeaderSize + size));
+
+		if (!c)
+			throw std::bad_alloc();
+		c->mpNext	= NULL;
+		c->mSize	= size;
+		if (mpChunk)
+			mpChunk->mpNext = c;
+		else
+			mpHead = c;
+		MERKOL_TRACE(this, "monotonic_arena::new_chunk", bytes, size);
+		if (mNextChunkSize < kMaxChunkSize)
+			mNextChunkSize = (mNextChunkSize * 2 < kMaxChunkSize) ? mNextChunkSize * 2 : kMaxChunkSize;
+
+		useChunk(c);
+		return allocate(bytes, alignment);
+	}
+
+
+	/// arena_scope
+	///
+	/// Rewinds the arena to where it was when the scope was entered. Everything allocated from the arena
+	/// inside the scope must be dead by then.
+	class arena_scope
+	{
+	public:
+		explicit arena_scope(monotonic_arena& arena) : mArena(arena), mPosition(arena.mark()) { }
+		~arena_scope() { mArena.rewind(mPosition); }
+
+	private:
+		arena_scope(const arena_scope&);
+		arena_scope& operator=(const arena_scope&);
+
+		monotonic_arena&			mArena;
+		monotonic_arena::marker		mPosition;
+	};
+
+
+	/// arena_allocator
+	///
+	/// Allocator adapter that takes its memory from a monotonic_arena, for
+	/// merkol::vector<T, merkol::arena_allocator<T> >. Copies share the arena. A default constructed
+	/// arena_allocator has no arena and can not allocate; pass one to the container constructor.
+	template <typename T>
+	class arena_allocator
+	{
+	public:
+		typedef T					value_type;
+		typedef T*					pointer;
+		typedef const T*			const_pointer;
+		typedef T&					reference;
+		typedef const T&			const_reference;
+		typedef std::size_t			size_type;
+		typedef std::ptrdiff_t		difference_type;
+
+		template <typename U>
+		struct rebind { typedef arena_allocator<U> other; };
+
+		arena_allocator() M_NOEXCEPT : mpArena(NULL) { }
+		arena_allocator(monotonic_arena& arena) M_NOEXCEPT : mpArena(&arena) { }
+		template <typename U>
+		arena_allocator(const arena_allocator<U>& other) M_NOEXCEPT : mpArena(other.arena()) { }
+
+		pointer allocate(size_type n, const void* /*hint*/ = 0)
+		{
+			if (!mpArena || n > max_size())
+				throw std::bad_alloc();
+			return static_cast<pointer>(mpArena->allocate(n * sizeof(T), merkol::alignment_of<T>::value));
+		}
+
+		void deallocate(pointer p, size_type n)
+		{
+			if (mpArena)
+				mpArena->deallocate(p, n * sizeof(T));
+		}
+
+		// Byte-wise, see allocator_can_reallocate.
+		pointer reallocate(pointer p, size_type n, size_type newN)
+		{
+			if (!mpArena || newN > max_size())
+				throw std::bad_alloc();
+			return static_cast<pointer>(mpArena->reallocate(p, n * sizeof(T), newN * sizeof(T), merkol::alignment_of<T>::value));
+		}
+
+		size_type			max_size() const M_NOEXCEPT { return (size_type)-1 / sizeof(T) / 2; }
+		monotonic_arena*	arena() const M_NOEXCEPT { return mpArena; }
+
+	private:
+		monotonic_arena*	mpArena;
+	}; // arena_allocator
+
+	template <typename T, typename U>
+	inline bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) { return a.arena() == b.arena(); }
+
+	template <typename T, typename U>
+	inline bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) { return a.arena() != b.arena(); }
+
+	template <typename T>
+	struct allocator_can_reallocate<arena_allocator<T> > : merkol::true_type {};
+
+} // namespace merkol
+
+#endif // ARENA_HPP
@@ -0,0 +1,149 @@
+#ifndef MALLOC_ALLOCATOR_HPP
+# define MALLOC_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "memory.hpp"
+
+#ifdef __linux__
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+namespace merkol
+{
+	/// malloc_allocator
+	///
+	/// Stateless allocator on top of malloc/free which also provides
+	///
+	///     T* reallocate(T* p, size_type n, size_type newN);
+	///
+	/// so that containers of trivially relocatable elements can grow a block instead of allocating a new one
+	/// and copying (see merkol::allocator_can_reallocate). Small blocks go through realloc(), which extends
+	/// in place whenever the next chunk is free. On Linux, blocks of kMapThreshold bytes and more are mapped
+	/// directly and grown with mremap(): the kernel moves page table entries, so growing a multi-GB buffer
+	/// costs no copy and never needs the old and the new block resident at the same time.
+	///
+	/// Whether a block is mapped is derived from its size, which is why deallocate() and reallocate() must
+	/// get the element count the block was allocated with, as with any allocator.
+	template <typename T>
+	class malloc_allocator
+	{
+	public:
+		typedef T					value_type;
+		typedef T*					pointer;
+		typedef const T*			const_pointer;
+		typedef T&					reference;
+		typedef const T&			const_reference;
+		typedef std::size_t			size_type;
+		typedef std::ptrdiff_t		difference_type;
+
+		template <typename U>
+		struct rebind { typedef malloc_allocator<U> other; };
+
+		static const size_type kMapThreshold = 1 << 20; // bytes
+
+		malloc_allocator() M_NOEXCEPT { }
+		malloc_allocator(const malloc_allocator& /*other*/) M_NOEXCEPT { }
+		template <typename U>
+		malloc_allocator(const malloc_allocator<U>& /*other*/) M_NOEXCEPT { }
+
+		pointer		allocate(size_type n, const void* /*hint*/ = 0);
+		void		deallocate(pointer p, size_type n);
+		pointer		reallocate(pointer p, size_type n, size_type newN);
+
+		size_type	max_size() const M_NOEXCEPT { return (size_type)-1 / sizeof(T) / 2; }
+
+		pointer			address(reference value) const { return merkol::addressof(value); }
+		const_pointer	address(const_reference value) const { return merkol::addressof(value); }
+
+	private:
+		static bool		isMapped(size_type n)	{ return n * sizeof(T) >= kMapThreshold; }
+	#ifdef __linux__
+		static size_type	mappedBytes(size_type n)
+		{
+			const size_type pageSize = (size_type)sysconf(_SC_PAGESIZE);
+
+			return (n * sizeof(T) + pageSize - 1) / pageSize * pageSize;
+		}
+	#endif
+	}; // malloc_allocator
+
+	template <typename T>
+	typename malloc_allocator<T>::pointer malloc_allocator<T>::allocate(size_type n, const void* /*hint*/)
+	{
+		if (n > max_size())
+			throw std::bad_alloc();
+	#ifdef __linux__
+		if (isMapped(n))
+		{
+			void* p = mmap(NULL, mappedBytes(n), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				throw std::bad_alloc();
+			return static_cast<pointer>(p);
+		}
+	#endif
+		void* p = std::malloc(n ? n * sizeof(T) : 1);
+		if (!p)
+			throw std::bad_alloc();
+		return static_cast<pointer>(p);
+	}
+
+	template <typename T>
+	void malloc_allocator<T>::deallocate(pointer p, size_type n)
+	{
+	#ifdef __linux__
+		if (isMapped(n))
+		{
+			munmap(static_cast<void*>(p), mappedBytes(n));
+			return;
+		}
+	#endif
+		std::free(static_cast<void*>(p));
+	}
+
+	// The content of the first min(n, newN) elements is preserved byte for byte; the caller is
+	// responsible for the elements being trivially relocatable. On failure p is left untouched.
+	template <typename T>
+	typename malloc_allocator<T>::pointer malloc_allocator<T>::reallocate(pointer p, size_type n, size_type newN)
+	{
+		if (newN > max_size())
+			throw std::bad_alloc();
+	#ifdef __linux__
+		if (isMapped(n) && isMapped(newN))
+		{
+			void* q = mremap(static_cast<void*>(p), mappedBytes(n), mappedBytes(newN), MREMAP_MAYMOVE);
+			if (q == MAP_FAILED)
+				throw std::bad_alloc();
+			return static_cast<pointer>(q);
+		}
+		if (isMapped(n) || isMapped(newN)) // crossing the threshold: one block of each kind
+		{
+			pointer q = allocate(newN);
+			std::memcpy(static_cast<void*>(q), static_cast<const void*>(p), ((n < newN) ? n : newN) * sizeof(T));
+			deallocate(p, n);
+			return q;
+		}
+	#else
+		(void)n;
+	#endif
+		void* q = std::realloc(static_cast<void*>(p), newN ? newN * sizeof(T) : 1);
+		if (!q)
+			throw std::bad_alloc();
+		return static_cast<pointer>(q);
+	}
+
+	template <typename T, typename U>
+	inline bool operator==(const malloc_allocator<T>& /*a*/, const malloc_allocator<U>& /*b*/) { return true; }
+
+	template <typename T, typename U>
+	inline bool operator!=(const malloc_allocator<T>& /*a*/, const malloc_allocator<U>& /*b*/) { return false; }
+
+	template <typename T>
+	struct allocator_can_reallocate<malloc_allocator<T> > : merkol::true_type {};
+
+} // namespace merkol
+
+#endif // MALLOC_ALLOCATOR_HPP
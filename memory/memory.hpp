@@ -2,98 +2,476 @@
 # define MEMORY_HPP
 
 #include <iostream>
+#include <memory>
+#include <new>
+#include <utility>
+#include <cstring>
 #include <memory.h>
+#include "../auxiliary/trace.hpp"
+#include "../aux_templates/type_traits.hpp"
+#include "../iterators/iterator_traits.hpp"
+#include "../iterators/random_access_iterator.hpp"
 
-#define M_NOEXCEPT throw()
+#if __cplusplus >= 201103L
+# define M_NOEXCEPT noexcept
+#else
+# define M_NOEXCEPT throw()
+#endif
+
+// Bytes kept between data written by different threads, so that they never share a cache line. 64 on
+// x86 and most ARM cores; define it to 128 for cores that fetch lines in pairs (Apple M1, POWER).
+#ifndef MERKOL_CACHE_LINE_SIZE
+# define MERKOL_CACHE_LINE_SIZE 64
+#endif
+
+/*
+	Uninitialized memory algorithms
+
+	Every algorithm below has a generic version, which constructs one element at a time with placement
+	new and destroys what it built if a constructor throws, and a fast path taken when the iterators are
+	raw pointers to a type for which construction is just a copy of bytes:
+
+		uninitialized_copy / uninitialized_move		is_trivially_copyable				-> memcpy
+		uninitialized_relocate						is_trivially_relocatable			-> memcpy, no destructor call
+		uninitialized_fill / uninitialized_fill_n	is_trivially_copyable				-> memset or a plain store loop
+		uninitialized_value_construct_n				is_trivially_default_constructible	-> memset(0)
+		destruct									is_trivially_destructible			-> nothing
+
+	The fast paths are selected by overloading on T* (the more specialized overload wins). The public
+	entry points first unwrap contiguous iterators (merkol::unwrap_iterator), so containers get them by
+	passing either their internal pointers or their iterators. Destination ranges are uninitialized storage and
+	can not overlap the source, which is why memcpy rather than memmove is used.
+*/
 
 namespace merkol
 {
-	template<typename ForwardIt, typename Count>
-	ForwardIt uninitialized_value_construct_n(ForwardIt first, Count n)
+	/// addressof
+	///
+	/// From the C++11 Standard, section 20.6.12.1
+	/// Returns the actual address of the object or function referenced by r, even in the presence of an overloaded operator&.
+	///
+	template<typename T>
+	T* addressof(T& value) M_NOEXCEPT
 	{
-		std::cout << "uninitialized_value_construct_n" << std::endl;
-		typedef typename merkol::iterator_traits<ForwardIt>::value_type value_type;
-		typename std::allocator<value_type> alloc;
-		ForwardIt currentDest(first);
+		return reinterpret_cast<T*>(&const_cast<char&>(reinterpret_cast<const volatile char&>(value)));
+	}
+
+	// destruct(first, last)
+	//
+	template <typename ForwardIterator>
+	inline void destruct_impl(ForwardIterator /*first*/, ForwardIterator /*last*/, merkol::true_type) // true means the type has a trivial destructor.
+	{
+		// Empty. The type has a trivial destructor.
+	}
+
+	template <typename ForwardIterator>
+	inline void destruct_impl(ForwardIterator first, ForwardIterator last, merkol::false_type) // false means the type has a significant destructor.
+	{
+		typedef typename merkol::iterator_traits<ForwardIterator>::value_type value_type;
+
+		for(; first != last; ++first)
+			(*first).~value_type();
+	}
+
+	/// destruct
+	///
+	/// Calls the destructor on a range of objects.
+	///
+	/// We have a specialization for objects with trivial destructors, such as
+	/// PODs. In this specialization the destruction of the range is a no-op.
+	///
+	template <typename ForwardIterator>
+	inline void destruct(ForwardIterator first, ForwardIterator last)
+	{
+		typedef typename merkol::iterator_traits<ForwardIterator>::value_type value_type;
+		destruct_impl(first, last, merkol::is_trivially_destructible<value_type>());
+	}
+
+
+	// uninitialized_copy(first, last, dest)
+	//
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_copy_impl(InputIterator first, InputIterator last, ForwardIterator dest, merkol::false_type)
+	{
+		typedef typename merkol::iterator_traits<ForwardIterator>::value_type value_type;
+		ForwardIterator currentDest(dest);
 
 		try
 		{
-			for (; n > 0; --n, ++currentDest)
-				alloc.construct(currentDest, value_type()); // ::new (static_cast<void*>(&*currentDest)) value_type(); ??
+			for (; first != last; ++first, ++currentDest)
+				::new(static_cast<void*>(merkol::addressof(*currentDest))) value_type(*first);
 			return currentDest;
 		}
-		catch(const std::exception& e)
+		catch (...)
 		{
-			for (; first < currentDest; ++first)
-				(*first).~value_type();
-			std::cerr << "!!!!ERROR!!!! uninitialized_value_construct_n" << std::endl;
+			merkol::destruct(dest, currentDest);
 			throw;
 		}
 	}
 
+	template<typename T>
+	inline T* uninitialized_copy_impl(const T* first, const T* last, T* dest, merkol::true_type) // true means T is trivially copyable.
+	{
+		const std::size_t n = (std::size_t)(last - first);
+
+		if (n)
+			std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), n * sizeof(T));
+		return dest + n;
+	}
+
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_copy_unwrapped(InputIterator first, InputIterator last, ForwardIterator dest)
+	{
+		return merkol::uninitialized_copy_impl(first, last, dest, merkol::false_type());
+	}
+
+	template<typename T>
+	inline T* uninitialized_copy_unwrapped(const T* first, const T* last, T* dest)
+	{
+		return merkol::uninitialized_copy_impl(first, last, dest, merkol::is_trivially_copyable<T>());
+	}
+
+	template<typename T>
+	inline T* uninitialized_copy_unwrapped(T* first, T* last, T* dest)
+	{
+		return merkol::uninitialized_copy_impl(static_cast<const T*>(first), static_cast<const T*>(last), dest, merkol::is_trivially_copyable<T>());
+	}
+
+	/// uninitialized_copy
+	///
+	/// Copy-constructs [first, last) into the uninitialized range starting at dest and returns the end
+	/// of the constructed range. If a constructor throws, the elements built so far are destroyed.
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator dest)
+	{
+		return merkol::rewrap_iterator(dest, merkol::uninitialized_copy_unwrapped(merkol::unwrap_iterator(first),
+			merkol::unwrap_iterator(last), merkol::unwrap_iterator(dest)));
+	}
+
+
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_move_unwrapped(InputIterator first, InputIterator last, ForwardIterator dest)
+	{
+	#if __cplusplus >= 201103L
+		return merkol::uninitialized_copy_impl(std::make_move_iterator(first), std::make_move_iterator(last), dest, merkol::false_type());
+	#else
+		return merkol::uninitialized_copy_unwrapped(first, last, dest);
+	#endif
+	}
+
+#if __cplusplus >= 201103L
+	template<typename T>
+	inline T* uninitialized_move_impl(T* first, T* last, T* dest, merkol::true_type) // true means T is trivially copyable.
+	{
+		return merkol::uninitialized_copy_impl(static_cast<const T*>(first), static_cast<const T*>(last), dest, merkol::true_type());
+	}
+
+	template<typename T>
+	inline T* uninitialized_move_impl(T* first, T* last, T* dest, merkol::false_type)
+	{
+		return merkol::uninitialized_copy_impl(std::make_move_iterator(first), std::make_move_iterator(last), dest, merkol::false_type());
+	}
+#endif
+
+	template<typename T>
+	inline T* uninitialized_move_unwrapped(T* first, T* last, T* dest)
+	{
+	#if __cplusplus >= 201103L
+		return merkol::uninitialized_move_impl(first, last, dest, merkol::is_trivially_copyable<T>());
+	#else
+		return merkol::uninitialized_copy_unwrapped(first, last, dest);
+	#endif
+	}
+
+	/// uninitialized_move
+	///
+	/// Move-constructs [first, last) into the uninitialized range starting at dest.
+	/// Copy-constructs in C++98 mode. If a constructor throws, the elements built so far are destroyed.
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_move(InputIterator first, InputIterator last, ForwardIterator dest)
+	{
+		return merkol::rewrap_iterator(dest, merkol::uninitialized_move_unwrapped(merkol::unwrap_iterator(first),
+			merkol::unwrap_iterator(last), merkol::unwrap_iterator(dest)));
+	}
+
+#if __cplusplus >= 201103L
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_move_if_noexcept_impl(InputIterator first, InputIterator last, ForwardIterator dest, merkol::true_type) // true means a move could throw, copy instead.
+	{
+		return merkol::uninitialized_copy(first, last, dest);
+	}
+
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_move_if_noexcept_impl(InputIterator first, InputIterator last, ForwardIterator dest, merkol::false_type)
+	{
+		return merkol::uninitialized_move(first, last, dest);
+	}
+#endif
+
+	/// uninitialized_move_if_noexcept
+	///
+	/// Used to relocate elements into a new buffer on reallocation. Elements are moved when their move
+	/// constructor is noexcept (or when they can not be copied at all, e.g. std::unique_ptr) and copied
+	/// otherwise, so that a throwing move can not leave the source buffer half moved-from and the
+	/// reallocation keeps the strong exception guarantee. For std::string and friends this means the
+	/// buffer pointers are stolen instead of every character array being reallocated.
+	template<typename InputIterator, typename ForwardIterator>
+	inline ForwardIterator uninitialized_move_if_noexcept(InputIterator first, InputIterator last, ForwardIterator dest)
+	{
+	#if __cplusplus >= 201103L
+		typedef typename merkol::iterator_traits<InputIterator>::value_type value_type;
+		return merkol::uninitialized_move_if_noexcept_impl(first, last, dest, merkol::move_if_noexcept_cond<value_type>());
+	#else
+		return merkol::uninitialized_copy(first, last, dest);
+	#endif
+	}
+
+
+#if __cplusplus >= 201103L
+	// std::unique_ptr with the default deleter is a single owning pointer: relocating it is a memcpy.
+	template<typename T>
+	struct is_trivially_relocatable<std::unique_ptr<T> > : merkol::true_type {};
+#endif
+
+	// A pair is relocated member by member. std::pair is never trivially copyable (it declares its
+	// assignment operators), which would otherwise keep pair<const int, int> off the memcpy path.
+	template<typename T1, typename T2>
+	struct is_trivially_relocatable<std::pair<T1, T2> >
+		: merkol::integral_constant<bool, merkol::is_trivially_relocatable<typename merkol::remove_cv<T1>::type>::value &&
+										  merkol::is_trivially_relocatable<typename merkol::remove_cv<T2>::type>::value> {};
+
+	// uninitialized_relocate(first, last, dest)
+	//
+	template<typename T>
+	inline T* uninitialized_relocate_impl(T* first, T* last, T* dest, merkol::true_type) // true means T is trivially relocatable.
+	{
+		const std::size_t n = (std::size_t)(last - first);
+
+		if (n)
+			std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), n * sizeof(T));
+		return dest + n;
+	}
+
+	template<typename T>
+	inline T* uninitialized_relocate_impl(T* first, T* last, T* dest, merkol::false_type)
+	{
+		T* const destEnd = merkol::uninitialized_move_if_noexcept(first, last, dest);
+
+		merkol::destruct(first, last);
+		return destEnd;
+	}
+
+	/// uninitialized_relocate
+	///
+	/// Moves [first, last) into the uninitialized range starting at dest and ends the lifetime of the
+	/// source elements, leaving [first, last) as raw storage. For trivially relocatable types this is a
+	/// single memcpy and no constructor or destructor runs. Otherwise the elements are moved (or copied,
+	/// see uninitialized_move_if_noexcept) and then destroyed; if that throws, the source is untouched.
+	template<typename T>
+	inline T* uninitialized_relocate(T* first, T* last, T* dest)
+	{
+		return merkol::uninitialized_relocate_impl(first, last, dest, merkol::is_trivially_relocatable<T>());
+	}
+
+	/// aligned_buffer
+	///
+	/// Uninitialized storage suitable for one T, e.g. to build an element before the buffer it belongs to
+	/// exists. Over-aligned types are only supported in C++11 mode.
+	template<typename T>
+	struct aligned_buffer
+	{
+	#if __cplusplus >= 201103L
+		alignas(T) unsigned char	mBuffer[sizeof(T)];
+	#else
+		union
+		{
+			unsigned char	mBuffer[sizeof(T)];
+			long double		mAlignLongDouble;
+			long long		mAlignLongLong;
+			void*			mAlignPointer;
+		};
+	#endif
+
+		T*	get() { return reinterpret_cast<T*>(mBuffer); }
+	};
+
+	/// allocator_can_reallocate
+	///
+	/// True for allocators that provide T* reallocate(T* p, size_type oldN, size_type newN), which resizes
+	/// a block and returns it with its bytes preserved, ideally without moving it (realloc, mremap, the
+	/// top of an arena...). Containers only use it for trivially relocatable elements.
+	template<typename Allocator>
+	struct allocator_can_reallocate : merkol::false_type {};
+
+	/// allocator_tracks_usage
+	///
+	/// True for allocators that provide void note_usage(T* p, size_type n, size_type used), which a
+	/// container calls right before it gives back a block of n elements of which used were constructed
+	/// (see tracking_allocator).
+	template<typename Allocator>
+	struct allocator_tracks_usage : merkol::false_type {};
+
+	// uninitialized_fill_n(first, n, value)
+	//
 	template<typename ForwardIt, typename Count, typename T>
-	ForwardIt uninitialized_fill_n(ForwardIt first, Count n, T val)
+	inline ForwardIt uninitialized_fill_n_impl(ForwardIt first, Count n, const T& val, merkol::false_type)
 	{
-		std::cout << "uninitialized_fill_n" << std::endl;
 		typedef typename merkol::iterator_traits<ForwardIt>::value_type value_type;
-		typename std::allocator<value_type> alloc;
 		ForwardIt currentDest(first);
 
 		try
 		{
 			for (; n > 0; --n, ++currentDest)
-				alloc.construct(currentDest, value_type(val)); // ::new (static_cast<void*>(&*currentDest)) value_type(); ??
+				::new(static_cast<void*>(merkol::addressof(*currentDest))) value_type(val);
 			return currentDest;
 		}
-		catch(const std::exception& e)
+		catch (...)
 		{
-			for (; first < currentDest; ++first)
-				(*first).~value_type();
-			std::cerr << "!!!!ERROR!!!! uninitialized_fill_n" << std::endl;
+			merkol::destruct(first, currentDest);
 			throw;
 		}
 	}
 
-	// destruct(first, last)
-	//
-	template <typename ForwardIterator>
-	inline void destruct_impl(ForwardIterator /*first*/, ForwardIterator /*last*/, merkol::true_type) // true means the type has a trivial destructor.
+	// Returns true if every byte of value is the same, i.e. if the fill can be done by memset.
+	// This covers zero (by far the most common fill value) and any single byte type.
+	template<typename T>
+	inline bool is_byte_repeated(const T& value)
 	{
-		// Empty. The type has a trivial destructor.
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(merkol::addressof(value));
+
+		for (std::size_t i = 1; i < sizeof(T); ++i)
+			if (bytes[i] != bytes[0])
+				return false;
+		return true;
 	}
 
-	template <typename ForwardIterator>
-	inline void destruct_impl(ForwardIterator first, ForwardIterator last, merkol::false_type) // false means the type has a significant destructor.
+	template<typename T, typename Count>
+	inline T* uninitialized_fill_n_impl(T* first, Count n, const T& val, merkol::true_type) // true means T is trivially copyable.
 	{
-		typedef typename merkol::iterator_traits<ForwardIterator>::value_type value_type;
+		if (n <= 0)
+			return first;
+		if (merkol::is_byte_repeated(val))
+			std::memset(static_cast<void*>(first), *reinterpret_cast<const unsigned char*>(merkol::addressof(val)), (std::size_t)n * sizeof(T));
+		else
+		{
+			// No constructor call and nothing that can throw: this is a plain store loop the compiler vectorizes.
+			const T value(val);
+			for (Count i = 0; i < n; ++i)
+				std::memcpy(static_cast<void*>(first + i), static_cast<const void*>(merkol::addressof(value)), sizeof(T));
+		}
+		return first + n;
+	}
 
-		for(; first != last; ++first)
-			(*first).~value_type();
+	template<typename ForwardIt, typename Count, typename T>
+	inline ForwardIt uninitialized_fill_n_unwrapped(ForwardIt first, Count n, const T& val)
+	{
+		return merkol::uninitialized_fill_n_impl(first, n, val, merkol::false_type());
 	}
 
-	/// destruct
-	///
-	/// Calls the destructor on a range of objects.
-	///
-	/// We have a specialization for objects with trivial destructors, such as
-	/// PODs. In this specialization the destruction of the range is a no-op.
+	template<typename T, typename Count>
+	inline T* uninitialized_fill_n_unwrapped(T* first, Count n, const T& val)
+	{
+		return merkol::uninitialized_fill_n_impl(first, n, val, merkol::is_trivially_copyable<T>());
+	}
+
+	/// uninitialized_fill_n
 	///
-	template <typename ForwardIterator>
-	inline void destruct(ForwardIterator first, ForwardIterator last)
+	/// Copy-constructs n copies of val starting at first and returns the end of the constructed range.
+	template<typename ForwardIt, typename Count, typename T>
+	inline ForwardIt uninitialized_fill_n(ForwardIt first, Count n, T val)
 	{
-		typedef typename merkol::iterator_traits<ForwardIterator>::value_type value_type;
-		destruct_impl(first, last, merkol::is_integral<value_type>());
+		MERKOL_TRACE(NULL, "uninitialized_fill_n", n, n);
+		return merkol::rewrap_iterator(first, merkol::uninitialized_fill_n_unwrapped(merkol::unwrap_iterator(first), n, val));
 	}
 
-	/// addressof
+	template<typename ForwardIt, typename T>
+	inline void uninitialized_fill_unwrapped(ForwardIt first, ForwardIt last, const T& val)
+	{
+		typedef typename merkol::iterator_traits<ForwardIt>::value_type value_type;
+		ForwardIt currentDest(first);
+
+		try
+		{
+			for (; currentDest != last; ++currentDest)
+				::new(static_cast<void*>(merkol::addressof(*currentDest))) value_type(val);
+		}
+		catch (...)
+		{
+			merkol::destruct(first, currentDest);
+			throw;
+		}
+	}
+
+	template<typename T>
+	inline void uninitialized_fill_unwrapped(T* first, T* last, const T& val)
+	{
+		merkol::uninitialized_fill_n_impl(first, last - first, val, merkol::is_trivially_copyable<T>());
+	}
+
+	/// uninitialized_fill
 	///
-	/// From the C++11 Standard, section 20.6.12.1
-	/// Returns the actual address of the object or function referenced by r, even in the presence of an overloaded operator&.
+	/// Copy-constructs val into every element of the uninitialized range [first, last).
+	template<typename ForwardIt, typename T>
+	inline void uninitialized_fill(ForwardIt first, ForwardIt last, const T& val)
+	{
+		merkol::uninitialized_fill_unwrapped(merkol::unwrap_iterator(first), merkol::unwrap_iterator(last), val);
+	}
+
+
+	// uninitialized_value_construct_n(first, n)
+	//
+	template<typename ForwardIt, typename Count>
+	inline ForwardIt uninitialized_value_construct_n_impl(ForwardIt first, Count n, merkol::false_type)
+	{
+		typedef typename merkol::iterator_traits<ForwardIt>::value_type value_type;
+		ForwardIt currentDest(first);
+
+		try
+		{
+			for (; n > 0; --n, ++currentDest)
+				::new(static_cast<void*>(merkol::addressof(*currentDest))) value_type();
+			return currentDest;
+		}
+		catch (...)
+		{
+			merkol::destruct(first, currentDest);
+			throw;
+		}
+	}
+
+	// Value-initializing a type with a trivial default constructor zero-initializes it.
+	// All bits zero is the zero/null value of every integral, floating point and pointer type on the
+	// platforms we target (pointers to data members, which are -1 on the Itanium ABI, are the exception).
+	template<typename T, typename Count>
+	inline T* uninitialized_value_construct_n_impl(T* first, Count n, merkol::true_type) // true means T is trivially default constructible.
+	{
+		if (n <= 0)
+			return first;
+		std::memset(static_cast<void*>(first), 0, (std::size_t)n * sizeof(T));
+		return first + n;
+	}
+
+	template<typename ForwardIt, typename Count>
+	inline ForwardIt uninitialized_value_construct_n_unwrapped(ForwardIt first, Count n)
+	{
+		return merkol::uninitialized_value_construct_n_impl(first, n, merkol::false_type());
+	}
+
+	template<typename T, typename Count>
+	inline T* uninitialized_value_construct_n_unwrapped(T* first, Count n)
+	{
+		return merkol::uninitialized_value_construct_n_impl(first, n,
+			merkol::integral_constant<bool, merkol::is_trivially_default_constructible<T>::value && merkol::is_trivially_copyable<T>::value>());
+	}
+
+	/// uninitialized_value_construct_n
 	///
-	template<typename T>
-	T* addressof(T& value) M_NOEXCEPT
+	/// Value-constructs ('T()') n elements starting at first and returns the end of the constructed range.
+	template<typename ForwardIt, typename Count>
+	inline ForwardIt uninitialized_value_construct_n(ForwardIt first, Count n)
 	{
-		return reinterpret_cast<T*>(&const_cast<char&>(reinterpret_cast<const volatile char&>(value)));
+		MERKOL_TRACE(NULL, "uninitialized_value_construct_n", n, n);
+		return merkol::rewrap_iterator(first, merkol::uninitialized_value_construct_n_unwrapped(merkol::unwrap_iterator(first), n));
 	}
 
 } // namespace merkol
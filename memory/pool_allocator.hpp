@@ -0,0 +1,509 @@
+#ifndef POOL_ALLOCATOR_HPP
+# define POOL_ALLOCATOR_HPP
+
+#if __cplusplus < 201103L
+# error "pool_allocator.hpp requires C++11"
+#endif
+
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include "memory.hpp"
+
+/*
+	Size class pool
+
+	Requests up to kMaxSize bytes are rounded up to one of kClassCount size classes (multiples of 16 up to
+	128 bytes, then 4 classes per power of two, the layout of growth_policy_size_class) and served from
+	free lists of blocks of exactly that size. Larger requests go to malloc.
+
+	Every thread owns a magazine per class: a small stack of free blocks that allocate() pops and
+	deallocate() pushes without any synchronization. Behind the magazines, a global depot per class holds
+	batches of free blocks under a mutex:
+
+		allocate, magazine empty	take one batch from the depot (refill), or carve a new slab
+		deallocate, magazine full	give half of the magazine back to the depot as one batch (flush)
+		thread exit					give the whole magazine back
+
+	So a block freed by another thread than the one that allocated it simply joins the freeing thread's
+	magazine and eventually the depot, where any thread can pick it up. Batches move in O(1) under the
+	lock: a batch is a chain of blocks linked through their first word, and batches are chained through
+	the second word of their first block (blocks are at least 16 bytes).
+
+	Blocks are 16 byte aligned. Slabs are never returned to the system.
+
+	Deallocation needs the size of the block (every standard allocator gets it), there is no header.
+*/
+
+namespace merkol
+{
+namespace pool
+{
+	static const std::size_t	kMaxSize		= 32 * 1024;
+	static const std::size_t	kClassCount		= 40;
+	static const std::size_t	kMaxMagazine	= 128;			// blocks per magazine for the smallest classes
+	static const std::size_t	kMagazineBytes	= 16 * 1024;	// magazines hold about this many bytes
+	static const std::size_t	kSlabSize		= 64 * 1024;
+
+	/// class_stats
+	///
+	/// Counters of one size class since the start of the process, over all threads.
+	struct class_stats
+	{
+		std::size_t	size;				// bytes per block
+		std::size_t	allocations;
+		std::size_t	hits;				// allocations served by the thread's magazine
+		std::size_t	refills;			// magazine refilled from the depot or a new slab
+		std::size_t	flushes;			// magazine partly returned to the depot
+		std::size_t	slabs;
+		std::size_t	bytes_outstanding;	// allocated and not freed yet
+	};
+
+	// Maps 1 <= bytes <= kMaxSize to its class.
+	inline std::size_t size_class_index(std::size_t bytes)
+	{
+		if (bytes <= 128)
+			return (bytes > 16) ? (bytes + 15) / 16 - 1 : 0;
+
+		const std::size_t lg	= sizeof(unsigned long long) * 8 - (std::size_t)__builtin_clzll((unsigned long long)(bytes - 1)); // ceil(log2(bytes))
+		const std::size_t half	= (std::size_t)1 << (lg - 1);
+
+		return 8 + (lg - 8) * 4 + (bytes - half - 1) / (half >> 2);
+	}
+
+	inline std::size_t size_class_bytes(std::size_t index)
+	{
+		if (index < 8)
+			return (index + 1) * 16;
+
+		const std::size_t lg	= 8 + (index - 8) / 4;
+		const std::size_t half	= (std::size_t)1 << (lg - 1);
+
+		return half + ((index - 8) % 4 + 1) * (half >> 2);
+	}
+
+	inline std::size_t magazine_capacity(std::size_t index)
+	{
+		const std::size_t blocks = kMagazineBytes / size_class_bytes(index);
+
+		return (blocks < 4) ? 4 : (blocks > kMaxMagazine) ? kMaxMagazine : blocks;
+	}
+
+	struct free_block
+	{
+		free_block*	mpNext;			// next block of the batch
+		free_block*	mpNextBatch;	// next batch in the depot, only meaningful in the first block
+	};
+
+	// Per class counters. A thread_cache's counters are only written by their thread; relaxed atomic
+	// stores let stats() read them from another thread.
+	struct class_counters
+	{
+		std::size_t	mAllocations;
+		std::size_t	mFrees;
+		std::size_t	mHits;
+		std::size_t	mRefills;
+		std::size_t	mFlushes;
+	};
+
+	inline void bump(std::size_t& counter)
+	{
+		__atomic_store_n(&counter, counter + 1, __ATOMIC_RELAXED);
+	}
+
+	struct thread_cache
+	{
+		void*			mBlocks[kClassCount][kMaxMagazine];
+		std::size_t		mCount[kClassCount];
+		class_counters	mCounters[kClassCount];
+		thread_cache*	mpPrev;
+		thread_cache*	mpNext;
+	};
+
+	struct depot
+	{
+		std::mutex		mMutex;
+		free_block*		mpBatches;
+		std::size_t		mSlabs;
+	};
+
+	// Process wide state. Allocated once and never destroyed, so that memory freed by static destructors
+	// after main() still has somewhere to go.
+	struct global_state
+	{
+		depot			mDepots[kClassCount];
+		std::mutex		mRegistryMutex;
+		thread_cache*	mpCaches;					// live thread caches
+		class_counters	mRetired[kClassCount];		// counters of exited threads and of uncached calls
+		std::size_t		mLargeBytesOutstanding;
+	};
+
+	inline global_state& state()
+	{
+		static global_state* const s = new global_state();
+
+		return *s;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// depot															///
+	///////////////////////////////////////////////////////////////////////
+
+	inline void push_batch(std::size_t index, free_block* batch)
+	{
+		depot& d = state().mDepots[index];
+		std::lock_guard<std::mutex> lock(d.mMutex);
+
+		batch->mpNextBatch	= d.mpBatches;
+		d.mpBatches			= batch;
+	}
+
+	// Returns a batch of at most magazine_capacity(index) blocks. Carves a new slab if the depot is empty.
+	inline free_block* pop_batch(std::size_t index)
+	{
+		depot& d = state().mDepots[index];
+		{
+			std::lock_guard<std::mutex> lock(d.mMutex);
+
+			if (free_block* batch = d.mpBatches)
+			{
+				d.mpBatches = batch->mpNextBatch;
+				return batch;
+			}
+		}
+
+		const std::size_t	blockSize	= size_class_bytes(index);
+		const std::size_t	batchSize	= magazine_capacity(index);
+		const std::size_t	slabBlocks	= (kSlabSize / blockSize > batchSize) ? kSlabSize / blockSize : batchSize;
+		char* const			slab		= static_cast<char*>(std::malloc(slabBlocks * blockSize));
+
+		if (!slab)
+			throw std::bad_alloc();
+
+		// Link the blocks into batches; the first one is returned, the others go to the depot.
+		free_block* first = NULL;
+		for (std::size_t begin = 0; begin < slabBlocks; begin += batchSize)
+		{
+			const std::size_t	end		= (begin + batchSize < slabBlocks) ? begin + batchSize : slabBlocks;
+			free_block* const	head	= reinterpret_cast<free_block*>(slab + begin * blockSize);
+
+			for (std::size_t i = begin; i < end; ++i)
+				reinterpret_cast<free_block*>(slab + i * blockSize)->mpNext = (i + 1 < end) ? reinterpret_cast<free_block*>(slab + (i + 1) * blockSize) : NULL;
+			if (!first)
+				first = head;
+			else
+				push_batch(index, head);
+		}
+		MERKOL_TRACE(&d, "pool::new_slab", blockSize, slabBlocks);
+		__atomic_fetch_add(&d.mSlabs, 1, __ATOMIC_RELAXED);
+		return first;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// thread caches													///
+	///////////////////////////////////////////////////////////////////////
+
+	// Gives the top n blocks of the magazine back to the depot as one batch.
+	inline void flush(thread_cache& cache, std::size_t index, std::size_t n)
+	{
+		void** const		top		= cache.mBlocks[index] + cache.mCount[index] - n;
+		free_block* const	head	= static_cast<free_block*>(top[0]);
+
+		for (std::size_t i = 0; i < n; ++i)
+			static_cast<free_block*>(top[i])->mpNext = (i + 1 < n) ? static_cast<free_block*>(top[i + 1]) : NULL;
+		cache.mCount[index] -= n;
+		push_batch(index, head);
+	}
+
+	inline void refill(thread_cache& cache, std::size_t index)
+	{
+		std::size_t count = 0;
+
+		for (free_block* b = pop_batch(index); b; b = b->mpNext)
+			cache.mBlocks[index][count++] = b;
+		cache.mCount[index] = count;
+	}
+
+	inline void retire_counters(const class_counters& c, std::size_t index)
+	{
+		class_counters& r = state().mRetired[index];
+
+		__atomic_fetch_add(&r.mAllocations, c.mAllocations, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&r.mFrees, c.mFrees, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&r.mHits, c.mHits, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&r.mRefills, c.mRefills, __ATOMIC_RELAXED);
+		__atomic_fetch_add(&r.mFlushes, c.mFlushes, __ATOMIC_RELAXED);
+	}
+
+	// Owns the calling thread's cache. At thread exit the magazines go back to the depot, and later
+	// calls from the same thread (other thread_local destructors) bypass the cache.
+	struct thread_cache_holder
+	{
+		thread_cache*	mpCache;
+
+		thread_cache_holder() : mpCache(NULL) { }
+
+		~thread_cache_holder()
+		{
+			thread_cache* const cache = mpCache;
+
+			if (!cache)
+				return;
+			mpCache = NULL;
+			for (std::size_t i = 0; i < kClassCount; ++i)
+			{
+				if (cache->mCount[i])
+					flush(*cache, i, cache->mCount[i]);
+			}
+
+			global_state& s = state();
+			std::lock_guard<std::mutex> lock(s.mRegistryMutex);
+			for (std::size_t i = 0; i < kClassCount; ++i)
+				retire_counters(cache->mCounters[i], i);
+			if (cache->mpPrev)
+				cache->mpPrev->mpNext = cache->mpNext;
+			else
+				s.mpCaches = cache->mpNext;
+			if (cache->mpNext)
+				cache->mpNext->mpPrev = cache->mpPrev;
+			std::free(cache);
+		}
+	};
+
+	inline bool& thread_exiting()
+	{
+		static MERKOL_THREAD_LOCAL bool exiting = false;
+
+		return exiting;
+	}
+
+	struct thread_exit_marker
+	{
+		~thread_exit_marker() { thread_exiting() = true; }
+	};
+
+	// Returns the calling thread's cache, or NULL once the thread is being torn down.
+	inline thread_cache* local_cache()
+	{
+		static thread_local thread_cache_holder holder;
+
+		if (holder.mpCache)
+			return holder.mpCache;
+		if (thread_exiting())
+			return NULL;
+
+		static thread_local thread_exit_marker marker; // destroyed before holder (constructed after it)
+		(void)marker;
+
+		thread_cache* const cache = static_cast<thread_cache*>(std::calloc(1, sizeof(thread_cache)));
+		if (!cache)
+			throw std::bad_alloc();
+
+		global_state& s = state();
+		std::lock_guard<std::mutex> lock(s.mRegistryMutex);
+		cache->mpNext = s.mpCaches;
+		if (s.mpCaches)
+			s.mpCaches->mpPrev = cache;
+		s.mpCaches		= cache;
+		holder.mpCache	= cache;
+		return cache;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// allocate / deallocate											///
+	///////////////////////////////////////////////////////////////////////
+
+	inline void* allocate(std::size_t bytes)
+	{
+		if (bytes > kMaxSize)
+		{
+			void* const p = std::malloc(bytes);
+
+			if (!p)
+				throw std::bad_alloc();
+			__atomic_fetch_add(&state().mLargeBytesOutstanding, bytes, __ATOMIC_RELAXED);
+			return p;
+		}
+
+		const std::size_t	index	= size_class_index(bytes);
+		thread_cache* const	cache	= local_cache();
+
+		if (!cache) // thread exit: straight from the depot, one batch at a time
+		{
+			free_block* const batch = pop_batch(index);
+
+			if (batch->mpNext)
+				push_batch(index, batch->mpNext);
+			__atomic_fetch_add(&state().mRetired[index].mAllocations, 1, __ATOMIC_RELAXED);
+			return batch;
+		}
+
+		class_counters& counters = cache->mCounters[index];
+		if (cache->mCount[index])
+			bump(counters.mHits);
+		else
+		{
+			refill(*cache, index);
+			bump(counters.mRefills);
+		}
+		bump(counters.mAllocations);
+		return cache->mBlocks[index][--cache->mCount[index]];
+	}
+
+	inline void deallocate(void* p, std::size_t bytes)
+	{
+		if (!p)
+			return;
+		if (bytes > kMaxSize)
+		{
+			__atomic_fetch_sub(&state().mLargeBytesOutstanding, bytes, __ATOMIC_RELAXED);
+			std::free(p);
+			return;
+		}
+
+		const std::size_t	index	= size_class_index(bytes);
+		thread_cache* const	cache	= local_cache();
+
+		if (!cache)
+		{
+			free_block* const block = static_cast<free_block*>(p);
+
+			block->mpNext = NULL;
+			push_batch(index, block);
+			__atomic_fetch_add(&state().mRetired[index].mFrees, 1, __ATOMIC_RELAXED);
+			return;
+		}
+
+		const std::size_t capacity = magazine_capacity(index);
+		if (cache->mCount[index] == capacity)
+		{
+			flush(*cache, index, capacity / 2);
+			bump(cache->mCounters[index].mFlushes);
+		}
+		bump(cache->mCounters[index].mFrees);
+		cache->mBlocks[index][cache->mCount[index]++] = p;
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// statistics														///
+	///////////////////////////////////////////////////////////////////////
+
+	inline void add_counters(class_counters& sum, const class_counters& c)
+	{
+		sum.mAllocations	+= __atomic_load_n(&c.mAllocations, __ATOMIC_RELAXED);
+		sum.mFrees			+= __atomic_load_n(&c.mFrees, __ATOMIC_RELAXED);
+		sum.mHits			+= __atomic_load_n(&c.mHits, __ATOMIC_RELAXED);
+		sum.mRefills		+= __atomic_load_n(&c.mRefills, __ATOMIC_RELAXED);
+		sum.mFlushes		+= __atomic_load_n(&c.mFlushes, __ATOMIC_RELAXED);
+	}
+
+	/// stats
+	///
+	/// Fills out[0, kClassCount). The counters of running threads are read while they change, so the
+	/// snapshot is only exact when the pool is idle.
+	inline void stats(class_stats* out)
+	{
+		global_state& s = state();
+		class_counters sums[kClassCount] = {};
+
+		{
+			std::lock_guard<std::mutex> lock(s.mRegistryMutex);
+
+			for (std::size_t i = 0; i < kClassCount; ++i)
+				add_counters(sums[i], s.mRetired[i]);
+			for (thread_cache* cache = s.mpCaches; cache; cache = cache->mpNext)
+			{
+				for (std::size_t i = 0; i < kClassCount; ++i)
+					add_counters(sums[i], cache->mCounters[i]);
+			}
+		}
+		for (std::size_t i = 0; i < kClassCount; ++i)
+		{
+			out[i].size					= size_class_bytes(i);
+			out[i].allocations			= sums[i].mAllocations;
+			out[i].hits					= sums[i].mHits;
+			out[i].refills				= sums[i].mRefills;
+			out[i].flushes				= sums[i].mFlushes;
+			out[i].slabs				= __atomic_load_n(&s.mDepots[i].mSlabs, __ATOMIC_RELAXED);
+			out[i].bytes_outstanding	= (sums[i].mAllocations - sums[i].mFrees) * out[i].size;
+		}
+	}
+
+	inline std::size_t large_bytes_outstanding()
+	{
+		return __atomic_load_n(&state().mLargeBytesOutstanding, __ATOMIC_RELAXED);
+	}
+
+	/// print_stats
+	///
+	/// One line per size class that was used.
+	inline void print_stats(std::ostream& os)
+	{
+		class_stats s[kClassCount];
+
+		stats(s);
+		os << "size\tallocations\thits\trefills\tflushes\tslabs\toutstanding\n";
+		for (std::size_t i = 0; i < kClassCount; ++i)
+		{
+			if (!s[i].allocations)
+				continue;
+			os << s[i].size << '\t' << s[i].allocations << '\t' << s[i].hits << '\t' << s[i].refills << '\t'
+			   << s[i].flushes << '\t' << s[i].slabs << '\t' << s[i].bytes_outstanding << '\n';
+		}
+		os << "large\toutstanding " << large_bytes_outstanding() << '\n';
+	}
+
+} // namespace pool
+
+
+	/// pool_allocator
+	///
+	/// Stateless allocator on top of the size class pool, for merkol::vector and node based containers.
+	/// All instances are interchangeable, memory can be freed by any thread.
+	template <typename T>
+	class pool_allocator
+	{
+		static_assert(alignof(T) <= 16, "merkol::pool_allocator -- blocks are only 16 byte aligned");
+
+	public:
+		typedef T					value_type;
+		typedef T*					pointer;
+		typedef const T*			const_pointer;
+		typedef T&					reference;
+		typedef const T&			const_reference;
+		typedef std::size_t			size_type;
+		typedef std::ptrdiff_t		difference_type;
+
+		template <typename U>
+		struct rebind { typedef pool_allocator<U> other; };
+
+		pool_allocator() noexcept { }
+		template <typename U>
+		pool_allocator(const pool_allocator<U>& /*other*/) noexcept { }
+
+		pointer allocate(size_type n, const void* /*hint*/ = 0)
+		{
+			if (n > max_size())
+				throw std::bad_alloc();
+			return static_cast<pointer>(pool::allocate(n * sizeof(T)));
+		}
+
+		void deallocate(pointer p, size_type n)
+		{
+			pool::deallocate(p, n * sizeof(T));
+		}
+
+		size_type	max_size() const noexcept { return (size_type)-1 / sizeof(T) / 2; }
+	}; // pool_allocator
+
+	template <typename T, typename U>
+	inline bool operator==(const pool_allocator<T>& /*a*/, const pool_allocator<U>& /*b*/) { return true; }
+
+	template <typename T, typename U>
+	inline bool operator!=(const pool_allocator<T>& /*a*/, const pool_allocator<U>& /*b*/) { return false; }
+
+} // namespace merkol
+
+#endif // POOL_ALLOCATOR_HPP
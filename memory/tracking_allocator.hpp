@@ -0,0 +1,483 @@
+#ifndef TRACKING_ALLOCATOR_HPP
+# define TRACKING_ALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <ostream>
+#include <typeinfo>
+#include <stdint.h>
+#include "memory.hpp"
+#include "../auxiliary/trace.hpp"
+
+#if defined(__GNUC__)
+# include <cxxabi.h>
+#endif
+
+/*
+	tracking_allocator<Inner>
+
+	Wraps any allocator and accounts for every block it hands out in a tracking::site: allocation and
+	deallocation counts, bytes, live and peak bytes, how long blocks live, and, for vectors, how much of
+	each block was used when the vector let go of it. Sites register themselves in a global list that
+	can be walked at runtime (tracking::for_each_site) or printed (tracking::report).
+
+	A site is a name for the containers that share it, usually one per member or variable of interest:
+
+		static merkol::tracking::site	gOrderSite("OrderBook::orders");
+
+		merkol::vector<Order, merkol::tracking_allocator<std::allocator<Order> > >
+			orders((merkol::tracking_allocator<std::allocator<Order> >(gOrderSite)));
+
+	A default constructed tracking_allocator accounts to the site of its value type, named after it.
+
+	What to look for in the report:
+	- churn: many allocations that live for microseconds (lifetime histogram, allocations per second).
+	- over-reservation: a large slack, the share of the released capacity that was never constructed.
+	  Vectors report it when they are destroyed (merkol::allocator_tracks_usage).
+	- size mismatches: blocks given back with another size than they were allocated with, a container
+	  bug. The header keeps the real size, which is what gets accounted and released.
+
+	The cost is a 16 byte header in front of every block (allocation time and size), a clock read per
+	allocation and per deallocation, and a few relaxed atomic additions. Sites must outlive every
+	container that uses them; they are never unregistered.
+
+	If the MERKOL_ALLOC_REPORT environment variable is set, the report is written at exit to that file,
+	or to stderr if the value is "-".
+*/
+
+namespace merkol
+{
+namespace tracking
+{
+	static const int kLifetimeBuckets = 40; // bucket i: lifetimes in [2^i, 2^(i+1)) ns, the last one takes the rest
+
+	/// site_stats
+	///
+	/// Snapshot of the counters of a site, see site::stats().
+	struct site_stats
+	{
+		uint64_t	allocations;
+		uint64_t	deallocations;
+		uint64_t	reallocations;			// through Allocator::reallocate
+		uint64_t	reallocations_moved;	// of which the block could not be resized in place
+		uint64_t	bytes_allocated;		// total requested, reallocation growth included
+		uint64_t	live_bytes;
+		uint64_t	peak_live_bytes;
+		uint64_t	released_with_usage;	// blocks for which the container reported its usage
+		uint64_t	released_capacity_bytes;
+		uint64_t	released_used_bytes;
+		uint64_t	size_mismatches;		// deallocate() or reallocate() given another size than allocated
+		uint64_t	lifetimes[kLifetimeBuckets];
+	};
+
+	inline void report_at_exit();
+
+	/// site
+	///
+	/// Counters shared by every allocator constructed with it. Updated with relaxed atomics, so the
+	/// containers of a site may live on different threads. Give it static storage duration.
+	class site
+	{
+	public:
+		explicit site(const char* name);
+
+		const char*	name() const { return mpName; }
+		site*		next() const { return mpNext; }
+		uint64_t	created() const { return mCreated; }
+		site_stats	stats() const;
+
+		void		on_allocate(std::size_t bytes);
+		void		on_deallocate(std::size_t bytes, uint64_t lifetime);
+		void		on_reallocate(std::size_t bytes, std::size_t newBytes, bool moved);
+		void		on_usage(std::size_t capacityBytes, std::size_t usedBytes);
+		void		on_size_mismatch() { add(mStats.size_mismatches, 1); }
+
+	private:
+		site(const site&);
+		site& operator=(const site&);
+
+		static void add(uint64_t& counter, uint64_t value) { __atomic_fetch_add(&counter, value, __ATOMIC_RELAXED); }
+		void		addLive(uint64_t bytes);
+
+		const char*	mpName;
+		site*		mpNext;
+		uint64_t	mCreated;
+		site_stats	mStats;
+	};
+
+	inline site*& registry_head()
+	{
+		static site* head = NULL;
+		return head;
+	}
+
+	inline site::site(const char* name)
+		: mpName(name ? name : "(unnamed)"),
+		  mpNext(NULL),
+		  mCreated(merkol::trace::now())
+	{
+		std::memset(&mStats, 0, sizeof(mStats));
+		mpNext = __atomic_load_n(&registry_head(), __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&registry_head(), &mpNext, this, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+		if (!mpNext && std::getenv("MERKOL_ALLOC_REPORT"))
+			std::atexit(report_at_exit);
+	}
+
+	inline site_stats site::stats() const
+	{
+		site_stats s;
+		const uint64_t* from = reinterpret_cast<const uint64_t*>(&mStats);
+		uint64_t*		to = reinterpret_cast<uint64_t*>(&s);
+
+		for (std::size_t i = 0; i < sizeof(site_stats) / sizeof(uint64_t); ++i)
+			to[i] = __atomic_load_n(from + i, __ATOMIC_RELAXED);
+		return s;
+	}
+
+	inline void site::addLive(uint64_t bytes)
+	{
+		const uint64_t	live = __atomic_add_fetch(&mStats.live_bytes, bytes, __ATOMIC_RELAXED);
+		uint64_t		peak = __atomic_load_n(&mStats.peak_live_bytes, __ATOMIC_RELAXED);
+
+		while (live > peak && !__atomic_compare_exchange_n(&mStats.peak_live_bytes, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			;
+	}
+
+	inline void site::on_allocate(std::size_t bytes)
+	{
+		add(mStats.allocations, 1);
+		add(mStats.bytes_allocated, bytes);
+		addLive(bytes);
+	}
+
+	inline void site::on_deallocate(std::size_t bytes, uint64_t lifetime)
+	{
+		int bucket = 0;
+
+		while (bucket < kLifetimeBuckets - 1 && (lifetime >> (bucket + 1)))
+			++bucket;
+		add(mStats.deallocations, 1);
+		add(mStats.lifetimes[bucket], 1);
+		__atomic_sub_fetch(&mStats.live_bytes, (uint64_t)bytes, __ATOMIC_RELAXED);
+	}
+
+	inline void site::on_reallocate(std::size_t bytes, std::size_t newBytes, bool moved)
+	{
+		add(mStats.reallocations, 1);
+		if (moved)
+			add(mStats.reallocations_moved, 1);
+		if (newBytes > bytes)
+		{
+			add(mStats.bytes_allocated, newBytes - bytes);
+			addLive(newBytes - bytes);
+		}
+		else
+			__atomic_sub_fetch(&mStats.live_bytes, (uint64_t)(bytes - newBytes), __ATOMIC_RELAXED);
+	}
+
+	inline void site::on_usage(std::size_t capacityBytes, std::size_t usedBytes)
+	{
+		add(mStats.released_with_usage, 1);
+		add(mStats.released_capacity_bytes, capacityBytes);
+		add(mStats.released_used_bytes, usedBytes);
+	}
+
+	// The returned string is never freed: it names a site, which lives until exit.
+	inline const char* demangle(const char* name)
+	{
+	#if defined(__GNUC__)
+		int		status = 0;
+		char*	readable = abi::__cxa_demangle(name, NULL, NULL, &status);
+
+		if (status == 0 && readable)
+			return readable;
+	#endif
+		return name;
+	}
+
+	/// default_site
+	///
+	/// The site of allocators constructed without one: one per value type, named after it.
+	template <typename T>
+	inline site& default_site()
+	{
+		static site s(demangle(typeid(T).name()));
+		return s;
+	}
+
+	/// for_each_site
+	///
+	/// Visits every registered site, most recently registered first.
+	template <typename Function>
+	inline void for_each_site(Function f)
+	{
+		for (site* s = __atomic_load_n(&registry_head(), __ATOMIC_ACQUIRE); s; s = s->next())
+			f(*s);
+	}
+
+	/// find_site
+	///
+	/// The first registered site with that name, or NULL.
+	inline site* find_site(const char* name)
+	{
+		for (site* s = __atomic_load_n(&registry_head(), __ATOMIC_ACQUIRE); s; s = s->next())
+			if (std::strcmp(s->name(), name) == 0)
+				return s;
+		return NULL;
+	}
+
+	inline void format_bytes(char* out, std::size_t size, uint64_t bytes)
+	{
+		if (bytes >= (1ull << 30))
+			snprintf(out, size, "%.1fG", (double)bytes / (1ull << 30));
+		else if (bytes >= (1ull << 20))
+			snprintf(out, size, "%.1fM", (double)bytes / (1ull << 20));
+		else if (bytes >= (1ull << 10))
+			snprintf(out, size, "%.1fK", (double)bytes / (1ull << 10));
+		else
+			snprintf(out, size, "%lluB", (unsigned long long)bytes);
+	}
+
+	inline void format_duration(char* out, std::size_t size, uint64_t ns)
+	{
+		if (ns >= 1000000000ull)
+			snprintf(out, size, "%.0fs", (double)ns / 1e9);
+		else if (ns >= 1000000ull)
+			snprintf(out, size, "%.0fms", (double)ns / 1e6);
+		else if (ns >= 1000ull)
+			snprintf(out, size, "%.0fus", (double)ns / 1e3);
+		else
+			snprintf(out, size, "%lluns", (unsigned long long)ns);
+	}
+
+	struct report_visitor
+	{
+		std::ostream*	os;
+		uint64_t		now;
+
+		void operator()(const site& s) const
+		{
+			const site_stats	st = s.stats();
+			const double		seconds = (double)(now - s.created()) / 1e9;
+			char				live[16], peak[16], total[16], line[256];
+
+			if (!st.allocations)
+				return;
+			format_bytes(live, sizeof(live), st.live_bytes);
+			format_bytes(peak, sizeof(peak), st.peak_live_bytes);
+			format_bytes(total, sizeof(total), st.bytes_allocated);
+			snprintf(line, sizeof(line), "%s\n  allocations %llu (%.0f/s)  deallocations %llu  reallocations %llu (%llu moved)\n"
+						  "  bytes allocated %s  live %s  peak %s",
+						  s.name(), (unsigned long long)st.allocations, seconds > 0 ? (double)st.allocations / seconds : 0.0,
+						  (unsigned long long)st.deallocations, (unsigned long long)st.reallocations,
+						  (unsigned long long)st.reallocations_moved, total, live, peak);
+			*os << line << '\n';
+
+			if (st.released_with_usage)
+			{
+				const double slack = st.released_capacity_bytes
+					? 100.0 * (double)(st.released_capacity_bytes - st.released_used_bytes) / (double)st.released_capacity_bytes : 0.0;
+
+				snprintf(line, sizeof(line), "  slack at release %.1f%% over %llu blocks", slack, (unsigned long long)st.released_with_usage);
+				*os << line << '\n';
+			}
+
+			if (st.size_mismatches)
+			{
+				snprintf(line, sizeof(line), "  size mismatches %llu", (unsigned long long)st.size_mismatches);
+				*os << line << '\n';
+			}
+
+			if (st.deallocations)
+			{
+				*os << "  lifetime";
+				for (int i = 0; i < kLifetimeBuckets; ++i)
+				{
+					if (!st.lifetimes[i])
+						continue;
+					const bool	last = (i == kLifetimeBuckets - 1);
+					char		bound[16];
+
+					format_duration(bound, sizeof(bound), last ? (1ull << i) : (1ull << (i + 1)));
+					snprintf(line, sizeof(line), " %s%s:%llu", last ? ">=" : "<", bound, (unsigned long long)st.lifetimes[i]);
+					*os << line;
+				}
+				*os << '\n';
+			}
+		}
+	};
+
+	/// report
+	///
+	/// Prints the counters of every site that allocated something. Never call this from a hot path.
+	inline void report(std::ostream& os)
+	{
+		report_visitor v;
+
+		v.os	= &os;
+		v.now	= merkol::trace::now();
+		for_each_site(v);
+		os.flush();
+	}
+
+	inline void report_at_exit()
+	{
+		const char* path = std::getenv("MERKOL_ALLOC_REPORT");
+
+		if (!path)
+			return;
+		if (std::strcmp(path, "-") == 0)
+		{
+			report(std::cerr);
+			return;
+		}
+		std::ofstream file(path);
+		if (file)
+			report(file);
+	}
+
+} // namespace tracking
+
+
+	/// tracking_allocator
+	///
+	/// Allocator adapter that forwards to Inner and accounts for every block in a tracking::site.
+	/// Blocks get a header, so the element alignment must not exceed the one of long double.
+	/// reallocate() is provided when Inner provides it, and note_usage() receives what vectors report
+	/// when they are destroyed.
+	template <typename Inner>
+	class tracking_allocator
+	{
+	public:
+		typedef typename Inner::value_type		value_type;
+		typedef value_type*						pointer;
+		typedef const value_type*				const_pointer;
+		typedef value_type&						reference;
+		typedef const value_type&				const_reference;
+		typedef std::size_t						size_type;
+		typedef std::ptrdiff_t					difference_type;
+		typedef Inner							inner_allocator_type;
+
+		template <typename U>
+		struct rebind { typedef tracking_allocator<typename Inner::template rebind<U>::other> other; };
+
+		tracking_allocator() : mInner(), mpSite(&tracking::default_site<value_type>()) { }
+		explicit tracking_allocator(tracking::site& site, const Inner& inner = Inner()) : mInner(inner), mpSite(&site) { }
+		template <typename OtherInner>
+		tracking_allocator(const tracking_allocator<OtherInner>& other) : mInner(other.inner()), mpSite(&other.site()) { }
+
+		pointer allocate(size_type n, const void* /*hint*/ = 0)
+		{
+			if (n > max_size())
+				throw std::bad_alloc();
+
+			unit_allocator	units(mInner);
+			unit* const		block = units.allocate(unitCount(n));
+			header* const	h = reinterpret_cast<header*>(block);
+
+			h->timestamp	= merkol::trace::now();
+			h->bytes		= n * sizeof(value_type);
+			mpSite->on_allocate(n * sizeof(value_type));
+			return reinterpret_cast<pointer>(block + kHeaderUnits);
+		}
+
+		// n is checked against the size in the header, which is the one used.
+		void deallocate(pointer p, size_type n)
+		{
+			unit_allocator	units(mInner);
+			unit* const		block = reinterpret_cast<unit*>(p) - kHeaderUnits;
+			header* const	h = reinterpret_cast<header*>(block);
+
+			n = checkedCount(h, n);
+			mpSite->on_deallocate(n * sizeof(value_type), merkol::trace::now() - h->timestamp);
+			units.deallocate(block, unitCount(n));
+		}
+
+		// Only instantiated when Inner has reallocate(), see allocator_can_reallocate below. The block keeps
+		// its allocation time.
+		pointer reallocate(pointer p, size_type n, size_type newN)
+		{
+			if (newN > max_size())
+				throw std::bad_alloc();
+
+			unit_allocator	units(mInner);
+			unit* const		block = reinterpret_cast<unit*>(p) - kHeaderUnits;
+
+			n = checkedCount(reinterpret_cast<header*>(block), n);
+
+			unit* const		newBlock = units.reallocate(block, unitCount(n), unitCount(newN));
+
+			reinterpret_cast<header*>(newBlock)->bytes = newN * sizeof(value_type);
+			mpSite->on_reallocate(n * sizeof(value_type), newN * sizeof(value_type), newBlock != block);
+			return reinterpret_cast<pointer>(newBlock + kHeaderUnits);
+		}
+
+		void note_usage(pointer /*p*/, size_type n, size_type used)
+		{
+			mpSite->on_usage(n * sizeof(value_type), used * sizeof(value_type));
+		}
+
+		size_type		max_size() const { return (size_type)-1 / sizeof(value_type) / 2; }
+		const Inner&	inner() const { return mInner; }
+		tracking::site&	site() const { return *mpSite; }
+
+	private:
+		struct header
+		{
+			uint64_t	timestamp;
+			uint64_t	bytes;
+		};
+
+		typedef merkol::aligned_buffer<long double>							unit;
+		typedef typename Inner::template rebind<unit>::other				unit_allocator;
+
+		static const size_type kHeaderUnits = (sizeof(header) + sizeof(unit) - 1) / sizeof(unit);
+
+	#if __cplusplus >= 201103L
+		static_assert(alignof(value_type) <= alignof(unit), "tracking_allocator: over-aligned element type");
+	#endif
+
+		static size_type unitCount(size_type n) { return kHeaderUnits + (n * sizeof(value_type) + sizeof(unit) - 1) / sizeof(unit); }
+
+		// The element count the block was allocated with; a different n is counted in the site.
+		size_type checkedCount(const header* h, size_type n) const
+		{
+			if (h->bytes != n * sizeof(value_type))
+			{
+				mpSite->on_size_mismatch();
+				return (size_type)(h->bytes / sizeof(value_type));
+			}
+			return n;
+		}
+
+		Inner				mInner;
+		tracking::site*		mpSite;
+	}; // tracking_allocator
+
+	template <typename A, typename B>
+	inline bool operator==(const tracking_allocator<A>& a, const tracking_allocator<B>& b)
+	{
+		return (&a.site() == &b.site()) && (a.inner() == b.inner());
+	}
+
+	template <typename A, typename B>
+	inline bool operator!=(const tracking_allocator<A>& a, const tracking_allocator<B>& b)
+	{
+		return !(a == b);
+	}
+
+	template <typename Inner>
+	struct allocator_can_reallocate<tracking_allocator<Inner> > : allocator_can_reallocate<Inner> {};
+
+	template <typename Inner>
+	struct allocator_tracks_usage<tracking_allocator<Inner> > : merkol::true_type {};
+
+} // namespace merkol
+
+#endif // TRACKING_ALLOCATOR_HPP
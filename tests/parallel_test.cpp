@@ -0,0 +1,77 @@
+// merkol::parallel algorithms at every grain, down to grain(1), on small and odd sizes: sort and
+// stable_sort against std::stable_sort (stability included), reduce, for_each and find.
+//
+//	c++ -std=c++11 -pthread parallel_test.cpp -o parallel_test && ./parallel_test
+
+#if __cplusplus < 201103L
+# error "parallel_test requires C++11"
+#endif
+
+#include "../aux_templates/parallel_algorithm.hpp"
+#include "test.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	typedef std::pair<int, int>	entry;		// key, original position
+
+	struct by_key
+	{
+		bool operator()(const entry& a, const entry& b) const { return a.first < b.first; }
+	};
+
+	std::vector<entry> make_entries(std::size_t n, int keys)
+	{
+		std::vector<entry>	v(n);
+		unsigned			x = 12345;
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			x = x * 1664525u + 1013904223u;
+			v[i] = entry((int)((x >> 8) % (unsigned)keys), (int)i);
+		}
+		return v;
+	}
+
+	void check(const merkol::parallel::policy& p, std::size_t n)
+	{
+		std::vector<entry> expected = make_entries(n, 7);
+		std::vector<entry> v		= expected;
+
+		std::stable_sort(expected.begin(), expected.end(), by_key());
+		merkol::parallel::stable_sort(p, v.begin(), v.end(), by_key());
+		CHECK(v == expected);
+
+		v = make_entries(n, 1000);
+		expected = v;
+		std::sort(expected.begin(), expected.end());
+		merkol::parallel::sort(p, v.begin(), v.end());
+		CHECK(v == expected);
+
+		std::vector<long> numbers(n);
+
+		merkol::parallel::for_each(p, numbers.begin(), numbers.end(), [](long& x) { x = 3; });
+		CHECK(merkol::parallel::reduce(p, numbers.begin(), numbers.end(), 0L) == (long)(3 * n));
+		if (n)
+		{
+			numbers[n / 2] = 4;
+			CHECK(merkol::parallel::find(p, numbers.begin(), numbers.end(), 4L) == numbers.begin() + (long)(n / 2));
+		}
+	}
+}
+
+int main()
+{
+	merkol::parallel::thread_pool	pool(4);
+	const std::size_t				grains[] = { 1, 2, 3, 7, 0 };		// 0: the default
+	const std::size_t				sizes[]	 = { 0, 1, 2, 3, 4, 5, 17, 100, 1000, 20000 };
+
+	for (std::size_t g = 0; g < sizeof(grains) / sizeof(grains[0]); ++g)
+	{
+		for (std::size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+			check(merkol::parallel::policy().pool(pool).grain(grains[g]), sizes[s]);
+	}
+	return 0;
+}
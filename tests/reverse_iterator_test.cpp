@@ -0,0 +1,106 @@
+// merkol::reverse_iterator::operator-> over the containers' iterators: plain pointers (vector), class
+// iterators (deque, map) and iterators whose reference is a proxy (flat_map, btree_map).
+//
+//	c++ -std=c++11 reverse_iterator_test.cpp -o reverse_iterator_test && ./reverse_iterator_test
+
+#include "../containers/btree_map.hpp"
+#include "../containers/deque.hpp"
+#include "../containers/flat_map.hpp"
+#include "../containers/map.hpp"
+#include "../containers/vector.hpp"
+#include "test.hpp"
+#include <string>
+#include <utility>
+
+namespace
+{
+	struct point
+	{
+		int x;
+		int y;
+	};
+
+	void vector_and_deque()
+	{
+		merkol::vector<point>	v;
+		merkol::deque<point>	d;
+		const point				p = { 1, 2 };
+		const point				q = { 3, 4 };
+
+		v.push_back(p);
+		v.push_back(q);
+		d.push_back(p);
+		d.push_back(q);
+		CHECK(v.rbegin()->x == 3);
+		CHECK(d.rbegin()->y == 4);
+		v.rbegin()->x = 5;
+		CHECK(v.back().x == 5);
+
+		const merkol::vector<point>& cv = v;
+
+		CHECK((++cv.rbegin())->y == 2);
+	}
+
+	void map()
+	{
+		merkol::map<int, std::string> m;
+
+		m[1] = "one";
+		m[2] = "two";
+		CHECK(m.rbegin()->first == 2);
+		CHECK(m.rbegin()->second == "two");
+		m.rbegin()->second = "deux";
+		CHECK(m[2] == "deux");
+	}
+
+	void flat_map()
+	{
+		merkol::flat_map<int, std::string> m;
+
+		m[1] = "one";
+		m[2] = "two";
+		m[3] = "three";
+		CHECK(m.rbegin()->first == 3);
+		CHECK(m.rbegin()->second == "three");
+		m.rbegin()->second = "trois";
+		CHECK(m[3] == "trois");
+
+		const merkol::flat_map<int, std::string>&					cm	= m;
+		merkol::flat_map<int, std::string>::const_reverse_iterator	it	= cm.rbegin();
+
+		++it;
+		CHECK(it->first == 2);
+		CHECK(it->second == "two");
+		CHECK((++it)->second == "one");
+	}
+
+	// btree_map's iterators hand out flat_map_reference too.
+	void btree_map()
+	{
+		merkol::btree_map<int, std::string> m;
+
+		for (int i = 0; i < 1000; ++i)
+			m.insert(std::make_pair(i, std::string(1, (char)('a' + i % 26))));
+		CHECK(m.rbegin()->first == 999);
+		CHECK(m.rbegin()->second == "l");
+		m.rbegin()->second = "last";
+		CHECK(m.find(999)->second == "last");
+
+		const merkol::btree_map<int, std::string>&					cm	= m;
+		merkol::btree_map<int, std::string>::const_reverse_iterator	it	= cm.rbegin();
+		int															n	= 0;
+
+		for (; it != cm.rend(); ++it, ++n)
+			CHECK(it->first == 999 - n);
+		CHECK(n == 1000);
+	}
+}
+
+int main()
+{
+	vector_and_deque();
+	map();
+	flat_map();
+	btree_map();
+	return 0;
+}
@@ -0,0 +1,109 @@
+// merkol::soa_vector: growth keeps the strong guarantee when one column throws while it is copied,
+// including for the columns relocated before it.
+//
+//	c++ -std=c++11 soa_vector_test.cpp -o soa_vector_test && ./soa_vector_test
+
+#if __cplusplus < 201103L
+# error "soa_vector_test requires C++11"
+#endif
+
+#include "../containers/soa_vector.hpp"
+#include "test.hpp"
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+	int gCopiesLeft = -1;		// copies until one throws, -1 for never
+
+	// Copies throw on demand; there is no move constructor, so rows holding one are copied on growth.
+	struct throwing
+	{
+		int value;
+
+		explicit throwing(int v) : value(v) { }
+		throwing(const throwing& other) : value(other.value)
+		{
+			if (gCopiesLeft == 0)
+				throw std::runtime_error("throwing copy");
+			if (gCopiesLeft > 0)
+				--gCopiesLeft;
+		}
+		throwing& operator=(const throwing& other) { value = other.value; return *this; }
+	};
+
+	std::string text(int i)
+	{
+		return "row " + std::to_string(i) + " long enough to live on the heap";
+	}
+
+	// The throwing column comes after a std::string column, which is relocated first.
+	void growth_throws_after_string_column()
+	{
+		merkol::soa_vector<std::string, throwing> v;
+
+		int n = 0;
+
+		while ((n < 8) || (v.size() < v.capacity()))		// full: the next push_back grows
+			v.push_back(text(n), throwing(n)), ++n;
+		for (int copies = 0; copies < n; ++copies)
+		{
+			const std::size_t capacity = v.capacity();
+
+			gCopiesLeft = copies;
+			try
+			{
+				v.push_back(text(100), throwing(100));
+				CHECK(false);
+			}
+			catch (const std::runtime_error&)
+			{
+			}
+			gCopiesLeft = -1;
+			CHECK(v.size() == (std::size_t)n);
+			CHECK(v.capacity() == capacity);
+			for (int i = 0; i < n; ++i)
+			{
+				CHECK(std::get<0>(v[i]) == text(i));
+				CHECK(std::get<1>(v[i]).value == i);
+			}
+		}
+		v.push_back(text(n), throwing(n));
+		CHECK(std::get<0>(v[n - 1]) == text(n - 1));
+		CHECK(std::get<0>(v[n]) == text(n));
+	}
+
+	// A move only column is moved even when the row is copied, and moved back if a later column throws.
+	void growth_throws_after_move_only_column()
+	{
+		merkol::soa_vector<std::unique_ptr<int>, std::string, throwing> v;
+
+		for (int i = 0; i < 8; ++i)
+			v.push_back(std::make_tuple(std::unique_ptr<int>(new int(i)), text(i), throwing(i)));
+		gCopiesLeft = 3;
+		try
+		{
+			v.reserve(v.capacity() + 1);
+			CHECK(false);
+		}
+		catch (const std::runtime_error&)
+		{
+		}
+		gCopiesLeft = -1;
+		CHECK(v.size() == 8);
+		for (int i = 0; i < 8; ++i)
+		{
+			CHECK(std::get<0>(v[i]) && (*std::get<0>(v[i]) == i));
+			CHECK(std::get<1>(v[i]) == text(i));
+			CHECK(std::get<2>(v[i]).value == i);
+		}
+	}
+}
+
+int main()
+{
+	growth_throws_after_string_column();
+	growth_throws_after_move_only_column();
+	return 0;
+}
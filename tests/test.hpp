@@ -0,0 +1,22 @@
+#ifndef MERKOL_TEST_HPP
+# define MERKOL_TEST_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+/*
+	CHECK(condition) for the programs in this directory: prints the failed condition with its location
+	and exits with status 1.
+*/
+
+#define CHECK(condition)																				\
+	do																									\
+	{																									\
+		if (!(condition))																				\
+		{																								\
+			std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);		\
+			std::exit(1);																				\
+		}																								\
+	} while (0)
+
+#endif // MERKOL_TEST_HPP